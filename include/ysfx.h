@@ -68,6 +68,9 @@ typedef void (ysfx_log_reporter_t)(intptr_t userdata, ysfx_log_level level, cons
 
 typedef struct ysfx_config_s ysfx_config_t;
 typedef struct ysfx_audio_format_s ysfx_audio_format_t;
+typedef struct ysfx_audio_cache_s ysfx_audio_cache_t;
+typedef struct ysfx_source_cache_s ysfx_source_cache_t;
+typedef struct ysfx_image_cache_s ysfx_image_cache_t;
 
 // create a new configuration
 YSFX_API ysfx_config_t *ysfx_config_new();
@@ -86,9 +89,25 @@ YSFX_API const char *ysfx_get_data_root(ysfx_config_t *config);
 // guess the undefined root folders, based on the path to the JSFX file
 YSFX_API void ysfx_guess_file_roots(ysfx_config_t *config, const char *sourcepath);
 // register an audio format into the system
+//   this reads the members which precede `seek`, and registers the format as not seekable,
+//   such that the formats which are built against the former structure keep working
 YSFX_API void ysfx_register_audio_format(ysfx_config_t *config, ysfx_audio_format_t *afmt);
+// register an audio format into the system, whose structure has the given size
+//   pass `sizeof(ysfx_audio_format_t)`; the members past the size are considered NULL
+YSFX_API void ysfx_register_audio_format_sized(ysfx_config_t *config, const ysfx_audio_format_t *afmt, size_t size);
 // register the builtin audio formats (at least WAV file support)
 YSFX_API void ysfx_register_builtin_audio_formats(ysfx_config_t *config);
+// set the cache of decoded audio files, taking a reference; NULL to decode files individually
+YSFX_API void ysfx_set_audio_cache(ysfx_config_t *config, ysfx_audio_cache_t *cache);
+// set the cache of parsed source files, taking a reference; NULL to parse files individually
+YSFX_API void ysfx_set_source_cache(ysfx_config_t *config, ysfx_source_cache_t *cache);
+// set the cache of decoded image files, taking a reference; NULL to decode files individually
+YSFX_API void ysfx_set_image_cache(ysfx_config_t *config, ysfx_image_cache_t *cache);
+// stream the audio files which are not cached, decoding in the background this many samples ahead; 0 to disable
+//   the reads in @block and @sample get the samples which are ready, and count an underrun if some are not;
+//   the reads in the other sections wait for the samples, as if the file were not streamed;
+//   a file opened in @block or @sample is opened in the background, and it is empty until then
+YSFX_API void ysfx_set_audio_read_ahead(ysfx_config_t *config, uint32_t samples);
 // set the log reporting function
 YSFX_API void ysfx_set_log_reporter(ysfx_config_t *config, ysfx_log_reporter_t *reporter);
 // set the callback user data
@@ -272,6 +291,7 @@ YSFX_API bool ysfx_receive_midi_from_bus(ysfx_t *fx, uint32_t bus, ysfx_midi_eve
 YSFX_API bool ysfx_send_trigger(ysfx_t *fx, uint32_t index);
 
 // get a bit mask of sliders whose values must be redisplayed, and clear it to zero
+//   this includes the sliders whose values the effect has changed since the last cycle
 YSFX_API uint64_t ysfx_fetch_slider_changes(ysfx_t *fx);
 // get a bit mask of sliders whose values must be automated, and clear it to zero
 YSFX_API uint64_t ysfx_fetch_slider_automations(ysfx_t *fx);
@@ -303,12 +323,28 @@ typedef struct ysfx_state_s {
 
 // load state
 YSFX_API bool ysfx_load_state(ysfx_t *fx, ysfx_state_t *state);
+// load state from the processing thread; @serialize does not wait, like @block and @sample:
+//   the streamed files give the samples which are ready, and no convolver can be made
+YSFX_API bool ysfx_load_state_realtime(ysfx_t *fx, ysfx_state_t *state);
 // save current state; release this object when done
 YSFX_API ysfx_state_t *ysfx_save_state(ysfx_t *fx);
+// save current state into an object made by `ysfx_state_new`, without allocating memory;
+//   returns false if the state did not fit the data capacity, in which case
+//   `data_size` is the capacity which it requires, or if the effect is not compiled;
+//   this is for the processing thread, and @serialize does not wait, like in `ysfx_load_state_realtime`
+YSFX_API bool ysfx_save_state_into(ysfx_t *fx, ysfx_state_t *state, size_t data_capacity);
+// create a state object with room for all the sliders, and for `data_capacity` bytes of data;
+//   release this object when done
+YSFX_API ysfx_state_t *ysfx_state_new(size_t data_capacity);
 // release a saved state object
 YSFX_API void ysfx_state_free(ysfx_state_t *state);
 // duplicate a state object
 YSFX_API ysfx_state_t *ysfx_state_dup(ysfx_state_t *state);
+// write the state in a compact binary form, if it fits the capacity of the buffer;
+//   returns the size of the encoding, which may be bigger than the capacity
+YSFX_API size_t ysfx_state_encode(ysfx_state_t *state, uint8_t *dest, size_t capacity);
+// read a state which was written by `ysfx_state_encode`; release this object when done
+YSFX_API ysfx_state_t *ysfx_state_decode(const uint8_t *data, size_t size);
 
 typedef struct ysfx_preset_s {
     // name of the preset
@@ -330,6 +366,11 @@ typedef struct ysfx_bank_s {
 YSFX_API const char *ysfx_get_bank_path(ysfx_t *fx);
 // read a preset bank from RPL file
 YSFX_API ysfx_bank_t *ysfx_load_bank(const char *path);
+// read the preset names of a RPL file, leaving the states to be decoded when requested;
+//   the `state` of the presets is null, use `ysfx_bank_get_preset_state` to access it
+YSFX_API ysfx_bank_t *ysfx_load_bank_lazy(const char *path);
+// get a copy of the state of a preset, decoding it if necessary; release this object when done
+YSFX_API ysfx_state_t *ysfx_bank_get_preset_state(ysfx_bank_t *bank, uint32_t index);
 // free a preset bank
 YSFX_API void ysfx_bank_free(ysfx_bank_t *bank);
 
@@ -341,6 +382,9 @@ YSFX_API void ysfx_enum_vars(ysfx_t *fx, ysfx_enum_vars_callback_t *callback, vo
 YSFX_API ysfx_real *ysfx_find_var(ysfx_t *fx, const char *name);
 // read a chunk of virtual memory from the VM
 YSFX_API void ysfx_read_vmem(ysfx_t *fx, uint32_t addr, ysfx_real *dest, uint32_t count);
+// get the number of reads of streamed audio files which came up short, the decoder being late,
+//   and of the partitions of convolutions which were late, in @block and @sample
+YSFX_API uint64_t ysfx_get_audio_underruns(ysfx_t *fx);
 
 //------------------------------------------------------------------------------
 // YSFX graphics
@@ -375,12 +419,35 @@ typedef struct ysfx_gfx_config_s {
 YSFX_API void ysfx_gfx_setup(ysfx_t *fx, ysfx_gfx_config_t *gc);
 // get whether the current effect is requesting Retina support
 YSFX_API bool ysfx_gfx_wants_retina(ysfx_t *fx);
+// decode the images named by the header into the image cache of the configuration,
+//   so @gfx finds them ready; unlike the other `ysfx_gfx_*` functions, this can be
+//   invoked from any thread, for example from a background thread after loading
+YSFX_API void ysfx_gfx_preload_images(ysfx_t *fx);
 // push a key to the input queue
 YSFX_API void ysfx_gfx_add_key(ysfx_t *fx, uint32_t mods, uint32_t key, bool press);
 // update mouse information; position is relative to canvas; wheel should be in steps normalized to ±1.0
 YSFX_API void ysfx_gfx_update_mouse(ysfx_t *fx, uint32_t mods, int32_t xpos, int32_t ypos, uint32_t buttons, ysfx_real wheel, ysfx_real hwheel);
 // invoke @gfx to paint the graphics; returns whether the framer buffer is modified
 YSFX_API bool ysfx_gfx_run(ysfx_t *fx);
+// get a counter which advances when @init or the processing may have changed what
+//   @gfx displays: one of the variables which it reads, or anything at all, if it
+//   reads memory or calls functions which may read what is not watched, which is
+//   the case of any function except the math, string and loop builtins;
+//   it can be invoked from any thread, to run @gfx only when there is new data
+YSFX_API uint64_t ysfx_gfx_get_data_serial(ysfx_t *fx);
+
+enum {
+    ysfx_gfx_max_damage = 8,
+};
+
+typedef struct ysfx_gfx_rect_s {
+    uint32_t x, y, w, h;
+} ysfx_gfx_rect_t;
+
+// get the regions of the frame buffer which the last @gfx has modified, in pixels
+// it stores at most `max_count` rectangles, and returns their number, which is
+// no greater than `ysfx_gfx_max_damage`
+YSFX_API uint32_t ysfx_gfx_get_damage(ysfx_t *fx, ysfx_gfx_rect_t *rects, uint32_t max_count);
 
 //------------------------------------------------------------------------------
 // YSFX key map
@@ -484,6 +551,8 @@ typedef struct ysfx_audio_file_info_s {
     ysfx_real sample_rate;
 } ysfx_audio_file_info_t;
 
+// NOTE: the members may be extended at the end, in the future versions;
+//   register with `ysfx_register_audio_format_sized` to use the members past `read`
 typedef struct ysfx_audio_format_s {
     // quickly checks if this format would be able to handle the given file
     bool (*can_handle)(const char *path);
@@ -499,8 +568,68 @@ typedef struct ysfx_audio_format_s {
     void (*rewind)(ysfx_audio_reader_t *reader);
     // read the next block of samples
     uint64_t (*read)(ysfx_audio_reader_t *reader, ysfx_real *samples, uint64_t count);
+    // move the read pointer to the given frame; NULL if the format is not seekable
+    bool (*seek)(ysfx_audio_reader_t *reader, uint64_t frame);
 } ysfx_audio_format_t;
 
+//------------------------------------------------------------------------------
+// YSFX audio cache
+
+// create a cache of decoded audio files, which can be shared by multiple configurations
+//   the least recently used files are evicted when the size exceeds the budget
+YSFX_API ysfx_audio_cache_t *ysfx_audio_cache_new(uint64_t max_bytes);
+// delete an audio cache
+YSFX_API void ysfx_audio_cache_free(ysfx_audio_cache_t *cache);
+// increase the reference counter
+YSFX_API void ysfx_audio_cache_add_ref(ysfx_audio_cache_t *cache);
+// set the maximum size of the decoded data retained by the cache, in bytes
+YSFX_API void ysfx_audio_cache_set_budget(ysfx_audio_cache_t *cache, uint64_t max_bytes);
+// get the size of the decoded data retained by the cache, in bytes
+YSFX_API uint64_t ysfx_audio_cache_get_size(ysfx_audio_cache_t *cache);
+// get the number of files retained by the cache
+YSFX_API uint32_t ysfx_audio_cache_get_count(ysfx_audio_cache_t *cache);
+// remove all the files from the cache; the files currently open are unaffected
+YSFX_API void ysfx_audio_cache_clear(ysfx_audio_cache_t *cache);
+
+//------------------------------------------------------------------------------
+// YSFX source cache
+
+// create a cache of parsed source files, which can be shared by multiple configurations
+//   a file which multiple effects load concurrently is parsed only once
+//   the least recently used files are evicted when the size exceeds the budget, 32 MiB initially
+YSFX_API ysfx_source_cache_t *ysfx_source_cache_new();
+// delete a source cache
+YSFX_API void ysfx_source_cache_free(ysfx_source_cache_t *cache);
+// increase the reference counter
+YSFX_API void ysfx_source_cache_add_ref(ysfx_source_cache_t *cache);
+// set the maximum size of the parsed text retained by the cache, in bytes
+YSFX_API void ysfx_source_cache_set_budget(ysfx_source_cache_t *cache, uint64_t max_bytes);
+// get the size of the parsed text retained by the cache, in bytes
+YSFX_API uint64_t ysfx_source_cache_get_size(ysfx_source_cache_t *cache);
+// get the number of files retained by the cache
+YSFX_API uint32_t ysfx_source_cache_get_count(ysfx_source_cache_t *cache);
+// remove all the files from the cache; the effects currently loaded are unaffected
+YSFX_API void ysfx_source_cache_clear(ysfx_source_cache_t *cache);
+
+//------------------------------------------------------------------------------
+// YSFX image cache
+
+// create a cache of decoded image files, which can be shared by multiple configurations
+//   the least recently used files are evicted when the size exceeds the budget
+YSFX_API ysfx_image_cache_t *ysfx_image_cache_new(uint64_t max_bytes);
+// delete an image cache
+YSFX_API void ysfx_image_cache_free(ysfx_image_cache_t *cache);
+// increase the reference counter
+YSFX_API void ysfx_image_cache_add_ref(ysfx_image_cache_t *cache);
+// set the maximum size of the decoded pixels retained by the cache, in bytes
+YSFX_API void ysfx_image_cache_set_budget(ysfx_image_cache_t *cache, uint64_t max_bytes);
+// get the size of the decoded pixels retained by the cache, in bytes
+YSFX_API uint64_t ysfx_image_cache_get_size(ysfx_image_cache_t *cache);
+// get the number of files retained by the cache
+YSFX_API uint32_t ysfx_image_cache_get_count(ysfx_image_cache_t *cache);
+// remove all the files from the cache; the images currently loaded are unaffected
+YSFX_API void ysfx_image_cache_clear(ysfx_image_cache_t *cache);
+
 //------------------------------------------------------------------------------
 
 #ifdef __cplusplus
@@ -524,6 +653,9 @@ YSFX_DEFINE_AUTO_PTR(ysfx_u, ysfx_t, ysfx_free);
 YSFX_DEFINE_AUTO_PTR(ysfx_state_u, ysfx_state_t, ysfx_state_free);
 YSFX_DEFINE_AUTO_PTR(ysfx_bank_u, ysfx_bank_t, ysfx_bank_free);
 YSFX_DEFINE_AUTO_PTR(ysfx_menu_u, ysfx_menu_t, ysfx_menu_free);
+YSFX_DEFINE_AUTO_PTR(ysfx_audio_cache_u, ysfx_audio_cache_t, ysfx_audio_cache_free);
+YSFX_DEFINE_AUTO_PTR(ysfx_source_cache_u, ysfx_source_cache_t, ysfx_source_cache_free);
+YSFX_DEFINE_AUTO_PTR(ysfx_image_cache_u, ysfx_image_cache_t, ysfx_image_cache_free);
 #endif // defined(__cplusplus) && (__cplusplus >= 201103L || (defined(_MSC_VER) && _MSVC_LANG >= 201103L))
 
 //------------------------------------------------------------------------------
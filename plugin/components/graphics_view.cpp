@@ -18,12 +18,11 @@
 #include "graphics_view.h"
 #include "utility/functional_timer.h"
 #include "utility/async_updater.h"
-#include "utility/rt_semaphore.h"
+#include "utility/worker_pool.h"
 #include <list>
 #include <map>
 #include <queue>
 #include <tuple>
-#include <thread>
 #include <atomic>
 #include <mutex>
 #include <condition_variable>
@@ -56,7 +55,10 @@ struct YsfxGraphicsView::Impl final : public better::AsyncUpdater::Listener,
         int m_gfxWidth = 0;
         int m_gfxHeight = 0;
         bool m_wantRetina = false;
+        // the back buffer, which only the background accesses
         juce::Image m_renderBitmap{juce::Image::ARGB, 1, 1, false};
+        int m_bitmapWidth = 1;
+        int m_bitmapHeight = 1;
         double m_bitmapScale = 1;
         int m_bitmapUnscaledWidth = 0;
         int m_bitmapUnscaledHeight = 0;
@@ -81,6 +83,26 @@ struct YsfxGraphicsView::Impl final : public better::AsyncUpdater::Listener,
     // whether the next @gfx is required to repaint the screen in full
     bool m_gfxDirty = true;
 
+    //--------------------------------------------------------------------------
+    // The pacing of @gfx: it runs when there is some input, new data from the
+    //   processing, or a resize, and it runs at the keep-alive rate otherwise.
+    // Heavy graphics are slowed down, to keep them at half the time at most.
+
+    struct GfxPacing {
+        int m_maxHz = 60;
+        int m_keepAliveHz = 5;
+        uint64_t m_lastDataSerial = 0;
+        bool m_inputPending = false;
+        double m_lastFrameMs = 0;
+        // the moving average of the duration of @gfx
+        double m_averageRunMs = 0;
+    };
+
+    GfxPacing m_gfxPacing;
+
+    bool isGfxFrameDue();
+    void startGfxTimer();
+
     //--------------------------------------------------------------------------
     struct KeyPressed {
         int jcode = 0;
@@ -114,10 +136,16 @@ struct YsfxGraphicsView::Impl final : public better::AsyncUpdater::Listener,
 
     // sends a bitmap the component should repaint itself with
     struct AsyncRepainter : public better::AsyncUpdater {
-        // whether the bitmap contains changes
+        // whether the bitmap contains changes, which are not repainted yet
         bool m_hasBitmapChanged = false;
-        // a double-buffer of the render bitmap, copied after a finished rendering
+        // whether the changes cover the entire bitmap
+        bool m_hasFullDamage = false;
+        // the regions of the bitmap which have changed, in pixels
+        juce::RectangleList<int> m_damage;
+        // the front buffer, swapped with the render bitmap after a finished rendering
         juce::Image m_bitmap{juce::Image::ARGB, 1, 1, false};
+        // the duration of the last @gfx, in milliseconds
+        double m_runMs = 0;
         std::mutex m_mutex;
     };
 
@@ -144,12 +172,13 @@ struct YsfxGraphicsView::Impl final : public better::AsyncUpdater::Listener,
     void handleAsyncUpdate(better::AsyncUpdater *updater) override;
 
     //--------------------------------------------------------------------------
-    // This background thread runs @gfx.
+    // This background work runs @gfx, on a queue of the shared worker pool.
     // This is on a separate thread, because it has elements which can block,
     // which otherwise would require modal loops (eg. `gfx_showmenu`).
 
     class BackgroundWork {
     public:
+        BackgroundWork();
         void start();
         void stop();
 
@@ -171,16 +200,13 @@ struct YsfxGraphicsView::Impl final : public better::AsyncUpdater::Listener,
         void postMessage(std::shared_ptr<Message> message);
 
     private:
-        void run();
-        std::shared_ptr<Message> popNextMessage();
+        void processMessage(Message &msg);
         void processGfxMessage(GfxMessage &msg);
 
     private:
-        std::thread m_thread;
-        RTSemaphore m_sema;
-        volatile bool m_running = false;
-        std::queue<std::shared_ptr<Message>> m_messages;
-        std::mutex m_messagesMutex;
+        juce::SharedResourcePointer<WorkerPool> m_pool;
+        std::unique_ptr<WorkerPool::Queue> m_queue;
+        bool m_running = false;
     };
 
     BackgroundWork m_work;
@@ -231,6 +257,10 @@ void YsfxGraphicsView::setEffect(ysfx_t *fx)
 
     m_impl->m_gfxDirty = true;
 
+    m_impl->m_gfxPacing.m_inputPending = false;
+    m_impl->m_gfxPacing.m_lastFrameMs = 0;
+    m_impl->m_gfxPacing.m_averageRunMs = 0;
+
     if (!fx || !ysfx_has_section(fx, ysfx_section_gfx)) {
         m_impl->m_gfxTimer.reset();
         repaint();
@@ -238,7 +268,7 @@ void YsfxGraphicsView::setEffect(ysfx_t *fx)
     else {
         m_impl->m_work.start();
         m_impl->m_gfxTimer.reset(FunctionalTimer::create([this]() { m_impl->tickGfx(); }));
-        m_impl->m_gfxTimer->startTimerHz(30);
+        m_impl->startGfxTimer();
     }
 
     m_impl->m_gfxInputState.reset(new Impl::GfxInputState);
@@ -254,6 +284,16 @@ void YsfxGraphicsView::setEffect(ysfx_t *fx)
     setMouseCursor(juce::MouseCursor{juce::MouseCursor::NormalCursor});
 }
 
+void YsfxGraphicsView::setFrameRates(int keepAliveHz, int maxHz)
+{
+    Impl::GfxPacing &pacing = m_impl->m_gfxPacing;
+    pacing.m_maxHz = juce::jmax(1, maxHz);
+    pacing.m_keepAliveHz = juce::jlimit(1, pacing.m_maxHz, keepAliveHz);
+
+    if (m_impl->m_gfxTimer)
+        m_impl->startGfxTimer();
+}
+
 void YsfxGraphicsView::paint(juce::Graphics &g)
 {
     ysfx_t *fx = m_impl->m_fx.get();
@@ -280,8 +320,8 @@ void YsfxGraphicsView::paint(juce::Graphics &g)
     std::lock_guard<std::mutex> lock{m_impl->m_asyncRepainter->m_mutex};
     juce::Image &image = m_impl->m_asyncRepainter->m_bitmap;
 
-    if (image.getWidth() != target->m_renderBitmap.getWidth() ||
-        image.getHeight() != target->m_renderBitmap.getHeight())
+    if (image.getWidth() != target->m_bitmapWidth ||
+        image.getHeight() != target->m_bitmapHeight)
     {
         g.fillAll(juce::Colours::black);
     }
@@ -315,6 +355,7 @@ bool YsfxGraphicsView::keyPressed(const juce::KeyPress &key)
     Impl::translateKeyPress(key, kp.ykey, kp.ymods);
 
     m_impl->m_keysPressed.push_back(kp);
+    m_impl->m_gfxPacing.m_inputPending = true;
     ysfx_t *fx = m_impl->m_fx.get();
     if (fx && ysfx_has_section(fx, ysfx_section_gfx)) {
         Impl::GfxInputState *inputs = m_impl->m_gfxInputState.get();
@@ -335,6 +376,7 @@ bool YsfxGraphicsView::keyStateChanged(bool isKeyDown)
                 ++it;
             else {
                 m_impl->m_keysPressed.erase(it++);
+                m_impl->m_gfxPacing.m_inputPending = true;
                 kp.ymods = Impl::translateModifiers(juce::ModifierKeys::getCurrentModifiers());
                 ysfx_t *fx = m_impl->m_fx.get();
                 if (fx && ysfx_has_section(fx, ysfx_section_gfx)) {
@@ -374,6 +416,7 @@ void YsfxGraphicsView::mouseUp(const juce::MouseEvent &event)
 
     Impl::GfxInputState *gfxInputState = m_impl->m_gfxInputState.get();
     gfxInputState->m_ysfxMouseButtons = 0;
+    m_impl->m_gfxPacing.m_inputPending = true;
 }
 
 void YsfxGraphicsView::mouseWheelMove(const juce::MouseEvent &event, const juce::MouseWheelDetails &wheel)
@@ -384,6 +427,7 @@ void YsfxGraphicsView::mouseWheelMove(const juce::MouseEvent &event, const juce:
     Impl::GfxInputState *gfxInputState = m_impl->m_gfxInputState.get();
     gfxInputState->m_ysfxWheel += wheel.deltaY;
     gfxInputState->m_ysfxHWheel += wheel.deltaX;
+    m_impl->m_gfxPacing.m_inputPending = true;
 }
 
 //------------------------------------------------------------------------------
@@ -464,6 +508,10 @@ void YsfxGraphicsView::Impl::tickGfx()
     if (m_numWaitedRepaints > 1)
         return;
 
+    // pause while the view is hidden or minimized
+    if (!m_self->isShowing())
+        return;
+
     ysfx_t *fx = m_fx.get();
     jassert(fx);
 
@@ -475,6 +523,9 @@ void YsfxGraphicsView::Impl::tickGfx()
     if (updateGfxTarget((int)gfxDim[0], (int)gfxDim[1], gfxWantRetina))
         m_gfxDirty = true;
 
+    if (!isGfxFrameDue())
+        return;
+
     ///
     std::shared_ptr<BackgroundWork::GfxMessage> msg{new BackgroundWork::GfxMessage};
     msg->m_fx.reset(fx);
@@ -493,12 +544,46 @@ void YsfxGraphicsView::Impl::tickGfx()
 
     m_gfxInputState->m_ysfxWheel = 0;
     m_gfxInputState->m_ysfxHWheel = 0;
+    m_gfxDirty = false;
+    m_gfxPacing.m_inputPending = false;
 
     ///
     m_work.postMessage(msg);
     m_numWaitedRepaints += 1;
 }
 
+bool YsfxGraphicsView::Impl::isGfxFrameDue()
+{
+    GfxPacing &pacing = m_gfxPacing;
+    double nowMs = juce::Time::getMillisecondCounterHiRes();
+
+    // the effect signals when its processing changes what @gfx displays
+    uint64_t serial = ysfx_gfx_get_data_serial(m_fx.get());
+    bool hasNewData = serial != pacing.m_lastDataSerial;
+    pacing.m_lastDataSerial = serial;
+
+    bool hasChanges = m_gfxDirty || pacing.m_inputPending || hasNewData;
+
+    // the timer already runs at the maximum rate, only heavy graphics wait
+    double keepAliveMs = 1000.0 / pacing.m_keepAliveHz;
+    double intervalMs = hasChanges ? juce::jmin(2 * pacing.m_averageRunMs, keepAliveMs) : keepAliveMs;
+
+    // the data which arrived during a wait is displayed by the next frame
+    if (nowMs - pacing.m_lastFrameMs < intervalMs) {
+        if (hasNewData)
+            pacing.m_lastDataSerial = ~(uint64_t)0;
+        return false;
+    }
+
+    pacing.m_lastFrameMs = nowMs;
+    return true;
+}
+
+void YsfxGraphicsView::Impl::startGfxTimer()
+{
+    m_gfxTimer->startTimerHz(m_gfxPacing.m_maxHz);
+}
+
 bool YsfxGraphicsView::Impl::updateGfxTarget(int newWidth, int newHeight, int newRetina)
 {
     GfxTarget *target = m_gfxTarget.get();
@@ -535,8 +620,8 @@ bool YsfxGraphicsView::Impl::updateGfxTarget(int newWidth, int newHeight, int ne
         scaledWidth = (int)std::ceil(unscaledWidth * bitmapScale);
         scaledHeight = (int)std::ceil(unscaledHeight * bitmapScale);
     }
-    needsUpdate = needsUpdate || (target->m_renderBitmap.getWidth() != juce::jmax(1, scaledWidth));
-    needsUpdate = needsUpdate || (target->m_renderBitmap.getHeight() != juce::jmax(1, scaledHeight));
+    needsUpdate = needsUpdate || (target->m_bitmapWidth != juce::jmax(1, scaledWidth));
+    needsUpdate = needsUpdate || (target->m_bitmapHeight != juce::jmax(1, scaledHeight));
 
     if (needsUpdate) {
         target = new GfxTarget;
@@ -545,6 +630,8 @@ bool YsfxGraphicsView::Impl::updateGfxTarget(int newWidth, int newHeight, int ne
         target->m_gfxHeight = newHeight;
         target->m_wantRetina = (bool)newRetina;
         target->m_renderBitmap = juce::Image(juce::Image::ARGB, juce::jmax(1, scaledWidth), juce::jmax(1, scaledHeight), true);
+        target->m_bitmapWidth = target->m_renderBitmap.getWidth();
+        target->m_bitmapHeight = target->m_renderBitmap.getHeight();
         target->m_bitmapScale = bitmapScale;
         target->m_bitmapUnscaledWidth = unscaledWidth;
         target->m_bitmapUnscaledHeight = unscaledHeight;
@@ -556,15 +643,22 @@ bool YsfxGraphicsView::Impl::updateGfxTarget(int newWidth, int newHeight, int ne
 void YsfxGraphicsView::Impl::updateYsfxKeyModifiers()
 {
     juce::ModifierKeys mods = juce::ModifierKeys::getCurrentModifiers();
-    m_gfxInputState->m_ysfxMouseMods = translateModifiers(mods);
+    uint32_t ymods = translateModifiers(mods);
+    if (ymods != m_gfxInputState->m_ysfxMouseMods)
+        m_gfxPacing.m_inputPending = true;
+    m_gfxInputState->m_ysfxMouseMods = ymods;
 }
 
 void YsfxGraphicsView::Impl::updateYsfxMousePosition(const juce::MouseEvent &event)
 {
     juce::Point<int> off = getDisplayOffset();
     double bitmapScale = m_gfxTarget->m_bitmapScale;
-    m_gfxInputState->m_ysfxMouseX = juce::roundToInt((event.x - off.x) * bitmapScale);
-    m_gfxInputState->m_ysfxMouseY = juce::roundToInt((event.y - off.y) * bitmapScale);
+    int32_t x = juce::roundToInt((event.x - off.x) * bitmapScale);
+    int32_t y = juce::roundToInt((event.y - off.y) * bitmapScale);
+    if (x != m_gfxInputState->m_ysfxMouseX || y != m_gfxInputState->m_ysfxMouseY)
+        m_gfxPacing.m_inputPending = true;
+    m_gfxInputState->m_ysfxMouseX = x;
+    m_gfxInputState->m_ysfxMouseY = y;
 }
 
 void YsfxGraphicsView::Impl::updateYsfxMouseButtons(const juce::MouseEvent &event)
@@ -576,6 +670,8 @@ void YsfxGraphicsView::Impl::updateYsfxMouseButtons(const juce::MouseEvent &even
         buttons |= ysfx_button_middle;
     if (event.mods.isRightButtonDown())
         buttons |= ysfx_button_right;
+    if (buttons != m_gfxInputState->m_ysfxMouseButtons)
+        m_gfxPacing.m_inputPending = true;
     m_gfxInputState->m_ysfxMouseButtons = buttons;
 }
 
@@ -699,13 +795,18 @@ const char *YsfxGraphicsView::Impl::getYsfxDropFile(void *userdata, int32_t inde
 }
 
 //------------------------------------------------------------------------------
+YsfxGraphicsView::Impl::BackgroundWork::BackgroundWork()
+    : m_queue{new WorkerPool::Queue{*m_pool, WorkerPool::kLaneGfx}}
+{
+}
+
 void YsfxGraphicsView::Impl::BackgroundWork::start()
 {
     if (m_running)
         return;
 
     m_running = true;
-    m_thread = std::thread([this]() { run(); });
+    m_queue->open();
 }
 
 void YsfxGraphicsView::Impl::BackgroundWork::stop()
@@ -714,13 +815,7 @@ void YsfxGraphicsView::Impl::BackgroundWork::stop()
         return;
 
     m_running = false;
-    m_sema.post();
-
-    m_thread.join();
-
-    std::lock_guard<std::mutex> lock{m_messagesMutex};
-    while (!m_messages.empty())
-        m_messages.pop();
+    m_queue->close();
 }
 
 void YsfxGraphicsView::Impl::BackgroundWork::postMessage(std::shared_ptr<Message> message)
@@ -728,38 +823,18 @@ void YsfxGraphicsView::Impl::BackgroundWork::postMessage(std::shared_ptr<Message
     if (!m_running)
         return;
 
-    {
-        std::lock_guard<std::mutex> lock{m_messagesMutex};
-        m_messages.emplace(message);
-    }
-    m_sema.post();
+    m_queue->post([this, message]() { processMessage(*message); });
 }
 
-void YsfxGraphicsView::Impl::BackgroundWork::run()
+void YsfxGraphicsView::Impl::BackgroundWork::processMessage(Message &msg)
 {
-    while (m_sema.wait(), m_running) {
-        std::shared_ptr<Message> msg = popNextMessage();
-        jassert(msg);
-
-        switch (msg->m_type) {
-        case '@gfx':
-            processGfxMessage(static_cast<GfxMessage &>(*msg));
-            break;
-        }
+    switch (msg.m_type) {
+    case '@gfx':
+        processGfxMessage(static_cast<GfxMessage &>(msg));
+        break;
     }
 }
 
-std::shared_ptr<YsfxGraphicsView::Impl::BackgroundWork::Message> YsfxGraphicsView::Impl::BackgroundWork::popNextMessage()
-{
-    std::lock_guard<std::mutex> lock{m_messagesMutex};
-    if (m_messages.empty())
-        return nullptr;
-
-    std::shared_ptr<Message> msg = m_messages.front();
-    m_messages.pop();
-    return msg;
-}
-
 void YsfxGraphicsView::Impl::BackgroundWork::processGfxMessage(GfxMessage &msg)
 {
     ysfx_t *fx = msg.m_fx.get();
@@ -792,45 +867,72 @@ void YsfxGraphicsView::Impl::BackgroundWork::processGfxMessage(GfxMessage &msg)
         gc.get_drop_file = &getYsfxDropFile;
         ysfx_gfx_setup(fx, &gc);
 
-        // multiple @gfx cannot run concurrently on different threads (issue 44)
-        // FIXME: this workaround affects performance, actually fix this properly
-        static std::mutex globalGfxRunMutex;
-        std::lock_guard<std::mutex> gfxRunLock{globalGfxRunMutex};
-
+        double startMs = juce::Time::getMillisecondCounterHiRes();
         mustRepaint = ysfx_gfx_run(fx) || msg.m_dirty;
+        double runMs = juce::Time::getMillisecondCounterHiRes() - startMs;
+
+        std::lock_guard<std::mutex> lock{msg.m_asyncRepainter->m_mutex};
+        msg.m_asyncRepainter->m_runMs = runMs;
+    }
+
+    if (!mustRepaint) {
+        msg.m_asyncRepainter->triggerAsyncUpdate();
+        return;
     }
 
     ///
-    std::lock_guard<std::mutex> lock{msg.m_asyncRepainter->m_mutex};
+    ysfx_gfx_rect_t rects[ysfx_gfx_max_damage];
+    uint32_t numRects = msg.m_dirty ? 0 : ysfx_gfx_get_damage(fx, rects, ysfx_gfx_max_damage);
 
-    if (!mustRepaint)
-        msg.m_asyncRepainter->m_hasBitmapChanged = false;
-    else
-    {
-        juce::Image &imgsrc = target->m_renderBitmap;
-        juce::Image &imgdst = msg.m_asyncRepainter->m_bitmap;
+    juce::Image &back = target->m_renderBitmap;
+    juce::Rectangle<int> bounds = back.getBounds();
 
-        int w = imgsrc.getWidth();
-        int h = imgsrc.getHeight();
+    juce::RectangleList<int> damage;
+    for (uint32_t i = 0; i < numRects; ++i)
+        damage.add(juce::Rectangle<int>{(int)rects[i].x, (int)rects[i].y, (int)rects[i].w, (int)rects[i].h});
 
-        if (w != imgdst.getWidth() || h != imgdst.getHeight())
-            imgdst = juce::Image{juce::Image::ARGB, w, h, false};
+    bool fullDamage = msg.m_dirty || damage.containsRectangle(bounds);
+    juce::Image front;
 
-        juce::Image::BitmapData src{imgsrc, juce::Image::BitmapData::readOnly};
-        juce::Image::BitmapData dst{imgdst, juce::Image::BitmapData::writeOnly};
+    {
+        std::lock_guard<std::mutex> lock{msg.m_asyncRepainter->m_mutex};
 
-        if (src.lineStride == dst.lineStride) {
-            memcpy(dst.data, src.data, (size_t)(h * src.lineStride));
-        }
-        else {
-            for (int row = 0; row < h; ++row)
-                memcpy(dst.getLinePointer(row), src.getLinePointer(row), (size_t)(w * src.pixelStride));
-        }
+        // present the rendering by exchanging the buffers, without a copy
+        std::swap(msg.m_asyncRepainter->m_bitmap, back);
+        front = msg.m_asyncRepainter->m_bitmap;
+
+        if (fullDamage || front.getBounds() != back.getBounds())
+            msg.m_asyncRepainter->m_hasFullDamage = true;
+        else
+            msg.m_asyncRepainter->m_damage.add(damage);
 
         msg.m_asyncRepainter->m_hasBitmapChanged = true;
     }
 
     msg.m_asyncRepainter->triggerAsyncUpdate();
+
+    ///
+    // bring the new back buffer up to date, since the next @gfx draws over it;
+    // only the damage differs, unless the previous front was another size
+    // NOTE: the front buffer is read-only from now on, and safe to read concurrently
+    if (back.getBounds() != bounds) {
+        back = juce::Image{juce::Image::ARGB, bounds.getWidth(), bounds.getHeight(), false};
+        fullDamage = true;
+    }
+
+    if (fullDamage) {
+        damage.clear();
+        damage.add(bounds);
+    }
+
+    juce::Image::BitmapData src{front, juce::Image::BitmapData::readOnly};
+    juce::Image::BitmapData dst{back, juce::Image::BitmapData::writeOnly};
+
+    for (juce::Rectangle<int> r : damage) {
+        r = r.getIntersection(bounds);
+        for (int row = r.getY(); row < r.getBottom(); ++row)
+            memcpy(dst.getPixelPointer(r.getX(), row), src.getPixelPointer(r.getX(), row), (size_t)(r.getWidth() * src.pixelStride));
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -909,8 +1011,25 @@ void YsfxGraphicsView::Impl::filesDropped(const juce::StringArray &files, int x,
 void YsfxGraphicsView::Impl::handleAsyncUpdate(better::AsyncUpdater *updater)
 {
     if (updater == m_asyncRepainter.get()) {
-        if (m_asyncRepainter->m_hasBitmapChanged)
-            m_self->repaint();
+        std::lock_guard<std::mutex> lock{m_asyncRepainter->m_mutex};
+        double &averageRunMs = m_gfxPacing.m_averageRunMs;
+        averageRunMs += 0.25 * (m_asyncRepainter->m_runMs - averageRunMs);
+        if (m_asyncRepainter->m_hasBitmapChanged) {
+            if (m_asyncRepainter->m_hasFullDamage)
+                m_self->repaint();
+            else {
+                // convert the damage from bitmap pixels into the component
+                juce::Point<int> off = getDisplayOffset();
+                double scale = m_gfxTarget->m_bitmapScale;
+                for (const juce::Rectangle<int> &r : m_asyncRepainter->m_damage) {
+                    juce::Rectangle<float> area = r.toFloat() / (float)scale;
+                    m_self->repaint(area.getSmallestIntegerContainer() + off);
+                }
+            }
+            m_asyncRepainter->m_hasBitmapChanged = false;
+            m_asyncRepainter->m_hasFullDamage = false;
+            m_asyncRepainter->m_damage.clear();
+        }
         m_numWaitedRepaints -= 1;
     }
     else if (updater == m_asyncMouseCursor.get()) {
@@ -25,6 +25,8 @@ public:
     YsfxGraphicsView();
     ~YsfxGraphicsView() override;
     void setEffect(ysfx_t *fx);
+    // run @gfx up to `maxHz` while there are changes, and at `keepAliveHz` otherwise
+    void setFrameRates(int keepAliveHz, int maxHz);
 
 protected:
     void paint(juce::Graphics &g) override;
@@ -16,22 +16,18 @@
 //
 
 #include "parameters_panel.h"
+#include "../processor.h"
 #include "../parameter.h"
+#include <algorithm>
+#include <iterator>
 
-class YsfxParameterListener : private YsfxParameter::Listener,
-                          private juce::Timer {
+// a component which displays the value of a parameter; the panel tells it
+//   when to redisplay, instead of each one listening to its parameter
+class YsfxParameterComponent : public juce::Component {
 public:
-    explicit YsfxParameterListener(YsfxParameter &param)
+    explicit YsfxParameterComponent(YsfxParameter &param)
         : parameter(param)
     {
-        parameter.addListener(this);
-
-        startTimer(100);
-    }
-
-    ~YsfxParameterListener() override
-    {
-        parameter.removeListener(this);
     }
 
     YsfxParameter &getParameter() const noexcept
@@ -42,39 +38,16 @@ public:
     virtual void handleNewParameterValue() = 0;
 
 private:
-    //==============================================================================
-    void parameterValueChanged(int, float) override
-    {
-        parameterValueHasChanged = 1;
-    }
-
-    void parameterGestureChanged(int, bool) override
-    {
-    }
-
-    //==============================================================================
-    void timerCallback() override
-    {
-        if (parameterValueHasChanged.compareAndSetBool(0, 1)) {
-            handleNewParameterValue();
-            startTimerHz(50);
-        }
-        else {
-            startTimer(juce::jmin(250, getTimerInterval() + 10));
-        }
-    }
-
     YsfxParameter &parameter;
-    juce::Atomic<int> parameterValueHasChanged{0};
 
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(YsfxParameterListener)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(YsfxParameterComponent)
 };
 
 //==============================================================================
-class YsfxBooleanParameterComponent final : public juce::Component, private YsfxParameterListener {
+class YsfxBooleanParameterComponent final : public YsfxParameterComponent {
 public:
     explicit YsfxBooleanParameterComponent(YsfxParameter &param)
-        : YsfxParameterListener(param)
+        : YsfxParameterComponent(param)
     {
         // Set the initial value.
         handleNewParameterValue();
@@ -121,10 +94,10 @@ private:
 };
 
 //==============================================================================
-class YsfxSwitchParameterComponent final : public juce::Component, private YsfxParameterListener {
+class YsfxSwitchParameterComponent final : public YsfxParameterComponent {
 public:
     explicit YsfxSwitchParameterComponent(YsfxParameter &param)
-        : YsfxParameterListener(param)
+        : YsfxParameterComponent(param)
     {
         for (auto &button : buttons) {
             button.setRadioGroupId(293847);
@@ -193,10 +166,10 @@ private:
 };
 
 //==============================================================================
-class YsfxChoiceParameterComponent final : public juce::Component, private YsfxParameterListener {
+class YsfxChoiceParameterComponent final : public YsfxParameterComponent {
 public:
     explicit YsfxChoiceParameterComponent(YsfxParameter &param)
-        : YsfxParameterListener(param)
+        : YsfxParameterComponent(param)
     {
         int enumSize = (int)param.getSliderEnumSize();
         for (int i = 0; i < enumSize; ++i)
@@ -264,10 +237,10 @@ private:
 };
 
 //==============================================================================
-class YsfxSliderParameterComponent final : public juce::Component, private YsfxParameterListener {
+class YsfxSliderParameterComponent final : public YsfxParameterComponent {
 public:
     explicit YsfxSliderParameterComponent(YsfxParameter &param)
-        : YsfxParameterListener(param)
+        : YsfxParameterComponent(param)
     {
         ysfx_slider_range_t range = getParameter().getSliderRange();
 
@@ -376,6 +349,11 @@ public:
         setSize(400, 40);
     }
 
+    void handleNewParameterValue()
+    {
+        parameterComp->handleNewParameterValue();
+    }
+
     void paint(juce::Graphics &) override
     {
     }
@@ -392,9 +370,9 @@ public:
 private:
     YsfxParameter &parameter;
     juce::Label parameterName, parameterLabel;
-    std::unique_ptr<Component> parameterComp;
+    std::unique_ptr<YsfxParameterComponent> parameterComp;
 
-    std::unique_ptr<Component> createParameterComp() const
+    std::unique_ptr<YsfxParameterComponent> createParameterComp() const
     {
         ysfx_slider_range_t range = parameter.getSliderRange();
         bool isEnum = parameter.isEnumSlider();
@@ -418,8 +396,10 @@ private:
 };
 
 //==============================================================================
-YsfxParametersPanel::YsfxParametersPanel()
+YsfxParametersPanel::YsfxParametersPanel(YsfxProcessor &proc)
+    : processor(proc)
 {
+    startTimerHz(refreshRate);
 }
 
 YsfxParametersPanel::~YsfxParametersPanel()
@@ -430,12 +410,16 @@ YsfxParametersPanel::~YsfxParametersPanel()
 void YsfxParametersPanel::setParametersDisplayed(const juce::Array<YsfxParameter *> &parameters)
 {
     paramComponents.clear();
+    std::fill(std::begin(componentsBySlider), std::end(componentsBySlider), nullptr);
     setSize(0, 0);
 
-    for (auto *param : parameters)
-        if (param->isAutomatable())
-            addAndMakeVisible(paramComponents.add(
-                new YsfxParameterDisplayComponent(*param)));
+    for (auto *param : parameters) {
+        if (param->isAutomatable()) {
+            auto *comp = paramComponents.add(new YsfxParameterDisplayComponent(*param));
+            componentsBySlider[param->getSliderIndex()] = comp;
+            addAndMakeVisible(comp);
+        }
+    }
 
     int maxWidth = 800;
 
@@ -446,6 +430,12 @@ void YsfxParametersPanel::setParametersDisplayed(const juce::Array<YsfxParameter
     setSize(maxWidth, getRecommendedHeight());
 }
 
+void YsfxParametersPanel::setRefreshRate(int hz)
+{
+    refreshRate = juce::jmax(1, hz);
+    startTimerHz(refreshRate);
+}
+
 int YsfxParametersPanel::getRecommendedHeight(int heightAtLeast) const
 {
     int height = 0;
@@ -468,3 +458,16 @@ void YsfxParametersPanel::resized()
     for (auto *comp : paramComponents)
         comp->setBounds(area.removeFromTop(comp->getHeight()));
 }
+
+void YsfxParametersPanel::timerCallback()
+{
+    // redisplay only the sliders which changed since the last refresh
+    uint64_t changed = processor.fetchSliderDisplayChanges();
+
+    for (int i = 0; changed != 0; ++i, changed >>= 1) {
+        if (changed & 1) {
+            if (YsfxParameterDisplayComponent *comp = componentsBySlider[i])
+                comp->handleNewParameterValue();
+        }
+    }
+}
@@ -16,16 +16,20 @@
 //
 
 #pragma once
+#include "ysfx.h"
 #include <juce_audio_processors/juce_audio_processors.h>
+class YsfxProcessor;
 class YsfxParameter;
 class YsfxParameterDisplayComponent;
 
-class YsfxParametersPanel : public juce::Component {
+class YsfxParametersPanel : public juce::Component, private juce::Timer {
 public:
-    explicit YsfxParametersPanel();
+    explicit YsfxParametersPanel(YsfxProcessor &proc);
     ~YsfxParametersPanel() override;
 
     void setParametersDisplayed(const juce::Array<YsfxParameter *> &parameters);
+    // set the frequency at which the changed values are redisplayed
+    void setRefreshRate(int hz);
 
     int getRecommendedHeight(int heightAtLeast = 125) const;
 
@@ -34,7 +38,12 @@ protected:
     void resized() override;
 
 private:
+    void timerCallback() override;
+
+    YsfxProcessor &processor;
     juce::OwnedArray<YsfxParameterDisplayComponent> paramComponents;
+    YsfxParameterDisplayComponent *componentsBySlider[ysfx_max_sliders] = {};
+    int refreshRate = 30;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(YsfxParametersPanel)
 };
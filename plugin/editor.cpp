@@ -366,7 +366,7 @@ void YsfxEditor::Impl::createUI()
     m_centerViewPort.reset(new juce::Viewport);
     m_centerViewPort->setScrollBarsShown(true, false);
     m_self->addAndMakeVisible(*m_centerViewPort);
-    m_parametersPanel.reset(new YsfxParametersPanel);
+    m_parametersPanel.reset(new YsfxParametersPanel(*m_proc));
     m_graphicsView.reset(new YsfxGraphicsView);
     m_ideView.reset(new YsfxIDEView);
     m_ideView->setVisible(true);
@@ -28,64 +28,94 @@ YsfxParameter::YsfxParameter(ysfx_t *fx, int sliderIndex)
 
 void YsfxParameter::setEffect(ysfx_t *fx)
 {
-    if (m_fx.get() == fx)
+    MetadataPtr current = getMetadata();
+    if (current && current->fx.get() == fx)
         return;
 
-    m_fx.reset(fx);
+    std::shared_ptr<Metadata> metadata{new Metadata};
+    metadata->fx.reset(fx);
     if (fx)
         ysfx_add_ref(fx);
+
+    metadata->exists = ysfx_slider_exists(fx, (uint32_t)m_sliderIndex);
+    metadata->isEnum = ysfx_slider_is_enum(fx, (uint32_t)m_sliderIndex);
+    ysfx_slider_get_range(fx, (uint32_t)m_sliderIndex, &metadata->range);
+
+    std::atomic_store(&m_metadata, MetadataPtr{std::move(metadata)});
 }
 
 bool YsfxParameter::existsAsSlider() const
 {
-    return ysfx_slider_exists(m_fx.get(), (uint32_t)m_sliderIndex);
+    return getMetadata()->exists;
 }
 
 juce::CharPointer_UTF8 YsfxParameter::getSliderName() const
 {
-    return juce::CharPointer_UTF8{ysfx_slider_get_name(m_fx.get(), (uint32_t)m_sliderIndex)};
+    return juce::CharPointer_UTF8{ysfx_slider_get_name(getMetadata()->fx.get(), (uint32_t)m_sliderIndex)};
 }
 
 ysfx_slider_range_t YsfxParameter::getSliderRange() const
 {
-    ysfx_slider_range_t range{};
-    ysfx_slider_get_range(m_fx.get(), (uint32_t)m_sliderIndex, &range);
-    return range;
+    return getMetadata()->range;
 }
 
 bool YsfxParameter::isEnumSlider() const
 {
-    return ysfx_slider_is_enum(m_fx.get(), (uint32_t)m_sliderIndex);
+    return getMetadata()->isEnum;
 }
 
 int YsfxParameter::getSliderEnumSize() const
 {
-    return (int)ysfx_slider_get_enum_size(m_fx.get(), (uint32_t)m_sliderIndex);
+    return (int)ysfx_slider_get_enum_size(getMetadata()->fx.get(), (uint32_t)m_sliderIndex);
 }
 
 juce::CharPointer_UTF8 YsfxParameter::getSliderEnumName(int index) const
 {
-    return juce::CharPointer_UTF8{ysfx_slider_get_enum_name(m_fx.get(), (uint32_t)m_sliderIndex, (uint32_t)index)};
+    return juce::CharPointer_UTF8{ysfx_slider_get_enum_name(getMetadata()->fx.get(), (uint32_t)m_sliderIndex, (uint32_t)index)};
 }
 
 ysfx_real YsfxParameter::convertToYsfxValue(float normValue) const
 {
-    ysfx_slider_range_t range = getSliderRange();
+    MetadataPtr metadata = getMetadata();
+    return convertToYsfxValue(metadata->range, metadata->isEnum, normValue);
+}
+
+float YsfxParameter::convertFromYsfxValue(ysfx_real actualValue) const
+{
+    MetadataPtr metadata = getMetadata();
+    return convertFromYsfxValue(metadata->range, metadata->isEnum, actualValue);
+}
+
+ysfx_real YsfxParameter::convertToYsfxValue(ysfx_t *fx, uint32_t index, float normValue)
+{
+    ysfx_slider_range_t range{};
+    ysfx_slider_get_range(fx, index, &range);
+    return convertToYsfxValue(range, ysfx_slider_is_enum(fx, index), normValue);
+}
+
+float YsfxParameter::convertFromYsfxValue(ysfx_t *fx, uint32_t index, ysfx_real actualValue)
+{
+    ysfx_slider_range_t range{};
+    ysfx_slider_get_range(fx, index, &range);
+    return convertFromYsfxValue(range, ysfx_slider_is_enum(fx, index), actualValue);
+}
+
+ysfx_real YsfxParameter::convertToYsfxValue(const ysfx_slider_range_t &range, bool isEnum, float normValue)
+{
     ysfx_real actualValue = (ysfx_real)normValue * (range.max - range.min) + range.min;
     // NOTE: if enumerated, round the value to nearest,
     //    to make sure imprecision does not land us on the wrong index
-    if (isEnumSlider())
+    if (isEnum)
         actualValue = juce::roundToInt(actualValue);
     return actualValue;
 }
 
-float YsfxParameter::convertFromYsfxValue(ysfx_real actualValue) const
+float YsfxParameter::convertFromYsfxValue(const ysfx_slider_range_t &range, bool isEnum, ysfx_real actualValue)
 {
-    ysfx_slider_range_t range = getSliderRange();
     if (range.min == range.max)
         return 0.0f;
     // NOTE: if enumerated, round value into an index
-    if (isEnumSlider())
+    if (isEnum)
         actualValue = juce::roundToInt(actualValue);
     float normValue = (float)((actualValue - range.min) / (range.max - range.min));
     return normValue;
@@ -108,15 +138,18 @@ float YsfxParameter::getDefaultValue() const
 
 juce::String YsfxParameter::getText(float normalisedValue, int) const
 {
-    ysfx_slider_range_t range = getSliderRange();
+    // hold the metadata, so the effect lives while its names are read
+    MetadataPtr metadata = getMetadata();
+    ysfx_t *fx = metadata->fx.get();
+    const ysfx_slider_range_t &range = metadata->range;
     ysfx_real actualValue = (ysfx_real)normalisedValue * (range.max - range.min) + range.min;
-    if (isEnumSlider()) {
-        int enumSize = getSliderEnumSize();
+    if (metadata->isEnum) {
+        int enumSize = (int)ysfx_slider_get_enum_size(fx, (uint32_t)m_sliderIndex);
         // NOTE: if enumerated, round the value to nearest,
         //    to make sure imprecision does not land us on the wrong index
         int index = juce::roundToInt(actualValue);
         if (index >= 0 && index < enumSize)
-            return getSliderEnumName(index);
+            return juce::CharPointer_UTF8{ysfx_slider_get_enum_name(fx, (uint32_t)m_sliderIndex, (uint32_t)index)};
     }
 
     return juce::String(actualValue);
@@ -124,14 +157,16 @@ juce::String YsfxParameter::getText(float normalisedValue, int) const
 
 float YsfxParameter::getValueForText(const juce::String &text) const
 {
-    ysfx_slider_range_t range = getSliderRange();
+    MetadataPtr metadata = getMetadata();
+    ysfx_t *fx = metadata->fx.get();
+    const ysfx_slider_range_t &range = metadata->range;
     ysfx_real actualValue{};
 
     bool foundEnum = false;
-    if (isEnumSlider()) {
-        int enumSize = getSliderEnumSize();
+    if (metadata->isEnum) {
+        int enumSize = (int)ysfx_slider_get_enum_size(fx, (uint32_t)m_sliderIndex);
         for (int i = 0; !foundEnum && i < enumSize; ++i) {
-            foundEnum = text == getSliderEnumName(i);
+            foundEnum = text == juce::CharPointer_UTF8{ysfx_slider_get_enum_name(fx, (uint32_t)m_sliderIndex, (uint32_t)i)};
             if (foundEnum)
                 actualValue = i;
         }
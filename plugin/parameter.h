@@ -18,13 +18,15 @@
 #pragma once
 #include "ysfx.h"
 #include <juce_audio_processors/juce_audio_processors.h>
+#include <memory>
 
 class YsfxParameter final : public juce::RangedAudioParameter {
 public:
     explicit YsfxParameter(ysfx_t *fx, int sliderIndex);
     int getSliderIndex() const { return m_sliderIndex; }
+    // NOTE: not on the audio thread, which may drop the former metadata
     void setEffect(ysfx_t *fx);
-    ysfx_t *getEffect() const { return m_fx.get(); }
+    ysfx_t *getEffect() const { return getMetadata()->fx.get(); }
 
     bool existsAsSlider() const;
     juce::CharPointer_UTF8 getSliderName() const;
@@ -36,6 +38,10 @@ public:
     ysfx_real convertToYsfxValue(float normValue) const;
     float convertFromYsfxValue(ysfx_real actualValue) const;
 
+    // the conversions with the slider of the given effect, for the audio thread
+    static ysfx_real convertToYsfxValue(ysfx_t *fx, uint32_t index, float normValue);
+    static float convertFromYsfxValue(ysfx_t *fx, uint32_t index, ysfx_real actualValue);
+
     const juce::NormalisableRange<float> &getNormalisableRange() const override { return m_range; }
     float getValue() const override;
     void setValue(float newValue) override;
@@ -44,7 +50,20 @@ public:
     float getValueForText(const juce::String &text) const override;
 
 private:
-    ysfx_u m_fx;
+    // the slider metadata, immutable once the effect is set
+    struct Metadata {
+        ysfx_u fx;
+        bool exists = false;
+        bool isEnum = false;
+        ysfx_slider_range_t range{};
+    };
+    using MetadataPtr = std::shared_ptr<const Metadata>;
+
+    MetadataPtr getMetadata() const { return std::atomic_load(&m_metadata); }
+    static ysfx_real convertToYsfxValue(const ysfx_slider_range_t &range, bool isEnum, float normValue);
+    static float convertFromYsfxValue(const ysfx_slider_range_t &range, bool isEnum, ysfx_real actualValue);
+
+    MetadataPtr m_metadata;
     int m_sliderIndex = 0;
     float m_value = 0.0f;
     const juce::NormalisableRange<float> m_range{0.0f, 1.0f};
@@ -22,11 +22,69 @@
 #include "utility/audio_processor_suspender.h"
 #include "utility/rt_semaphore.h"
 #include "utility/sync_bitset.hpp"
+#include "utility/worker_pool.h"
 #include "ysfx.h"
 #include <atomic>
-#include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <algorithm>
+
+// the plugin state chunk, which the older `ysfx` value trees are distinguished from
+static const char stateChunkMagic[4] = {'Y', 'S', 'F', 'X'};
+static constexpr int stateChunkVersion = 2;
+static constexpr int stateChunkCompressionNone = 0;
+
+// the fade into a new preset, which only smooths the junction: its source is
+//   the history extended in reverse, not a continuation of the former preset
+static constexpr double presetCrossfadeTime = 0.002;
+
+// fade the destination in from the source, where this block starts at the
+//   given position of the fade; past the end of the fade, keep the destination
+template <class Real>
+static void crossfadeOutputs(const Real *const *source, Real *const *dest, uint32_t numChannels, uint32_t numFrames, uint32_t position, uint32_t length)
+{
+    if (position >= length)
+        return;
+    uint32_t fadeFrames = juce::jmin(numFrames, length - position);
+    Real step = (Real)1 / (Real)(length + 1);
+    for (uint32_t c = 0; c < numChannels; ++c) {
+        const Real *src = source[c];
+        Real *dst = dest[c];
+        for (uint32_t i = 0; i < fadeFrames; ++i) {
+            Real gain = (Real)(position + i + 1) * step;
+            dst[i] = src[i] + gain * (dst[i] - src[i]);
+        }
+    }
+}
+
+// write the block at the given position of the ring buffer of the history
+template <class Real>
+static void recordOutputs(const Real *const *source, Real *const *history, uint32_t numChannels, uint32_t numFrames, uint32_t position, uint32_t capacity)
+{
+    for (uint32_t c = 0; c < numChannels; ++c) {
+        const Real *src = source[c];
+        Real *hist = history[c];
+        for (uint32_t i = 0, j = position; i < numFrames; ++i) {
+            hist[j] = src[i];
+            j = (j + 1 < capacity) ? (j + 1) : 0;
+        }
+    }
+}
+
+// continue the history past its end, mirrored in time, so that it joins the
+//   latest output without a discontinuity; the count must be within capacity
+template <class Real>
+static void mirrorOutputs(const Real *const *history, Real *const *dest, uint32_t numChannels, uint32_t numFrames, uint32_t position, uint32_t capacity)
+{
+    for (uint32_t c = 0; c < numChannels; ++c) {
+        const Real *hist = history[c];
+        Real *dst = dest[c];
+        for (uint32_t i = 0, j = position; i < numFrames; ++i) {
+            j = (j > 0) ? (j - 1) : (capacity - 1);
+            dst[i] = hist[j];
+        }
+    }
+}
 
 struct YsfxProcessor::Impl : public juce::AudioProcessorListener {
     YsfxProcessor *m_self = nullptr;
@@ -34,11 +92,23 @@ struct YsfxProcessor::Impl : public juce::AudioProcessorListener {
     ysfx_time_info_t m_timeInfo{};
     int m_sliderParamOffset = 0;
     ysfx::sync_bitset64 m_sliderParametersChanged;
+    // the sliders whose values the editor has yet to redisplay
+    ysfx::sync_bitset64 m_sliderParamsToDisplay;
     YsfxInfo::Ptr m_info{new YsfxInfo};
 
     //==========================================================================
     void processBlockGenerically(const void *inputs[], void *outputs[], uint32_t numIns, uint32_t numOuts, uint32_t numFrames, uint32_t processBits, juce::MidiBuffer &midiMessages);
-    void processMidiInput(juce::MidiBuffer &midi);
+    void processCycle(ysfx_t *fx, const void *inputs[], void *outputs[], uint32_t numIns, uint32_t numOuts, uint32_t numFrames, uint32_t processBits);
+    uint32_t processStagedPreset(uint32_t numIns, uint32_t numOuts, uint32_t numFrames, uint32_t processBits);
+    void processStagedEffect();
+    bool processFadingEffect(const void *inputs[], uint32_t numIns, uint32_t numOuts, uint32_t numFrames, uint32_t processBits, juce::MidiBuffer &midiMessages);
+    void processCrossfade(void *outputs[], uint32_t numOuts, uint32_t numFrames, uint32_t processBits, uint32_t position, uint32_t length);
+    void renderForCrossfade(ysfx_t *fx, const void *inputs[], uint32_t numIns, uint32_t numOuts, uint32_t numFrames, uint32_t processBits);
+    void recordForCrossfade(void *outputs[], uint32_t numOuts, uint32_t numFrames, uint32_t processBits);
+    void mirrorForCrossfade(uint32_t numOuts, uint32_t numFrames, uint32_t processBits);
+    bool canCrossfade(uint32_t numIns, uint32_t numOuts, uint32_t numFrames) const;
+    void retireFadingEffect();
+    void processMidiInput(ysfx_t *fx, juce::MidiBuffer &midi);
     void processMidiOutput(juce::MidiBuffer &midi);
     void processSliderChanges();
     void processLatency();
@@ -47,14 +117,24 @@ struct YsfxProcessor::Impl : public juce::AudioProcessorListener {
     void syncSlidersToParameters(bool notify);
     void syncParameterToSlider(int index);
     void syncSliderToParameter(int index, bool notify);
-    static YsfxInfo::Ptr createNewFx(juce::CharPointer_UTF8 filePath, ysfx_state_t *initialState);
+    static YsfxInfo::Ptr createNewFx(juce::CharPointer_UTF8 filePath, ysfx_state_t *initialState, double sampleRate, int blockSize);
+    void reconfigureNewFx(ysfx_t *fx, ysfx_state_t *initialState);
     void installNewFx(YsfxInfo::Ptr info);
-    void loadNewPreset(const ysfx_preset_t &preset);
+    bool stageNewFx(ysfx_t *fx);
+    void loadNewPreset(ysfx_state_t *state);
+    bool captureState(ysfx_u &fx, ysfx_state_u &state);
+    bool stagePreset(ysfx_state_t *state);
+    uint32_t getAudioResponseTimeout() const;
+    void prepareCrossfade(uint32_t numChannels, uint32_t numFrames, double sampleRate);
+    void processStateCapture();
+    void clearOutputs(void *outputs[], uint32_t numOuts, uint32_t numFrames, uint32_t processBits);
 
     //==========================================================================
     struct LoadRequest : public std::enable_shared_from_this<LoadRequest> {
         juce::String filePath;
         ysfx_state_u initialState;
+        // the chunk which this load restores, if it comes from the host
+        juce::MemoryBlock stateChunk;
         volatile bool completion = false;
         std::mutex completionMutex;
         std::condition_variable completionVariable;
@@ -72,6 +152,76 @@ struct YsfxProcessor::Impl : public juce::AudioProcessorListener {
 
     LoadRequest::Ptr m_loadRequest;
     PresetRequest::Ptr m_presetRequest;
+
+    void postLoadRequest(LoadRequest::Ptr loadRequest);
+    bool decodeStateChunk(const uint8_t *data, size_t size, LoadRequest &req);
+    bool decodeLegacyStateChunk(const void *data, size_t size, LoadRequest &req);
+
+    // the latest load, until its effect is installed; while it restores a
+    //   state, the output is muted, and the host gets this state if it asks
+    LoadRequest::Ptr m_pendingLoad;
+    std::atomic<bool> m_muted{false};
+
+    //==========================================================================
+    // the state, saved by the audio thread at the start of a block;
+    //   the effect is retained along, for it to stay consistent with the state;
+    //   the audio thread saves into a buffer which the requester allocates,
+    //   and which the requester grows before asking again, if it was too small
+    struct StateCapture {
+        std::mutex requestMutex;
+        std::atomic<bool> requested{false};
+        RTSemaphore completion;
+        ysfx_u effect;
+        ysfx_state_u buffer;
+        size_t capacity = 0;
+        bool saved = false;
+    };
+
+    StateCapture m_stateCapture;
+    std::atomic<bool> m_prepared{false};
+
+    //==========================================================================
+    // a preset, which the audio thread applies at the start of a block
+    struct PresetStaging {
+        std::atomic<ysfx_state_t *> state{nullptr};
+        RTSemaphore completion;
+    };
+
+    PresetStaging m_presetStaging;
+
+    // a new effect, which the audio thread swaps in at the start of a block
+    struct EffectStaging {
+        std::atomic<ysfx_t *> effect{nullptr};
+        RTSemaphore completion;
+    };
+
+    EffectStaging m_effectStaging;
+
+    // the former effect, which the background releases after it faded out
+    std::atomic<ysfx_t *> m_retiredFx{nullptr};
+
+    // the output before a change, which the new output fades in from
+    struct Crossfade {
+        uint32_t presetFrames = 0;
+        std::atomic<uint32_t> effectFrames{0};
+        ysfx_u fadingFx;
+        uint32_t effectPosition = 0;
+        uint32_t effectLength = 0;
+        uint32_t maxChannels = 0;
+        uint32_t maxFrames = 0;
+        std::unique_ptr<double[]> inputData;
+        std::unique_ptr<double[]> outputData;
+        std::unique_ptr<void *[]> inputs;
+        std::unique_ptr<void *[]> outputs;
+        // the latest output, which the preset changes fade out from
+        std::unique_ptr<double[]> historyData;
+        std::unique_ptr<void *[]> history;
+        uint32_t historyPosition = 0;
+    };
+
+    Crossfade m_crossfade;
+    std::atomic<double> m_effectCrossfadeTime{0.05};
+
     ysfx::sync_bitset64 m_sliderParamsToNotify;
 
     //==========================================================================
@@ -91,20 +241,26 @@ struct YsfxProcessor::Impl : public juce::AudioProcessorListener {
     std::unique_ptr<SliderNotificationUpdater> m_sliderNotificationUpdater;
 
     //==========================================================================
+    // The background work, which runs on queues of the shared worker pool.
     class Background {
     public:
         explicit Background(Impl *impl);
         void shutdown();
         void wakeUp();
+        void postLoadRequest();
+        void postPresetRequest();
     private:
-        void run();
+        void processNotifications();
         void processSliderNotifications(uint64_t sliderMask);
         void processLoadRequest(LoadRequest &req);
         void processPresetRequest(PresetRequest &req);
         Impl *m_impl = nullptr;
-        RTSemaphore m_sema;
-        std::atomic<bool> m_running{};
-        std::thread m_thread;
+        juce::SharedResourcePointer<WorkerPool> m_pool;
+        std::unique_ptr<WorkerPool::Queue> m_notificationQueue;
+        std::unique_ptr<WorkerPool::Queue> m_loadQueue;
+        std::unique_ptr<WorkerPool::Queue> m_presetQueue;
+        // loads and presets are on separate queues, they must not overlap
+        std::mutex m_installMutex;
     };
 
     std::unique_ptr<Background> m_background;
@@ -163,6 +319,14 @@ YsfxProcessor::~YsfxProcessor()
 
     ///
     m_impl->m_background->shutdown();
+
+    ysfx_free(m_impl->m_effectStaging.effect.exchange(nullptr));
+    ysfx_free(m_impl->m_retiredFx.exchange(nullptr));
+}
+
+uint64_t YsfxProcessor::fetchSliderDisplayChanges()
+{
+    return m_impl->m_sliderParamsToDisplay.exchange(0);
 }
 
 YsfxParameter *YsfxProcessor::getYsfxParameter(int sliderIndex)
@@ -179,8 +343,7 @@ void YsfxProcessor::loadJsfxFile(const juce::String &filePath, ysfx_state_t *ini
     Impl::LoadRequest::Ptr loadRequest{new Impl::LoadRequest};
     loadRequest->filePath = filePath;
     loadRequest->initialState.reset(ysfx_state_dup(initialState));
-    std::atomic_store(&m_impl->m_loadRequest, loadRequest);
-    m_impl->m_background->wakeUp();
+    m_impl->postLoadRequest(loadRequest);
     if (!async) {
         std::unique_lock<std::mutex> lock(loadRequest->completionMutex);
         loadRequest->completionVariable.wait(lock, [&]() { return loadRequest->completion; });
@@ -192,14 +355,28 @@ void YsfxProcessor::loadJsfxPreset(YsfxInfo::Ptr info, uint32_t index, bool asyn
     Impl::PresetRequest::Ptr presetRequest{new Impl::PresetRequest};
     presetRequest->info = info;
     presetRequest->index = index;
-    std::atomic_store(&m_impl->m_presetRequest, presetRequest);
-    m_impl->m_background->wakeUp();
+
+    // a request which is replaced never gets processed, release its requester
+    if (Impl::PresetRequest::Ptr previous = std::atomic_exchange(&m_impl->m_presetRequest, presetRequest)) {
+        std::lock_guard<std::mutex> lock(previous->completionMutex);
+        previous->completion = true;
+        previous->completionVariable.notify_one();
+    }
+
+    m_impl->m_background->postPresetRequest();
     if (!async) {
         std::unique_lock<std::mutex> lock(presetRequest->completionMutex);
         presetRequest->completionVariable.wait(lock, [&]() { return presetRequest->completion; });
     }
 }
 
+void YsfxProcessor::setEffectCrossfadeTime(double seconds)
+{
+    seconds = juce::jmax(0.0, seconds);
+    m_impl->m_effectCrossfadeTime.store(seconds);
+    m_impl->m_crossfade.effectFrames.store((uint32_t)juce::roundToInt(seconds * getSampleRate()));
+}
+
 YsfxInfo::Ptr YsfxProcessor::getCurrentInfo()
 {
     return std::atomic_load(&m_impl->m_info);
@@ -218,14 +395,25 @@ void YsfxProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
     ysfx_init(fx);
 
     m_impl->processLatency();
+
+    // a fade which is in progress does not survive the reconfiguration
+    m_impl->m_crossfade.fadingFx.reset();
+
+    uint32_t numChannels = (uint32_t)juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels());
+    m_impl->prepareCrossfade(numChannels, (uint32_t)samplesPerBlock, sampleRate);
+
+    m_impl->m_prepared.store(true);
 }
 
 void YsfxProcessor::releaseResources()
 {
+    m_impl->m_prepared.store(false);
 }
 
 void YsfxProcessor::Impl::processBlockGenerically(const void *inputs[], void *outputs[], uint32_t numIns, uint32_t numOuts, uint32_t numFrames, uint32_t processBits, juce::MidiBuffer &midiMessages)
 {
+    processStagedEffect();
+
     ysfx_t *fx = m_fx.get();
 
     uint64_t sliderParametersChanged = m_sliderParametersChanged.exchange(0);
@@ -236,11 +424,50 @@ void YsfxProcessor::Impl::processBlockGenerically(const void *inputs[], void *ou
         }
     }
 
+    processStateCapture();
+
+    // a restored state is still loading, stay silent until it's installed
+    if (m_muted.load(std::memory_order_relaxed)) {
+        clearOutputs(outputs, numOuts, numFrames, processBits);
+        recordForCrossfade(outputs, numOuts, numFrames, processBits);
+        midiMessages.clear();
+        return;
+    }
+
     updateTimeInfo();
     ysfx_set_time_info(fx, &m_timeInfo);
 
-    processMidiInput(midiMessages);
+    processMidiInput(fx, midiMessages);
+
+    // a change of effect fades over several blocks, during which the presets
+    //   are applied without their own fade
+    if (processFadingEffect(inputs, numIns, numOuts, numFrames, processBits, midiMessages)) {
+        processStagedPreset(numIns, numOuts, numFrames, processBits);
+        processCycle(fx, inputs, outputs, numIns, numOuts, numFrames, processBits);
+
+        Crossfade &xf = m_crossfade;
+        processCrossfade(outputs, numOuts, numFrames, processBits, xf.effectPosition, xf.effectLength);
+        xf.effectPosition += numFrames;
+        if (xf.effectPosition >= xf.effectLength)
+            retireFadingEffect();
+    }
+    else {
+        uint32_t fadeFrames = processStagedPreset(numIns, numOuts, numFrames, processBits);
+        processCycle(fx, inputs, outputs, numIns, numOuts, numFrames, processBits);
+        // the fade of a preset completes within the block, as far as its source reaches
+        if (fadeFrames > 0)
+            processCrossfade(outputs, numOuts, numFrames, processBits, 0, fadeFrames);
+    }
+
+    recordForCrossfade(outputs, numOuts, numFrames, processBits);
 
+    processMidiOutput(midiMessages);
+    processSliderChanges();
+    processLatency();
+}
+
+void YsfxProcessor::Impl::processCycle(ysfx_t *fx, const void *inputs[], void *outputs[], uint32_t numIns, uint32_t numOuts, uint32_t numFrames, uint32_t processBits)
+{
     switch (processBits) {
     case 32:
         ysfx_process_float(fx, (const float **)inputs, (float **)outputs, numIns, numOuts, numFrames);
@@ -251,10 +478,138 @@ void YsfxProcessor::Impl::processBlockGenerically(const void *inputs[], void *ou
     default:
         jassertfalse;
     }
+}
 
-    processMidiOutput(midiMessages);
-    processSliderChanges();
-    processLatency();
+uint32_t YsfxProcessor::Impl::processStagedPreset(uint32_t numIns, uint32_t numOuts, uint32_t numFrames, uint32_t processBits)
+{
+    ysfx_state_t *state = m_presetStaging.state.exchange(nullptr);
+    if (!state)
+        return 0;
+
+    ysfx_t *fx = m_fx.get();
+
+    // fade out of the output of the former preset, extended from the history,
+    //   because rendering this block with it would advance the effect twice
+    uint32_t fadeFrames = 0;
+    if (!m_crossfade.fadingFx && canCrossfade(numIns, numOuts, numFrames))
+        fadeFrames = juce::jmin(numFrames, m_crossfade.presetFrames);
+    if (fadeFrames > 0)
+        mirrorForCrossfade(numOuts, fadeFrames, processBits);
+
+    ysfx_load_state_realtime(fx, state);
+
+    bool notify = false;
+    syncSlidersToParameters(notify);
+    m_sliderParamsToNotify.store(~(uint64_t)0);
+    m_background->wakeUp();
+
+    // the requester owns the state, and it can release it now
+    m_presetStaging.completion.post();
+    return fadeFrames;
+}
+
+void YsfxProcessor::Impl::processStagedEffect()
+{
+    Crossfade &xf = m_crossfade;
+
+    // wait until the previous change of effect is over
+    if (xf.fadingFx || m_retiredFx.load() != nullptr)
+        return;
+
+    ysfx_t *fx = m_effectStaging.effect.exchange(nullptr);
+    if (!fx)
+        return;
+
+    // NOTE: the former effect is kept referenced, so that nothing is freed here
+    xf.fadingFx = std::move(m_fx);
+    m_fx.reset(fx);
+
+    // NOTE: the parameters get the metadata of the new effect from the
+    //   requester, because replacing it here could free the former one
+    bool notify = false;
+    syncSlidersToParameters(notify);
+    m_sliderParamsToNotify.store(~(uint64_t)0);
+    m_background->wakeUp();
+
+    // do not fade in from the effect which was there before a restore
+    xf.effectPosition = 0;
+    xf.effectLength = m_muted.load(std::memory_order_relaxed) ? 0 : xf.effectFrames.load(std::memory_order_relaxed);
+    if (xf.effectLength == 0)
+        retireFadingEffect();
+
+    m_effectStaging.completion.post();
+}
+
+bool YsfxProcessor::Impl::processFadingEffect(const void *inputs[], uint32_t numIns, uint32_t numOuts, uint32_t numFrames, uint32_t processBits, juce::MidiBuffer &midiMessages)
+{
+    Crossfade &xf = m_crossfade;
+    ysfx_t *fx = xf.fadingFx.get();
+    if (!fx)
+        return false;
+
+    if (!canCrossfade(numIns, numOuts, numFrames)) {
+        retireFadingEffect();
+        return false;
+    }
+
+    ysfx_set_time_info(fx, &m_timeInfo);
+    processMidiInput(fx, midiMessages);
+    renderForCrossfade(fx, inputs, numIns, numOuts, numFrames, processBits);
+    return true;
+}
+
+void YsfxProcessor::Impl::processCrossfade(void *outputs[], uint32_t numOuts, uint32_t numFrames, uint32_t processBits, uint32_t position, uint32_t length)
+{
+    if (processBits == 32)
+        crossfadeOutputs((const float *const *)m_crossfade.outputs.get(), (float *const *)outputs, numOuts, numFrames, position, length);
+    else
+        crossfadeOutputs((const double *const *)m_crossfade.outputs.get(), (double *const *)outputs, numOuts, numFrames, position, length);
+}
+
+void YsfxProcessor::Impl::renderForCrossfade(ysfx_t *fx, const void *inputs[], uint32_t numIns, uint32_t numOuts, uint32_t numFrames, uint32_t processBits)
+{
+    // the inputs are copied, because the outputs may be the same buffers
+    size_t frameSize = processBits / 8;
+    for (uint32_t i = 0; i < numIns; ++i)
+        memcpy(m_crossfade.inputs[i], inputs[i], numFrames * frameSize);
+    processCycle(fx, (const void **)m_crossfade.inputs.get(), m_crossfade.outputs.get(), numIns, numOuts, numFrames, processBits);
+
+    // drop the MIDI output of what is faded out
+    ysfx_midi_event_t event;
+    while (ysfx_receive_midi(fx, &event)) {}
+}
+
+void YsfxProcessor::Impl::recordForCrossfade(void *outputs[], uint32_t numOuts, uint32_t numFrames, uint32_t processBits)
+{
+    Crossfade &xf = m_crossfade;
+    if (numFrames == 0 || !canCrossfade(0, numOuts, numFrames))
+        return;
+
+    if (processBits == 32)
+        recordOutputs((const float *const *)outputs, (float *const *)xf.history.get(), numOuts, numFrames, xf.historyPosition, xf.maxFrames);
+    else
+        recordOutputs((const double *const *)outputs, (double *const *)xf.history.get(), numOuts, numFrames, xf.historyPosition, xf.maxFrames);
+    xf.historyPosition = (uint32_t)(((uint64_t)xf.historyPosition + numFrames) % xf.maxFrames);
+}
+
+void YsfxProcessor::Impl::mirrorForCrossfade(uint32_t numOuts, uint32_t numFrames, uint32_t processBits)
+{
+    Crossfade &xf = m_crossfade;
+    if (processBits == 32)
+        mirrorOutputs((const float *const *)xf.history.get(), (float *const *)xf.outputs.get(), numOuts, numFrames, xf.historyPosition, xf.maxFrames);
+    else
+        mirrorOutputs((const double *const *)xf.history.get(), (double *const *)xf.outputs.get(), numOuts, numFrames, xf.historyPosition, xf.maxFrames);
+}
+
+bool YsfxProcessor::Impl::canCrossfade(uint32_t numIns, uint32_t numOuts, uint32_t numFrames) const
+{
+    return juce::jmax(numIns, numOuts) <= m_crossfade.maxChannels && numFrames <= m_crossfade.maxFrames;
+}
+
+void YsfxProcessor::Impl::retireFadingEffect()
+{
+    m_retiredFx.store(m_crossfade.fadingFx.release());
+    m_background->wakeUp();
 }
 
 void YsfxProcessor::processBlock(juce::AudioBuffer<float> &buffer, juce::MidiBuffer &midiMessages)
@@ -354,51 +709,109 @@ void YsfxProcessor::changeProgramName(int index, const juce::String &newName)
 //==============================================================================
 void YsfxProcessor::getStateInformation(juce::MemoryBlock &destData)
 {
+    // a restore is in progress, give back what the host gave us
+    Impl::LoadRequest::Ptr pendingLoad = std::atomic_load(&m_impl->m_pendingLoad);
+    if (pendingLoad && pendingLoad->stateChunk.getSize() > 0) {
+        destData = pendingLoad->stateChunk;
+        return;
+    }
+
     juce::File path;
+    ysfx_u fx;
     ysfx_state_u state;
 
-    {
+    // if the audio is not running, we must stop callbacks to save
+    if (!m_impl->captureState(fx, state)) {
         AudioProcessorSuspender sus(*this);
         sus.lockCallbacks();
-        ysfx_t *fx = m_impl->m_fx.get();
-        path = juce::CharPointer_UTF8(ysfx_get_file_path(fx));
-        state.reset(ysfx_save_state(fx));
+        fx.reset(m_impl->m_fx.get());
+        ysfx_add_ref(fx.get());
+        state.reset(ysfx_save_state(fx.get()));
     }
 
-    juce::ValueTree root("ysfx");
-    root.setProperty("version", 1, nullptr);
-    root.setProperty("path", path.getFullPathName(), nullptr);
+    path = juce::CharPointer_UTF8(ysfx_get_file_path(fx.get()));
+
+    // the chunk is a binary header, followed by the encoded ysfx state
+    size_t encodedSize = state ? ysfx_state_encode(state.get(), nullptr, 0) : 0;
+
+    {
+        juce::MemoryOutputStream stream(destData, false);
+        stream.write(stateChunkMagic, 4);
+        stream.writeInt(stateChunkVersion);
+        stream.writeInt(stateChunkCompressionNone);
+        juce::String pathName = path.getFullPathName();
+        stream.writeInt((int)pathName.getNumBytesAsUTF8());
+        stream.write(pathName.toRawUTF8(), pathName.getNumBytesAsUTF8());
+        stream.writeInt64(state ? (juce::int64)encodedSize : -1);
+    }
 
+    // encode directly into the chunk, after the header
     if (state) {
-        juce::ValueTree stateTree("state");
+        size_t offset = destData.getSize();
+        destData.setSize(offset + encodedSize);
+        ysfx_state_encode(state.get(), (uint8_t *)destData.getData() + offset, encodedSize);
+    }
+}
+
+void YsfxProcessor::setStateInformation(const void *data, int sizeInBytes)
+{
+    Impl::LoadRequest::Ptr loadRequest{new Impl::LoadRequest};
+
+    bool decoded;
+    if (sizeInBytes >= 4 && memcmp(data, stateChunkMagic, 4) == 0)
+        decoded = m_impl->decodeStateChunk((const uint8_t *)data, (size_t)sizeInBytes, *loadRequest);
+    else
+        decoded = m_impl->decodeLegacyStateChunk(data, (size_t)sizeInBytes, *loadRequest);
+    if (!decoded)
+        return;
 
-        juce::ValueTree sliderTree("sliders");
-        for (uint32_t i = 0; i < state->slider_count; ++i)
-            sliderTree.setProperty(juce::String(state->sliders[i].index), state->sliders[i].value, nullptr);
-        stateTree.addChild(sliderTree, -1, nullptr);
+    // do not wait for the load: when a project opens, the instances are
+    //   restored one after another, and this lets them load in parallel
+    loadRequest->stateChunk.replaceAll(data, (size_t)sizeInBytes);
+    m_impl->postLoadRequest(loadRequest);
+}
 
-        stateTree.setProperty("data", juce::Base64::toBase64(state->data, state->data_size), nullptr);
+bool YsfxProcessor::Impl::decodeStateChunk(const uint8_t *data, size_t size, LoadRequest &req)
+{
+    juce::MemoryInputStream stream(data, size, false);
+    stream.skipNextBytes(4);
 
-        root.addChild(stateTree, -1, nullptr);
-    }
+    if (stream.readInt() != stateChunkVersion)
+        return false;
+    //NOTE: no compression method is implemented so far
+    if (stream.readInt() != stateChunkCompressionNone)
+        return false;
 
-    juce::MemoryOutputStream stream(destData, false);
-    root.writeToStream(stream);
+    int pathSize = stream.readInt();
+    if (pathSize < 0 || pathSize > stream.getNumBytesRemaining())
+        return false;
+    req.filePath = juce::String::fromUTF8((const char *)data + stream.getPosition(), pathSize);
+    stream.skipNextBytes(pathSize);
+
+    juce::int64 encodedSize = stream.readInt64();
+    if (encodedSize < 0)
+        return true;
+    if (encodedSize > stream.getNumBytesRemaining())
+        return false;
+
+    req.initialState.reset(ysfx_state_decode(data + stream.getPosition(), (size_t)encodedSize));
+    return req.initialState != nullptr;
 }
 
-void YsfxProcessor::setStateInformation(const void *data, int sizeInBytes)
+bool YsfxProcessor::Impl::decodeLegacyStateChunk(const void *data, size_t size, LoadRequest &req)
 {
     juce::File path;
 
-    juce::MemoryInputStream stream(data, (size_t)sizeInBytes, false);
+    juce::MemoryInputStream stream(data, size, false);
     juce::ValueTree root = juce::ValueTree::readFromStream(stream);
 
     if (root.getType().getCharPointer().compare(juce::CharPointer_UTF8("ysfx")) != 0)
-        return;
+        return false;
     if ((int)root.getProperty("version") != 1)
-        return;
+        return false;
 
     path = root.getProperty("path").toString();
+    req.filePath = path.getFullPathName();
 
     juce::ValueTree stateTree = root.getChildWithName("state");
     if (stateTree != juce::ValueTree{}) {
@@ -426,11 +839,10 @@ void YsfxProcessor::setStateInformation(const void *data, int sizeInBytes)
         state.slider_count = (uint32_t)sliders.size();
         state.data = (uint8_t *)dataBlock.getData();
         state.data_size = dataBlock.getSize();
-        loadJsfxFile(path.getFullPathName(), &state, false);
-    }
-    else {
-        loadJsfxFile(path.getFullPathName(), nullptr, false);
+        req.initialState.reset(ysfx_state_dup(&state));
     }
+
+    return true;
 }
 
 //==============================================================================
@@ -446,10 +858,8 @@ bool YsfxProcessor::isBusesLayoutSupported(const BusesLayout &layout) const
 }
 
 //==============================================================================
-void YsfxProcessor::Impl::processMidiInput(juce::MidiBuffer &midi)
+void YsfxProcessor::Impl::processMidiInput(ysfx_t *fx, juce::MidiBuffer &midi)
 {
-    ysfx_t *fx = m_fx.get();
-
     for (juce::MidiMessageMetadata md : midi) {
         ysfx_midi_event_t event{};
         event.offset = (uint32_t)md.samplePosition;
@@ -473,39 +883,31 @@ void YsfxProcessor::Impl::processSliderChanges()
 {
     ysfx_t *fx = m_fx.get();
 
-    if ((0)) {
-        // this automates according to ysfx change bits (eg. sliderchange)
-        uint64_t changed = ysfx_fetch_slider_changes(fx);
-        uint64_t automated = ysfx_fetch_slider_automations(fx);
-
-        if (changed|automated) {
-            //NOTE: it should avoid recording an automation point in case of
-            //  `changed` only, but I don't know how to implement this
-            m_sliderParamsToNotify.fetch_or(changed|automated);
-            m_background->wakeUp();
-        }
-    }
-    else {
-        // this automates whenever we detect a value change
-        // it seems that Reaper acts like this (?)
-        uint64_t changed = 0;
-
-        for (int i = 0; i < ysfx_max_sliders; ++i) {
-            YsfxParameter *param = m_self->getYsfxParameter(i);
-            if (param->existsAsSlider()) {
-                float normValue = param->convertFromYsfxValue(ysfx_slider_get_value(fx, (uint32_t)i));
-                if (param->getValue() != normValue) {
-                    param->setValue(normValue);
-                    changed |= uint64_t{1} << i;
-                }
+    // the sliders which the effect has changed, either by detection of the
+    //   value, or explicitly (eg. sliderchange, slider_automate)
+    uint64_t dirty = ysfx_fetch_slider_changes(fx) | ysfx_fetch_slider_automations(fx);
+
+    // this automates whenever a value changes
+    // it seems that Reaper acts like this (?)
+    uint64_t changed = 0;
+
+    for (int i = 0; dirty != 0; ++i, dirty >>= 1) {
+        if (!(dirty & 1))
+            continue;
+        YsfxParameter *param = m_self->getYsfxParameter(i);
+        if (ysfx_slider_exists(fx, (uint32_t)i)) {
+            float normValue = YsfxParameter::convertFromYsfxValue(fx, (uint32_t)i, ysfx_slider_get_value(fx, (uint32_t)i));
+            if (param->getValue() != normValue) {
+                param->setValue(normValue);
+                changed |= uint64_t{1} << i;
             }
         }
+    }
 
-        // this will sync parameters later (on message thread)
-        if (changed) {
-            m_sliderParamsToNotify.fetch_or(changed);
-            m_background->wakeUp();
-        }
+    // this will sync parameters later (on message thread)
+    if (changed) {
+        m_sliderParamsToNotify.fetch_or(changed);
+        m_background->wakeUp();
     }
 
     //TODO: visibility changes
@@ -566,10 +968,12 @@ void YsfxProcessor::Impl::syncParameterToSlider(int index)
     if (index < 0 || index >= ysfx_max_sliders)
         return;
 
+    // NOTE: the metadata of the parameter may lag behind the effect
+    ysfx_t *fx = m_fx.get();
     YsfxParameter *param = m_self->getYsfxParameter(index);
-    if (param->existsAsSlider()) {
-        ysfx_real actualValue = param->convertToYsfxValue(param->getValue());
-        ysfx_slider_set_value(m_fx.get(), (uint32_t)index, actualValue);
+    if (ysfx_slider_exists(fx, (uint32_t)index)) {
+        ysfx_real actualValue = YsfxParameter::convertToYsfxValue(fx, (uint32_t)index, param->getValue());
+        ysfx_slider_set_value(fx, (uint32_t)index, actualValue);
     }
 }
 
@@ -584,9 +988,10 @@ void YsfxProcessor::Impl::syncSliderToParameter(int index, bool notify)
     if (index < 0 || index >= ysfx_max_sliders)
         return;
 
+    ysfx_t *fx = m_fx.get();
     YsfxParameter *param = m_self->getYsfxParameter(index);
-    if (param->existsAsSlider()) {
-        float normValue = param->convertFromYsfxValue(ysfx_slider_get_value(m_fx.get(), (uint32_t)index));
+    if (ysfx_slider_exists(fx, (uint32_t)index)) {
+        float normValue = YsfxParameter::convertFromYsfxValue(fx, (uint32_t)index, ysfx_slider_get_value(fx, (uint32_t)index));
         if (notify)
             param->setValueNotifyingHost(normValue);
         else {
@@ -596,7 +1001,28 @@ void YsfxProcessor::Impl::syncSliderToParameter(int index, bool notify)
     }
 }
 
-YsfxInfo::Ptr YsfxProcessor::Impl::createNewFx(juce::CharPointer_UTF8 filePath, ysfx_state_t *initialState)
+// the decoded audio files, shared by all the instances of the plugin
+static ysfx_audio_cache_t *getSharedAudioCache()
+{
+    static ysfx_audio_cache_u cache{ysfx_audio_cache_new(256 << 20)};
+    return cache.get();
+}
+
+// the parsed source files, shared by all the instances of the plugin
+static ysfx_source_cache_t *getSharedSourceCache()
+{
+    static ysfx_source_cache_u cache{ysfx_source_cache_new()};
+    return cache.get();
+}
+
+// the decoded images, shared by all the instances of the plugin
+static ysfx_image_cache_t *getSharedImageCache()
+{
+    static ysfx_image_cache_u cache{ysfx_image_cache_new(128 << 20)};
+    return cache.get();
+}
+
+YsfxInfo::Ptr YsfxProcessor::Impl::createNewFx(juce::CharPointer_UTF8 filePath, ysfx_state_t *initialState, double sampleRate, int blockSize)
 {
     YsfxInfo::Ptr info{new YsfxInfo};
 
@@ -605,6 +1031,10 @@ YsfxInfo::Ptr YsfxProcessor::Impl::createNewFx(juce::CharPointer_UTF8 filePath,
     ///
     ysfx_config_u config{ysfx_config_new()};
     ysfx_register_builtin_audio_formats(config.get());
+    ysfx_set_audio_cache(config.get(), getSharedAudioCache());
+    ysfx_set_source_cache(config.get(), getSharedSourceCache());
+    ysfx_set_image_cache(config.get(), getSharedImageCache());
+    ysfx_set_audio_read_ahead(config.get(), 1 << 16);
     ysfx_guess_file_roots(config.get(), filePath);
 
     ///
@@ -630,20 +1060,67 @@ YsfxInfo::Ptr YsfxProcessor::Impl::createNewFx(juce::CharPointer_UTF8 filePath,
 
     ///
     const char *bankpath = ysfx_get_bank_path(fx);
-    info->bank.reset(ysfx_load_bank(bankpath));
+    info->bank.reset(ysfx_load_bank_lazy(bankpath));
+
+    // initialize here, so the effect is ready to process when installed
+    if (sampleRate > 0)
+        ysfx_set_sample_rate(fx, sampleRate);
+    if (blockSize > 0)
+        ysfx_set_block_size(fx, (uint32_t)blockSize);
 
     if (initialState)
         ysfx_load_state(fx, initialState);
+    else
+        ysfx_init(fx);
+
+    // decode the images now, so that opening the editor does not have to wait
+    if (ysfx_has_section(fx, ysfx_section_gfx))
+        ysfx_gfx_preload_images(fx);
 
     return info;
 }
 
+void YsfxProcessor::Impl::reconfigureNewFx(ysfx_t *fx, ysfx_state_t *initialState)
+{
+    double sampleRate = m_self->getSampleRate();
+    int blockSize = m_self->getBlockSize();
+    if (sampleRate <= 0 || blockSize <= 0)
+        return;
+
+    if (ysfx_get_sample_rate(fx) == sampleRate && ysfx_get_block_size(fx) == (uint32_t)blockSize)
+        return;
+
+    ysfx_set_sample_rate(fx, sampleRate);
+    ysfx_set_block_size(fx, (uint32_t)blockSize);
+
+    if (initialState)
+        ysfx_load_state(fx, initialState);
+    else
+        ysfx_init(fx);
+}
+
 void YsfxProcessor::Impl::installNewFx(YsfxInfo::Ptr info)
 {
+    ysfx_t *fx = info->effect.get();
+
+    // let the audio thread swap it in, and fade the former effect out
+    if (stageNewFx(fx)) {
+        for (uint32_t i = 0; i < ysfx_max_sliders; ++i) {
+            YsfxParameter *param = m_self->getYsfxParameter((int)i);
+            param->setEffect(fx);
+        }
+        std::atomic_store(&m_info, info);
+
+        // notify parameters again, now that they describe the new effect
+        m_sliderParamsToNotify.store(~(uint64_t)0);
+        m_background->wakeUp();
+        return;
+    }
+
     AudioProcessorSuspender sus{*m_self};
     sus.lockCallbacks();
 
-    ysfx_t *fx = info->effect.get();
+    m_crossfade.fadingFx.reset();
     m_fx.reset(fx);
     ysfx_add_ref(fx);
     std::atomic_store(&m_info, info);
@@ -661,13 +1138,13 @@ void YsfxProcessor::Impl::installNewFx(YsfxInfo::Ptr info)
     m_background->wakeUp();
 }
 
-void YsfxProcessor::Impl::loadNewPreset(const ysfx_preset_t &preset)
+void YsfxProcessor::Impl::loadNewPreset(ysfx_state_t *state)
 {
     AudioProcessorSuspender sus{*m_self};
     sus.lockCallbacks();
 
     ysfx_t *fx = m_fx.get();
-    ysfx_load_state(fx, preset.state);
+    ysfx_load_state(fx, state);
 
     bool notify = false;
     syncSlidersToParameters(notify);
@@ -677,6 +1154,164 @@ void YsfxProcessor::Impl::loadNewPreset(const ysfx_preset_t &preset)
     m_background->wakeUp();
 }
 
+bool YsfxProcessor::Impl::captureState(ysfx_u &fx, ysfx_state_u &state)
+{
+    uint32_t timeout = getAudioResponseTimeout();
+    if (timeout == 0)
+        return false;
+
+    std::lock_guard<std::mutex> lock(m_stateCapture.requestMutex);
+
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        if (!m_stateCapture.buffer) {
+            m_stateCapture.capacity = std::max<size_t>(m_stateCapture.capacity, 4096);
+            m_stateCapture.buffer.reset(ysfx_state_new(m_stateCapture.capacity));
+        }
+
+        m_stateCapture.requested.store(true);
+
+        if (!m_stateCapture.completion.timed_wait(timeout)) {
+            // withdraw the request, unless the audio thread has just taken it
+            if (m_stateCapture.requested.exchange(false))
+                return false;
+            m_stateCapture.completion.wait();
+        }
+
+        fx = std::move(m_stateCapture.effect);
+        ysfx_state_t *buffer = m_stateCapture.buffer.get();
+
+        if (m_stateCapture.saved) {
+            state.reset(ysfx_state_dup(buffer));
+            return true;
+        }
+
+        // the effect is not compiled, there is no state
+        if (buffer->data_size <= m_stateCapture.capacity) {
+            state.reset();
+            return true;
+        }
+
+        // the state has grown, make room with some margin and ask again
+        m_stateCapture.capacity = buffer->data_size + buffer->data_size / 2;
+        m_stateCapture.buffer.reset();
+    }
+
+    return false;
+}
+
+bool YsfxProcessor::Impl::stagePreset(ysfx_state_t *state)
+{
+    uint32_t timeout = getAudioResponseTimeout();
+    if (timeout == 0)
+        return false;
+
+    m_presetStaging.state.store(state);
+
+    if (!m_presetStaging.completion.timed_wait(timeout)) {
+        // withdraw the preset, unless the audio thread has just taken it
+        if (m_presetStaging.state.exchange(nullptr) != nullptr)
+            return false;
+        m_presetStaging.completion.wait();
+    }
+
+    return true;
+}
+
+bool YsfxProcessor::Impl::stageNewFx(ysfx_t *fx)
+{
+    uint32_t timeout = getAudioResponseTimeout();
+    if (timeout == 0)
+        return false;
+
+    // the audio thread may have to finish fading the previous effect first
+    timeout += (uint32_t)juce::roundToInt(1000.0 * m_effectCrossfadeTime.load());
+
+    ysfx_add_ref(fx);
+    m_effectStaging.effect.store(fx);
+
+    if (!m_effectStaging.completion.timed_wait(timeout)) {
+        // withdraw the effect, unless the audio thread has just taken it
+        if (m_effectStaging.effect.exchange(nullptr) != nullptr) {
+            ysfx_free(fx);
+            return false;
+        }
+        m_effectStaging.completion.wait();
+    }
+
+    return true;
+}
+
+uint32_t YsfxProcessor::Impl::getAudioResponseTimeout() const
+{
+    if (!m_prepared.load() || m_self->isSuspended())
+        return 0;
+
+    // allow a few blocks of time for the audio thread to respond
+    double sampleRate = m_self->getSampleRate();
+    int blockSize = m_self->getBlockSize();
+    uint32_t timeout = 50;
+    if (sampleRate > 0 && blockSize > 0)
+        timeout += (uint32_t)(4000.0 * blockSize / sampleRate);
+    return timeout;
+}
+
+void YsfxProcessor::Impl::prepareCrossfade(uint32_t numChannels, uint32_t numFrames, double sampleRate)
+{
+    Crossfade &xf = m_crossfade;
+
+    if (numChannels > xf.maxChannels || numFrames > xf.maxFrames) {
+        xf.maxChannels = juce::jmax(numChannels, xf.maxChannels);
+        xf.maxFrames = juce::jmax(numFrames, xf.maxFrames);
+        size_t size = (size_t)xf.maxChannels * xf.maxFrames;
+        xf.inputData.reset(new double[size]{});
+        xf.outputData.reset(new double[size]{});
+        xf.historyData.reset(new double[size]{});
+        xf.inputs.reset(new void *[xf.maxChannels]);
+        xf.outputs.reset(new void *[xf.maxChannels]);
+        xf.history.reset(new void *[xf.maxChannels]);
+        for (uint32_t i = 0; i < xf.maxChannels; ++i) {
+            xf.inputs[i] = &xf.inputData[(size_t)i * xf.maxFrames];
+            xf.outputs[i] = &xf.outputData[(size_t)i * xf.maxFrames];
+            xf.history[i] = &xf.historyData[(size_t)i * xf.maxFrames];
+        }
+        xf.historyPosition = 0;
+    }
+
+    xf.presetFrames = (uint32_t)juce::roundToInt(presetCrossfadeTime * sampleRate);
+    xf.effectFrames.store((uint32_t)juce::roundToInt(m_effectCrossfadeTime.load() * sampleRate));
+}
+
+void YsfxProcessor::Impl::postLoadRequest(LoadRequest::Ptr loadRequest)
+{
+    std::atomic_store(&m_pendingLoad, loadRequest);
+    if (loadRequest->stateChunk.getSize() > 0)
+        m_muted.store(true);
+
+    std::atomic_store(&m_loadRequest, loadRequest);
+    m_background->postLoadRequest();
+}
+
+void YsfxProcessor::Impl::clearOutputs(void *outputs[], uint32_t numOuts, uint32_t numFrames, uint32_t processBits)
+{
+    size_t frameSize = processBits / 8;
+    for (uint32_t i = 0; i < numOuts; ++i)
+        memset(outputs[i], 0, numFrames * frameSize);
+}
+
+void YsfxProcessor::Impl::processStateCapture()
+{
+    if (!m_stateCapture.requested.exchange(false))
+        return;
+
+    // NOTE: the previous effect was moved out by the requester, so nothing
+    //   gets freed here, and the state is written into the buffer in place
+    ysfx_t *fx = m_fx.get();
+    ysfx_add_ref(fx);
+    m_stateCapture.effect.reset(fx);
+    m_stateCapture.saved = ysfx_save_state_into(fx, m_stateCapture.buffer.get(), m_stateCapture.capacity);
+    m_stateCapture.completion.post();
+}
+
 //==============================================================================
 void YsfxProcessor::Impl::SliderNotificationUpdater::handleAsyncUpdate()
 {
@@ -694,32 +1329,47 @@ void YsfxProcessor::Impl::SliderNotificationUpdater::handleAsyncUpdate()
 YsfxProcessor::Impl::Background::Background(Impl *impl)
     : m_impl(impl)
 {
-    m_running.store(true, std::memory_order_relaxed);
-    m_thread = std::thread([this]() { run(); });
+    m_notificationQueue.reset(new WorkerPool::Queue{*m_pool, WorkerPool::kLaneSliderNotification});
+    m_loadQueue.reset(new WorkerPool::Queue{*m_pool, WorkerPool::kLaneLoad});
+    m_presetQueue.reset(new WorkerPool::Queue{*m_pool, WorkerPool::kLanePreset});
+
+    m_notificationQueue->setSignalHandler([this]() { processNotifications(); });
 }
 
 void YsfxProcessor::Impl::Background::shutdown()
 {
-    m_running.store(false, std::memory_order_relaxed);
-    m_sema.post();
-    m_thread.join();
+    m_notificationQueue->close();
+    m_loadQueue->close();
+    m_presetQueue->close();
 }
 
 void YsfxProcessor::Impl::Background::wakeUp()
 {
-    m_sema.post();
+    m_notificationQueue->signal();
 }
 
-void YsfxProcessor::Impl::Background::run()
+void YsfxProcessor::Impl::Background::postLoadRequest()
 {
-    while (m_sema.wait(), m_running.load(std::memory_order_relaxed)) {
-        if (uint64_t sliderMask = m_impl->m_sliderParamsToNotify.exchange(0))
-            processSliderNotifications(sliderMask);
+    m_loadQueue->post([this]() {
         if (LoadRequest::Ptr loadRequest = std::atomic_exchange(&m_impl->m_loadRequest, LoadRequest::Ptr{}))
             processLoadRequest(*loadRequest);
+    });
+}
+
+void YsfxProcessor::Impl::Background::postPresetRequest()
+{
+    m_presetQueue->post([this]() {
         if (PresetRequest::Ptr presetRequest = std::atomic_exchange(&m_impl->m_presetRequest, PresetRequest::Ptr{}))
             processPresetRequest(*presetRequest);
-    }
+    });
+}
+
+void YsfxProcessor::Impl::Background::processNotifications()
+{
+    if (uint64_t sliderMask = m_impl->m_sliderParamsToNotify.exchange(0))
+        processSliderNotifications(sliderMask);
+    if (ysfx_t *retiredFx = m_impl->m_retiredFx.exchange(nullptr))
+        ysfx_free(retiredFx);
 }
 
 void YsfxProcessor::Impl::Background::processSliderNotifications(uint64_t sliderMask)
@@ -733,8 +1383,22 @@ void YsfxProcessor::Impl::Background::processSliderNotifications(uint64_t slider
 
 void YsfxProcessor::Impl::Background::processLoadRequest(LoadRequest &req)
 {
-    YsfxInfo::Ptr info = createNewFx(req.filePath.toUTF8(), req.initialState.get());
-    m_impl->installNewFx(info);
+    YsfxProcessor *self = m_impl->m_self;
+    YsfxInfo::Ptr info = createNewFx(req.filePath.toUTF8(), req.initialState.get(), self->getSampleRate(), self->getBlockSize());
+
+    {
+        std::lock_guard<std::mutex> installLock(m_installMutex);
+
+        // the processing may have been prepared while this was loading,
+        //   which is common when the load is the restore of a project
+        m_impl->reconfigureNewFx(info->effect.get(), req.initialState.get());
+        m_impl->installNewFx(info);
+
+        // unmute, unless a newer load has been requested since
+        LoadRequest::Ptr expected = req.shared_from_this();
+        if (std::atomic_compare_exchange_strong(&m_impl->m_pendingLoad, &expected, LoadRequest::Ptr{}))
+            m_impl->m_muted.store(false);
+    }
 
     std::lock_guard<std::mutex> lock(req.completionMutex);
     req.completion = true;
@@ -743,16 +1407,21 @@ void YsfxProcessor::Impl::Background::processLoadRequest(LoadRequest &req)
 
 void YsfxProcessor::Impl::Background::processPresetRequest(PresetRequest &req)
 {
-    if (m_impl->m_info != req.info)
-        return;
+    {
+        std::lock_guard<std::mutex> installLock(m_installMutex);
 
-    ysfx_bank_t *bank = req.info->bank.get();
-    if (!bank || req.index >= bank->preset_count)
-        return;
+        ysfx_bank_t *bank = (m_impl->m_info == req.info) ? req.info->bank.get() : nullptr;
 
-    const ysfx_preset_t &preset = bank->presets[req.index];
-    m_impl->loadNewPreset(preset);
+        // decode the preset here, and let the audio thread apply it between
+        //   blocks; if it is not running, suspend the processing to apply it
+        ysfx_state_u state;
+        if (bank && req.index < bank->preset_count)
+            state.reset(ysfx_bank_get_preset_state(bank, req.index));
+        if (state && !m_impl->stagePreset(state.get()))
+            m_impl->loadNewPreset(state.get());
+    }
 
+    // complete also when the preset could not be applied, the requester may wait
     std::lock_guard<std::mutex> lock(req.completionMutex);
     req.completion = true;
     req.completionVariable.notify_one();
@@ -765,8 +1434,10 @@ void YsfxProcessor::Impl::audioProcessorParameterChanged(AudioProcessor *process
     (void)newValue;
 
     int sliderIndex = parameterIndex - m_sliderParamOffset;
-    if (sliderIndex >= 0 && sliderIndex < ysfx_max_sliders)
+    if (sliderIndex >= 0 && sliderIndex < ysfx_max_sliders) {
         m_sliderParametersChanged.fetch_or((uint64_t)1 << sliderIndex);
+        m_sliderParamsToDisplay.fetch_or((uint64_t)1 << sliderIndex);
+    }
 }
 
 void YsfxProcessor::Impl::audioProcessorChanged(AudioProcessor *processor, const ChangeDetails &details)
@@ -29,8 +29,12 @@ public:
     ~YsfxProcessor() override;
 
     YsfxParameter *getYsfxParameter(int sliderIndex);
+    // get a bit mask of the sliders whose values must be redisplayed, and clear it
+    uint64_t fetchSliderDisplayChanges();
     void loadJsfxFile(const juce::String &filePath, ysfx_state_t *initialState, bool async);
     void loadJsfxPreset(YsfxInfo::Ptr info, uint32_t index, bool async);
+    // set the duration of the fade into a newly loaded effect, 0 to disable
+    void setEffectCrossfadeTime(double seconds);
     YsfxInfo::Ptr getCurrentInfo();
 
     //==========================================================================
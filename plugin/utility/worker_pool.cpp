@@ -0,0 +1,237 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "worker_pool.h"
+#include <algorithm>
+
+WorkerPool::WorkerPool()
+{
+    int numCpus = (int)std::thread::hardware_concurrency();
+    setThreadCount(juce::jlimit(2, 8, numCpus / 2));
+}
+
+WorkerPool::~WorkerPool()
+{
+    setThreadCount(0);
+    jassert(m_queues.empty());
+}
+
+void WorkerPool::setThreadCount(int count)
+{
+    // NOTE: this must not be called from a task, since it waits for the threads
+    std::lock_guard<std::mutex> configLock{m_configMutex};
+
+    if (count == m_threadCount)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_exitCount = (int)m_threads.size();
+    }
+    for (size_t i = 0; i < m_threads.size(); ++i)
+        m_sema.post();
+    for (std::thread &thread : m_threads)
+        thread.join();
+    m_threads.clear();
+
+    m_threadCount = count;
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_workerCount = count;
+    }
+    m_threads.reserve((size_t)count);
+    for (int i = 0; i < count; ++i) {
+        m_threads.emplace_back([this]() { run(); });
+        // let the new threads look for the work which was left pending
+        m_sema.post();
+    }
+}
+
+int WorkerPool::getThreadCount()
+{
+    std::lock_guard<std::mutex> configLock{m_configMutex};
+    return m_threadCount;
+}
+
+int WorkerPool::getQueueDepth(Lane lane)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    size_t depth = 0;
+    for (Queue *queue : m_queues) {
+        if (queue->m_lane == lane)
+            depth += queue->m_tasks.size();
+    }
+    return (int)depth;
+}
+
+void WorkerPool::run()
+{
+    for (;;) {
+        m_sema.wait();
+
+        std::unique_lock<std::mutex> lock{m_mutex};
+        if (m_exitCount > 0) {
+            --m_exitCount;
+            return;
+        }
+
+        collectSignals();
+        Queue *queue = popReadyQueue();
+        if (!queue)
+            continue;
+
+        std::function<void()> task = std::move(queue->m_tasks.front());
+        queue->m_tasks.pop_front();
+        if (!task) {
+            // this is where a signal was received
+            task = queue->m_signalHandler;
+            queue->m_handlerQueued = false;
+        }
+        queue->m_running = true;
+        bool isLong = queue->m_lane >= kFirstLongLane;
+        m_longTaskCount += isLong;
+        lock.unlock();
+
+        if (task)
+            task();
+        m_taskCount.fetch_add(1, std::memory_order_relaxed);
+
+        lock.lock();
+        queue->m_running = false;
+        makeReady(*queue);
+        queue->m_idle.notify_all();
+
+        if (isLong) {
+            // the long tasks which were held back may run now
+            --m_longTaskCount;
+            for (int lane = kFirstLongLane; lane < kNumLanes; ++lane) {
+                if (!m_ready[lane].empty()) {
+                    m_sema.post();
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void WorkerPool::makeReady(Queue &queue)
+{
+    if (queue.m_ready || queue.m_running || queue.m_tasks.empty())
+        return;
+
+    queue.m_ready = true;
+    m_ready[queue.m_lane].push_back(&queue);
+    m_sema.post();
+}
+
+void WorkerPool::collectSignals()
+{
+    for (Queue *queue : m_queues) {
+        if (!queue->m_signaled.exchange(false))
+            continue;
+        if (queue->m_open && !queue->m_handlerQueued) {
+            // an empty task stands for the signal handler
+            queue->m_tasks.emplace_back();
+            queue->m_handlerQueued = true;
+            makeReady(*queue);
+        }
+    }
+}
+
+WorkerPool::Queue *WorkerPool::popReadyQueue()
+{
+    // keep a worker free for the short lanes, unless there is only one
+    bool canRunLong = m_workerCount < 2 || m_longTaskCount + 1 < m_workerCount;
+
+    for (int lane = 0; lane < kNumLanes; ++lane) {
+        if (lane >= kFirstLongLane && !canRunLong)
+            break;
+        if (!m_ready[lane].empty()) {
+            Queue *queue = m_ready[lane].front();
+            m_ready[lane].pop_front();
+            queue->m_ready = false;
+            return queue;
+        }
+    }
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
+WorkerPool::Queue::Queue(WorkerPool &pool, Lane lane)
+    : m_pool(pool),
+      m_lane(lane)
+{
+    std::lock_guard<std::mutex> lock{pool.m_mutex};
+    pool.m_queues.push_back(this);
+}
+
+WorkerPool::Queue::~Queue()
+{
+    close();
+
+    std::lock_guard<std::mutex> lock{m_pool.m_mutex};
+    std::vector<Queue *> &queues = m_pool.m_queues;
+    queues.erase(std::find(queues.begin(), queues.end(), this));
+}
+
+void WorkerPool::Queue::post(std::function<void()> task)
+{
+    jassert(task);
+
+    std::lock_guard<std::mutex> lock{m_pool.m_mutex};
+    if (!m_open)
+        return;
+
+    m_tasks.push_back(std::move(task));
+    m_pool.makeReady(*this);
+}
+
+void WorkerPool::Queue::setSignalHandler(std::function<void()> handler)
+{
+    std::lock_guard<std::mutex> lock{m_pool.m_mutex};
+    m_signalHandler = std::move(handler);
+}
+
+void WorkerPool::Queue::signal()
+{
+    if (!m_signaled.exchange(true))
+        m_pool.m_sema.post();
+}
+
+void WorkerPool::Queue::close()
+{
+    std::unique_lock<std::mutex> lock{m_pool.m_mutex};
+
+    m_open = false;
+    m_tasks.clear();
+    m_handlerQueued = false;
+    m_signaled.store(false);
+
+    if (m_ready) {
+        std::deque<Queue *> &ready = m_pool.m_ready[m_lane];
+        ready.erase(std::find(ready.begin(), ready.end(), this));
+        m_ready = false;
+    }
+
+    m_idle.wait(lock, [this]() { return !m_running; });
+}
+
+void WorkerPool::Queue::open()
+{
+    std::lock_guard<std::mutex> lock{m_pool.m_mutex};
+    m_open = true;
+}
@@ -0,0 +1,109 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+#include "rt_semaphore.h"
+#include <juce_core/juce_core.h>
+#include <functional>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+// A pool of worker threads, which is shared by all the plugin instances.
+// The work is submitted to serial queues, which execute their tasks one at a
+// time and in order; the ready queues are picked in the priority of their lanes.
+// The tasks of the long lanes may block for a long time, so they never occupy
+// the last free worker, which remains for the short lanes.
+class WorkerPool {
+public:
+    // the lanes in decreasing order of priority
+    enum Lane {
+        kLaneSliderNotification,
+        kLanePreset,
+        kLaneGfx,
+        kLaneLoad,
+        kNumLanes,
+        // the lanes from this one on are long
+        kFirstLongLane = kLaneGfx,
+    };
+
+    WorkerPool();
+    ~WorkerPool();
+
+    // set the number of worker threads, at least 1
+    void setThreadCount(int count);
+    int getThreadCount();
+    // get the number of tasks which wait to execute in the lane
+    int getQueueDepth(Lane lane);
+    // get the number of tasks which were executed since the start
+    uint64_t getTaskCount() const { return m_taskCount.load(std::memory_order_relaxed); }
+
+    //--------------------------------------------------------------------------
+    class Queue {
+    public:
+        Queue(WorkerPool &pool, Lane lane);
+        ~Queue();
+
+        // add a task to execute after the ones which are already pending
+        void post(std::function<void()> task);
+        // set the task which `signal` requests to execute
+        void setSignalHandler(std::function<void()> handler);
+        // request to execute the signal handler; this is safe in real-time
+        void signal();
+        // drop the pending tasks, wait for the running one, and stop accepting new ones
+        void close();
+        // accept tasks again after `close`
+        void open();
+
+    private:
+        friend class WorkerPool;
+        WorkerPool &m_pool;
+        Lane m_lane{};
+        std::deque<std::function<void()>> m_tasks;
+        std::function<void()> m_signalHandler;
+        std::atomic<bool> m_signaled{false};
+        bool m_open = true;
+        bool m_handlerQueued = false;
+        bool m_ready = false;
+        bool m_running = false;
+        std::condition_variable m_idle;
+    };
+
+private:
+    void run();
+    void makeReady(Queue &queue);
+    void collectSignals();
+    Queue *popReadyQueue();
+
+private:
+    std::mutex m_configMutex;
+    std::mutex m_mutex;
+    RTSemaphore m_sema;
+    std::vector<Queue *> m_queues;
+    std::deque<Queue *> m_ready[kNumLanes];
+    std::vector<std::thread> m_threads;
+    int m_threadCount = 0;
+    int m_exitCount = 0;
+    // the count of workers, and of those running long tasks, under `m_mutex`
+    int m_workerCount = 0;
+    int m_longTaskCount = 0;
+    std::atomic<uint64_t> m_taskCount{0};
+};
@@ -48,6 +48,13 @@ void ysfx_set_thread_id(ysfx_thread_id_t id)
     ysfx_thread_id = id;
 }
 
+static thread_local bool ysfx_in_audio_section;
+
+bool ysfx_is_in_audio_section()
+{
+    return ysfx_in_audio_section;
+}
+
 //------------------------------------------------------------------------------
 struct ysfx_api_initializer {
 private:
@@ -66,6 +73,12 @@ ysfx_api_initializer::ysfx_api_initializer()
     ysfx_api_init_reaper();
     ysfx_api_init_file();
     ysfx_api_init_gfx();
+
+    // the compiler initializes some of its tables lazily, in the first
+    //   compilations which need them; do it now instead, since effects
+    //   may be compiled on several threads concurrently
+    NSEEL_VMCTX_u vm{NSEEL_VM_alloc()};
+    NSEEL_CODEHANDLE_u code{NSEEL_code_compile_ex(vm.get(), "x*x; 2^x;", 0, 0)};
 }
 
 ysfx_api_initializer::~ysfx_api_initializer()
@@ -194,6 +207,29 @@ ysfx_config_t *ysfx_get_config(ysfx_t *fx)
     return fx->config.get();
 }
 
+// parse a source file, through the cache if the configuration has one
+static ysfx_source_unit_ptr ysfx_load_source_unit(ysfx_t *fx, const char *path, ysfx::file_uid &uid)
+{
+    ysfx_source_result_t result;
+
+    ysfx::file_stamp stamp;
+    if (ysfx::get_file_stamp(path, stamp)) {
+        ysfx_source_cache_t *cache = fx->config->source_cache.get();
+        result = cache ? ysfx_source_cache_acquire(cache, path, stamp) : ysfx_source_parse(path);
+    }
+
+    if (!result.unit) {
+        if (result.error)
+            ysfx_logf(*fx->config, ysfx_log_error, "%s:%u: %s", ysfx::path_file_name(path).c_str(), result.error.line + 1, result.error.message.c_str());
+        else
+            ysfx_logf(*fx->config, ysfx_log_error, "%s: cannot open file for reading", ysfx::path_file_name(path).c_str());
+        return nullptr;
+    }
+
+    uid = stamp.uid;
+    return result.unit;
+}
+
 bool ysfx_load_file(ysfx_t *fx, const char *filepath, uint32_t loadopts)
 {
     ysfx_unload(fx);
@@ -209,22 +245,12 @@ bool ysfx_load_file(ysfx_t *fx, const char *filepath, uint32_t loadopts)
     ysfx::file_uid main_uid;
 
     {
-        ysfx_source_unit_u main{new ysfx_source_unit_t};
-
-        ysfx::FILE_u stream{ysfx::fopen_utf8(filepath, "rb")};
-        if (!stream || !ysfx::get_stream_file_uid(stream.get(), main_uid)) {
-            ysfx_logf(*fx->config, ysfx_log_error, "%s: cannot open file for reading", ysfx::path_file_name(filepath).c_str());
+        ysfx_source_unit_ptr parsed = ysfx_load_source_unit(fx, filepath, main_uid);
+        if (!parsed)
             return false;
-        }
 
-        ysfx::stdio_text_reader reader(stream.get());
-
-        ysfx_parse_error error;
-        if (!ysfx_parse_toplevel(reader, main->toplevel, &error)) {
-            ysfx_logf(*fx->config, ysfx_log_error, "%s:%u: %s", ysfx::path_file_name(filepath).c_str(), error.line + 1, error.message.c_str());
-            return false;
-        }
-        ysfx_parse_header(main->toplevel.header.get(), main->header);
+        // the main unit gets modified below, so it's a copy of the parsed one
+        ysfx_source_unit_u main = ysfx_source_unit_clone(*parsed);
 
         // validity check
         if (main->header.desc.empty()) {
@@ -293,28 +319,16 @@ bool ysfx_load_file(ysfx_t *fx, const char *filepath, uint32_t loadopts)
                 return false;
             }
 
+            // parse it
             ysfx::file_uid imported_uid;
-            ysfx::FILE_u stream{ysfx::fopen_utf8(imported_path.c_str(), "rb")};
-            if (!stream || !ysfx::get_stream_file_uid(stream.get(), imported_uid)) {
-                ysfx_logf(*fx->config, ysfx_log_error, "%s: cannot open file for reading", ysfx::path_file_name(imported_path.c_str()).c_str());
+            ysfx_source_unit_ptr unit = ysfx_load_source_unit(fx, imported_path.c_str(), imported_uid);
+            if (!unit)
                 return false;
-            }
 
             // this file was already visited, skip
             if (!seen.insert(imported_uid).second)
                 return true;
 
-            // parse it
-            ysfx_source_unit_u unit{new ysfx_source_unit_t};
-            ysfx::stdio_text_reader reader(stream.get());
-
-            ysfx_parse_error error;
-            if (!ysfx_parse_toplevel(reader, unit->toplevel, &error)) {
-                ysfx_logf(*fx->config, ysfx_log_error, "%s:%u: %s", ysfx::path_file_name(imported_path.c_str()).c_str(), error.line + 1, error.message.c_str());
-                return false;
-            }
-            ysfx_parse_header(unit->toplevel.header.get(), unit->header);
-
             // process the imported dependencies, *first*
             for (const std::string &name : unit->header.imports) {
                 if (!do_next_import(name, imported_path.c_str(), level + 1))
@@ -335,8 +349,13 @@ bool ysfx_load_file(ysfx_t *fx, const char *filepath, uint32_t loadopts)
     //--------------------------------------------------------------------------
     // initialize the sliders to defaults
 
-    for (uint32_t i = 0; i < ysfx_max_sliders; ++i)
-        *fx->var.slider[i] = fx->source.main->header.sliders[i].def;
+    fx->slider.exist_mask = 0;
+    for (uint32_t i = 0; i < ysfx_max_sliders; ++i) {
+        const ysfx_slider_t &slider = fx->source.main->header.sliders[i];
+        *fx->var.slider[i] = slider.def;
+        fx->slider.last_values[i] = slider.def;
+        fx->slider.exist_mask |= (uint64_t)slider.exists << i;
+    }
 
     //--------------------------------------------------------------------------
 
@@ -344,6 +363,126 @@ bool ysfx_load_file(ysfx_t *fx, const char *filepath, uint32_t loadopts)
     return true;
 }
 
+#if !defined(YSFX_NO_GFX)
+static void ysfx_gfx_update_watch(ysfx_t *fx, ysfx_section_t *gfx)
+{
+    fx->gfx.watch_vars.clear();
+    fx->gfx.watch_values.clear();
+    fx->gfx.watch_all = true;
+
+    if (!fx->code.gfx)
+        return;
+
+    ysfx_code_scan_t scan;
+    ysfx_scan_code(gfx->text, scan);
+
+    // the memory, and what the functions may read, are not watched
+    if (scan.has_indexing)
+        return;
+
+    // the functions which read nothing but their arguments; any other call,
+    //   including to a builtin which is missing here or to a user function,
+    //   may read what is not watched, and so every block counts as new data
+    static const char *const pure_functions[] = {
+        "loop", "while", "local", "static", "instance", "globals", "global",
+        "sin", "cos", "tan", "asin", "acos", "atan", "atan2", "sqr", "sqrt",
+        "pow", "exp", "log", "log10", "abs", "min", "max", "sign", "floor",
+        "ceil", "int", "invsqrt", "rand", "time", "time_precise",
+        "printf", "sprintf", "strlen", "strcpy", "strcat", "strcmp", "stricmp",
+        "strncmp", "strnicmp", "strncpy", "strncat", "strcpy_from", "strcpy_substr",
+        "str_getchar", "str_setchar", "str_setlen", "str_insert", "str_delsub",
+        "match", "matchi", "sliderchange", "slider_automate", "slider_show",
+    };
+    // the graphics functions which read the memory
+    static const char *const memory_gfx_functions[] = {
+        "gfx_blitext", "gfx_transformblit",
+    };
+    auto is_listed = [](const std::string &name, const char *const *list, size_t count) -> bool {
+        for (size_t i = 0; i < count; ++i) {
+            if (name == list[i])
+                return true;
+        }
+        return false;
+    };
+
+    std::set<std::string> read;
+    std::set<std::string> written;
+
+    for (const ysfx_code_ident_t &ident : scan.idents) {
+        const std::string &name = ident.name;
+        if (ident.is_call) {
+            bool is_gfx = name.compare(0, 4, "gfx_") == 0;
+            if (is_gfx ? is_listed(name, memory_gfx_functions, sizeof(memory_gfx_functions) / sizeof(*memory_gfx_functions)) :
+                !is_listed(name, pure_functions, sizeof(pure_functions) / sizeof(*pure_functions)))
+                return;
+        }
+        else if (ident.is_assigned)
+            written.insert(name);
+        else if (!ident.is_definition && name.compare(0, 4, "gfx_") != 0 && name.compare(0, 6, "mouse_") != 0)
+            read.insert(name);
+    }
+
+    // what @gfx writes itself would signal every frame that follows
+    for (const std::string &name : written)
+        read.erase(name);
+
+    struct watch_data {
+        const std::set<std::string> *read = nullptr;
+        std::vector<ysfx_real *> *vars = nullptr;
+    };
+    watch_data wd;
+    wd.read = &read;
+    wd.vars = &fx->gfx.watch_vars;
+    auto callback = [](const char *name, EEL_F *var, void *userdata) -> int {
+        watch_data *wd = (watch_data *)userdata;
+        std::string lower{name};
+        for (char &c : lower)
+            c = ysfx::ascii_tolower(c);
+        if (wd->read->find(lower) != wd->read->end())
+            wd->vars->push_back(var);
+        return 1;
+    };
+    NSEEL_VM_enumallvars(fx->vm.get(), +callback, &wd);
+
+    fx->gfx.watch_values.resize(fx->gfx.watch_vars.size());
+    fx->gfx.watch_all = false;
+}
+
+static void ysfx_gfx_watch_after_processing(ysfx_t *fx)
+{
+    if (!fx->code.gfx)
+        return;
+
+    // compare with the values at the end of the previous cycle, for the
+    //   changes in between to count too, such as the automation of sliders;
+    //   compare the bits, for a NaN to be unchanged
+    const std::vector<ysfx_real *> &vars = fx->gfx.watch_vars;
+    ysfx_real *values = fx->gfx.watch_values.data();
+    bool changed = fx->gfx.watch_all;
+    for (size_t i = 0, n = vars.size(); i < n; ++i) {
+        if (memcmp(&values[i], vars[i], sizeof(ysfx_real)) != 0) {
+            changed = true;
+            values[i] = *vars[i];
+        }
+    }
+
+    if (changed)
+        fx->gfx.data_serial.fetch_add(1, std::memory_order_relaxed);
+}
+#endif
+
+static bool ysfx_section_calls_fft(const ysfx_section_t *section)
+{
+    ysfx_code_scan_t scan;
+    ysfx_scan_code(section->text, scan);
+    for (const ysfx_code_ident_t &ident : scan.idents) {
+        const std::string &name = ident.name;
+        if (ident.is_call && (name.compare(0, 3, "fft") == 0 || name.compare(0, 4, "ifft") == 0))
+            return true;
+    }
+    return false;
+}
+
 bool ysfx_compile(ysfx_t *fx, uint32_t compileopts)
 {
     ysfx_unload_code(fx);
@@ -394,6 +533,9 @@ bool ysfx_compile(ysfx_t *fx, uint32_t compileopts)
             return true;
         };
 
+    // the sections which are compiled
+    std::vector<ysfx_section_t *> compiled;
+
     // compile the multiple @init sections, imports first
     {
         std::vector<ysfx_section_t *> secs;
@@ -410,6 +552,8 @@ bool ysfx_compile(ysfx_t *fx, uint32_t compileopts)
                 return false;
             fx->code.init.push_back(std::move(code));
         }
+
+        compiled = secs;
     }
 
     // compile the other sections, single
@@ -436,6 +580,22 @@ bool ysfx_compile(ysfx_t *fx, uint32_t compileopts)
     if (serialize && !compile_section(serialize, "@serialize", fx->code.serialize))
         return false;
 
+    compiled.insert(compiled.end(), {slider, block, sample, gfx, serialize});
+
+    // a transform which crosses the memory blocks needs a buffer, which is
+    //   better allocated now than by the first @sample which calls it
+    for (ysfx_section_t *sec : compiled) {
+        if (sec && ysfx_section_calls_fft(sec)) {
+            ysfx_eel_fft_prepare(fx);
+            break;
+        }
+    }
+
+#if !defined(YSFX_NO_GFX)
+    if (gfx)
+        ysfx_gfx_update_watch(fx, gfx);
+#endif
+
     fx->code.compiled = true;
     fx->is_freshly_compiled = true;
     fx->must_compute_init = true;
@@ -468,9 +628,13 @@ void ysfx_unload_code(ysfx_t *fx)
         fx->gfx.wants_retina = false;
         fx->gfx.must_init.store(false);
     }
+    fx->gfx.watch_vars.clear();
+    fx->gfx.watch_values.clear();
+    fx->gfx.watch_all = true;
 #endif
 
     fx->code = {};
+    fx->fft = {};
 
     fx->is_freshly_compiled = false;
     fx->must_compute_init = false;
@@ -640,7 +804,7 @@ bool ysfx_wants_meters(ysfx_t *fx)
 
 bool ysfx_get_gfx_dim(ysfx_t *fx, uint32_t dim[2])
 {
-    ysfx_toplevel_t *origin = nullptr;
+    const ysfx_toplevel_t *origin = nullptr;
     ysfx_section_t *sec = ysfx_search_section(fx, ysfx_section_gfx, &origin);
 
     if (!sec) {
@@ -658,15 +822,15 @@ bool ysfx_get_gfx_dim(ysfx_t *fx, uint32_t dim[2])
     return true;
 }
 
-ysfx_section_t *ysfx_search_section(ysfx_t *fx, uint32_t type, ysfx_toplevel_t **origin)
+ysfx_section_t *ysfx_search_section(ysfx_t *fx, uint32_t type, const ysfx_toplevel_t **origin)
 {
     if (!fx->source.main)
         return nullptr;
 
     auto search =
-        [fx](ysfx_section_t *(*test)(ysfx_toplevel_t &tl), ysfx_toplevel_t **origin) -> ysfx_section_t *
+        [fx](ysfx_section_t *(*test)(const ysfx_toplevel_t &tl), const ysfx_toplevel_t **origin) -> ysfx_section_t *
         {
-            ysfx_toplevel_t *tl = &fx->source.main->toplevel;
+            const ysfx_toplevel_t *tl = &fx->source.main->toplevel;
             ysfx_section_t *sec = test(*tl);
             for (size_t i = 0; !sec && i < fx->source.imports.size(); ++i) {
                 tl = &fx->source.imports[i]->toplevel;
@@ -679,17 +843,17 @@ ysfx_section_t *ysfx_search_section(ysfx_t *fx, uint32_t type, ysfx_toplevel_t *
 
     switch (type) {
     case ysfx_section_init:
-        return search([](ysfx_toplevel_t &tl) { return tl.init.get(); }, origin);
+        return search([](const ysfx_toplevel_t &tl) { return tl.init.get(); }, origin);
     case ysfx_section_slider:
-        return search([](ysfx_toplevel_t &tl) { return tl.slider.get(); }, origin);
+        return search([](const ysfx_toplevel_t &tl) { return tl.slider.get(); }, origin);
     case ysfx_section_block:
-        return search([](ysfx_toplevel_t &tl) { return tl.block.get(); }, origin);
+        return search([](const ysfx_toplevel_t &tl) { return tl.block.get(); }, origin);
     case ysfx_section_sample:
-        return search([](ysfx_toplevel_t &tl) { return tl.sample.get(); }, origin);
+        return search([](const ysfx_toplevel_t &tl) { return tl.sample.get(); }, origin);
     case ysfx_section_gfx:
-        return search([](ysfx_toplevel_t &tl) { return tl.gfx.get(); }, origin);
+        return search([](const ysfx_toplevel_t &tl) { return tl.gfx.get(); }, origin);
     case ysfx_section_serialize:
-        return search([](ysfx_toplevel_t &tl) { return tl.serialize.get(); }, origin);
+        return search([](const ysfx_toplevel_t &tl) { return tl.serialize.get(); }, origin);
     default:
         return nullptr;
     }
@@ -808,6 +972,8 @@ void ysfx_slider_set_value(ysfx_t *fx, uint32_t index, ysfx_real value)
         *fx->var.slider[index] = value;
         fx->must_compute_slider = true;
     }
+    // the caller knows this value, it's not a change to report
+    fx->slider.last_values[index] = value;
 }
 
 std::string ysfx_resolve_import_path(ysfx_t *fx, const std::string &name, const std::string &origin)
@@ -922,6 +1088,7 @@ void ysfx_init(ysfx_t *fx)
     }
 
     ysfx_clear_files(fx);
+    ysfx_clear_convolvers(fx);
 
     for (size_t i = 0; i < fx->code.init.size(); ++i)
         NSEEL_code_execute(fx->code.init[i].get());
@@ -934,6 +1101,7 @@ void ysfx_init(ysfx_t *fx)
     // release-acquire order is for VM `gfx_*` variables and `wants_retina`
     fx->gfx.wants_retina = *fx->var.gfx_ext_retina > 0;
     fx->gfx.must_init.store(true, std::memory_order_release);
+    fx->gfx.data_serial.fetch_add(1, std::memory_order_relaxed);
 #endif
 }
 
@@ -1054,6 +1222,29 @@ uint64_t ysfx_get_slider_visibility(ysfx_t *fx)
     return fx->slider.visible_mask.load();
 }
 
+// mark the sliders whose values have changed since the last detection,
+//   whether by the code of the effect, or by the graphics between cycles
+static void ysfx_detect_slider_changes(ysfx_t *fx)
+{
+    uint64_t changed = 0;
+    uint64_t mask = fx->slider.exist_mask;
+
+    for (uint32_t i = 0; mask != 0; ++i, mask >>= 1) {
+        if (!(mask & 1))
+            continue;
+        ysfx_real value = *fx->var.slider[i];
+        ysfx_real &last = fx->slider.last_values[i];
+        // NOTE: compare the bits, for a NaN to be reported only once
+        if (memcmp(&value, &last, sizeof(ysfx_real)) != 0) {
+            last = value;
+            changed |= (uint64_t)1 << i;
+        }
+    }
+
+    if (changed)
+        fx->slider.change_mask.fetch_or(changed);
+}
+
 template <class Real>
 void ysfx_process_generic(ysfx_t *fx, const Real *const *ins, Real *const *outs, uint32_t num_ins, uint32_t num_outs, uint32_t num_frames)
 {
@@ -1095,6 +1286,9 @@ void ysfx_process_generic(ysfx_t *fx, const Real *const *ins, Real *const *outs,
             fx->must_compute_slider = false;
         }
 
+        // the sections which must not wait, such as for the streamed files
+        ysfx_in_audio_section = true;
+
         // compute @block
         NSEEL_code_execute(fx->code.block.get());
 
@@ -1112,9 +1306,17 @@ void ysfx_process_generic(ysfx_t *fx, const Real *const *ins, Real *const *outs,
             }
         }
 
+        ysfx_in_audio_section = false;
+
+#if !defined(YSFX_NO_GFX)
+        ysfx_gfx_watch_after_processing(fx);
+#endif
+
         // clear any output channels above the maximum count
         for (uint32_t ch = num_outs; ch < orig_num_outs; ++ch)
             memset(outs[ch], 0, num_frames * sizeof(Real));
+
+        ysfx_detect_slider_changes(fx);
     }
 
     // prepare MIDI input for writing, output for reading
@@ -1194,14 +1396,64 @@ int32_t ysfx_insert_file(ysfx_t *fx, ysfx_file_t *file)
     return (uint32_t)pos;
 }
 
-bool ysfx_load_state(ysfx_t *fx, ysfx_state_t *state)
+void ysfx_clear_convolvers(ysfx_t *fx)
+{
+    std::lock_guard<ysfx::mutex> list_lock(fx->conv.list_mutex);
+
+    while (!fx->conv.list.empty()) {
+        ysfx_convolver_t *conv = fx->conv.list.back().get();
+        std::unique_ptr<ysfx::mutex> conv_mutex;
+        std::unique_lock<ysfx::mutex> conv_lock;
+        if (conv) {
+            conv_lock = std::unique_lock<ysfx::mutex>{*conv->m_mutex};
+            conv_mutex = std::move(conv->m_mutex);
+        }
+        fx->conv.list.pop_back();
+    }
+}
+
+ysfx_convolver_t *ysfx_get_convolver(ysfx_t *fx, uint32_t handle, std::unique_lock<ysfx::mutex> &lock, std::unique_lock<ysfx::mutex> *list_lock)
+{
+    std::unique_lock<ysfx::mutex> local_list_lock;
+    if (list_lock)
+        *list_lock = std::unique_lock<ysfx::mutex>(fx->conv.list_mutex);
+    else
+        local_list_lock = std::unique_lock<ysfx::mutex>(fx->conv.list_mutex);
+    if (handle >= fx->conv.list.size())
+        return nullptr;
+    ysfx_convolver_t *conv = fx->conv.list[handle].get();
+    if (!conv)
+        return nullptr;
+    lock = std::unique_lock<ysfx::mutex>{*conv->m_mutex};
+    return conv;
+}
+
+int32_t ysfx_insert_convolver(ysfx_t *fx, ysfx_convolver_t *conv)
+{
+    std::lock_guard<ysfx::mutex> lock(fx->conv.list_mutex);
+
+    for (size_t i = 0, n = fx->conv.list.size(); i < n; ++i) {
+        if (!fx->conv.list[i]) {
+            fx->conv.list[i].reset(conv);
+            return (int32_t)i;
+        }
+    }
+
+    enum { max_convolver_handles = 64 };
+
+    size_t pos = fx->conv.list.size();
+    if (pos >= max_convolver_handles)
+        return -1;
+
+    fx->conv.list.emplace_back(conv);
+    return (int32_t)pos;
+}
+
+static bool ysfx_load_state_generic(ysfx_t *fx, ysfx_state_t *state, bool realtime)
 {
     if (!fx->code.compiled)
         return false;
 
-    // restore the serialization
-    std::string buffer((char *)state->data, state->data_size);
-
     // restore the sliders
     for (uint32_t i = 0; i < ysfx_max_sliders; ++i)
         *fx->var.slider[i] = fx->source.main->header.sliders[i].def;
@@ -1218,9 +1470,9 @@ bool ysfx_load_state(ysfx_t *fx, ysfx_state_t *state)
         std::unique_lock<ysfx::mutex> lock;
         ysfx_serializer_t *serializer = static_cast<ysfx_serializer_t *>(ysfx_get_file(fx, 0, lock));
         assert(serializer);
-        serializer->begin(false, buffer);
+        serializer->begin_load(state->data, state->data_size);
         lock.unlock();
-        ysfx_serialize(fx);
+        ysfx_serialize(fx, realtime);
         lock.lock();
         serializer->end();
     }
@@ -1228,48 +1480,86 @@ bool ysfx_load_state(ysfx_t *fx, ysfx_state_t *state)
     return true;
 }
 
+bool ysfx_load_state(ysfx_t *fx, ysfx_state_t *state)
+{
+    return ysfx_load_state_generic(fx, state, false);
+}
+
+bool ysfx_load_state_realtime(ysfx_t *fx, ysfx_state_t *state)
+{
+    return ysfx_load_state_generic(fx, state, true);
+}
+
+static uint32_t ysfx_save_sliders(ysfx_t *fx, ysfx_state_slider_t *sliders)
+{
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < ysfx_max_sliders; ++i) {
+        if (fx->source.main->header.sliders[i].exists) {
+            sliders[count].index = i;
+            sliders[count].value = *fx->var.slider[i];
+            ++count;
+        }
+    }
+    return count;
+}
+
 ysfx_state_t *ysfx_save_state(ysfx_t *fx)
 {
     if (!fx->code.compiled)
         return nullptr;
 
-    std::string buffer;
+    ysfx_state_u state{new ysfx_state_t{}};
 
-    // invoke @serialize
+    // invoke @serialize, and take the data which it has written
     {
         std::unique_lock<ysfx::mutex> lock;
         ysfx_serializer_t *serializer = static_cast<ysfx_serializer_t *>(ysfx_get_file(fx, 0, lock));
         assert(serializer);
-        serializer->begin(true, buffer);
+        serializer->begin_save();
         lock.unlock();
         ysfx_serialize(fx);
         lock.lock();
-        serializer->end();
+        state->data = serializer->end(&state->data_size).release();
     }
 
     // save the sliders
-    ysfx_state_u state{new ysfx_state_t};
     uint32_t slider_count = 0;
     for (uint32_t i = 0; i < ysfx_max_sliders; ++i)
         slider_count += fx->source.main->header.sliders[i].exists;
 
     state->sliders = new ysfx_state_slider_t[slider_count]{};
-    state->slider_count = slider_count;
+    state->slider_count = ysfx_save_sliders(fx, state->sliders);
 
-    for (uint32_t i = 0, j = 0; i < slider_count; ++i) {
-        if (fx->source.main->header.sliders[i].exists) {
-            state->sliders[j].index = i;
-            state->sliders[j].value = *fx->var.slider[i];
-            ++j;
-        }
+    return state.release();
+}
+
+bool ysfx_save_state_into(ysfx_t *fx, ysfx_state_t *state, size_t data_capacity)
+{
+    if (!fx->code.compiled)
+        return false;
+
+    // invoke @serialize, writing directly into the data of the state
+    {
+        std::unique_lock<ysfx::mutex> lock;
+        ysfx_serializer_t *serializer = static_cast<ysfx_serializer_t *>(ysfx_get_file(fx, 0, lock));
+        assert(serializer);
+        serializer->begin_save_into(state->data, data_capacity);
+        lock.unlock();
+        ysfx_serialize(fx, true);
+        lock.lock();
+        serializer->end(&state->data_size);
     }
 
-    // save the serialization
-    state->data_size = buffer.size();
-    state->data = new uint8_t[state->data_size];
-    memcpy(state->data, buffer.data(), state->data_size);
+    state->slider_count = ysfx_save_sliders(fx, state->sliders);
 
-    //
+    return state->data_size <= data_capacity;
+}
+
+ysfx_state_t *ysfx_state_new(size_t data_capacity)
+{
+    ysfx_state_u state{new ysfx_state_t{}};
+    state->sliders = new ysfx_state_slider_t[ysfx_max_sliders]{};
+    state->data = new uint8_t[data_capacity];
     return state.release();
 }
 
@@ -1302,12 +1592,84 @@ ysfx_state_t *ysfx_state_dup(ysfx_state_t *state_in)
     return state_out.release();
 }
 
-void ysfx_serialize(ysfx_t *fx)
+// the binary encoding of a state, all little-endian:
+//   "YSST", u32 version, u32 slider count, (u32 index, f64 value) * slider count,
+//   u64 data size, the data
+static constexpr uint32_t ysfx_state_encoding_version = 1;
+static constexpr size_t ysfx_state_encoding_header_size = 4 + 4 + 4;
+static constexpr size_t ysfx_state_encoding_slider_size = 4 + 8;
+
+size_t ysfx_state_encode(ysfx_state_t *state, uint8_t *dest, size_t capacity)
+{
+    size_t size = ysfx_state_encoding_header_size +
+        ysfx_state_encoding_slider_size * state->slider_count + 8 + state->data_size;
+    if (size > capacity)
+        return size;
+
+    uint8_t *p = dest;
+    memcpy(p, "YSST", 4);
+    ysfx::pack_u32le(ysfx_state_encoding_version, p + 4);
+    ysfx::pack_u32le(state->slider_count, p + 8);
+    p += ysfx_state_encoding_header_size;
+    for (uint32_t i = 0; i < state->slider_count; ++i) {
+        ysfx::pack_u32le(state->sliders[i].index, p);
+        ysfx::pack_f64le(state->sliders[i].value, p + 4);
+        p += ysfx_state_encoding_slider_size;
+    }
+    ysfx::pack_u64le(state->data_size, p);
+    p += 8;
+    if (state->data_size > 0)
+        memcpy(p, state->data, state->data_size);
+
+    return size;
+}
+
+ysfx_state_t *ysfx_state_decode(const uint8_t *data, size_t size)
+{
+    if (size < ysfx_state_encoding_header_size || memcmp(data, "YSST", 4) != 0)
+        return nullptr;
+    if (ysfx::unpack_u32le(data + 4) != ysfx_state_encoding_version)
+        return nullptr;
+
+    uint32_t slider_count = ysfx::unpack_u32le(data + 8);
+    const uint8_t *p = data + ysfx_state_encoding_header_size;
+    size_t remain = size - ysfx_state_encoding_header_size;
+    if (slider_count > ysfx_max_sliders || remain < ysfx_state_encoding_slider_size * slider_count + 8)
+        return nullptr;
+
+    ysfx_state_u state{new ysfx_state_t{}};
+    state->sliders = new ysfx_state_slider_t[slider_count];
+    state->slider_count = slider_count;
+    for (uint32_t i = 0; i < slider_count; ++i) {
+        state->sliders[i].index = ysfx::unpack_u32le(p);
+        state->sliders[i].value = ysfx::unpack_f64le(p + 4);
+        p += ysfx_state_encoding_slider_size;
+    }
+    remain -= ysfx_state_encoding_slider_size * slider_count;
+
+    uint64_t data_size = ysfx::unpack_u64le(p);
+    p += 8;
+    remain -= 8;
+    if (data_size > remain)
+        return nullptr;
+
+    state->data = new uint8_t[(size_t)data_size];
+    state->data_size = (size_t)data_size;
+    if (data_size > 0)
+        memcpy(state->data, p, (size_t)data_size);
+
+    return state.release();
+}
+
+void ysfx_serialize(ysfx_t *fx, bool realtime)
 {
     if (fx->code.serialize) {
         if (fx->must_compute_init)
             ysfx_init(fx);
+        bool was_in_audio_section = ysfx_in_audio_section;
+        ysfx_in_audio_section = was_in_audio_section || realtime;
         NSEEL_code_execute(fx->code.serialize.get());
+        ysfx_in_audio_section = was_in_audio_section;
     }
 }
 
@@ -1355,6 +1717,11 @@ void ysfx_read_vmem(ysfx_t *fx, uint32_t addr, ysfx_real *dest, uint32_t count)
         dest[i] = reader.read_next();
 }
 
+uint64_t ysfx_get_audio_underruns(ysfx_t *fx)
+{
+    return fx->file.streamer->underruns();
+}
+
 bool ysfx_find_data_file(ysfx_t *fx, EEL_F *file, std::string &result)
 {
     // 3 possibilities for file
@@ -1460,6 +1827,15 @@ bool ysfx_gfx_wants_retina(ysfx_t *fx)
 #endif
 }
 
+void ysfx_gfx_preload_images(ysfx_t *fx)
+{
+#if !defined(YSFX_NO_GFX)
+    ysfx_gfx_cache_images(fx);
+#else
+    (void)fx;
+#endif
+}
+
 void ysfx_gfx_add_key(ysfx_t *fx, uint32_t mods, uint32_t key, bool press)
 {
 #if !defined(YSFX_NO_GFX)
@@ -1537,3 +1913,31 @@ bool ysfx_gfx_run(ysfx_t *fx)
     return false;
 #endif
 }
+
+uint64_t ysfx_gfx_get_data_serial(ysfx_t *fx)
+{
+#if !defined(YSFX_NO_GFX)
+    return fx->gfx.data_serial.load(std::memory_order_relaxed);
+#else
+    (void)fx;
+    return 0;
+#endif
+}
+
+uint32_t ysfx_gfx_get_damage(ysfx_t *fx, ysfx_gfx_rect_t *rects, uint32_t max_count)
+{
+#if !defined(YSFX_NO_GFX)
+    bool doinit = false;
+    ysfx_scoped_gfx_t scope{fx, doinit};
+
+    if (!fx->gfx.ready)
+        return 0;
+
+    return ysfx_gfx_state_get_damage(fx->gfx.state.get(), rects, max_count);
+#else
+    (void)fx;
+    (void)rects;
+    (void)max_count;
+    return 0;
+#endif
+}
@@ -23,7 +23,9 @@
 #include "ysfx_api_reaper.hpp"
 #include "ysfx_api_file.hpp"
 #include "ysfx_api_gfx.hpp"
+#include "ysfx_convolver.hpp"
 #include "ysfx_utils.hpp"
+#include "ysfx_source_cache.hpp"
 #include "utility/sync_bitset.hpp"
 #include "WDL/eel2/ns-eel.h"
 #include "WDL/eel2/ns-eel-int.h"
@@ -33,12 +35,6 @@
 YSFX_DEFINE_AUTO_PTR(NSEEL_VMCTX_u, void, NSEEL_VM_free); // NOTE: `NSEEL_VMCTX` is `void *`
 YSFX_DEFINE_AUTO_PTR(NSEEL_CODEHANDLE_u, void, NSEEL_code_free); // NOTE: `NSEEL_CODEHANDLE` is `void *`
 
-struct ysfx_source_unit_t {
-    ysfx_toplevel_t toplevel;
-    ysfx_header_t header;
-};
-using ysfx_source_unit_u = std::unique_ptr< ysfx_source_unit_t>;
-
 enum ysfx_file_type_t {
     ysfx_file_type_none,
     ysfx_file_type_txt,
@@ -75,7 +71,7 @@ struct ysfx_s {
         std::string main_file_path;
         std::string bank_path;
         ysfx_source_unit_u main;
-        std::vector<ysfx_source_unit_u> imports;
+        std::vector<ysfx_source_unit_ptr> imports;
         std::unordered_map<std::string, uint32_t> slider_alias;
     } source;
 
@@ -147,6 +143,9 @@ struct ysfx_s {
         ysfx::sync_bitset64 automate_mask;
         ysfx::sync_bitset64 change_mask;
         ysfx::sync_bitset64 visible_mask;
+        // the sliders which exist, and their values as of the last change detection
+        uint64_t exist_mask = 0;
+        ysfx_real last_values[ysfx_max_sliders] = {};
     } slider;
 
     // Triggers
@@ -154,10 +153,25 @@ struct ysfx_s {
 
     // Files
     struct {
+        // NOTE: must outlive the files, which unregister their streams
+        ysfx_audio_streamer_u streamer{new ysfx_audio_streamer_t};
         std::vector<ysfx_file_u> list;
         ysfx::mutex list_mutex;
     } file;
 
+    // FFT
+    struct {
+        // the copies of the transforms which cross the memory blocks,
+        //   for the processing, for @gfx, and for the other sections
+        std::vector<ysfx_real> scratch[3];
+    } fft;
+
+    // Convolvers
+    struct {
+        std::vector<ysfx_convolver_u> list;
+        ysfx::mutex list_mutex;
+    } conv;
+
 #if !defined(YSFX_NO_GFX)
     // Graphics
     struct {
@@ -166,6 +180,13 @@ struct ysfx_s {
         volatile bool ready = false;
         volatile bool wants_retina = false;
         std::atomic<bool> must_init{false};
+        // the variables which @gfx reads, and their values after the last processing;
+        //   if @gfx may read something which is not watched, all the blocks count
+        std::vector<ysfx_real *> watch_vars;
+        std::vector<ysfx_real> watch_values;
+        bool watch_all = true;
+        // advances when the processing may have changed what @gfx displays
+        std::atomic<uint64_t> data_serial{0};
     } gfx;
 #endif
 
@@ -174,19 +195,25 @@ struct ysfx_s {
 
 ysfx_thread_id_t ysfx_get_thread_id();
 void ysfx_set_thread_id(ysfx_thread_id_t id);
+// whether the thread is running the @block or @sample of an effect
+bool ysfx_is_in_audio_section();
 void ysfx_unload_source(ysfx_t *fx);
 void ysfx_unload_code(ysfx_t *fx);
 void ysfx_first_init(ysfx_t *fx);
 void ysfx_update_slider_visibility_mask(ysfx_t *fx);
 void ysfx_fill_file_enums(ysfx_t *fx);
 void ysfx_fix_invalid_enums(ysfx_t *fx);
-ysfx_section_t *ysfx_search_section(ysfx_t *fx, uint32_t type, ysfx_toplevel_t **origin = nullptr);
+ysfx_section_t *ysfx_search_section(ysfx_t *fx, uint32_t type, const ysfx_toplevel_t **origin = nullptr);
 std::string ysfx_resolve_import_path(ysfx_t *fx, const std::string &name, const std::string &origin);
 uint32_t ysfx_current_midi_bus(ysfx_t *fx);
 void ysfx_clear_files(ysfx_t *fx);
 ysfx_file_t *ysfx_get_file(ysfx_t *fx, uint32_t handle, std::unique_lock<ysfx::mutex> &lock, std::unique_lock<ysfx::mutex> *list_lock = nullptr);
 int32_t ysfx_insert_file(ysfx_t *fx, ysfx_file_t *file);
-void ysfx_serialize(ysfx_t *fx);
+void ysfx_clear_convolvers(ysfx_t *fx);
+ysfx_convolver_t *ysfx_get_convolver(ysfx_t *fx, uint32_t handle, std::unique_lock<ysfx::mutex> &lock, std::unique_lock<ysfx::mutex> *list_lock = nullptr);
+int32_t ysfx_insert_convolver(ysfx_t *fx, ysfx_convolver_t *conv);
+// run @serialize; in `realtime`, it does not wait, like @block and @sample
+void ysfx_serialize(ysfx_t *fx, bool realtime = false);
 uint32_t ysfx_get_slider_of_var(ysfx_t *fx, EEL_F *var);
 bool ysfx_find_data_file(ysfx_t *fx, EEL_F *file, std::string &result);
 ysfx_file_type_t ysfx_detect_file_type(ysfx_t *fx, const char *path, void **fmtobj);
@@ -17,10 +17,14 @@
 
 #include "ysfx.hpp"
 #include "ysfx_api_eel.hpp"
+#include "ysfx_eel_utils.hpp"
 #include "ysfx_utils.hpp"
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <cstdlib>
 #include <cstddef>
+#include <vector>
 
 #include "WDL/ptrlist.h"
 #include "WDL/assocarray.h"
@@ -41,19 +45,521 @@ static ysfx::mutex atomic_mutex;
 
 #include "WDL/eel2/eel_strings.h"
 #include "WDL/eel2/eel_misc.h"
-#include "WDL/eel2/eel_fft.h"
 #include "WDL/eel2/eel_mdct.h"
 #include "WDL/eel2/eel_atomic.h"
 
+//------------------------------------------------------------------------------
+// Arithmetic on ranges of memory, which runs vectorized over the contiguous
+//   spans between the blocks of RAM. Like `memcpy`, the ranges are clipped
+//   to the memory; the sources which are not allocated read as zeros, and
+//   overlapping ranges which are not identical give unspecified results.
+
+static EEL_F ysfx_eel_zeros[NSEEL_RAM_ITEMSPERBLOCK];
+
+struct ysfx_eel_mem_span {
+    EEL_F *dst = nullptr;
+    const EEL_F *src[2] = {};
+    uint32_t count = 0;
+};
+
+// visit the ranges of `length` items, which are given by their addresses;
+//   `dst` is absent for the reductions, and `src` has `num_src` addresses
+template <class F>
+static void ysfx_eel_mem_visit(void *opaque, EEL_F length_, const EEL_F *dst_, const EEL_F *const *src_, uint32_t num_src, F &&fn)
+{
+    NSEEL_VMCTX vm = ((ysfx_t *)opaque)->vm.get();
+    const int64_t mem_size = (int64_t)NSEEL_RAM_BLOCKS * NSEEL_RAM_ITEMSPERBLOCK;
+
+    // round towards negative, so the negative addresses keep their distances
+    auto to_index = [mem_size](EEL_F x) -> int64_t {
+        x = std::max<EEL_F>((EEL_F)-mem_size, std::min<EEL_F>(x, (EEL_F)mem_size));
+        return (int64_t)std::floor(x + (EEL_F)0.0001);
+    };
+
+    int64_t length = std::max<int64_t>(0, to_index(length_));
+    int64_t addr[3] = {};
+    uint32_t num_addr = 0;
+    if (dst_)
+        addr[num_addr++] = to_index(*dst_);
+    for (uint32_t i = 0; i < num_src; ++i)
+        addr[num_addr++] = to_index(*src_[i]);
+
+    // trim to the front and to the back
+    int64_t lowest = *std::min_element(addr, addr + num_addr);
+    int64_t highest = *std::max_element(addr, addr + num_addr);
+    if (lowest < 0) {
+        for (uint32_t i = 0; i < num_addr; ++i)
+            addr[i] -= lowest;
+        highest -= lowest;
+        length += lowest;
+    }
+    length = std::min(length, mem_size - highest);
+    if (length <= 0)
+        return;
+
+    ysfx_eel_ram_writer writer;
+    ysfx_eel_ram_reader readers[2];
+    uint32_t a = 0;
+    if (dst_)
+        writer = ysfx_eel_ram_writer{vm, addr[a++]};
+    for (uint32_t i = 0; i < num_src; ++i)
+        readers[i] = ysfx_eel_ram_reader{vm, addr[a++]};
+
+    while (length > 0) {
+        // the largest span which remains inside a block in all the ranges
+        uint32_t n = (uint32_t)std::min<int64_t>(length, NSEEL_RAM_ITEMSPERBLOCK);
+        for (uint32_t i = 0; i < num_addr; ++i)
+            n = std::min<uint32_t>(n, NSEEL_RAM_ITEMSPERBLOCK - (uint32_t)(addr[i] % NSEEL_RAM_ITEMSPERBLOCK));
+
+        ysfx_eel_mem_span span;
+        span.count = n;
+        uint32_t count;
+        if (dst_)
+            span.dst = writer.write_span(n, &count);
+        for (uint32_t i = 0; i < num_src; ++i) {
+            const EEL_F *src = readers[i].read_span(n, &count);
+            span.src[i] = src ? src : ysfx_eel_zeros;
+        }
+
+        // a destination which is not addressable discards the results
+        if (!dst_ || span.dst)
+            fn(span);
+
+        for (uint32_t i = 0; i < num_addr; ++i)
+            addr[i] += n;
+        length -= n;
+    }
+}
+
+static EEL_F NSEEL_CGEN_CALL ysfx_api_mem_add(void *opaque, EEL_F *dst_, EEL_F *src_, EEL_F *len_)
+{
+    const ysfx::f64_kernels &k = ysfx::get_f64_kernels();
+    const EEL_F *src[] = {src_};
+    ysfx_eel_mem_visit(opaque, *len_, dst_, src, 1, [&k](const ysfx_eel_mem_span &s) {
+        k.add(s.dst, s.src[0], s.count);
+    });
+    return *dst_;
+}
+
+static EEL_F NSEEL_CGEN_CALL ysfx_api_mem_mul(void *opaque, EEL_F *dst_, EEL_F *src_, EEL_F *len_)
+{
+    const ysfx::f64_kernels &k = ysfx::get_f64_kernels();
+    const EEL_F *src[] = {src_};
+    ysfx_eel_mem_visit(opaque, *len_, dst_, src, 1, [&k](const ysfx_eel_mem_span &s) {
+        k.mul(s.dst, s.src[0], s.count);
+    });
+    return *dst_;
+}
+
+static EEL_F NSEEL_CGEN_CALL ysfx_api_mem_mac(void *opaque, INT_PTR np, EEL_F **parms)
+{
+    (void)np;
+    const ysfx::f64_kernels &k = ysfx::get_f64_kernels();
+    const EEL_F *src[] = {parms[1], parms[2]};
+    ysfx_eel_mem_visit(opaque, *parms[3], parms[0], src, 2, [&k](const ysfx_eel_mem_span &s) {
+        k.mac(s.dst, s.src[0], s.src[1], s.count);
+    });
+    return *parms[0];
+}
+
+static EEL_F NSEEL_CGEN_CALL ysfx_api_mem_scale(void *opaque, EEL_F *dst_, EEL_F *gain_, EEL_F *len_)
+{
+    const ysfx::f64_kernels &k = ysfx::get_f64_kernels();
+    const EEL_F gain = *gain_;
+    ysfx_eel_mem_visit(opaque, *len_, dst_, nullptr, 0, [&k, gain](const ysfx_eel_mem_span &s) {
+        k.scale(s.dst, gain, s.count);
+    });
+    return *dst_;
+}
+
+static EEL_F NSEEL_CGEN_CALL ysfx_api_mem_sum(void *opaque, EEL_F *src_, EEL_F *len_)
+{
+    const ysfx::f64_kernels &k = ysfx::get_f64_kernels();
+    const EEL_F *src[] = {src_};
+    EEL_F sum = 0;
+    ysfx_eel_mem_visit(opaque, *len_, nullptr, src, 1, [&k, &sum](const ysfx_eel_mem_span &s) {
+        sum += k.sum(s.src[0], s.count);
+    });
+    return sum;
+}
+
+static EEL_F NSEEL_CGEN_CALL ysfx_api_mem_dot(void *opaque, EEL_F *src1_, EEL_F *src2_, EEL_F *len_)
+{
+    const ysfx::f64_kernels &k = ysfx::get_f64_kernels();
+    const EEL_F *src[] = {src1_, src2_};
+    EEL_F sum = 0;
+    ysfx_eel_mem_visit(opaque, *len_, nullptr, src, 2, [&k, &sum](const ysfx_eel_mem_span &s) {
+        sum += k.dot(s.src[0], s.src[1], s.count);
+    });
+    return sum;
+}
+
+// the extremum of an empty range is zero
+template <double (*const ysfx::f64_kernels::*Kernel)(const double *, size_t, double)>
+static EEL_F ysfx_eel_mem_extremum(void *opaque, EEL_F *src_, EEL_F *len_)
+{
+    const ysfx::f64_kernels &k = ysfx::get_f64_kernels();
+    const EEL_F *src[] = {src_};
+    EEL_F value = 0;
+    bool first = true;
+    ysfx_eel_mem_visit(opaque, *len_, nullptr, src, 1, [&k, &value, &first](const ysfx_eel_mem_span &s) {
+        if (first) {
+            value = s.src[0][0];
+            first = false;
+        }
+        value = (k.*Kernel)(s.src[0], s.count, value);
+    });
+    return value;
+}
+
+static EEL_F NSEEL_CGEN_CALL ysfx_api_mem_min(void *opaque, EEL_F *src_, EEL_F *len_)
+{
+    return ysfx_eel_mem_extremum<&ysfx::f64_kernels::min>(opaque, src_, len_);
+}
+
+static EEL_F NSEEL_CGEN_CALL ysfx_api_mem_max(void *opaque, EEL_F *src_, EEL_F *len_)
+{
+    return ysfx_eel_mem_extremum<&ysfx::f64_kernels::max>(opaque, src_, len_);
+}
+
+static EEL_F NSEEL_CGEN_CALL ysfx_api_mem_absmax(void *opaque, EEL_F *src_, EEL_F *len_)
+{
+    // the absolute values are non-negative, so zero is a neutral start
+    const ysfx::f64_kernels &k = ysfx::get_f64_kernels();
+    const EEL_F *src[] = {src_};
+    EEL_F value = 0;
+    ysfx_eel_mem_visit(opaque, *len_, nullptr, src, 1, [&k, &value](const ysfx_eel_mem_span &s) {
+        value = k.absmax(s.src[0], s.count, value);
+    });
+    return value;
+}
+
+//------------------------------------------------------------------------------
+// The FFT functions of eel_fft.h, with the same conventions, over the vector
+//   implementation of ysfx; unlike the original, these go up to the size of
+//   2^16, and the ranges are allowed to cross the boundaries of the blocks.
+
+enum {
+    ysfx_eel_fft_min_bits = 4,
+    ysfx_eel_fft_min_bits_permute = 3,
+};
+
+// 0=fft, 1=ifft, 2=fft_real, 3=ifft_real, 4=fft_permute, 5=fft_ipermute
+static void ysfx_eel_fft_apply(int dir, EEL_F *data, uint32_t bits)
+{
+    switch (dir) {
+    case 0: case 1:
+        ysfx::fft_complex(data, bits, dir & 1);
+        break;
+    case 2: case 3:
+        ysfx::fft_real(data, bits, dir & 1);
+        break;
+    case 4: case 5:
+        ysfx::fft_permute(data, bits, dir & 1);
+        break;
+    }
+}
+
+// the processing, @gfx, and the other sections run by the host, may all
+//   transform concurrently: each has its own buffer
+static uint32_t ysfx_eel_fft_scratch_index()
+{
+    if (ysfx_is_in_audio_section() || ysfx_get_thread_id() == ysfx_thread_id_dsp)
+        return 0;
+    if (ysfx_get_thread_id() == ysfx_thread_id_gfx)
+        return 1;
+    return 2;
+}
+
+void ysfx_eel_fft_prepare(ysfx_t *fx)
+{
+    // the largest is the complex transform, of 2 items per point
+    const size_t capacity = (size_t)2 << ysfx::fft_max_bits;
+    for (std::vector<ysfx_real> &scratch : fx->fft.scratch)
+        scratch.resize(capacity);
+}
+
+static EEL_F *ysfx_eel_fft(int dir, void *opaque, EEL_F *start, EEL_F *length)
+{
+    ysfx_t *fx = (ysfx_t *)opaque;
+    NSEEL_VMCTX vm = fx->vm.get();
+
+    const int64_t offs = ysfx_eel_round<int64_t>(*start);
+    const uint32_t item_shift = (dir & 2) ? 0 : 1;
+
+    int64_t l = ysfx_eel_round<int64_t>(*length);
+    uint32_t bits = 0;
+    while (l > 1 && bits < ysfx::fft_max_bits) {
+        ++bits;
+        l >>= 1;
+    }
+    if (bits < (uint32_t)((dir & 4) ? ysfx_eel_fft_min_bits_permute : ysfx_eel_fft_min_bits))
+        return start;
+
+    const uint32_t count = (uint32_t)1 << (bits + item_shift);
+    if (offs < 0 || offs + count > (int64_t)NSEEL_RAM_BLOCKS * NSEEL_RAM_ITEMSPERBLOCK)
+        return start;
+
+    // in a single block, it transforms the memory directly
+    if (offs / NSEEL_RAM_ITEMSPERBLOCK == (offs + count - 1) / NSEEL_RAM_ITEMSPERBLOCK) {
+        EEL_F *ptr = NSEEL_VM_getramptr(vm, (unsigned)offs, nullptr);
+        if (ptr)
+            ysfx_eel_fft_apply(dir, ptr, bits);
+        return start;
+    }
+
+    // otherwise, it transforms a contiguous copy of the blocks, in the buffer
+    //   of the caller, which the compilation has allocated; without it, the
+    //   transform fails rather than allocate
+    std::vector<ysfx_real> &buffer = fx->fft.scratch[ysfx_eel_fft_scratch_index()];
+    if (buffer.size() < count)
+        return start;
+
+    EEL_F *spans[NSEEL_RAM_BLOCKS];
+    uint32_t num_spans = 0;
+    for (uint32_t i = 0; i < count; ) {
+        const uint32_t addr = (uint32_t)offs + i;
+        const uint32_t n = std::min<uint32_t>(count - i, NSEEL_RAM_ITEMSPERBLOCK - addr % NSEEL_RAM_ITEMSPERBLOCK);
+        EEL_F *ptr = NSEEL_VM_getramptr(vm, addr, nullptr);
+        if (!ptr)
+            return start;
+        spans[num_spans++] = ptr;
+        std::memcpy(&buffer[i], ptr, n * sizeof(EEL_F));
+        i += n;
+    }
+
+    ysfx_eel_fft_apply(dir, buffer.data(), bits);
+
+    for (uint32_t i = 0, s = 0; i < count; ++s) {
+        const uint32_t addr = (uint32_t)offs + i;
+        const uint32_t n = std::min<uint32_t>(count - i, NSEEL_RAM_ITEMSPERBLOCK - addr % NSEEL_RAM_ITEMSPERBLOCK);
+        std::memcpy(spans[s], &buffer[i], n * sizeof(EEL_F));
+        i += n;
+    }
+
+    return start;
+}
+
+static EEL_F *NSEEL_CGEN_CALL ysfx_api_fft(void *opaque, EEL_F *start, EEL_F *length)
+{
+    return ysfx_eel_fft(0, opaque, start, length);
+}
+
+static EEL_F *NSEEL_CGEN_CALL ysfx_api_ifft(void *opaque, EEL_F *start, EEL_F *length)
+{
+    return ysfx_eel_fft(1, opaque, start, length);
+}
+
+static EEL_F *NSEEL_CGEN_CALL ysfx_api_fft_real(void *opaque, EEL_F *start, EEL_F *length)
+{
+    return ysfx_eel_fft(2, opaque, start, length);
+}
+
+static EEL_F *NSEEL_CGEN_CALL ysfx_api_ifft_real(void *opaque, EEL_F *start, EEL_F *length)
+{
+    return ysfx_eel_fft(3, opaque, start, length);
+}
+
+static EEL_F *NSEEL_CGEN_CALL ysfx_api_fft_permute(void *opaque, EEL_F *start, EEL_F *length)
+{
+    return ysfx_eel_fft(4, opaque, start, length);
+}
+
+static EEL_F *NSEEL_CGEN_CALL ysfx_api_fft_ipermute(void *opaque, EEL_F *start, EEL_F *length)
+{
+    return ysfx_eel_fft(5, opaque, start, length);
+}
+
+static EEL_F *NSEEL_CGEN_CALL ysfx_api_convolve_c(EEL_F **blocks, EEL_F *dest, EEL_F *src, EEL_F *lenptr)
+{
+    // the same limits as the original, which multiplies an even number of pairs
+    const int64_t dest_offs = ysfx_eel_round<int64_t>(*dest);
+    const int64_t src_offs = ysfx_eel_round<int64_t>(*src);
+    const int64_t len = ysfx_eel_round<int64_t>(*lenptr) * 2;
+    const int64_t mem_size = (int64_t)NSEEL_RAM_BLOCKS * NSEEL_RAM_ITEMSPERBLOCK;
+
+    if (len < 1 || len > NSEEL_RAM_ITEMSPERBLOCK || dest_offs < 0 || src_offs < 0 ||
+        dest_offs >= mem_size || src_offs >= mem_size)
+        return dest;
+    if ((dest_offs & (NSEEL_RAM_ITEMSPERBLOCK - 1)) + len > NSEEL_RAM_ITEMSPERBLOCK)
+        return dest;
+    if ((src_offs & (NSEEL_RAM_ITEMSPERBLOCK - 1)) + len > NSEEL_RAM_ITEMSPERBLOCK)
+        return dest;
+
+    EEL_F *srcptr = __NSEEL_RAMAlloc(blocks, (unsigned)src_offs);
+    if (!srcptr || srcptr == &nseel_ramalloc_onfail)
+        return dest;
+    EEL_F *destptr = __NSEEL_RAMAlloc(blocks, (unsigned)dest_offs);
+    if (!destptr || destptr == &nseel_ramalloc_onfail)
+        return dest;
+
+    ysfx::get_f64_kernels().cmul(destptr, srcptr, (size_t)((len / 2) & ~1));
+    return dest;
+}
+
+//------------------------------------------------------------------------------
+// The convolvers are made in @init: the response is copied and transformed,
+//   which @block and @sample must not wait for, so they get -1 there. The
+//   response of conv_new_file is read in full, even if the file is streamed.
+//   They can be freed anywhere, and their tail is computed by shared workers,
+//   which @block and @sample do not wait for either.
+
+enum {
+    // the longest impulse response of a convolver, about 3 minutes at 96 kHz
+    ysfx_eel_conv_max_length = 1 << 24,
+};
+
+static EEL_F NSEEL_CGEN_CALL ysfx_api_conv_new(void *opaque, EEL_F *response_, EEL_F *length_)
+{
+    int64_t addr = ysfx_eel_round<int64_t>(*response_);
+    int32_t length = ysfx_eel_round<int32_t>(*length_);
+    if (addr < 0 || length < 0 || length > ysfx_eel_conv_max_length)
+        return -1;
+    if (ysfx_is_in_audio_section())
+        return -1;
+
+    ysfx_t *fx = (ysfx_t *)opaque;
+    std::vector<double> response((size_t)length);
+    ysfx_eel_ram_reader reader{fx->vm.get(), addr};
+    for (uint32_t i = 0; i < (uint32_t)length; ) {
+        uint32_t n = 0;
+        const EEL_F *span = reader.read_span((uint32_t)length - i, &n);
+        if (span)
+            std::copy(span, span + n, &response[i]);
+        i += n;
+    }
+
+    return ysfx_insert_convolver(fx, new ysfx_convolver_t(response.data(), (uint32_t)length));
+}
+
+static EEL_F NSEEL_CGEN_CALL ysfx_api_conv_new_file(void *opaque, EEL_F *handle_, EEL_F *channel_)
+{
+    int32_t handle = ysfx_eel_round<int32_t>(*handle_);
+    int32_t channel = ysfx_eel_round<int32_t>(*channel_);
+    if (handle < 0 || channel < 0)
+        return -1;
+    if (ysfx_is_in_audio_section())
+        return -1;
+
+    ysfx_t *fx = (ysfx_t *)opaque;
+    std::vector<double> response;
+    {
+        std::unique_lock<ysfx::mutex> lock;
+        ysfx_file_t *file = ysfx_get_file(fx, (uint32_t)handle, lock);
+        if (!file)
+            return -1;
+
+        // the files which are not audio have a single channel
+        uint32_t nch = 1;
+        ysfx_real samplerate = 0;
+        if (!file->riff(nch, samplerate))
+            nch = 1;
+        if ((uint32_t)channel >= nch)
+            return -1;
+
+        // the remaining frames, from the current position of the file
+        ysfx_real value = 0;
+        for (uint32_t i = 0; response.size() < ysfx_eel_conv_max_length && file->var(&value); ++i) {
+            if (i % nch == (uint32_t)channel)
+                response.push_back(value);
+        }
+    }
+
+    return ysfx_insert_convolver(fx, new ysfx_convolver_t(response.data(), (uint32_t)response.size()));
+}
+
+static EEL_F NSEEL_CGEN_CALL ysfx_api_conv_process(void *opaque, EEL_F *handle_, EEL_F *buf_, EEL_F *len_)
+{
+    int32_t handle = ysfx_eel_round<int32_t>(*handle_);
+    if (handle < 0)
+        return 0;
+
+    ysfx_t *fx = (ysfx_t *)opaque;
+    std::unique_lock<ysfx::mutex> lock;
+    ysfx_convolver_t *conv = ysfx_get_convolver(fx, (uint32_t)handle, lock);
+    if (!conv)
+        return 0;
+
+    // @block and @sample do not wait for the tail, which counts an underrun if late
+    const bool wait = !ysfx_is_in_audio_section();
+    uint32_t late = 0;
+    ysfx_eel_mem_visit(opaque, *len_, buf_, nullptr, 0, [conv, wait, &late](const ysfx_eel_mem_span &s) {
+        late += conv->process(s.dst, s.count, wait);
+    });
+    if (late > 0)
+        fx->file.streamer->count_underrun(late);
+    return *buf_;
+}
+
+static EEL_F NSEEL_CGEN_CALL ysfx_api_conv_reset(void *opaque, EEL_F *handle_)
+{
+    int32_t handle = ysfx_eel_round<int32_t>(*handle_);
+    if (handle < 0)
+        return -1;
+
+    ysfx_t *fx = (ysfx_t *)opaque;
+    std::unique_lock<ysfx::mutex> lock;
+    ysfx_convolver_t *conv = ysfx_get_convolver(fx, (uint32_t)handle, lock);
+    if (!conv)
+        return -1;
+
+    conv->reset();
+    return 0;
+}
+
+static EEL_F NSEEL_CGEN_CALL ysfx_api_conv_free(void *opaque, EEL_F *handle_)
+{
+    int32_t handle = ysfx_eel_round<int32_t>(*handle_);
+    if (handle < 0)
+        return -1;
+
+    ysfx_t *fx = (ysfx_t *)opaque;
+    std::unique_ptr<ysfx::mutex> conv_mutex;
+    std::unique_lock<ysfx::mutex> lock;
+    std::unique_lock<ysfx::mutex> list_lock;
+
+    // hold both locks to protect the convolver and the list during removal
+    if (!ysfx_get_convolver(fx, (uint32_t)handle, lock, &list_lock))
+        return -1;
+
+    // preserve the locked mutex of the object being removed
+    conv_mutex = std::move(fx->conv.list[(uint32_t)handle]->m_mutex);
+
+    fx->conv.list[(uint32_t)handle].reset();
+    return 0;
+}
+
 //------------------------------------------------------------------------------
 void ysfx_api_init_eel()
 {
     EEL_string_register();
-    EEL_fft_register();
+    ysfx::fft_init();
+    NSEEL_addfunc_retptr("convolve_c", 3, NSEEL_PProc_RAM, &ysfx_api_convolve_c);
+    NSEEL_addfunc_retptr("fft", 2, NSEEL_PProc_THIS, &ysfx_api_fft);
+    NSEEL_addfunc_retptr("ifft", 2, NSEEL_PProc_THIS, &ysfx_api_ifft);
+    NSEEL_addfunc_retptr("fft_real", 2, NSEEL_PProc_THIS, &ysfx_api_fft_real);
+    NSEEL_addfunc_retptr("ifft_real", 2, NSEEL_PProc_THIS, &ysfx_api_ifft_real);
+    NSEEL_addfunc_retptr("fft_permute", 2, NSEEL_PProc_THIS, &ysfx_api_fft_permute);
+    NSEEL_addfunc_retptr("fft_ipermute", 2, NSEEL_PProc_THIS, &ysfx_api_fft_ipermute);
+    NSEEL_addfunc_retval("conv_new", 2, NSEEL_PProc_THIS, &ysfx_api_conv_new);
+    NSEEL_addfunc_retval("conv_new_file", 2, NSEEL_PProc_THIS, &ysfx_api_conv_new_file);
+    NSEEL_addfunc_retval("conv_process", 3, NSEEL_PProc_THIS, &ysfx_api_conv_process);
+    NSEEL_addfunc_retval("conv_reset", 1, NSEEL_PProc_THIS, &ysfx_api_conv_reset);
+    NSEEL_addfunc_retval("conv_free", 1, NSEEL_PProc_THIS, &ysfx_api_conv_free);
     EEL_mdct_register();
     EEL_string_register();
     EEL_misc_register();
     EEL_atomic_register();
+
+    NSEEL_addfunc_retval("mem_add", 3, NSEEL_PProc_THIS, &ysfx_api_mem_add);
+    NSEEL_addfunc_retval("mem_mul", 3, NSEEL_PProc_THIS, &ysfx_api_mem_mul);
+    NSEEL_addfunc_exparms("mem_mac", 4, NSEEL_PProc_THIS, &ysfx_api_mem_mac);
+    NSEEL_addfunc_retval("mem_scale", 3, NSEEL_PProc_THIS, &ysfx_api_mem_scale);
+    NSEEL_addfunc_retval("mem_sum", 2, NSEEL_PProc_THIS, &ysfx_api_mem_sum);
+    NSEEL_addfunc_retval("mem_dot", 3, NSEEL_PProc_THIS, &ysfx_api_mem_dot);
+    NSEEL_addfunc_retval("mem_min", 2, NSEEL_PProc_THIS, &ysfx_api_mem_min);
+    NSEEL_addfunc_retval("mem_max", 2, NSEEL_PProc_THIS, &ysfx_api_mem_max);
+    NSEEL_addfunc_retval("mem_absmax", 2, NSEEL_PProc_THIS, &ysfx_api_mem_absmax);
 }
 
 //------------------------------------------------------------------------------
@@ -132,13 +638,37 @@ const char *ysfx_string_access_unlocked(ysfx_t *fx, ysfx_real id, WDL_FastString
 }
 
 //------------------------------------------------------------------------------
-// NOTE(jpc) implement this? I guess probably not.
-//     DSP and UI should not mutex each other.
+// The compiler guards the state which it shares between the VMs with this:
+//     the global variables and the table of functions. It's entered when a
+//     VM first touches one of these, which permits effects to compile on
+//     multiple threads concurrently.
+
+static ysfx::mutex ysfx_eel_host_mutex;
 
 void NSEEL_HOSTSTUB_EnterMutex()
 {
+    ysfx_eel_host_mutex.lock();
 }
 
 void NSEEL_HOSTSTUB_LeaveMutex()
 {
+    ysfx_eel_host_mutex.unlock();
+}
+
+// The memory of the VMs is guarded apart, with a lock which the build
+//     substitutes in nseel-ram.c: the blocks of the VMs, the shared memory
+//     `gmem`, and the accounting of allocated memory. It's entered when the
+//     code first touches a block, so the processing never waits on a compile.
+//     DSP and UI do not mutex each other in the steady state.
+
+static ysfx::mutex ysfx_eel_ram_mutex;
+
+extern "C" void NSEEL_HOSTSTUB_EnterRAMMutex()
+{
+    ysfx_eel_ram_mutex.lock();
+}
+
+extern "C" void NSEEL_HOSTSTUB_LeaveRAMMutex()
+{
+    ysfx_eel_ram_mutex.unlock();
 }
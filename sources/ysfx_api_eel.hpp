@@ -25,6 +25,11 @@ class WDL_FastString;
 //------------------------------------------------------------------------------
 void ysfx_api_init_eel();
 
+//------------------------------------------------------------------------------
+// allocate the buffers of the transforms which cross the memory blocks,
+//   for the effect to never allocate them while it processes
+void ysfx_eel_fft_prepare(ysfx_t *fx);
+
 //------------------------------------------------------------------------------
 void ysfx_eel_string_initvm(NSEEL_VMCTX vm);
 
@@ -19,53 +19,93 @@
 #include "ysfx_config.hpp"
 #include "ysfx_api_file.hpp"
 #include "ysfx_eel_utils.hpp"
+#include <algorithm>
 #include <cstring>
 #include <cstdio>
 #include <cassert>
 
 ysfx_raw_file_t::ysfx_raw_file_t(NSEEL_VMCTX vm, const char *filename)
-    : m_vm(vm),
-      m_stream(ysfx::fopen_utf8(filename, "rb"))
+    : m_vm(vm)
+{
+    if (!m_map.open(filename, ysfx::mapped_file_min_size))
+        m_stream.reset(ysfx::fopen_utf8(filename, "rb"));
+}
+
+uint64_t ysfx_raw_file_t::map_avail(bool refresh)
 {
+    uint64_t size = refresh ? m_map.refresh() : m_map.size();
+    return (m_map_pos < size) ? (size - m_map_pos) : 0;
 }
 
 int32_t ysfx_raw_file_t::avail()
 {
-    if (!m_stream)
-        return 0;
+    uint64_t byte_count;
 
-    int64_t cur_off = ysfx::ftell_lfs(m_stream.get());
-    if (cur_off == -1)
-        return 0;
+    if (m_map.data())
+        byte_count = map_avail(true);
+    else {
+        if (!m_stream)
+            return 0;
 
-    if (ysfx::fseek_lfs(m_stream.get(), 0, SEEK_END) == -1)
-        return 0;
+        int64_t cur_off = ysfx::ftell_lfs(m_stream.get());
+        if (cur_off == -1)
+            return 0;
 
-    int64_t end_off = ysfx::ftell_lfs(m_stream.get());
-    if (end_off == -1)
-        return 0;
+        if (ysfx::fseek_lfs(m_stream.get(), 0, SEEK_END) == -1)
+            return 0;
 
-    if (ysfx::fseek_lfs(m_stream.get(), cur_off, SEEK_SET) == -1)
-        return 0;
+        int64_t end_off = ysfx::ftell_lfs(m_stream.get());
+        if (end_off == -1)
+            return 0;
 
-    if ((uint64_t)end_off < (uint64_t)cur_off)
-        return 0;
+        if (ysfx::fseek_lfs(m_stream.get(), cur_off, SEEK_SET) == -1)
+            return 0;
+
+        if ((uint64_t)end_off < (uint64_t)cur_off)
+            return 0;
+
+        byte_count = (uint64_t)end_off - (uint64_t)cur_off;
+    }
 
-    uint64_t byte_count = (uint64_t)end_off - (uint64_t)cur_off;
     uint64_t f32_count = byte_count / 4;
     return (f32_count > 0x7fffffff) ? 0x7fffffff : (uint32_t)f32_count;
 }
 
 void ysfx_raw_file_t::rewind()
 {
+    if (m_map.data())
+        m_map_pos = 0;
+    else if (m_stream)
+        ::rewind(m_stream.get());
+}
+
+bool ysfx_raw_file_t::seek(uint64_t position)
+{
+    if (position > (uint64_t)INT64_MAX / 4)
+        return false;
+
+    if (m_map.data()) {
+        m_map_pos = std::min<uint64_t>(4 * position, m_map.refresh());
+        return true;
+    }
+
     if (!m_stream)
-        return;
+        return false;
 
-    ::rewind(m_stream.get());
+    return ysfx::fseek_lfs(m_stream.get(), (int64_t)(4 * position), SEEK_SET) == 0;
 }
 
 bool ysfx_raw_file_t::var(ysfx_real *var)
 {
+    if (m_map.data()) {
+        // check the size again whenever the read enters another 64 KiB
+        if (map_avail((m_map_pos & 0xffff) < 4) < 4)
+            return false;
+        *var = (EEL_F)ysfx::unpack_f32le(m_map.data() + m_map_pos);
+        m_map_pos += 4;
+        return true;
+    }
+
     if (!m_stream)
         return false;
 
@@ -79,6 +119,26 @@ bool ysfx_raw_file_t::var(ysfx_real *var)
 
 uint32_t ysfx_raw_file_t::mem(uint32_t offset, uint32_t length)
 {
+    if (m_map.data()) {
+        uint64_t avail = map_avail(true) / 4;
+        if (length > avail)
+            length = (uint32_t)avail;
+
+        ysfx_eel_ram_writer writer(m_vm, offset);
+
+        // convert from the mapped pages, one RAM block at a time
+        for (uint32_t numread = 0; numread < length; ) {
+            uint32_t n = 0;
+            ysfx_real *span = writer.write_span(length - numread, &n);
+            if (span)
+                ysfx::widen_f32le_to_f64(m_map.data() + m_map_pos + 4 * (uint64_t)numread, span, n);
+            numread += n;
+        }
+
+        m_map_pos += 4 * (uint64_t)length;
+        return length;
+    }
+
     if (!m_stream)
         return 0;
 
@@ -97,6 +157,19 @@ uint32_t ysfx_raw_file_t::mem(uint32_t offset, uint32_t length)
 
 uint32_t ysfx_raw_file_t::string(std::string &str)
 {
+    if (m_map.data()) {
+        uint64_t avail = map_avail(true);
+        if (avail < 4)
+            return 0;
+
+        const uint8_t *data = m_map.data() + m_map_pos;
+        uint32_t srclen = ysfx::unpack_u32le(data);
+        uint32_t count = (uint32_t)std::min<uint64_t>(srclen, avail - 4);
+        str.assign((const char *)data + 4, std::min<uint32_t>(count, ysfx_string_max_length));
+        m_map_pos += 4 + (uint64_t)count;
+        return count;
+    }
+
     if (!m_stream)
         return 0;
 
@@ -123,7 +196,8 @@ ysfx_text_file_t::ysfx_text_file_t(NSEEL_VMCTX vm, const char *filename)
     : m_vm(vm),
       m_stream(ysfx::fopen_utf8(filename, "rb"))
 {
-    m_buf.reserve(256);
+    if (m_stream)
+        m_buf.resize(buffer_size);
 }
 
 int32_t ysfx_text_file_t::avail()
@@ -131,7 +205,7 @@ int32_t ysfx_text_file_t::avail()
     if (!m_stream || ferror(m_stream.get()))
         return -1;
 
-    return (feof(m_stream.get()) == 0) ? 0 : 1;
+    return m_eof ? 1 : 0;
 }
 
 void ysfx_text_file_t::rewind()
@@ -140,50 +214,109 @@ void ysfx_text_file_t::rewind()
         return;
 
     ::rewind(m_stream.get());
+    m_buf_pos = 0;
+    m_buf_end = 0;
+    m_eof = false;
+}
+
+bool ysfx_text_file_t::fill_buffer()
+{
+    // keep the pending part at the front, and grow if it occupies all the space
+    size_t pending = m_buf_end - m_buf_pos;
+    if (m_buf_pos > 0)
+        memmove(m_buf.data(), m_buf.data() + m_buf_pos, pending);
+    else if (pending == m_buf.size())
+        m_buf.resize(2 * m_buf.size());
+    m_buf_pos = 0;
+    m_buf_end = pending;
+
+    size_t count = fread(m_buf.data() + m_buf_end, 1, m_buf.size() - m_buf_end, m_stream.get());
+    m_buf_end += count;
+    return count > 0;
+}
+
+bool ysfx_text_file_t::next_field(const char **first, const char **last)
+{
+    // get the next field separated by newline or comma; the returned range is
+    //   valid until the next call. returns false for the final one at the end
+    for (size_t scan = m_buf_pos; ; ) {
+        const char *data = m_buf.data();
+        for (size_t i = scan; i < m_buf_end; ++i) {
+            if (data[i] == '\n' || data[i] == ',') {
+                *first = data + m_buf_pos;
+                *last = data + i;
+                m_buf_pos = i + 1;
+                return true;
+            }
+        }
+        scan = m_buf_end - m_buf_pos;
+        if (m_eof || !fill_buffer()) {
+            m_eof = true;
+            *first = m_buf.data() + m_buf_pos;
+            *last = m_buf.data() + m_buf_end;
+            m_buf_pos = m_buf_end;
+            return false;
+        }
+    }
 }
 
-bool ysfx_text_file_t::var(ysfx_real *var)
+bool ysfx_text_file_t::next_number(ysfx_real *var)
 {
-    if (!m_stream)
-        return false;
-
     //TODO support the expression language for arithmetic
 
-    int ch;
-    do {
-        // get the next number separated by newline or comma
-        // but skip invalid lines
-        m_buf.clear();
-        while ((ch = fgetc(m_stream.get())) != EOF && ch != '\n' && ch != ',')
-            m_buf.push_back((unsigned char)ch);
-        const char *startp = m_buf.c_str();
-        const char *endp = (char *)startp;
-        double value = ysfx::dot_strtod(startp, (char **)&endp);
-        if (endp != startp) {
+    // skip the fields which are not numbers
+    for (bool more = true; more; ) {
+        const char *first;
+        const char *last;
+        more = next_field(&first, &last);
+        double value;
+        if (ysfx::dot_parse_number(first, last, value) != first) {
             *var = (EEL_F)value;
             return true;
         }
-    } while (ch != EOF);
+    }
 
     return false;
 }
 
+bool ysfx_text_file_t::var(ysfx_real *var)
+{
+    if (!m_stream)
+        return false;
+
+    return next_number(var);
+}
+
 uint32_t ysfx_text_file_t::mem(uint32_t offset, uint32_t length)
 {
     if (!m_stream)
         return 0;
 
-    ysfx_eel_ram_writer writer{m_vm, offset};
+    uint32_t numread = 0;
+    ysfx_eel_ram_writer writer(m_vm, offset);
 
-    uint32_t read;
-    for (read = 0; read < length; ++read) {
-        ysfx_real value;
-        if (!var(&value))
+    // parse directly into the VM memory, one RAM block at a time
+    while (numread < length) {
+        uint32_t n = 0;
+        ysfx_real *span = writer.write_span(length - numread, &n);
+
+        uint32_t m = 0;
+        if (span) {
+            while (m < n && next_number(&span[m]))
+                ++m;
+        }
+        else {
+            ysfx_real discard;
+            while (m < n && next_number(&discard))
+                ++m;
+        }
+
+        numread += m;
+        if (m < n)
             break;
-        writer.write_next(value);
     }
 
-    return read;
+    return numread;
 }
 
 uint32_t ysfx_text_file_t::string(std::string &str)
@@ -194,43 +327,126 @@ uint32_t ysfx_text_file_t::string(std::string &str)
     str.clear();
     str.reserve(256);
 
-    int ch;
-    do {
-        ch = fgetc(m_stream.get());
-        if (ch != EOF && str.size() < ysfx_string_max_length)
-            str.push_back((unsigned char)ch);
-    } while (ch != EOF && ch != '\n');
+    // read a line, including the final newline
+    for (bool done = false; !done; ) {
+        const char *data = m_buf.data();
+        size_t i = m_buf_pos;
+        while (i < m_buf_end && data[i] != '\n')
+            ++i;
+        done = i < m_buf_end;
+        i += done;
+
+        size_t room = ysfx_string_max_length - str.size();
+        size_t count = i - m_buf_pos;
+        str.append(data + m_buf_pos, (count < room) ? count : room);
+        m_buf_pos = i;
+
+        if (!done && (m_eof || !fill_buffer())) {
+            m_eof = true;
+            done = true;
+        }
+    }
 
     return (uint32_t)str.size();
 }
 
 //------------------------------------------------------------------------------
-ysfx_audio_file_t::ysfx_audio_file_t(NSEEL_VMCTX vm, const ysfx_audio_format_t &fmt, const char *filename)
+ysfx_audio_file_t::ysfx_audio_file_t(NSEEL_VMCTX vm, const ysfx_audio_format_t &fmt, const char *filename, ysfx_audio_cache_t *cache, ysfx_audio_streamer_t *streamer, uint32_t read_ahead)
     : m_vm(vm),
       m_fmt(fmt),
-      m_reader(fmt.open(filename), fmt.close)
+      m_reader(nullptr, fmt.close),
+      m_streamer(streamer)
+{
+    // in the processing, take only what is decoded already, and stream the rest,
+    //   which the worker thread opens
+    bool realtime = ysfx_is_in_audio_section();
+    if (cache)
+        m_data = ysfx_audio_cache_acquire(cache, fmt, filename, !realtime);
+    if (!m_data && streamer && read_ahead > 0)
+        m_stream = streamer->open(fmt, filename, read_ahead, realtime);
+    if (!m_data && !m_stream)
+        m_reader.reset(fmt.open(filename));
+}
+
+ysfx_audio_file_t::~ysfx_audio_file_t()
 {
+    if (m_stream)
+        m_streamer->close(m_stream);
+}
+
+uint32_t ysfx_audio_file_t::read_stream(ysfx_real *samples, uint32_t count)
+{
+    bool underrun = false;
+    uint32_t numread = m_stream->read(samples, count, underrun);
+    if (!underrun)
+        return numread;
+
+    // @block and @sample get what is ready; the other sections read
+    //   synchronously, like the files which are not streamed
+    if (ysfx_is_in_audio_section()) {
+        m_streamer->count_underrun();
+        return numread;
+    }
+    while (underrun) {
+        m_streamer->wait_fill();
+        numread += m_stream->read(samples + numread, count - numread, underrun);
+    }
+    return numread;
 }
 
 int32_t ysfx_audio_file_t::avail()
 {
-    if (!m_reader)
+    uint64_t avail;
+    if (m_data)
+        avail = m_data->samples.size() - m_data_pos;
+    else if (m_stream)
+        avail = m_stream->avail();
+    else if (m_reader)
+        avail = m_fmt.avail(m_reader.get());
+    else
         return -1;
 
-    uint64_t avail = m_fmt.avail(m_reader.get());
     return (avail > 0x7fffffff) ? 0x7fffffff : (int32_t)avail;
 }
 
 void ysfx_audio_file_t::rewind()
 {
-    if (!m_reader)
-        return;
+    if (m_data)
+        m_data_pos = 0;
+    else if (m_stream)
+        m_stream->rewind();
+    else if (m_reader)
+        m_fmt.rewind(m_reader.get());
+}
 
-    m_fmt.rewind(m_reader.get());
+bool ysfx_audio_file_t::seek(uint64_t position)
+{
+    if (m_data) {
+        m_data_pos = (size_t)std::min<uint64_t>(position, m_data->samples.size());
+        return true;
+    }
+    else if (m_stream) {
+        m_stream->seek(position);
+        return true;
+    }
+    else if (m_reader)
+        return ysfx_audio_seek(m_fmt, m_reader.get(), position);
+
+    return false;
 }
 
 bool ysfx_audio_file_t::var(ysfx_real *var)
 {
+    if (m_data) {
+        if (m_data_pos == m_data->samples.size())
+            return false;
+        *var = m_data->samples[m_data_pos++];
+        return true;
+    }
+
+    if (m_stream)
+        return read_stream(var, 1) == 1;
+
     if (!m_reader)
         return false;
 
@@ -239,21 +455,80 @@ bool ysfx_audio_file_t::var(ysfx_real *var)
 
 uint32_t ysfx_audio_file_t::mem(uint32_t offset, uint32_t length)
 {
+    if (m_data) {
+        size_t avail = m_data->samples.size() - m_data_pos;
+        if (length > avail)
+            length = (uint32_t)avail;
+
+        const ysfx_real *src = m_data->samples.data() + m_data_pos;
+        ysfx_eel_ram_writer writer(m_vm, offset);
+
+        // copy from the shared buffer, one RAM block at a time
+        for (uint32_t numread = 0; numread < length; ) {
+            uint32_t n = 0;
+            ysfx_real *span = writer.write_span(length - numread, &n);
+            if (span)
+                memcpy(span, src + numread, n * sizeof(ysfx_real));
+            numread += n;
+        }
+
+        m_data_pos += length;
+        return length;
+    }
+
+    if (m_stream) {
+        uint32_t numread = 0;
+        ysfx_eel_ram_writer writer(m_vm, offset);
+
+        // copy out of the stream, which waits for the samples only outside of @block and @sample
+        while (numread < length) {
+            uint32_t n = 0;
+            ysfx_real *span = writer.write_span(length - numread, &n);
+
+            uint32_t m = 0;
+            if (span)
+                m = read_stream(span, n);
+            else {
+                // out of addressable memory: consume the samples and discard them
+                for (bool end = false; m < n && !end; ) {
+                    uint32_t k = (n - m < buffer_size) ? (n - m) : (uint32_t)buffer_size;
+                    uint32_t r = read_stream(m_buf.get(), k);
+                    m += r;
+                    end = r < k;
+                }
+            }
+
+            numread += m;
+            if (m < n)
+                break;
+        }
+
+        return numread;
+    }
+
     if (!m_reader)
         return 0;
 
     uint32_t numread = 0;
-    ysfx_real *buf = m_buf.get();
     ysfx_eel_ram_writer writer(m_vm, offset);
 
+    // decode directly into the VM memory, one RAM block at a time
     while (numread < length) {
-        uint32_t n = length - numread;
-        if (n > buffer_size)
-            n = buffer_size;
-
-        uint32_t m = (uint32_t)m_fmt.read(m_reader.get(), buf, n);
-        for (uint32_t i = 0; i < m; ++i)
-            writer.write_next(buf[i]);
+        uint32_t n = 0;
+        ysfx_real *span = writer.write_span(length - numread, &n);
+
+        uint32_t m = 0;
+        if (span)
+            m = (uint32_t)m_fmt.read(m_reader.get(), span, n);
+        else {
+            // out of addressable memory: consume the samples and discard them
+            for (bool eof = false; m < n && !eof; ) {
+                uint32_t k = (n - m < buffer_size) ? (n - m) : (uint32_t)buffer_size;
+                uint32_t r = (uint32_t)m_fmt.read(m_reader.get(), m_buf.get(), k);
+                m += r;
+                eof = r < k;
+            }
+        }
 
         numread += m;
         if (m < n)
@@ -271,10 +546,16 @@ uint32_t ysfx_audio_file_t::string(std::string &str)
 
 bool ysfx_audio_file_t::riff(uint32_t &nch, ysfx_real &samplerate)
 {
-    if (!m_reader)
+    ysfx_audio_file_info_t info;
+    if (m_data)
+        info = m_data->info;
+    else if (m_stream)
+        info = m_stream->info();
+    else if (m_reader)
+        info = m_fmt.info(m_reader.get());
+    else
         return false;
 
-    ysfx_audio_file_info_t info = m_fmt.info(m_reader.get());
     nch = info.channels;
     samplerate = info.sample_rate;
     return true;
@@ -286,17 +567,72 @@ ysfx_serializer_t::ysfx_serializer_t(NSEEL_VMCTX vm)
 {
 }
 
-void ysfx_serializer_t::begin(bool write, std::string &buffer)
+void ysfx_serializer_t::begin_save()
 {
-    m_write = (int)write;
-    m_buffer = &buffer;
+    m_write = 1;
+    m_save_capacity = m_last_save_size;
+    m_save.reset(new uint8_t[m_save_capacity]);
+    m_size = 0;
     m_pos = 0;
 }
 
-void ysfx_serializer_t::end()
+void ysfx_serializer_t::begin_save_into(uint8_t *buffer, size_t capacity)
 {
+    m_write = 1;
+    m_save_into = buffer;
+    m_save_capacity = capacity;
+    m_size = 0;
+    m_pos = 0;
+}
+
+void ysfx_serializer_t::begin_load(const uint8_t *data, size_t size)
+{
+    m_write = 0;
+    m_load = data;
+    m_size = size;
+    m_pos = 0;
+}
+
+std::unique_ptr<uint8_t[]> ysfx_serializer_t::end(size_t *size)
+{
+    std::unique_ptr<uint8_t[]> data;
+    bool saved = m_write == 1;
+    if (saved) {
+        data = std::move(m_save);
+        m_save_capacity = 0;
+        m_last_save_size = m_size;
+    }
+    if (size)
+        *size = saved ? m_size : 0;
     m_write = -1;
-    m_buffer = nullptr;
+    m_save_into = nullptr;
+    m_load = nullptr;
+    m_size = 0;
+    m_pos = 0;
+    return data;
+}
+
+uint8_t *ysfx_serializer_t::append(size_t count)
+{
+    if (m_save_into) {
+        uint8_t *dst = (m_size + count <= m_save_capacity) ? &m_save_into[m_size] : nullptr;
+        m_size += count;
+        return dst;
+    }
+
+    if (m_size + count > m_save_capacity) {
+        size_t capacity = (m_save_capacity > 64) ? m_save_capacity : 64;
+        while (capacity < m_size + count)
+            capacity *= 2;
+        std::unique_ptr<uint8_t[]> save{new uint8_t[capacity]};
+        if (m_size > 0)
+            memcpy(save.get(), m_save.get(), m_size);
+        m_save = std::move(save);
+        m_save_capacity = capacity;
+    }
+    uint8_t *dst = &m_save[m_size];
+    m_size += count;
+    return dst;
 }
 
 int32_t ysfx_serializer_t::avail()
@@ -314,18 +650,17 @@ void ysfx_serializer_t::rewind()
 bool ysfx_serializer_t::var(ysfx_real *var)
 {
     if (m_write == 1) {
-        uint8_t buf[4];
-        ysfx::pack_f32le((float)*var, buf);
-        m_buffer->append((char *)buf, 4);
+        if (uint8_t *dst = append(4))
+            ysfx::pack_f32le((float)*var, dst);
         return true;
     }
     else if (m_write == 0) {
-        if (m_pos + 4 > m_buffer->size()) {
-            m_pos = m_buffer->size();
+        if (m_pos + 4 > m_size) {
+            m_pos = m_size;
             *var = 0;
             return false;
         }
-        *var = (EEL_F)ysfx::unpack_f32le((uint8_t *)&(*m_buffer)[m_pos]);
+        *var = (EEL_F)ysfx::unpack_f32le(&m_load[m_pos]);
         m_pos += 4;
         return true;
     }
@@ -335,23 +670,37 @@ bool ysfx_serializer_t::var(ysfx_real *var)
 uint32_t ysfx_serializer_t::mem(uint32_t offset, uint32_t length)
 {
     if (m_write == 1) {
+        // reserve the whole size at once, and convert the memory block by block
+        uint8_t *dst = append(4 * (size_t)length);
+        if (!dst)
+            return length;
         ysfx_eel_ram_reader reader{m_vm, offset};
-        for (uint32_t i = 0; i < length; ++i) {
-            ysfx_real value = reader.read_next();
-            if (!var(&value))
-                return i;
+        for (uint32_t i = 0; i < length; ) {
+            uint32_t count = 0;
+            const ysfx_real *span = reader.read_span(length - i, &count);
+            if (span)
+                ysfx::narrow_f64_to_f32le(span, &dst[4 * (size_t)i], count);
+            else
+                memset(&dst[4 * (size_t)i], 0, 4 * (size_t)count);
+            i += count;
         }
         return length;
     }
     else if (m_write == 0) {
+        uint32_t avail = (uint32_t)std::min<size_t>((m_size - m_pos) / 4, length);
         ysfx_eel_ram_writer writer{m_vm, offset};
-        for (uint32_t i = 0; i < length; ++i) {
-            ysfx_real value{};
-            if (!var(&value))
-                return i;
-            writer.write_next(value);
+        for (uint32_t i = 0; i < avail; ) {
+            uint32_t count = 0;
+            ysfx_real *span = writer.write_span(avail - i, &count);
+            if (span)
+                ysfx::widen_f32le_to_f64(&m_load[m_pos], span, count);
+            m_pos += 4 * (size_t)count;
+            i += count;
         }
-        return length;
+        // a short read consumes the rest of the data, like `var`
+        if (avail < length)
+            m_pos = m_size;
+        return avail;
     }
     return 0;
 }
@@ -384,7 +733,7 @@ static EEL_F NSEEL_CGEN_CALL ysfx_api_file_open(void *opaque, EEL_F *file_)
         file.reset(new ysfx_raw_file_t(fx->vm.get(), filepath.c_str()));
         break;
     case ysfx_file_type_audio:
-        file.reset(new ysfx_audio_file_t(fx->vm.get(), *(ysfx_audio_format_t *)fmtobj, filepath.c_str()));
+        file.reset(new ysfx_audio_file_t(fx->vm.get(), *(ysfx_audio_format_t *)fmtobj, filepath.c_str(), fx->config->audio_cache.get(), fx->file.streamer.get(), fx->config->audio_read_ahead));
         break;
     case ysfx_file_type_none:
         break;
@@ -441,6 +790,25 @@ static EEL_F *NSEEL_CGEN_CALL ysfx_api_file_rewind(void *opaque, EEL_F *handle_)
     return handle_;
 }
 
+static EEL_F NSEEL_CGEN_CALL ysfx_api_file_seek(void *opaque, EEL_F *handle_, EEL_F *position_)
+{
+    int32_t handle = ysfx_eel_round<int32_t>(*handle_);
+    if (handle < 0)
+        return 0;
+
+    int64_t position = ysfx_eel_round<int64_t>(*position_);
+    if (position < 0)
+        return 0;
+
+    ysfx_t *fx = (ysfx_t *)opaque;
+    std::unique_lock<ysfx::mutex> lock;
+    ysfx_file_t *file = ysfx_get_file(fx, (uint32_t)handle, lock);
+    if (!file)
+        return 0;
+
+    return file->seek((uint64_t)position);
+}
+
 static EEL_F NSEEL_CGEN_CALL ysfx_api_file_var(void *opaque, EEL_F *handle_, EEL_F *var)
 {
     int32_t handle = ysfx_eel_round<int32_t>(*handle_);
@@ -565,6 +933,7 @@ void ysfx_api_init_file()
     NSEEL_addfunc_retval("file_open", 1, NSEEL_PProc_THIS, &ysfx_api_file_open);
     NSEEL_addfunc_retval("file_close", 1, NSEEL_PProc_THIS, &ysfx_api_file_close);
     NSEEL_addfunc_retptr("file_rewind", 1, NSEEL_PProc_THIS, &ysfx_api_file_rewind);
+    NSEEL_addfunc_retval("file_seek", 2, NSEEL_PProc_THIS, &ysfx_api_file_seek);
     NSEEL_addfunc_retval("file_var", 2, NSEEL_PProc_THIS, &ysfx_api_file_var);
     NSEEL_addfunc_retval("file_mem", 3, NSEEL_PProc_THIS, &ysfx_api_file_mem);
     NSEEL_addfunc_retval("file_avail", 1, NSEEL_PProc_THIS, &ysfx_api_file_avail);
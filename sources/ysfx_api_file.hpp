@@ -18,6 +18,8 @@
 #pragma once
 #include "ysfx.h"
 #include "ysfx_utils.hpp"
+#include "ysfx_audio_cache.hpp"
+#include "ysfx_audio_stream.hpp"
 #include "WDL/eel2/ns-eel.h"
 #include "WDL/eel2/ns-eel-int.h"
 #include <vector>
@@ -28,6 +30,7 @@ struct ysfx_file_t {
 
     virtual int32_t avail() = 0;
     virtual void rewind() = 0;
+    virtual bool seek(uint64_t position) = 0;
     virtual bool var(ysfx_real *var) = 0;
     virtual uint32_t mem(uint32_t offset, uint32_t length) = 0;
     virtual uint32_t string(std::string &str) = 0;
@@ -47,6 +50,7 @@ struct ysfx_raw_file_t final : ysfx_file_t {
 
     int32_t avail() override;
     void rewind() override;
+    bool seek(uint64_t position) override;
     bool var(ysfx_real *var) override;
     uint32_t mem(uint32_t offset, uint32_t length) override;
     uint32_t string(std::string &str) override;
@@ -54,7 +58,13 @@ struct ysfx_raw_file_t final : ysfx_file_t {
     bool is_text() override { return false; }
     bool is_in_write_mode() override { return false; }
 
+    // the bytes which remain in the mapping, optionally checking for a truncation
+    uint64_t map_avail(bool refresh);
+
     NSEEL_VMCTX m_vm = nullptr;
+    // the file is mapped if it is large, otherwise it is read with stdio
+    ysfx::mapped_file m_map;
+    uint64_t m_map_pos = 0;
     ysfx::FILE_u m_stream;
 };
 
@@ -65,6 +75,7 @@ struct ysfx_text_file_t final : ysfx_file_t {
 
     int32_t avail() override;
     void rewind() override;
+    bool seek(uint64_t) override { return false; }
     bool var(ysfx_real *var) override;
     uint32_t mem(uint32_t offset, uint32_t length) override;
     uint32_t string(std::string &str) override;
@@ -72,18 +83,28 @@ struct ysfx_text_file_t final : ysfx_file_t {
     bool is_text() override { return true; }
     bool is_in_write_mode() override { return false; }
 
+    bool next_field(const char **first, const char **last);
+    bool next_number(ysfx_real *var);
+    bool fill_buffer();
+
     NSEEL_VMCTX m_vm = nullptr;
     ysfx::FILE_u m_stream;
-    std::string m_buf;
+    enum { buffer_size = 65536 };
+    std::vector<char> m_buf;
+    size_t m_buf_pos = 0;
+    size_t m_buf_end = 0;
+    bool m_eof = false;
 };
 
 //------------------------------------------------------------------------------
 
 struct ysfx_audio_file_t final : ysfx_file_t {
-    ysfx_audio_file_t(NSEEL_VMCTX vm, const ysfx_audio_format_t &fmt, const char *filename);
+    ysfx_audio_file_t(NSEEL_VMCTX vm, const ysfx_audio_format_t &fmt, const char *filename, ysfx_audio_cache_t *cache = nullptr, ysfx_audio_streamer_t *streamer = nullptr, uint32_t read_ahead = 0);
+    ~ysfx_audio_file_t() override;
 
     int32_t avail() override;
     void rewind() override;
+    bool seek(uint64_t position) override;
     bool var(ysfx_real *var) override;
     uint32_t mem(uint32_t offset, uint32_t length) override;
     uint32_t string(std::string &str) override;
@@ -91,11 +112,19 @@ struct ysfx_audio_file_t final : ysfx_file_t {
     bool is_text() override { return false; }
     bool is_in_write_mode() override { return false; }
 
+    uint32_t read_stream(ysfx_real *samples, uint32_t count);
+
     NSEEL_VMCTX m_vm = nullptr;
     ysfx_audio_format_t m_fmt{};
     std::unique_ptr<ysfx_audio_reader_t, void (*)(ysfx_audio_reader_t *)> m_reader;
     enum { buffer_size = 256 };
     std::unique_ptr<ysfx_real[]> m_buf{new ysfx_real[buffer_size]};
+    // if the file is cached, its decoded contents replace the reader
+    ysfx_audio_data_ptr m_data;
+    size_t m_data_pos = 0;
+    // if the file is streamed, the worker thread owns the reader
+    ysfx_audio_streamer_t *m_streamer = nullptr;
+    ysfx_audio_stream_ptr m_stream = nullptr;
 };
 
 //------------------------------------------------------------------------------
@@ -103,11 +132,19 @@ struct ysfx_audio_file_t final : ysfx_file_t {
 struct ysfx_serializer_t final : ysfx_file_t {
     explicit ysfx_serializer_t(NSEEL_VMCTX vm);
 
-    void begin(bool write, std::string &buffer);
-    void end();
+    // start saving into a new buffer, presized to the previous save
+    void begin_save();
+    // start saving into a fixed buffer, which must remain valid until `end`;
+    //   the writes past its capacity are dropped, but they count in the size
+    void begin_save_into(uint8_t *buffer, size_t capacity);
+    // start loading from the data, which must remain valid until `end`
+    void begin_load(const uint8_t *data, size_t size);
+    // finish the operation; after saving, give away the data which was written
+    std::unique_ptr<uint8_t[]> end(size_t *size = nullptr);
 
     int32_t avail() override;
     void rewind() override;
+    bool seek(uint64_t) override { return false; }
     bool var(ysfx_real *var) override;
     uint32_t mem(uint32_t offset, uint32_t length) override;
     uint32_t string(std::string &str) override;
@@ -115,9 +152,21 @@ struct ysfx_serializer_t final : ysfx_file_t {
     bool is_text() override { return false; }
     bool is_in_write_mode() override { return m_write == 1; }
 
+    // reserve `count` bytes at the end of the save buffer, and get them,
+    //   or null if they are past the capacity of a fixed buffer
+    uint8_t *append(size_t count);
+
     NSEEL_VMCTX m_vm{};
     int m_write = -1;
-    std::string *m_buffer = nullptr;
+    // the buffer being saved, which is allocated so as to be given to the state
+    std::unique_ptr<uint8_t[]> m_save;
+    size_t m_save_capacity = 0;
+    size_t m_last_save_size = 0;
+    // the fixed buffer being saved, if any
+    uint8_t *m_save_into = nullptr;
+    // the data being loaded
+    const uint8_t *m_load = nullptr;
+    size_t m_size = 0;
     size_t m_pos = 0;
 };
 
@@ -80,6 +80,11 @@ static bool eel_lice_get_filename_for_string(void *opaque, EEL_F idx, WDL_FastSt
 #define EEL_LICE_GET_FILENAME_FOR_STRING(idx, fs, p)    \
     eel_lice_get_filename_for_string(opaque, (idx), (fs), (p))
 
+static LICE_IBitmap *eel_lice_load_image(void *opaque, const char *path);
+
+#define EEL_LICE_LOAD_IMAGE(opaque, path)               \
+    eel_lice_load_image((opaque), (path))
+
 #endif // !defined(YSFX_NO_GFX)
 
 //------------------------------------------------------------------------------
@@ -89,6 +94,65 @@ static bool eel_lice_get_filename_for_string(void *opaque, EEL_F idx, WDL_FastSt
 #   include "ysfx_api_gfx_dummy.hpp"
 #endif
 
+//------------------------------------------------------------------------------
+#if !defined(YSFX_NO_GFX)
+static ysfx_image_data_ptr ysfx_gfx_decode_image(const char *path)
+{
+    std::unique_ptr<LICE_IBitmap> bm{LICE_LoadImage(path, nullptr, false)};
+    if (!bm)
+        return nullptr;
+
+    uint32_t w = (uint32_t)bm->getWidth();
+    uint32_t h = (uint32_t)bm->getHeight();
+    const LICE_pixel *bits = bm->getBits();
+    size_t span = (size_t)bm->getRowSpan();
+    bool flipped = bm->isFlipped();
+
+    std::shared_ptr<ysfx_image_data_t> data{new ysfx_image_data_t};
+    data->width = w;
+    data->height = h;
+    data->pixels.resize((size_t)w * h);
+    for (uint32_t row = 0; row < h; ++row) {
+        const LICE_pixel *src = &bits[(flipped ? (h - 1 - row) : row) * span];
+        memcpy(&data->pixels[(size_t)row * w], src, w * sizeof(LICE_pixel));
+    }
+
+    return data;
+}
+
+static LICE_IBitmap *eel_lice_load_image(void *opaque, const char *path)
+{
+    ysfx_t *fx = (ysfx_t *)opaque;
+
+    ysfx_image_cache_t *cache = fx->config->image_cache.get();
+    if (!cache)
+        return LICE_LoadImage(path, nullptr, false);
+
+    ysfx_image_data_ptr data = ysfx_image_cache_acquire(cache, path, &ysfx_gfx_decode_image);
+    if (!data)
+        return nullptr;
+
+    return new eel_lice_shared_bitmap(data);
+}
+
+void ysfx_gfx_cache_images(ysfx_t *fx)
+{
+    ysfx_image_cache_t *cache = fx->config->image_cache.get();
+    if (!cache || !fx->source.main)
+        return;
+
+    // these are the images which @gfx loads at first, the files which are
+    //   not images get rejected by their extension without being read
+    uint32_t numfiles = (uint32_t)fx->source.main->header.filenames.size();
+    for (uint32_t i = 0; i < numfiles; ++i) {
+        EEL_F index = (EEL_F)i;
+        std::string path;
+        if (ysfx_find_data_file(fx, &index, path))
+            ysfx_image_cache_acquire(cache, path.c_str(), &ysfx_gfx_decode_image);
+    }
+}
+#endif // !defined(YSFX_NO_GFX)
+
 //------------------------------------------------------------------------------
 #if !defined(YSFX_NO_GFX)
 static bool translate_special_key(uint32_t uni_key, uint32_t &jsfx_key)
@@ -276,6 +340,24 @@ bool ysfx_gfx_state_is_dirty(ysfx_gfx_state_t *state)
     return state->lice->m_framebuffer_dirty;
 }
 
+uint32_t ysfx_gfx_state_get_damage(ysfx_gfx_state_t *state, ysfx_gfx_rect_t *rects, uint32_t max_count)
+{
+    static_assert((int)eel_lice_damage::MAX_RECTS <= (int)ysfx_gfx_max_damage, "too many damage rectangles");
+
+    const eel_lice_damage &damage = state->lice->m_framebuffer_damage;
+    uint32_t count = (uint32_t)damage.count();
+
+    for (uint32_t i = 0; i < count && i < max_count; ++i) {
+        const RECT &r = damage.get((int)i);
+        rects[i].x = (uint32_t)r.left;
+        rects[i].y = (uint32_t)r.top;
+        rects[i].w = (uint32_t)(r.right - r.left);
+        rects[i].h = (uint32_t)(r.bottom - r.top);
+    }
+
+    return count;
+}
+
 void ysfx_gfx_state_add_key(ysfx_gfx_state_t *state, uint32_t mods, uint32_t key, bool press)
 {
     if (key < 1)
@@ -387,6 +469,7 @@ void ysfx_gfx_prepare(ysfx_t *fx)
     eel_lice_state *lice = state->lice.get();
 
     lice->m_framebuffer_dirty = false;
+    lice->m_framebuffer_damage.clear();
 
     // set variables `gfx_w` and `gfx_h`
     ysfx_real gfx_w = (ysfx_real)lice->m_framebuffer->getWidth();
@@ -400,6 +483,14 @@ void ysfx_gfx_prepare(ysfx_t *fx)
     *fx->var.gfx_h = gfx_h;
 }
 
+#if defined(YSFX_TESTING)
+uint32_t ysfx_gfx_get_font_cache_count()
+{
+    std::lock_guard<ysfx::mutex> gdi_lock{eel_lice_gdi_mutex};
+    return (uint32_t)eel_lice_font_cache::instance().count();
+}
+#endif
+
 #endif // !defined(YSFX_NO_GFX)
 
 //------------------------------------------------------------------------------
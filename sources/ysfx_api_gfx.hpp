@@ -30,6 +30,9 @@ void ysfx_gfx_state_set_show_menu_callback(ysfx_gfx_state_t *state, int (*callba
 void ysfx_gfx_state_set_set_cursor_callback(ysfx_gfx_state_t *state, void (*callback)(void *, int32_t));
 void ysfx_gfx_state_set_get_drop_file_callback(ysfx_gfx_state_t *state, const char *(*callback)(void *, int32_t));
 bool ysfx_gfx_state_is_dirty(ysfx_gfx_state_t *state);
+uint32_t ysfx_gfx_state_get_damage(ysfx_gfx_state_t *state, ysfx_gfx_rect_t *rects, uint32_t max_count);
+// decode the images of the header into the image cache, if there is one
+void ysfx_gfx_cache_images(ysfx_t *fx);
 void ysfx_gfx_state_add_key(ysfx_gfx_state_t *state, uint32_t mods, uint32_t key, bool press);
 void ysfx_gfx_state_update_mouse(ysfx_gfx_state_t *state, uint32_t mods, int xpos, int ypos, uint32_t buttons, int wheel, int hwheel);
 
@@ -38,6 +41,10 @@ void ysfx_gfx_enter(ysfx_t *fx, bool doinit);
 void ysfx_gfx_leave(ysfx_t *fx);
 ysfx_gfx_state_t *ysfx_gfx_get_context(ysfx_t *fx);
 void ysfx_gfx_prepare(ysfx_t *fx);
+#if defined(YSFX_TESTING)
+// get the number of fonts in the cache which the instances share
+uint32_t ysfx_gfx_get_font_cache_count();
+#endif
 
 struct ysfx_scoped_gfx_t {
     ysfx_scoped_gfx_t(ysfx_t *fx, bool doinit) : m_fx(fx) { ysfx_gfx_enter(fx, doinit); }
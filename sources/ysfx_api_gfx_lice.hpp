@@ -31,6 +31,8 @@
 
 #pragma once
 #include "ysfx_api_eel.hpp"
+#include "ysfx_image_cache.hpp"
+#include "ysfx_utils.hpp"
 #include "WDL/wdlstring.h"
 #include "WDL/wdlcstring.h"
 #include "WDL/wdlutf8.h"
@@ -38,6 +40,9 @@
 #include <cmath>
 #include <cstdio>
 #include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
 
 // help clangd to figure things out
 #if defined(__CLANGD__)
@@ -50,6 +55,13 @@
 
 #define LICE_FUNCTION_VALID(x) (sizeof(int) > 0)
 
+// The fonts, the text rendering, and the system bitmaps of LICE and SWELL
+//   share some global state: the temporary bitmap of the cached fonts, the
+//   pools of GDI objects and contexts, the font cache, and FreeType.
+// This lock protects them, and it is the only part of @gfx which does not
+//   run in parallel with the other instances. (issue 44)
+static ysfx::mutex eel_lice_gdi_mutex;
+
 static HDC LICE__GetDC(LICE_IBitmap *bm)
 {
   return bm->getDC();
@@ -105,6 +117,102 @@ static LICE_IBitmap *__LICE_CreateBitmap(int mode, int w, int h)
   return new LICE_MemBitmap(w,h);
 }
 
+// An image which shares the pixels of the image cache, until it is modified,
+//   when it makes a private copy of them.
+class eel_lice_shared_bitmap : public LICE_IBitmap
+{
+public:
+  explicit eel_lice_shared_bitmap(const ysfx_image_data_ptr &data) : m_data(data), m_own(NULL) {}
+  virtual ~eel_lice_shared_bitmap() { delete m_own; }
+
+  virtual LICE_pixel *getBits() { return m_own ? m_own->getBits() : (LICE_pixel *)m_data->pixels.data(); }
+  virtual int getWidth() { return m_own ? m_own->getWidth() : (int)m_data->width; }
+  virtual int getHeight() { return m_own ? m_own->getHeight() : (int)m_data->height; }
+  virtual int getRowSpan() { return m_own ? m_own->getRowSpan() : (int)m_data->width; }
+  virtual bool resize(int w, int h) { detach(); return m_own->resize(w,h); }
+
+  void detach()
+  {
+    if (m_own) return;
+    LICE_MemBitmap *own = new LICE_MemBitmap((int)m_data->width,(int)m_data->height);
+    LICE_Copy(own,this);
+    m_own = own;
+    m_data.reset();
+  }
+
+private:
+  ysfx_image_data_ptr m_data;
+  LICE_IBitmap *m_own;
+};
+
+// The regions of the framebuffer which the last @gfx has modified.
+// It keeps a few rectangles, merging those which touch each other, and when
+//   it is full, merging the new one with the one whose union grows the least.
+class eel_lice_damage
+{
+public:
+  enum { MAX_RECTS = 8 };
+
+  eel_lice_damage() : m_count(0) {}
+
+  void clear() { m_count=0; }
+  int count() const { return m_count; }
+  const RECT &get(int i) const { return m_rects[i]; }
+
+  void add(RECT r)
+  {
+    if (r.right <= r.left || r.bottom <= r.top) return;
+
+    int i=0;
+    while (i < m_count)
+    {
+      const RECT &o = m_rects[i];
+      if (r.left <= o.right && o.left <= r.right && r.top <= o.bottom && o.top <= r.bottom)
+      {
+        r = unite(r,o);
+        m_rects[i] = m_rects[--m_count];
+        i=0;
+      }
+      else
+        i++;
+    }
+
+    if (m_count == MAX_RECTS)
+    {
+      int best=0;
+      double bestgrowth=0.0;
+      for (i=0; i < m_count; i++)
+      {
+        const RECT &o = m_rects[i];
+        const double growth = area(unite(r,o)) - area(r) - area(o);
+        if (i == 0 || growth < bestgrowth) { best=i; bestgrowth=growth; }
+      }
+      RECT u = unite(r,m_rects[best]);
+      m_rects[best] = m_rects[--m_count];
+      add(u);
+      return;
+    }
+
+    m_rects[m_count++] = r;
+  }
+
+private:
+  static RECT unite(const RECT &a, const RECT &b)
+  {
+    RECT u = { wdl_min(a.left,b.left), wdl_min(a.top,b.top), wdl_max(a.right,b.right), wdl_max(a.bottom,b.bottom) };
+    return u;
+  }
+  static double area(const RECT &a)
+  {
+    return (double)(a.right-a.left) * (double)(a.bottom-a.top);
+  }
+
+  RECT m_rects[MAX_RECTS];
+  int m_count;
+};
+
+struct eel_lice_shared_font;
+
 class eel_lice_state
 {
 public:
@@ -114,9 +222,10 @@ public:
 
   LICE_IBitmap *m_framebuffer, *m_framebuffer_extra;
   int m_framebuffer_dirty;
+  eel_lice_damage m_framebuffer_damage;
   WDL_TypedBuf<LICE_IBitmap *> m_gfx_images;
   struct gfxFontStruct {
-    LICE_IFont *font;
+    eel_lice_shared_font *font;
     char last_fontname[128];
     char actual_fontname[128];
     int last_fontsize;
@@ -133,7 +242,7 @@ public:
   };
 
   int m_gfx_font_active; // -1 for default, otherwise index into gfx_fonts (NOTE: this differs from the exposed API, which defines 0 as default, 1-n)
-  LICE_IFont *GetActiveFont() { return m_gfx_font_active>=0&&m_gfx_font_active<m_gfx_fonts.GetSize() && m_gfx_fonts.Get()[m_gfx_font_active].use_fonth ? m_gfx_fonts.Get()[m_gfx_font_active].font : NULL; }
+  LICE_IFont *GetActiveFont();
 
   LICE_IBitmap *GetImageForIndex(EEL_F idx, const char *callername) 
   { 
@@ -147,17 +256,45 @@ public:
     return NULL;
   };
 
-  void SetImageDirty(LICE_IBitmap *bm)
+  // marks the image as modified; on the framebuffer, the area which is about
+  //   to be drawn is added to the damage, or the entire frame if it's NULL
+  void SetImageDirty(LICE_IBitmap *bm, const RECT *area = NULL)
   {
-    if (bm == m_framebuffer && !m_framebuffer_dirty)
+    if (bm != m_framebuffer)
+    {
+      // copy the pixels of a cached image, before they get modified
+      eel_lice_shared_bitmap *shared = dynamic_cast<eel_lice_shared_bitmap *>(bm);
+      if (shared) shared->detach();
+      return;
+    }
+
+    const int fbw = LICE__GetWidth(m_framebuffer), fbh = LICE__GetHeight(m_framebuffer);
+    const RECT full = {0,0,fbw,fbh};
+
+    if (!m_framebuffer_dirty)
     {
       if (m_gfx_clear && *m_gfx_clear > -1.0)
       {
         const int a=(int)*m_gfx_clear;
         if (LICE_FUNCTION_VALID(LICE_Clear)) LICE_Clear(m_framebuffer,LICE_RGBA((a&0xff),((a>>8)&0xff),((a>>16)&0xff),0));
+        m_framebuffer_damage.add(full);
       }
       m_framebuffer_dirty=1;
     }
+
+    if (!area)
+      m_framebuffer_damage.add(full);
+    else if (area->right > area->left && area->bottom > area->top)
+    {
+      // leave a pixel of margin, for antialiasing and rounding
+      RECT r = { wdl_max(area->left-1,0), wdl_max(area->top-1,0), wdl_min(area->right+1,fbw), wdl_min(area->bottom+1,fbh) };
+      m_framebuffer_damage.add(r);
+    }
+  }
+  void SetImageDirty(LICE_IBitmap *bm, int x1, int y1, int x2, int y2)
+  {
+    RECT r = { wdl_min(x1,x2), wdl_min(y1,y2), wdl_max(x1,x2), wdl_max(y1,y2) };
+    SetImageDirty(bm,&r);
   }
 
   // R, G, B, A, w, h, x, y, mode(1=add,0=copy)
@@ -201,6 +338,176 @@ public:
   EEL_F gfx_setcursor(void* opaque, EEL_F** parms, int nparms);
 };
 
+// A font of gfx_setfont, shared by all the instances which set the same face,
+//   size and flags, so the glyphs which LICE renders into its cache serve all
+//   of them. The fonts and the cache are protected by `eel_lice_gdi_mutex`.
+struct eel_lice_shared_font
+{
+  LICE_IFont *font; // NULL if the font could not be created
+  char actual_fontname[128];
+  int height;
+  int refs;
+  unsigned int last_use;
+};
+
+class eel_lice_font_cache
+{
+public:
+  // the number of fonts which remain cached without users, for the scripts
+  //   which alternate between several fonts
+  enum { MAX_UNUSED = 32 };
+
+  // the cache is never destroyed: instances which outlive the static
+  //   destructors, as in a leaked plugin, still release their fonts into it
+  static eel_lice_font_cache &instance()
+  {
+    static eel_lice_font_cache *cache = new eel_lice_font_cache;
+    return *cache;
+  }
+
+  eel_lice_font_cache() : m_unused(0), m_clock(0) {}
+
+  // get the font, creating it if necessary; `dcbm` is a bitmap to measure it on
+  eel_lice_shared_font *acquire(const char *face, int size, int flags, LICE_IBitmap *dcbm)
+  {
+    key k(face,size,flags);
+    font_map::iterator it = m_fonts.find(k);
+    eel_lice_shared_font *sf;
+    if (it != m_fonts.end())
+    {
+      sf = it->second;
+      if (!sf->refs) m_unused--;
+    }
+    else
+    {
+      sf = create(face,size,flags,dcbm);
+      m_fonts[k] = sf;
+    }
+    sf->refs++;
+    return sf;
+  }
+
+  void release(eel_lice_shared_font *sf)
+  {
+    if (!sf || --sf->refs > 0) return;
+    sf->last_use = ++m_clock;
+    if (++m_unused > MAX_UNUSED) evict();
+  }
+
+  int count() const { return (int)m_fonts.size(); }
+
+private:
+  struct key
+  {
+    key(const char *face, int size, int flags) : face(face), size(size), flags(flags) {}
+    bool operator<(const key &o) const
+    {
+      if (size != o.size) return size < o.size;
+      if (flags != o.flags) return flags < o.flags;
+      return face < o.face;
+    }
+    std::string face;
+    int size, flags;
+  };
+  typedef std::map<key, eel_lice_shared_font *> font_map;
+
+  static eel_lice_shared_font *create(const char *face, int sz, int fontflag, LICE_IBitmap *dcbm);
+
+  // delete the unused font which was released the longest ago
+  void evict()
+  {
+    font_map::iterator victim = m_fonts.end();
+    for (font_map::iterator it = m_fonts.begin(); it != m_fonts.end(); ++it)
+    {
+      const eel_lice_shared_font *sf = it->second;
+      if (!sf->refs && (victim == m_fonts.end() || sf->last_use < victim->second->last_use)) victim = it;
+    }
+    if (victim == m_fonts.end()) return;
+    destroy(victim->second);
+    m_fonts.erase(victim);
+    m_unused--;
+  }
+
+  static void destroy(eel_lice_shared_font *sf)
+  {
+    if (sf->font) LICE__DestroyFont(sf->font);
+    delete sf;
+  }
+
+  font_map m_fonts;
+  int m_unused;
+  unsigned int m_clock;
+};
+
+eel_lice_shared_font *eel_lice_font_cache::create(const char *face, int sz, int fontflag, LICE_IBitmap *dcbm)
+{
+  eel_lice_shared_font *sf = new eel_lice_shared_font;
+  sf->font=NULL;
+  sf->actual_fontname[0]=0;
+  sf->height=0;
+  sf->refs=0;
+  sf->last_use=0;
+
+  const int fw = (fontflag&eel_lice_state::EELFONT_FLAG_BOLD) ? FW_BOLD : FW_NORMAL;
+  const bool italic = !!(fontflag&eel_lice_state::EELFONT_FLAG_ITALIC);
+  const bool underline = !!(fontflag&eel_lice_state::EELFONT_FLAG_UNDERLINE);
+  HFONT hf=NULL;
+#if defined(_WIN32) && !defined(WDL_NO_SUPPORT_UTF8)
+  WCHAR wf[256];
+  if (WDL_DetectUTF8(face)>0 &&
+      GetVersion()<0x80000000 &&
+      MultiByteToWideChar(CP_UTF8,MB_ERR_INVALID_CHARS,face,-1,wf,256))
+  {
+    hf = CreateFontW(sz,0,0,0,fw,italic,underline,FALSE,DEFAULT_CHARSET,OUT_DEFAULT_PRECIS,CLIP_DEFAULT_PRECIS,DEFAULT_QUALITY,DEFAULT_PITCH,wf);
+  }
+#endif
+  if (!hf) hf = CreateFont(sz,0,0,0,fw,italic,underline,FALSE,DEFAULT_CHARSET,OUT_DEFAULT_PRECIS,CLIP_DEFAULT_PRECIS,DEFAULT_QUALITY,DEFAULT_PITCH,face);
+  if (!hf) return sf; // this font stays disabled
+
+  TEXTMETRIC tm;
+  tm.tmHeight = sz;
+
+  if (dcbm && LICE_FUNCTION_VALID(LICE__GetDC))
+  {
+    HGDIOBJ oldFont = 0;
+    HDC hdc=LICE__GetDC(dcbm);
+    if (hdc)
+    {
+      oldFont = SelectObject(hdc,hf);
+      GetTextMetrics(hdc,&tm);
+
+#if defined(_WIN32) && !defined(WDL_NO_SUPPORT_UTF8)
+      if (GetVersion()<0x80000000 &&
+          GetTextFaceW(hdc,sizeof(wf)/sizeof(wf[0]),wf) &&
+          WideCharToMultiByte(CP_UTF8,0,wf,-1,sf->actual_fontname,sizeof(sf->actual_fontname),NULL,NULL))
+      {
+        sf->actual_fontname[sizeof(sf->actual_fontname)-1]=0;
+      }
+      else
+#endif
+        GetTextFace(hdc, sizeof(sf->actual_fontname), sf->actual_fontname);
+      SelectObject(hdc,oldFont);
+    }
+  }
+
+  sf->font=LICE_CreateFont();
+  if (sf->font)
+  {
+    sf->height=wdl_max(tm.tmHeight,1);
+    LICE__SetFromHFont(sf->font,hf, (fontflag & ~eel_lice_state::EELFONT_FLAG_MASK) | 512 /*LICE_FONT_FLAG_OWNS_HFONT*/);
+  }
+  else
+    DeleteObject(hf);
+  return sf;
+}
+
+LICE_IFont *eel_lice_state::GetActiveFont()
+{
+  if (m_gfx_font_active<0 || m_gfx_font_active>=m_gfx_fonts.GetSize()) return NULL;
+  const gfxFontStruct *s = m_gfx_fonts.Get()+m_gfx_font_active;
+  return s->use_fonth && s->font ? s->font->font : NULL;
+}
+
 eel_lice_state::eel_lice_state(NSEEL_VMCTX vm, void *ctx, int image_slots, int font_slots)
 {
   m_user_ctx=ctx;
@@ -240,6 +547,8 @@ eel_lice_state::eel_lice_state(NSEEL_VMCTX vm, void *ctx, int image_slots, int f
 }
 eel_lice_state::~eel_lice_state()
 {
+  std::lock_guard<ysfx::mutex> gdi_lock{eel_lice_gdi_mutex};
+
   if (LICE_FUNCTION_VALID(LICE__Destroy)) 
   {
     LICE__Destroy(m_framebuffer_extra);
@@ -250,13 +559,10 @@ eel_lice_state::~eel_lice_state()
       LICE__Destroy(m_gfx_images.Get()[x]);
     }
   }
-  if (LICE_FUNCTION_VALID(LICE__DestroyFont))
+  int x;
+  for (x=0;x<m_gfx_fonts.GetSize();x++)
   {
-    int x;
-    for (x=0;x<m_gfx_fonts.GetSize();x++)
-    {
-      if (m_gfx_fonts.Get()[x].font) LICE__DestroyFont(m_gfx_fonts.Get()[x].font);
-    }
+    eel_lice_font_cache::instance().release(m_gfx_fonts.Get()[x].font);
   }
 }
 
@@ -611,7 +917,7 @@ void eel_lice_state::gfx_lineto(EEL_F xpos, EEL_F ypos, EEL_F aaflag)
       LICE_FUNCTION_VALID(LICE_ClipLine) && 
       LICE_ClipLine(&x1,&y1,&x2,&y2,0,0,LICE__GetWidth(dest),LICE__GetHeight(dest))) 
   {
-    SetImageDirty(dest);
+    SetImageDirty(dest,wdl_min(x1,x2),wdl_min(y1,y2),wdl_max(x1,x2)+1,wdl_max(y1,y2)+1);
     LICE_Line(dest,x1,y1,x2,y2,getCurColor(),(float) *m_gfx_a,getCurMode(),aaflag > 0.5);
   }
   *m_gfx_x = xpos;
@@ -626,7 +932,7 @@ void eel_lice_state::gfx_circle(float x, float y, float r, bool fill, bool aafla
 
   if (LICE_FUNCTION_VALID(LICE_Circle) && LICE_FUNCTION_VALID(LICE_FillCircle))
   {
-    SetImageDirty(dest);
+    SetImageDirty(dest,(int)floor(x-r)-1,(int)floor(y-r)-1,(int)ceil(x+r)+2,(int)ceil(y+r)+2);
     if(fill)
       LICE_FillCircle(dest, x, y, r, getCurColor(), (float) *m_gfx_a, getCurMode(), aaflag);
     else
@@ -640,7 +946,16 @@ void eel_lice_state::gfx_triangle(EEL_F** parms, int np)
   if (np >= 6)
   {
     np &= ~1;
-    SetImageDirty(dest);
+    {
+      int i, x1=(int)parms[0][0], y1=(int)parms[1][0], x2=x1, y2=y1;
+      for (i=2; i < np; i+=2)
+      {
+        const int x=(int)parms[i][0], y=(int)parms[i+1][0];
+        x1=wdl_min(x1,x); x2=wdl_max(x2,x);
+        y1=wdl_min(y1,y); y2=wdl_max(y2,y);
+      }
+      SetImageDirty(dest,x1,y1,x2+1,y2+1);
+    }
     if (np == 6)
     {        
       if (!LICE_FUNCTION_VALID(LICE_FillTriangle)) return;
@@ -678,7 +993,7 @@ void eel_lice_state::gfx_rectto(EEL_F xpos, EEL_F ypos)
 
   if (LICE_FUNCTION_VALID(LICE_FillRect) && x2-x1 > 0.5 && y2-y1 > 0.5)
   {
-    SetImageDirty(dest);
+    SetImageDirty(dest,(int)x1,(int)y1,(int)x1+(int)(x2-x1),(int)y1+(int)(y2-y1));
     LICE_FillRect(dest,(int)x1,(int)y1,(int)(x2-x1),(int)(y2-y1),getCurColor(),(float)*m_gfx_a,getCurMode());
   }
   *m_gfx_x = xpos;
@@ -697,7 +1012,7 @@ void eel_lice_state::gfx_line(int np, EEL_F **parms)
       LICE_FUNCTION_VALID(LICE_Line) && 
       LICE_FUNCTION_VALID(LICE_ClipLine) && LICE_ClipLine(&x1,&y1,&x2,&y2,0,0,LICE__GetWidth(dest),LICE__GetHeight(dest))) 
   {
-    SetImageDirty(dest);
+    SetImageDirty(dest,wdl_min(x1,x2),wdl_min(y1,y2),wdl_max(x1,x2)+1,wdl_max(y1,y2)+1);
     LICE_Line(dest,x1,y1,x2,y2,getCurColor(),(float)*m_gfx_a,getCurMode(),np< 5 || parms[4][0] > 0.5);
   } 
 }
@@ -712,7 +1027,7 @@ void eel_lice_state::gfx_rect(int np, EEL_F **parms)
 
   if (LICE_FUNCTION_VALID(LICE_FillRect) && LICE_FUNCTION_VALID(LICE_DrawRect) && w>0 && h>0)
   {
-    SetImageDirty(dest);
+    SetImageDirty(dest,x1,y1,x1+w,y1+h);
     if (filled) LICE_FillRect(dest,x1,y1,w,h,getCurColor(),(float)*m_gfx_a,getCurMode());
     else LICE_DrawRect(dest, x1, y1, w-1, h-1, getCurColor(), (float)*m_gfx_a, getCurMode());
   }
@@ -727,7 +1042,7 @@ void eel_lice_state::gfx_roundrect(int np, EEL_F **parms)
 
   if (LICE_FUNCTION_VALID(LICE_RoundRect) && parms[2][0]>0 && parms[3][0]>0)
   {
-    SetImageDirty(dest);
+    SetImageDirty(dest,(int)floor(parms[0][0]),(int)floor(parms[1][0]),(int)ceil(parms[0][0]+parms[2][0])+1,(int)ceil(parms[1][0]+parms[3][0])+1);
     LICE_RoundRect(dest, (float)parms[0][0], (float)parms[1][0], (float)parms[2][0], (float)parms[3][0], (int)parms[4][0], getCurColor(), (float)*m_gfx_a, getCurMode(), aa);
   }
 }
@@ -741,7 +1056,8 @@ void eel_lice_state::gfx_arc(int np, EEL_F **parms)
 
   if (LICE_FUNCTION_VALID(LICE_Arc))
   {
-    SetImageDirty(dest);
+    const EEL_F r=fabs(parms[2][0]);
+    SetImageDirty(dest,(int)floor(parms[0][0]-r)-1,(int)floor(parms[1][0]-r)-1,(int)ceil(parms[0][0]+r)+2,(int)ceil(parms[1][0]+r)+2);
     LICE_Arc(dest, (float)parms[0][0], (float)parms[1][0], (float)parms[2][0], (float)parms[3][0], (float)parms[4][0], getCurColor(), (float)*m_gfx_a, getCurMode(), aa);
   }
 }
@@ -755,7 +1071,7 @@ void eel_lice_state::gfx_grad_or_muladd_rect(int whichmode, int np, EEL_F **parm
 
   if (w>0 && h>0)
   {
-    SetImageDirty(dest);
+    SetImageDirty(dest,x1,y1,x1+w,y1+h);
     if (whichmode==0 && LICE_FUNCTION_VALID(LICE_GradRect) && np > 7)
     {
       LICE_GradRect(dest,x1,y1,w,h,(float)parms[4][0],(float)parms[5][0],(float)parms[6][0],(float)parms[7][0],
@@ -788,7 +1104,8 @@ void eel_lice_state::gfx_setpixel(EEL_F r, EEL_F g, EEL_F b)
 
   if (LICE_FUNCTION_VALID(LICE_PutPixel)) 
   {
-    SetImageDirty(dest);
+    const int x=(int)*m_gfx_x, y=(int)*m_gfx_y;
+    SetImageDirty(dest,x,y,x+1,y+1);
     LICE_PutPixel(dest,(int)*m_gfx_x, (int)*m_gfx_y,LICE_RGBA(red,green,blue,255), (float)*m_gfx_a,getCurMode());
   }
 }
@@ -821,7 +1138,11 @@ EEL_F eel_lice_state::gfx_loadimg(void *opaque, int img, EEL_F loadFrom)
 
     if (ok && fs.GetLength())
     {
+#ifdef EEL_LICE_LOAD_IMAGE
+      LICE_IBitmap *bm = EEL_LICE_LOAD_IMAGE(opaque,fs.Get());
+#else
       LICE_IBitmap *bm = LICE_LoadImage(fs.Get(),NULL,false);
+#endif
       if (bm)
       {
         LICE__Destroy(m_gfx_images.Get()[img]);
@@ -850,6 +1171,8 @@ EEL_F eel_lice_state::gfx_setimgdim(int img, EEL_F *w, EEL_F *h)
   LICE_IBitmap *bm=NULL;
   if (img >= 0 && img < m_gfx_images.GetSize()) 
   {
+    std::lock_guard<ysfx::mutex> gdi_lock{eel_lice_gdi_mutex};
+
     bm=m_gfx_images.Get()[img];  
     if (!bm) 
     {
@@ -874,14 +1197,14 @@ void eel_lice_state::gfx_blurto(EEL_F x, EEL_F y)
 #endif
     ) return;
 
-  SetImageDirty(dest);
-  
   int srcx = (int)x;
   int srcy = (int)y;
   int srcw=(int) (*m_gfx_x-x);
   int srch=(int) (*m_gfx_y-y);
   if (srch < 0) { srch=-srch; srcy = (int)*m_gfx_y; }
   if (srcw < 0) { srcw=-srcw; srcx = (int)*m_gfx_x; }
+
+  SetImageDirty(dest,srcx,srcy,srcx+srcw,srcy+srch);
   LICE_Blur(dest,dest,srcx,srcy,srcx,srcy,srcw,srch);
   *m_gfx_x = x;
   *m_gfx_y = y;
@@ -914,7 +1237,10 @@ void eel_lice_state::gfx_transformblit(EEL_F **parms, int div_w, int div_h, EEL_
  
   const bool isFromFB = bm==m_framebuffer;
 
-  SetImageDirty(dest);
+  {
+    const int x=(int)floor(parms[1][0]), y=(int)floor(parms[2][0]);
+    SetImageDirty(dest,x,y,x+(int)floor(parms[3][0]),y+(int)floor(parms[4][0]));
+  }
 
   if (bm == dest)
   {
@@ -989,63 +1315,18 @@ EEL_F eel_lice_state::gfx_setfont(void *opaque, int np, EEL_F **parms)
 
       if (doCreate)
       {
-        s->actual_fontname[0]=0;
-        if (!s->font) s->font=LICE_CreateFont();
-        if (s->font)
-        {
-          const int fw = (fontflag&EELFONT_FLAG_BOLD) ? FW_BOLD : FW_NORMAL;
-          const bool italic = !!(fontflag&EELFONT_FLAG_ITALIC);
-          const bool underline = !!(fontflag&EELFONT_FLAG_UNDERLINE);
-          HFONT hf=NULL;
-#if defined(_WIN32) && !defined(WDL_NO_SUPPORT_UTF8)
-          WCHAR wf[256];
-          if (WDL_DetectUTF8(s->last_fontname)>0 &&
-              GetVersion()<0x80000000 &&
-              MultiByteToWideChar(CP_UTF8,MB_ERR_INVALID_CHARS,s->last_fontname,-1,wf,256))
-          {
-            hf = CreateFontW(sz,0,0,0,fw,italic,underline,FALSE,DEFAULT_CHARSET,OUT_DEFAULT_PRECIS,CLIP_DEFAULT_PRECIS,DEFAULT_QUALITY,DEFAULT_PITCH,wf);
-          }
-#endif
-          if (!hf) hf = CreateFont(sz,0,0,0,fw,italic,underline,FALSE,DEFAULT_CHARSET,OUT_DEFAULT_PRECIS,CLIP_DEFAULT_PRECIS,DEFAULT_QUALITY,DEFAULT_PITCH,s->last_fontname);
-
-          if (!hf)
-          {
-            s->use_fonth=0; // disable this font
-          }
-          else
-          {
-            TEXTMETRIC tm;
-            tm.tmHeight = sz;
-
-            if (!m_framebuffer && LICE_FUNCTION_VALID(__LICE_CreateBitmap)) m_framebuffer=__LICE_CreateBitmap(1,64,64);
-
-            if (m_framebuffer && LICE_FUNCTION_VALID(LICE__GetDC))
-            {
-              HGDIOBJ oldFont = 0;
-              HDC hdc=LICE__GetDC(m_framebuffer);
-              if (hdc)
-              {
-                oldFont = SelectObject(hdc,hf);
-                GetTextMetrics(hdc,&tm);
-
-#if defined(_WIN32) && !defined(WDL_NO_SUPPORT_UTF8)
-                if (GetVersion()<0x80000000 &&
-                    GetTextFaceW(hdc,sizeof(wf)/sizeof(wf[0]),wf) &&
-                    WideCharToMultiByte(CP_UTF8,0,wf,-1,s->actual_fontname,sizeof(s->actual_fontname),NULL,NULL))
-                {
-                  s->actual_fontname[sizeof(s->actual_fontname)-1]=0;
-                }
-                else
-#endif
-                  GetTextFace(hdc, sizeof(s->actual_fontname), s->actual_fontname);
-                SelectObject(hdc,oldFont);
-              }
-            }
-
-            s->use_fonth=wdl_max(tm.tmHeight,1);
-            LICE__SetFromHFont(s->font,hf, (fontflag & ~EELFONT_FLAG_MASK) | 512 /*LICE_FONT_FLAG_OWNS_HFONT*/);
-          }
-        }
+        std::lock_guard<ysfx::mutex> gdi_lock{eel_lice_gdi_mutex};
+
+        if (!m_framebuffer && LICE_FUNCTION_VALID(__LICE_CreateBitmap)) m_framebuffer=__LICE_CreateBitmap(1,64,64);
+
+        // acquire the new one first, so that a font in use elsewhere is not
+        //   deleted and recreated
+        eel_lice_font_cache &cache = eel_lice_font_cache::instance();
+        eel_lice_shared_font *sf = cache.acquire(s->last_fontname,sz,fontflag,m_framebuffer);
+        cache.release(s->font);
+        s->font=sf;
+        lstrcpyn_safe(s->actual_fontname,sf->actual_fontname,sizeof(s->actual_fontname));
+        s->use_fonth=sf->height; // 0 disables this font
       }
     }
 
@@ -1107,7 +1388,10 @@ void eel_lice_state::gfx_blitext2(int np, EEL_F **parms, int blitmode)
   coords[7]=np > 8 ? parms[8][0] : coords[3]*sc;
  
   const bool isFromFB = bm == m_framebuffer;
-  SetImageDirty(dest);
+  if (blitmode==0 && fabs(angle)>0.000000001)
+    SetImageDirty(dest); // the rotation can go past the destination
+  else
+    SetImageDirty(dest,(int)coords[4],(int)coords[5],(int)coords[4]+(int)coords[6],(int)coords[5]+(int)coords[7]);
  
   if (bm == dest &&
       (blitmode != 0 || np > 1) && // legacy behavior to matech previous gfx_blit(3parm), do not use temp buffer
@@ -1166,7 +1450,10 @@ void eel_lice_state::gfx_blitext(EEL_F img, EEL_F *coords, EEL_F angle)
   LICE_IBitmap *bm=GetImageForIndex(img,"gfx_blitext:src");
   if (!bm) return;
   
-  SetImageDirty(dest);
+  if (fabs(angle)>0.000000001)
+    SetImageDirty(dest); // the rotation can go past the destination
+  else
+    SetImageDirty(dest,(int)coords[4],(int)coords[5],(int)coords[4]+(int)coords[6],(int)coords[5]+(int)coords[7]);
   const bool isFromFB = bm == m_framebuffer;
  
   int bmw=LICE__GetWidth(bm);
@@ -1226,11 +1513,27 @@ void eel_lice_state::gfx_getpixel(EEL_F *r, EEL_F *g, EEL_F *b)
 }
 
 
+static void __uniteTextDamage(RECT *damage, int l, int t, int r, int b)
+{
+  if (damage->right <= damage->left || damage->bottom <= damage->top)
+  {
+    damage->left=l; damage->top=t; damage->right=r; damage->bottom=b;
+  }
+  else
+  {
+    damage->left=wdl_min(damage->left,l); damage->top=wdl_min(damage->top,t);
+    damage->right=wdl_max(damage->right,r); damage->bottom=wdl_max(damage->bottom,b);
+  }
+}
+
+// if `damage` is given, it receives the bounds of the drawn text
 static int __drawTextWithFont(LICE_IBitmap *dest, const RECT *rect, LICE_IFont *font, const char *buf, int buflen, 
-  int fg, int mode, float alpha, int flags, EEL_F *wantYoutput, EEL_F **measureOnly)
+  int fg, int mode, float alpha, int flags, EEL_F *wantYoutput, EEL_F **measureOnly, RECT *damage = NULL)
 {
   if (font && LICE_FUNCTION_VALID(LICE__DrawText))
   {
+    std::lock_guard<ysfx::mutex> gdi_lock{eel_lice_gdi_mutex};
+
     RECT tr=*rect;
     LICE__SetTextColor(font,fg);
     LICE__SetTextCombineMode(font,mode,alpha);
@@ -1245,6 +1548,14 @@ static int __drawTextWithFont(LICE_IBitmap *dest, const RECT *rect, LICE_IFont *
       int lineh = LICE__DrawText(font,dest,buf,thislen?thislen:1,&r,DT_SINGLELINE|DT_NOPREFIX|DT_CALCRECT);
       if (!measureOnly)
       {
+        if (damage)
+        {
+          // the text box, with a margin for the slant and the effects
+          const int w=r.right, h=wdl_max(r.bottom,lineh), m=h/2+2;
+          const int x = (flags & DT_RIGHT) ? tr.right-w : (flags & DT_CENTER) ? (tr.left+tr.right-w)/2 : tr.left;
+          const int y = (flags & DT_BOTTOM) ? tr.bottom-h : (flags & DT_VCENTER) ? (tr.top+tr.bottom-h)/2 : tr.top;
+          __uniteTextDamage(damage,x-m,y-m,x+w+m,y+h+m);
+        }
         r.right += tr.left;
         lineh = LICE__DrawText(font,dest,buf,thislen?thislen:1,&tr,DT_SINGLELINE|DT_NOPREFIX|flags);
         if (wantYoutput) *wantYoutput = tr.top;
@@ -1314,7 +1625,15 @@ static int __drawTextWithFont(LICE_IBitmap *dest, const RECT *rect, LICE_IFont *
         case ' ': xpos += 8; break;
         case '\t': xpos += 8*5; break;
         default:
-          if (!measureOnly) LICE_DrawChar(dest,xpos,ypos,buf[x], fg,alpha,mode);
+          if (!measureOnly)
+          {
+            LICE_DrawChar(dest,xpos,ypos,buf[x], fg,alpha,mode);
+            if (damage)
+            {
+              const int ox = dest == &sbm ? rect->left : 0, oy = dest == &sbm ? rect->top : 0;
+              __uniteTextDamage(damage,ox+xpos,oy+ypos,ox+xpos+8,oy+ypos+8);
+            }
+          }
           xpos += 8;
           if (xpos > maxx) maxx=xpos;
           maxy = ypos + 8;
@@ -1387,7 +1706,8 @@ void eel_lice_state::gfx_drawstr(void *opaque, EEL_F **parms, int nparms, int fo
 
   if (s_len)
   {
-    SetImageDirty(dest);
+    RECT damage={0,0,0,0};
+    SetImageDirty(dest,&damage);
     if (formatmode>=2)
     {
       if (nfmtparms==2)
@@ -1409,7 +1729,8 @@ void eel_lice_state::gfx_drawstr(void *opaque, EEL_F **parms, int nparms, int fo
         r.bottom=(int)*parms[3];
       }
       *m_gfx_x=__drawTextWithFont(dest,&r,GetActiveFont(),s,s_len,
-        getCurColor(),getCurMode(),(float)*m_gfx_a,flags,m_gfx_y,NULL);
+        getCurColor(),getCurMode(),(float)*m_gfx_a,flags,m_gfx_y,NULL,&damage);
+      SetImageDirty(dest,&damage);
     }
   }
 }
@@ -1419,7 +1740,8 @@ void eel_lice_state::gfx_drawchar(EEL_F ch)
   LICE_IBitmap *dest = GetImageForIndex(*m_gfx_dest,"gfx_drawchar");
   if (!dest) return;
 
-  SetImageDirty(dest);
+  RECT damage={0,0,0,0};
+  SetImageDirty(dest,&damage);
 
   int a=(int)(ch+0.5);
   if (a == '\r' || a=='\n') a=' ';
@@ -1430,7 +1752,8 @@ void eel_lice_state::gfx_drawchar(EEL_F ch)
   RECT r={(int)floor(*m_gfx_x),(int)floor(*m_gfx_y),0,0};
   *m_gfx_x = __drawTextWithFont(dest,&r,
                          GetActiveFont(),buf,buflen,
-                         getCurColor(),getCurMode(),(float)*m_gfx_a,DT_NOCLIP,NULL,NULL);
+                         getCurColor(),getCurMode(),(float)*m_gfx_a,DT_NOCLIP,NULL,NULL,&damage);
+  SetImageDirty(dest,&damage);
 
 }
 
@@ -1440,7 +1763,8 @@ void eel_lice_state::gfx_drawnumber(EEL_F n, EEL_F ndigits)
   LICE_IBitmap *dest = GetImageForIndex(*m_gfx_dest,"gfx_drawnumber");
   if (!dest) return;
 
-  SetImageDirty(dest);
+  RECT damage={0,0,0,0};
+  SetImageDirty(dest,&damage);
 
   char buf[512];
   int a=(int)(ndigits+0.5);
@@ -1451,5 +1775,6 @@ void eel_lice_state::gfx_drawnumber(EEL_F n, EEL_F ndigits)
   RECT r={(int)floor(*m_gfx_x),(int)floor(*m_gfx_y),0,0};
   *m_gfx_x = __drawTextWithFont(dest,&r,
                            GetActiveFont(),buf,(int)strlen(buf),
-                           getCurColor(),getCurMode(),(float)*m_gfx_a,DT_NOCLIP,NULL,NULL);
+                           getCurColor(),getCurMode(),(float)*m_gfx_a,DT_NOCLIP,NULL,NULL,&damage);
+  SetImageDirty(dest,&damage);
 }
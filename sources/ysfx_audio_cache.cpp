@@ -0,0 +1,192 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ysfx_audio_cache.hpp"
+#include <mutex>
+
+static void ysfx_audio_cache_trim(ysfx_audio_cache_t &cache, uint64_t budget);
+static void ysfx_audio_cache_erase(ysfx_audio_cache_t &cache, std::list<ysfx_audio_cache_t::entry_t>::iterator pos);
+static uint64_t ysfx_audio_data_size(const ysfx_audio_data_t &data);
+
+ysfx_audio_cache_t *ysfx_audio_cache_new(uint64_t max_bytes)
+{
+    ysfx_audio_cache_t *cache = new ysfx_audio_cache_t;
+    cache->budget = max_bytes;
+    return cache;
+}
+
+void ysfx_audio_cache_free(ysfx_audio_cache_t *cache)
+{
+    if (!cache)
+        return;
+
+    if (cache->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        delete cache;
+}
+
+void ysfx_audio_cache_add_ref(ysfx_audio_cache_t *cache)
+{
+    cache->ref_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ysfx_audio_cache_set_budget(ysfx_audio_cache_t *cache, uint64_t max_bytes)
+{
+    std::lock_guard<ysfx::mutex> lock{cache->mutex};
+    cache->budget = max_bytes;
+    ysfx_audio_cache_trim(*cache, max_bytes);
+}
+
+uint64_t ysfx_audio_cache_get_size(ysfx_audio_cache_t *cache)
+{
+    std::lock_guard<ysfx::mutex> lock{cache->mutex};
+    return cache->size;
+}
+
+uint32_t ysfx_audio_cache_get_count(ysfx_audio_cache_t *cache)
+{
+    std::lock_guard<ysfx::mutex> lock{cache->mutex};
+    return (uint32_t)cache->lru.size();
+}
+
+void ysfx_audio_cache_clear(ysfx_audio_cache_t *cache)
+{
+    std::lock_guard<ysfx::mutex> lock{cache->mutex};
+    cache->lru.clear();
+    cache->index.clear();
+    cache->size = 0;
+}
+
+//------------------------------------------------------------------------------
+static void ysfx_audio_cache_trim(ysfx_audio_cache_t &cache, uint64_t budget)
+{
+    // NOTE: the pending entries may go too, their requesters hold the result
+    while (cache.size > budget && !cache.lru.empty())
+        ysfx_audio_cache_erase(cache, std::prev(cache.lru.end()));
+}
+
+static void ysfx_audio_cache_erase(ysfx_audio_cache_t &cache, std::list<ysfx_audio_cache_t::entry_t>::iterator pos)
+{
+    cache.size -= pos->size;
+    cache.index.erase(pos->key);
+    cache.lru.erase(pos);
+}
+
+static uint64_t ysfx_audio_data_size(const ysfx_audio_data_t &data)
+{
+    return (uint64_t)data.samples.size() * sizeof(ysfx_real);
+}
+
+static ysfx_audio_data_ptr ysfx_audio_decode(const ysfx_audio_format_t &fmt, const char *path, uint64_t budget)
+{
+    std::unique_ptr<ysfx_audio_reader_t, void (*)(ysfx_audio_reader_t *)> reader{fmt.open(path), fmt.close};
+    if (!reader)
+        return nullptr;
+
+    uint64_t count = fmt.avail(reader.get());
+    if (count > budget / sizeof(ysfx_real))
+        return nullptr;
+
+    std::shared_ptr<ysfx_audio_data_t> data{new ysfx_audio_data_t};
+    data->info = fmt.info(reader.get());
+
+    std::vector<ysfx_real> &samples = data->samples;
+    samples.resize((size_t)count);
+    samples.resize((size_t)fmt.read(reader.get(), samples.data(), count));
+
+    // the length which the format indicates may be an estimate: read the remainder
+    if (samples.size() == count) {
+        const size_t chunk = 16384;
+        for (size_t n = chunk; n == chunk; ) {
+            size_t pos = samples.size();
+            samples.resize(pos + chunk);
+            n = (size_t)fmt.read(reader.get(), &samples[pos], chunk);
+            samples.resize(pos + n);
+        }
+        samples.shrink_to_fit();
+    }
+
+    return data;
+}
+
+ysfx_audio_data_ptr ysfx_audio_cache_acquire(ysfx_audio_cache_t *cache, const ysfx_audio_format_t &fmt, const char *path, bool blocking)
+{
+    ysfx::file_stamp stamp;
+    if (!ysfx::get_file_stamp(path, stamp))
+        return nullptr;
+
+    ysfx_audio_cache_t::key_t key;
+    key.path = path;
+    key.open = fmt.open;
+    std::promise<ysfx_audio_data_ptr> promise;
+    uint64_t budget;
+
+    {
+        std::unique_lock<ysfx::mutex> lock{cache->mutex};
+        auto it = cache->index.find(key);
+        if (it != cache->index.end()) {
+            auto pos = it->second;
+            if (pos->stamp == stamp) {
+                if (pos->pending && !blocking)
+                    return nullptr;
+                cache->lru.splice(cache->lru.begin(), cache->lru, pos);
+                std::shared_future<ysfx_audio_data_ptr> data = pos->data;
+                lock.unlock();
+                return data.get();
+            }
+            if (!blocking)
+                return nullptr;
+            // the file has changed since it was cached: discard the old contents
+            ysfx_audio_cache_erase(*cache, pos);
+        }
+        else if (!blocking)
+            return nullptr;
+        // register the decoding in progress, for other requesters to wait on it
+        ysfx_audio_cache_t::entry_t entry;
+        entry.key = key;
+        entry.stamp = stamp;
+        entry.data = promise.get_future().share();
+        cache->lru.push_front(std::move(entry));
+        cache->index[key] = cache->lru.begin();
+        budget = cache->budget;
+    }
+
+    ysfx_audio_data_ptr data = ysfx_audio_decode(fmt, path, budget);
+    promise.set_value(data);
+
+    std::lock_guard<ysfx::mutex> lock{cache->mutex};
+    auto it = cache->index.find(key);
+    // the entry was evicted or replaced meanwhile
+    if (it == cache->index.end() || !(it->second->stamp == stamp) || !it->second->pending)
+        return data;
+
+    // do not retain the failures, nor what is too large to fit along with the rest
+    uint64_t size = data ? ysfx_audio_data_size(*data) : 0;
+    if (!data || size > cache->budget) {
+        ysfx_audio_cache_erase(*cache, it->second);
+        return data;
+    }
+
+    ysfx_audio_cache_t::entry_t &entry = *it->second;
+    entry.size = size;
+    entry.pending = false;
+    cache->size += size;
+    // keep this entry out of the eviction, it is no larger than the budget
+    cache->lru.splice(cache->lru.begin(), cache->lru, it->second);
+    ysfx_audio_cache_trim(*cache, cache->budget);
+
+    return data;
+}
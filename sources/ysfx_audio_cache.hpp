@@ -0,0 +1,75 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+#include "ysfx.h"
+#include "ysfx_utils.hpp"
+#include <unordered_map>
+#include <functional>
+#include <list>
+#include <vector>
+#include <string>
+#include <memory>
+#include <future>
+#include <atomic>
+
+// the decoded contents of an audio file, which are immutable once cached
+struct ysfx_audio_data_t {
+    ysfx_audio_file_info_t info{};
+    std::vector<ysfx_real> samples;
+};
+
+using ysfx_audio_data_ptr = std::shared_ptr<const ysfx_audio_data_t>;
+
+struct ysfx_audio_cache_s {
+    // a file as decoded by a format, which is identified by its open function
+    struct key_t {
+        std::string path;
+        ysfx_audio_reader_t *(*open)(const char *) = nullptr;
+        bool operator==(const key_t &other) const { return path == other.path && open == other.open; }
+    };
+    struct key_hash_t {
+        size_t operator()(const key_t &key) const
+        {
+            return std::hash<std::string>{}(key.path) ^ (std::hash<ysfx_audio_reader_t *(*)(const char *)>{}(key.open) * 31);
+        }
+    };
+    struct entry_t {
+        key_t key;
+        ysfx::file_stamp stamp;
+        // the contents, which are pending while the first requester decodes the file
+        std::shared_future<ysfx_audio_data_ptr> data;
+        // the size of the contents, which is zero while they are pending
+        uint64_t size = 0;
+        bool pending = true;
+    };
+
+    ysfx::mutex mutex;
+    // the entries, ordered from the most recently used to the least
+    std::list<entry_t> lru;
+    std::unordered_map<key_t, std::list<entry_t>::iterator, key_hash_t> index;
+    uint64_t budget = 0;
+    uint64_t size = 0;
+    std::atomic<uint32_t> ref_count{1};
+};
+
+// get the decoded contents of an audio file, decoding the file if it is not
+//   in cache or if it has changed on disk since it was cached
+// returns null if the file cannot be decoded, or if its length exceeds the budget
+// if not blocking, returns only the contents which are ready, and null if
+//   the file would have to be decoded, or waited for while another decodes it
+ysfx_audio_data_ptr ysfx_audio_cache_acquire(ysfx_audio_cache_t *cache, const ysfx_audio_format_t &fmt, const char *path, bool blocking = true);
@@ -135,8 +135,7 @@ static uint64_t ysfx_flac_read(ysfx_audio_reader_t *reader_, ysfx_real *samples,
         uint64_t readframes = drflac_read_pcm_frames_f32(reader->flac.get(), count / channels, f32buf);
         uint64_t readsamples = channels * readframes;
         // f32->f64
-        for (uint64_t i = readsamples; i-- > 0; )
-            samples[i] = f32buf[i];
+        ysfx::widen_f32_to_f64(f32buf, samples, readsamples);
         samples += readsamples;
         count -= readsamples;
         readtotal += readsamples;
@@ -155,6 +154,18 @@ static uint64_t ysfx_flac_read(ysfx_audio_reader_t *reader_, ysfx_real *samples,
     return readtotal;
 }
 
+static bool ysfx_flac_seek(ysfx_audio_reader_t *reader_, uint64_t frame)
+{
+    ysfx_flac_reader_t *reader = (ysfx_flac_reader_t *)reader_;
+    uint64_t total = reader->flac->totalPCMFrameCount;
+    if (total > 0 && frame > total)
+        frame = total;
+    if (!drflac_seek_to_pcm_frame(reader->flac.get(), frame))
+        return false;
+    reader->nbuff = 0;
+    return true;
+}
+
 const ysfx_audio_format_t ysfx_audio_format_flac = {
     &ysfx_flac_can_handle,
     &ysfx_flac_open,
@@ -163,4 +174,5 @@ const ysfx_audio_format_t ysfx_audio_format_flac = {
     &ysfx_flac_avail,
     &ysfx_flac_rewind,
     &ysfx_flac_read,
+    &ysfx_flac_seek,
 };
@@ -0,0 +1,356 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ysfx_audio_stream.hpp"
+#include "utility/rt_semaphore.h"
+#include <condition_variable>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <cstring>
+
+enum {
+    ysfx_audio_stream_min_ring = 1024,
+};
+
+//------------------------------------------------------------------------------
+
+// the thread which opens and fills the streams of all the effects
+class ysfx_audio_stream_worker_t {
+public:
+    static ysfx_audio_stream_worker_t &instance()
+    {
+        // never destroyed, for the effects which outlive the static destructors
+        static ysfx_audio_stream_worker_t *worker = new ysfx_audio_stream_worker_t;
+        return *worker;
+    }
+
+    void add(ysfx_audio_stream_t *stream);
+    void wake() { m_sem.post(); }
+    void wait_pass();
+
+private:
+    ysfx_audio_stream_worker_t();
+    void run();
+
+private:
+    RTSemaphore m_sem;
+    // the streams added since the last pass, linked in a lock-free stack
+    std::atomic<ysfx_audio_stream_t *> m_added{nullptr};
+    // the streams, accessed by the worker only
+    std::vector<ysfx_audio_stream_t *> m_streams;
+    std::mutex m_pass_mutex;
+    std::condition_variable m_pass_cond;
+    uint64_t m_pass = 0;
+    std::thread m_thread;
+};
+
+ysfx_audio_stream_worker_t::ysfx_audio_stream_worker_t()
+{
+    m_thread = std::thread([this]() { run(); });
+}
+
+void ysfx_audio_stream_worker_t::add(ysfx_audio_stream_t *stream)
+{
+    ysfx_audio_stream_t *head = m_added.load(std::memory_order_relaxed);
+    do
+        stream->m_next_added = head;
+    while (!m_added.compare_exchange_weak(head, stream, std::memory_order_release, std::memory_order_relaxed));
+    m_sem.post();
+}
+
+void ysfx_audio_stream_worker_t::wait_pass()
+{
+    std::unique_lock<std::mutex> lock{m_pass_mutex};
+    uint64_t target = m_pass + 1;
+    m_sem.post();
+    m_pass_cond.wait(lock, [this, target]() { return m_pass >= target; });
+}
+
+void ysfx_audio_stream_worker_t::run()
+{
+    for (;;) {
+        m_sem.wait();
+
+        for (ysfx_audio_stream_t *stream = m_added.exchange(nullptr, std::memory_order_acquire); stream; ) {
+            ysfx_audio_stream_t *next = stream->m_next_added;
+            m_streams.push_back(stream);
+            stream = next;
+        }
+
+        bool busy = false;
+        for (size_t i = 0; i < m_streams.size(); ) {
+            ysfx_audio_stream_t *stream = m_streams[i];
+            if (stream->m_closed.load(std::memory_order_acquire)) {
+                m_streams[i] = m_streams.back();
+                m_streams.pop_back();
+                delete stream;
+                continue;
+            }
+            if (stream->m_state.load(std::memory_order_relaxed) == ysfx_audio_stream_t::state_pending)
+                stream->open();
+            busy = stream->fill() || busy;
+            ++i;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{m_pass_mutex};
+            ++m_pass;
+        }
+        m_pass_cond.notify_all();
+
+        // continue without waiting while there is decoding to do
+        if (busy)
+            m_sem.post();
+    }
+}
+
+bool ysfx_audio_seek(const ysfx_audio_format_t &fmt, ysfx_audio_reader_t *reader, uint64_t position)
+{
+    uint64_t skip = position;
+
+    if (fmt.seek) {
+        uint32_t channels = fmt.info(reader).channels;
+        if (channels == 0 || !fmt.seek(reader, position / channels))
+            return false;
+        skip = position % channels;
+    }
+    else
+        fmt.rewind(reader);
+
+    enum { skip_size = 256 };
+    ysfx_real buf[skip_size];
+    while (skip > 0) {
+        uint32_t k = (uint32_t)std::min<uint64_t>(skip, skip_size);
+        if (fmt.read(reader, buf, k) != k)
+            return false;
+        skip -= k;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+ysfx_audio_stream_t::ysfx_audio_stream_t(const ysfx_audio_format_t &fmt, const char *path, uint32_t read_ahead)
+    : m_fmt(fmt),
+      m_path(path),
+      m_read_ahead(read_ahead),
+      m_reader(nullptr, fmt.close)
+{
+}
+
+bool ysfx_audio_stream_t::open()
+{
+    ysfx_audio_reader_t *reader = m_fmt.open(m_path.c_str());
+    if (!reader) {
+        m_state.store(state_failed, std::memory_order_release);
+        return false;
+    }
+
+    m_reader.reset(reader);
+    m_info = m_fmt.info(reader);
+    m_length = m_fmt.avail(reader);
+
+    m_head.resize(m_read_ahead);
+    m_head.resize((size_t)m_fmt.read(reader, m_head.data(), m_read_ahead));
+    m_head_complete = m_head.size() < m_read_ahead;
+
+    if (!m_head_complete) {
+        uint64_t ring_size = ysfx_audio_stream_min_ring;
+        while (ring_size < m_read_ahead)
+            ring_size <<= 1;
+        m_ring.reset(new ysfx_real[(size_t)ring_size]);
+        m_ring_mask = ring_size - 1;
+    }
+
+    m_state.store(state_ready, std::memory_order_release);
+    return true;
+}
+
+ysfx_audio_file_info_t ysfx_audio_stream_t::info() const
+{
+    if (!ready())
+        return ysfx_audio_file_info_t{};
+    return m_info;
+}
+
+uint64_t ysfx_audio_stream_t::avail() const
+{
+    if (!ready())
+        return 0;
+    if (m_head_complete)
+        return (m_consumed < m_head.size()) ? (m_head.size() - m_consumed) : 0;
+    return (m_consumed < m_length) ? (m_length - m_consumed) : 0;
+}
+
+void ysfx_audio_stream_t::seek(uint64_t position)
+{
+    if (!ready())
+        m_consumed = position;
+    else if (m_head_complete) {
+        m_consumed = std::min<uint64_t>(position, m_head.size());
+        return;
+    }
+    else
+        m_consumed = std::min(position, m_length);
+
+    // discard what is in the ring, the producer will acknowledge and refill
+    m_read_pos.store(m_write_pos.load(std::memory_order_acquire), std::memory_order_release);
+    m_seek_target.store(m_consumed, std::memory_order_relaxed);
+    m_seek_request.store(m_seek_request.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    ysfx_audio_stream_worker_t::instance().wake();
+}
+
+uint32_t ysfx_audio_stream_t::read(ysfx_real *dest, uint32_t count, bool &underrun)
+{
+    uint32_t numread = 0;
+    underrun = false;
+
+    int state = m_state.load(std::memory_order_acquire);
+    if (state != state_ready) {
+        underrun = state == state_pending;
+        return 0;
+    }
+
+    // copy from the head
+    if (m_consumed < m_head.size()) {
+        uint32_t n = (uint32_t)std::min<uint64_t>(count, m_head.size() - m_consumed);
+        memcpy(dest, &m_head[(size_t)m_consumed], n * sizeof(ysfx_real));
+        m_consumed += n;
+        numread += n;
+    }
+
+    if (numread == count || m_head_complete)
+        return numread;
+
+    // copy from the ring, if the producer is done with the last rewind
+    uint32_t ack = m_seek_ack.load(std::memory_order_acquire);
+    if (ack != m_seek_request.load(std::memory_order_relaxed)) {
+        underrun = true;
+        return numread;
+    }
+
+    uint64_t rpos = m_read_pos.load(std::memory_order_relaxed);
+    if (m_seen_ack != ack) {
+        // skip the stale samples which were written before the seek
+        m_seen_ack = ack;
+        rpos = std::max(rpos, m_seek_pos.load(std::memory_order_relaxed));
+    }
+
+    uint64_t end = m_end_pos.load(std::memory_order_acquire);
+    uint64_t wpos = m_write_pos.load(std::memory_order_acquire);
+
+    uint32_t n = (uint32_t)std::min<uint64_t>(count - numread, wpos - rpos);
+    for (uint32_t i = 0; i < n; ) {
+        size_t index = (size_t)((rpos + i) & m_ring_mask);
+        uint32_t k = (uint32_t)std::min<uint64_t>(n - i, m_ring_mask + 1 - index);
+        memcpy(dest + numread + i, &m_ring[index], k * sizeof(ysfx_real));
+        i += k;
+    }
+
+    rpos += n;
+    m_read_pos.store(rpos, std::memory_order_seq_cst);
+    m_consumed += n;
+    numread += n;
+
+    // wake the producer if it waits for room, and there is enough of it
+    if (m_wake_on_room.load(std::memory_order_seq_cst)) {
+        uint64_t ring_size = m_ring_mask + 1;
+        uint64_t space = ring_size - (m_write_pos.load(std::memory_order_acquire) - rpos);
+        if (space >= ring_size / 4 && m_wake_on_room.exchange(false, std::memory_order_relaxed))
+            ysfx_audio_stream_worker_t::instance().wake();
+    }
+
+    underrun = numread < count && rpos != end;
+    return numread;
+}
+
+bool ysfx_audio_stream_t::fill()
+{
+    if (m_head_complete)
+        return false;
+
+    uint64_t wpos = m_write_pos.load(std::memory_order_relaxed);
+
+    uint32_t request = m_seek_request.load(std::memory_order_acquire);
+    if (request != m_seek_ack.load(std::memory_order_relaxed)) {
+        // reposition the reader, the head being served by the consumer
+        uint64_t target = std::max<uint64_t>(m_seek_target.load(std::memory_order_relaxed), m_head.size());
+        if (ysfx_audio_seek(m_fmt, m_reader.get(), target))
+            m_end_pos.store(~(uint64_t)0, std::memory_order_relaxed);
+        else
+            m_end_pos.store(wpos, std::memory_order_relaxed);
+        m_seek_pos.store(wpos, std::memory_order_relaxed);
+        m_seek_ack.store(request, std::memory_order_release);
+        return true;
+    }
+
+    if (m_end_pos.load(std::memory_order_relaxed) != ~(uint64_t)0)
+        return false;
+
+    uint64_t ring_size = m_ring_mask + 1;
+    uint64_t space = ring_size - (wpos - m_read_pos.load(std::memory_order_acquire));
+    if (space < ring_size / 4) {
+        // ask for a wake-up, and check again in case the consumer read meanwhile
+        m_wake_on_room.store(true, std::memory_order_seq_cst);
+        space = ring_size - (wpos - m_read_pos.load(std::memory_order_seq_cst));
+        if (space < ring_size / 4)
+            return false;
+        m_wake_on_room.store(false, std::memory_order_relaxed);
+    }
+
+    size_t index = (size_t)(wpos & m_ring_mask);
+    uint64_t n = std::min<uint64_t>(space, ring_size - index);
+    uint64_t m = m_fmt.read(m_reader.get(), &m_ring[index], n);
+
+    m_write_pos.store(wpos + m, std::memory_order_release);
+    if (m < n)
+        m_end_pos.store(wpos + m, std::memory_order_release);
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+ysfx_audio_streamer_t::ysfx_audio_streamer_t()
+{
+    ysfx_audio_stream_worker_t::instance();
+}
+
+ysfx_audio_stream_ptr ysfx_audio_streamer_t::open(const ysfx_audio_format_t &fmt, const char *path, uint32_t read_ahead, bool deferred)
+{
+    ysfx_audio_stream_t *stream = new ysfx_audio_stream_t(fmt, path, read_ahead);
+    if (!deferred && !stream->open()) {
+        delete stream;
+        return nullptr;
+    }
+
+    ysfx_audio_stream_worker_t::instance().add(stream);
+    return stream;
+}
+
+void ysfx_audio_streamer_t::close(ysfx_audio_stream_ptr stream)
+{
+    stream->m_closed.store(true, std::memory_order_release);
+    ysfx_audio_stream_worker_t::instance().wake();
+}
+
+void ysfx_audio_streamer_t::wait_fill()
+{
+    ysfx_audio_stream_worker_t::instance().wait_pass();
+}
@@ -0,0 +1,131 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+#include "ysfx.h"
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+
+// move the read pointer to the sample position, seeking if the format permits,
+//   otherwise reading through from the beginning
+bool ysfx_audio_seek(const ysfx_audio_format_t &fmt, ysfx_audio_reader_t *reader, uint64_t position);
+
+//------------------------------------------------------------------------------
+
+// an audio file which is decoded ahead of the reads by a worker thread
+//   the reads only copy out of a ring, they never wait on the decoder;
+//   the head of the file is retained, so that a rewind resumes instantly,
+//   whereas a seek elsewhere underruns until the worker has caught up
+// the file may be opened by the worker as well, in which case the stream
+//   is empty and underruns until the worker has opened it
+class ysfx_audio_stream_t {
+public:
+    // prepare to open the file, which happens in `open`
+    ysfx_audio_stream_t(const ysfx_audio_format_t &fmt, const char *path, uint32_t read_ahead);
+
+    // consumer side: for the thread which runs the effect
+    ysfx_audio_file_info_t info() const;
+    uint64_t avail() const;
+    void rewind() { seek(0); }
+    void seek(uint64_t position);
+    // copy the samples which are ready; `underrun` indicates a short read before the end of file
+    uint32_t read(ysfx_real *dest, uint32_t count, bool &underrun);
+
+    // producer side: for the worker thread, or the consumer before it has shared the stream
+    // open the file and decode the head, return false if the file cannot be opened
+    bool open();
+    // decode into the free space of the ring, return false if there was nothing to do
+    bool fill();
+
+private:
+    enum { state_pending, state_ready, state_failed };
+    bool ready() const { return m_state.load(std::memory_order_acquire) == state_ready; }
+
+private:
+    ysfx_audio_format_t m_fmt{};
+    std::string m_path;
+    uint32_t m_read_ahead = 0;
+    std::atomic<int> m_state{state_pending};
+
+    std::unique_ptr<ysfx_audio_reader_t, void (*)(ysfx_audio_reader_t *)> m_reader;
+    ysfx_audio_file_info_t m_info{};
+    uint64_t m_length = 0;
+
+    // the beginning of the file; if `m_head_complete`, it is the whole file
+    std::vector<ysfx_real> m_head;
+    bool m_head_complete = false;
+
+    // the ring, which continues after the head; positions increase monotonically
+    std::unique_ptr<ysfx_real[]> m_ring;
+    uint64_t m_ring_mask = 0;
+    std::atomic<uint64_t> m_write_pos{0};
+    std::atomic<uint64_t> m_read_pos{0};
+    // the write position of the end of file, if it is reached
+    std::atomic<uint64_t> m_end_pos{~(uint64_t)0};
+    // set by the producer when the ring is full, for the consumer to wake it
+    //   when there is room again
+    std::atomic<bool> m_wake_on_room{false};
+
+    // seek handshake: the producer acknowledges the request after it has
+    //   repositioned the reader, and indicates where the fresh samples start
+    std::atomic<uint64_t> m_seek_target{0};
+    std::atomic<uint32_t> m_seek_request{0};
+    std::atomic<uint32_t> m_seek_ack{0};
+    std::atomic<uint64_t> m_seek_pos{0};
+
+    // consumer state
+    uint64_t m_consumed = 0;
+    uint32_t m_seen_ack = 0;
+
+    // the hand-over to the worker thread
+    std::atomic<bool> m_closed{false};
+    ysfx_audio_stream_t *m_next_added = nullptr;
+    friend class ysfx_audio_stream_worker_t;
+    friend class ysfx_audio_streamer_t;
+};
+
+// a stream belongs to the worker thread, which deletes it after it is closed
+using ysfx_audio_stream_ptr = ysfx_audio_stream_t *;
+
+//------------------------------------------------------------------------------
+
+// the streams of an effect, which are filled by a thread shared by all the effects
+//   the operations never lock, so they may be called from the audio thread
+class ysfx_audio_streamer_t {
+public:
+    // start the shared thread, if it is not started already
+    ysfx_audio_streamer_t();
+
+    // open the file immediately, or leave it for the worker thread if deferred
+    // returns null if the file cannot be opened; a deferred stream is never null
+    ysfx_audio_stream_ptr open(const ysfx_audio_format_t &fmt, const char *path, uint32_t read_ahead, bool deferred = false);
+    // retire the stream, which is not to be used anymore after this call
+    void close(ysfx_audio_stream_ptr stream);
+
+    // wake the worker, and wait until it has completed a pass over the streams
+    void wait_fill();
+
+    void count_underrun(uint64_t count = 1) { m_underruns.fetch_add(count, std::memory_order_relaxed); }
+    uint64_t underruns() const { return m_underruns.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> m_underruns{0};
+};
+
+using ysfx_audio_streamer_u = std::unique_ptr<ysfx_audio_streamer_t>;
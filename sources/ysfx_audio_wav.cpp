@@ -39,6 +39,11 @@ struct ysfx_wav_reader_t {
     std::unique_ptr<drwav> wav;
     uint32_t nbuff = 0;
     std::unique_ptr<float[]> buff;
+    // float32 data is read from the mapped file, if it is large, bypassing drwav
+    std::unique_ptr<ysfx::mapped_file> map;
+    const uint8_t *mapdata = nullptr;
+    uint64_t mapcount = 0;
+    uint64_t mappos = 0;
 };
 
 static bool ysfx_wav_can_handle(const char *path)
@@ -46,6 +51,37 @@ static bool ysfx_wav_can_handle(const char *path)
     return ysfx::path_has_suffix(path, "wav");
 }
 
+static void ysfx_wav_try_map(ysfx_wav_reader_t *reader, const char *path)
+{
+    const drwav &wav = *reader->wav;
+    if (wav.translatedFormatTag != DR_WAVE_FORMAT_IEEE_FLOAT || wav.bitsPerSample != 32)
+        return;
+
+    std::unique_ptr<ysfx::mapped_file> map{new ysfx::mapped_file};
+    if (!map->open(path, ysfx::mapped_file_min_size))
+        return;
+
+    uint64_t count = wav.totalPCMFrameCount * wav.channels;
+    if (wav.dataChunkDataPos > map->size() || count > (map->size() - wav.dataChunkDataPos) / 4)
+        return;
+
+    reader->mapdata = map->data() + wav.dataChunkDataPos;
+    reader->mapcount = count;
+    reader->map = std::move(map);
+}
+
+// shorten the mapped data, if another process has truncated the file
+static void ysfx_wav_refresh_map(ysfx_wav_reader_t *reader)
+{
+    uint64_t size = reader->map->refresh();
+    uint64_t start = reader->wav->dataChunkDataPos;
+    uint64_t count = (size > start) ? ((size - start) / 4) : 0;
+    if (reader->mapcount > count)
+        reader->mapcount = count;
+    if (reader->mappos > reader->mapcount)
+        reader->mappos = reader->mapcount;
+}
+
 static ysfx_audio_reader_t *ysfx_wav_open(const char *path)
 {
     std::unique_ptr<drwav> wav{new drwav};
@@ -59,6 +95,7 @@ static ysfx_audio_reader_t *ysfx_wav_open(const char *path)
     std::unique_ptr<ysfx_wav_reader_t> reader{new ysfx_wav_reader_t};
     reader->wav = std::move(wav);
     reader->buff.reset(new float[reader->wav->channels]);
+    ysfx_wav_try_map(reader.get(), path);
     return (ysfx_audio_reader_t *)reader.release();
 }
 
@@ -80,12 +117,21 @@ static ysfx_audio_file_info_t ysfx_wav_info(ysfx_audio_reader_t *reader_)
 static uint64_t ysfx_wav_avail(ysfx_audio_reader_t *reader_)
 {
     ysfx_wav_reader_t *reader = (ysfx_wav_reader_t *)reader_;
+    if (reader->map) {
+        ysfx_wav_refresh_map(reader);
+        return reader->mapcount - reader->mappos;
+    }
     return reader->nbuff + reader->wav->channels * (reader->wav->totalPCMFrameCount - reader->wav->readCursorInPCMFrames);
 }
 
 static void ysfx_wav_rewind(ysfx_audio_reader_t *reader_)
 {
     ysfx_wav_reader_t *reader = (ysfx_wav_reader_t *)reader_;
+    if (reader->map) {
+        reader->mappos = 0;
+        ysfx_wav_refresh_map(reader);
+        return;
+    }
     drwav_seek_to_pcm_frame(reader->wav.get(), 0);
     reader->nbuff = 0;
 }
@@ -115,6 +161,17 @@ static uint64_t ysfx_wav_read(ysfx_audio_reader_t *reader_, ysfx_real *samples,
     uint32_t channels = reader->wav->channels;
     uint64_t readtotal = 0;
 
+    if (reader->map) {
+        // check the size at every bulk read, and whenever a read enters another 64 KiB
+        if (count > 1 || (reader->mappos & 0x3fff) == 0)
+            ysfx_wav_refresh_map(reader);
+        uint64_t avail = reader->mapcount - reader->mappos;
+        readtotal = (count < avail) ? count : avail;
+        ysfx::widen_f32le_to_f64(reader->mapdata + 4 * reader->mappos, samples, (size_t)readtotal);
+        reader->mappos += readtotal;
+        return readtotal;
+    }
+
     if (count == 0)
         return readtotal;
     else {
@@ -131,8 +188,7 @@ static uint64_t ysfx_wav_read(ysfx_audio_reader_t *reader_, ysfx_real *samples,
         uint64_t readframes = drwav_read_pcm_frames_f32(reader->wav.get(), count / channels, f32buf);
         uint64_t readsamples = channels * readframes;
         // f32->f64
-        for (uint64_t i = readsamples; i-- > 0; )
-            samples[i] = f32buf[i];
+        ysfx::widen_f32_to_f64(f32buf, samples, readsamples);
         samples += readsamples;
         count -= readsamples;
         readtotal += readsamples;
@@ -151,6 +207,22 @@ static uint64_t ysfx_wav_read(ysfx_audio_reader_t *reader_, ysfx_real *samples,
     return readtotal;
 }
 
+static bool ysfx_wav_seek(ysfx_audio_reader_t *reader_, uint64_t frame)
+{
+    ysfx_wav_reader_t *reader = (ysfx_wav_reader_t *)reader_;
+    if (frame > reader->wav->totalPCMFrameCount)
+        frame = reader->wav->totalPCMFrameCount;
+    if (reader->map) {
+        reader->mappos = frame * reader->wav->channels;
+        ysfx_wav_refresh_map(reader);
+        return true;
+    }
+    if (!drwav_seek_to_pcm_frame(reader->wav.get(), frame))
+        return false;
+    reader->nbuff = 0;
+    return true;
+}
+
 const ysfx_audio_format_t ysfx_audio_format_wav = {
     &ysfx_wav_can_handle,
     &ysfx_wav_open,
@@ -159,4 +231,5 @@ const ysfx_audio_format_t ysfx_audio_format_wav = {
     &ysfx_wav_avail,
     &ysfx_wav_rewind,
     &ysfx_wav_read,
+    &ysfx_wav_seek,
 };
@@ -19,6 +19,9 @@
 #include "ysfx_utils.hpp"
 #include "ysfx_audio_wav.hpp"
 #include "ysfx_audio_flac.hpp"
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
 #include <cassert>
 
 ysfx_config_t *ysfx_config_new()
@@ -99,7 +102,14 @@ void ysfx_guess_file_roots(ysfx_config_t *config, const char *sourcepath)
 
 void ysfx_register_audio_format(ysfx_config_t *config, ysfx_audio_format_t *afmt)
 {
-    config->audio_formats.push_back(*afmt);
+    ysfx_register_audio_format_sized(config, afmt, offsetof(ysfx_audio_format_t, seek));
+}
+
+void ysfx_register_audio_format_sized(ysfx_config_t *config, const ysfx_audio_format_t *afmt, size_t size)
+{
+    ysfx_audio_format_t fmt{};
+    memcpy(&fmt, afmt, std::min(size, sizeof(fmt)));
+    config->audio_formats.push_back(fmt);
 }
 
 void ysfx_register_builtin_audio_formats(ysfx_config_t *config)
@@ -108,6 +118,32 @@ void ysfx_register_builtin_audio_formats(ysfx_config_t *config)
     config->audio_formats.push_back(ysfx_audio_format_flac);
 }
 
+void ysfx_set_audio_cache(ysfx_config_t *config, ysfx_audio_cache_t *cache)
+{
+    if (cache)
+        ysfx_audio_cache_add_ref(cache);
+    config->audio_cache.reset(cache);
+}
+
+void ysfx_set_source_cache(ysfx_config_t *config, ysfx_source_cache_t *cache)
+{
+    if (cache)
+        ysfx_source_cache_add_ref(cache);
+    config->source_cache.reset(cache);
+}
+
+void ysfx_set_image_cache(ysfx_config_t *config, ysfx_image_cache_t *cache)
+{
+    if (cache)
+        ysfx_image_cache_add_ref(cache);
+    config->image_cache.reset(cache);
+}
+
+void ysfx_set_audio_read_ahead(ysfx_config_t *config, uint32_t samples)
+{
+    config->audio_read_ahead = samples;
+}
+
 void ysfx_set_log_reporter(ysfx_config_t *config, ysfx_log_reporter_t *reporter)
 {
     config->log_reporter = reporter;
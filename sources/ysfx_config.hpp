@@ -26,6 +26,10 @@ struct ysfx_config_s {
     std::string import_root;
     std::string data_root;
     std::vector<ysfx_audio_format_t> audio_formats;
+    ysfx_audio_cache_u audio_cache;
+    ysfx_source_cache_u source_cache;
+    ysfx_image_cache_u image_cache;
+    uint32_t audio_read_ahead = 0;
     ysfx_log_reporter_t *log_reporter = nullptr;
     intptr_t userdata = 0;
     std::atomic<uint32_t> ref_count{1};
@@ -0,0 +1,380 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ysfx_convolver.hpp"
+#include "utility/rt_semaphore.h"
+#include <algorithm>
+#include <thread>
+#include <cstring>
+
+enum {
+    // the part of the response which is applied in the time domain, and the
+    //   partition size of the first stage, which follows it
+    ysfx_convolver_head_size = 64,
+    // the growth of the partitions from a stage to the next
+    ysfx_convolver_growth = 4,
+    // the partition size of the last stage, which covers all the rest
+    ysfx_convolver_max_size = 16384,
+    // the stages after the first, which each have a size of their own
+    ysfx_convolver_tail_levels = 4,
+};
+
+static_assert(ysfx_convolver_head_size * ysfx_convolver_growth * ysfx_convolver_growth *
+              ysfx_convolver_growth * ysfx_convolver_growth == ysfx_convolver_max_size,
+              "the tail levels must reach the maximum size");
+
+//------------------------------------------------------------------------------
+// The workers of the tail stages, shared by all the convolvers, one for each
+//   partition size, so that a short partition never waits behind a long one.
+// The processing hands the stages over with their state, and wakes the worker
+//   with a semaphore; it takes no lock.
+
+class ysfx_convolver_pool_t {
+public:
+    static ysfx_convolver_pool_t &instance()
+    {
+        // never destroyed, for the convolvers which outlive the static destructors
+        static ysfx_convolver_pool_t *pool = new ysfx_convolver_pool_t;
+        return *pool;
+    }
+
+    void add(ysfx_convolver_t *conv);
+    void remove(ysfx_convolver_t *conv);
+    void wake(uint32_t level) { m_workers[level].sem.post(); }
+
+private:
+    struct worker_t {
+        RTSemaphore sem;
+        // protects the list, which the worker holds while it computes
+        ysfx::mutex mutex;
+        std::vector<ysfx_convolver_t *> convs;
+        std::thread thread;
+    };
+
+    void run(uint32_t level);
+
+    worker_t m_workers[ysfx_convolver_tail_levels];
+};
+
+void ysfx_convolver_pool_t::add(ysfx_convolver_t *conv)
+{
+    const uint32_t levels = conv->m_num_stages - 1;
+    conv->m_refs.store(levels, std::memory_order_relaxed);
+    for (uint32_t level = 0; level < levels; ++level) {
+        worker_t &w = m_workers[level];
+        std::lock_guard<ysfx::mutex> lock(w.mutex);
+        if (!w.thread.joinable())
+            w.thread = std::thread([this, level]() { run(level); });
+        w.convs.push_back(conv);
+    }
+}
+
+void ysfx_convolver_pool_t::remove(ysfx_convolver_t *conv)
+{
+    for (uint32_t level = 0; level + 1 < conv->m_num_stages; ++level) {
+        worker_t &w = m_workers[level];
+        std::lock_guard<ysfx::mutex> lock(w.mutex);
+        w.convs.erase(std::remove(w.convs.begin(), w.convs.end(), conv), w.convs.end());
+    }
+}
+
+void ysfx_convolver_pool_t::run(uint32_t level)
+{
+    worker_t &w = m_workers[level];
+    for (;;) {
+        w.sem.wait();
+        std::lock_guard<ysfx::mutex> lock(w.mutex);
+        for (size_t i = 0; i < w.convs.size(); ) {
+            ysfx_convolver_t *conv = w.convs[i];
+            if (conv->m_disposed.load(std::memory_order_acquire)) {
+                w.convs[i] = w.convs.back();
+                w.convs.pop_back();
+                if (conv->m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    delete conv;
+                continue;
+            }
+            conv->run_stage(conv->m_stages[level + 1]);
+            ++i;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+ysfx_convolver_t::ysfx_convolver_t(const double *response, uint32_t length)
+    : m_length(length)
+{
+    uint32_t head = std::min<uint32_t>(length, ysfx_convolver_head_size);
+    m_head.assign(response, response + head);
+    std::reverse(m_head.begin(), m_head.end());
+
+    // the first stage starts after the head, with a latency of one partition;
+    //   the next ones are due one partition later, so each must start after
+    //   two of its partitions, which is where the previous stage ends
+    struct range_t { uint32_t size, offset, end; };
+    std::vector<range_t> ranges;
+    uint32_t offset = ysfx_convolver_head_size;
+    uint32_t size = ysfx_convolver_head_size;
+    while (offset < length) {
+        uint32_t next = std::min<uint32_t>(size * ysfx_convolver_growth, ysfx_convolver_max_size);
+        uint32_t end = length;
+        if (size < ysfx_convolver_max_size)
+            end = (uint32_t)std::min<uint64_t>(length, 2 * (uint64_t)next);
+        ranges.push_back(range_t{size, offset, end});
+        offset = end;
+        size = next;
+    }
+
+    m_num_stages = (uint32_t)ranges.size();
+    m_stages.reset(new stage_t[m_num_stages]);
+    for (uint32_t i = 0; i < m_num_stages; ++i) {
+        const range_t &r = ranges[i];
+        setup_stage(m_stages[i], r.size, response + r.offset, r.end - r.offset);
+    }
+
+    uint32_t ring_size = 2 * ysfx_convolver_head_size;
+    for (uint32_t i = 0; i < m_num_stages; ++i)
+        ring_size = std::max(ring_size, 2 * m_stages[i].size);
+    m_history.resize(2 * (size_t)ring_size);
+    m_ahead.resize(ring_size);
+    m_ring_mask = ring_size - 1;
+
+    if (m_num_stages > 1)
+        ysfx_convolver_pool_t::instance().add(this);
+}
+
+ysfx_convolver_t::~ysfx_convolver_t()
+{
+    // a freed convolver is deleted by a worker, after all have let it go
+    if (m_num_stages > 1 && !m_disposed.load(std::memory_order_relaxed))
+        ysfx_convolver_pool_t::instance().remove(this);
+}
+
+void ysfx_convolver_free(ysfx_convolver_t *conv)
+{
+    if (!conv)
+        return;
+
+    // without a tail, there are only the head and the first stage to free
+    const uint32_t num_stages = conv->m_num_stages;
+    if (num_stages < 2) {
+        delete conv;
+        return;
+    }
+
+    // the convolver may be gone once the last worker is woken
+    conv->m_disposed.store(true, std::memory_order_release);
+    ysfx_convolver_pool_t &pool = ysfx_convolver_pool_t::instance();
+    for (uint32_t level = 0; level + 1 < num_stages; ++level)
+        pool.wake(level);
+}
+
+void ysfx_convolver_t::setup_stage(stage_t &stage, uint32_t size, const double *response, uint32_t count)
+{
+    const uint32_t n2 = 2 * size;
+    stage.size = size;
+    stage.bits = 1;
+    while ((1u << stage.bits) < n2)
+        ++stage.bits;
+    stage.count = (count + size - 1) / size;
+
+    // the partitions, zero-padded to the size of the transform; the scale
+    //   cancels the gain of a forward transform of both, then an inverse
+    const double gain = 1.0 / (4.0 * n2);
+    stage.filter.resize((size_t)stage.count * n2);
+    for (uint32_t m = 0; m < stage.count; ++m) {
+        double *part = &stage.filter[(size_t)m * n2];
+        uint32_t n = std::min(size, count - m * size);
+        for (uint32_t i = 0; i < n; ++i)
+            part[i] = gain * response[(size_t)m * size + i];
+        ysfx::fft_real(part, stage.bits, false);
+    }
+
+    stage.fdl.resize((size_t)stage.count * n2);
+    stage.input.resize(n2);
+    stage.spectrum.resize(n2);
+    stage.output.resize(size);
+    stage.last_output.resize(size);
+}
+
+void ysfx_convolver_t::compute_stage(stage_t &stage)
+{
+    const ysfx::f64_kernels &k = ysfx::get_f64_kernels();
+    const uint32_t size = stage.size;
+    const uint32_t n2 = 2 * size;
+
+    stage.fdl_pos = (stage.fdl_pos + 1 < stage.count) ? (stage.fdl_pos + 1) : 0;
+    double *current = &stage.fdl[(size_t)stage.fdl_pos * n2];
+    memcpy(current, stage.input.data(), n2 * sizeof(double));
+    ysfx::fft_real(current, stage.bits, false);
+
+    // the bins 0 and N/2 are real, and packed in the first pair
+    double *spectrum = stage.spectrum.data();
+    std::fill_n(spectrum, n2, 0.0);
+    double dc = 0;
+    double nyquist = 0;
+    for (uint32_t m = 0; m < stage.count; ++m) {
+        uint32_t pos = (stage.fdl_pos >= m) ? (stage.fdl_pos - m) : (stage.fdl_pos + stage.count - m);
+        const double *x = &stage.fdl[(size_t)pos * n2];
+        const double *h = &stage.filter[(size_t)m * n2];
+        dc += x[0] * h[0];
+        nyquist += x[1] * h[1];
+        k.cmac(spectrum, x, h, size);
+    }
+    spectrum[0] = dc;
+    spectrum[1] = nyquist;
+
+    // overlap-save: the first half is aliased, the second is the output
+    ysfx::fft_real(spectrum, stage.bits, true);
+    memcpy(stage.output.data(), spectrum + size, size * sizeof(double));
+}
+
+void ysfx_convolver_t::run_stage(stage_t &stage)
+{
+    if (stage.state.load(std::memory_order_acquire) != stage_queued)
+        return;
+
+    if (stage.fdl_generation != stage.job_generation) {
+        std::fill(stage.fdl.begin(), stage.fdl.end(), 0.0);
+        stage.fdl_pos = 0;
+        stage.fdl_generation = stage.job_generation;
+    }
+    compute_stage(stage);
+    stage.state.store(stage_done, std::memory_order_release);
+
+    // a calling thread outside of the processing may be waiting for it
+    { std::lock_guard<std::mutex> lock(m_done_mutex); }
+    m_done_cond.notify_all();
+}
+
+void ysfx_convolver_t::wait_stage(stage_t &stage)
+{
+    std::unique_lock<std::mutex> lock(m_done_mutex);
+    m_done_cond.wait(lock, [&stage]() { return stage.state.load(std::memory_order_acquire) == stage_done; });
+}
+
+void ysfx_convolver_t::begin_stage(stage_t &stage)
+{
+    // the last input samples, which the history has contiguously
+    const uint32_t ring_size = m_ring_mask + 1;
+    const uint32_t pos = (uint32_t)m_time & m_ring_mask;
+    memcpy(stage.input.data(), &m_history[pos + ring_size - 2 * stage.size], 2 * stage.size * sizeof(double));
+}
+
+void ysfx_convolver_t::accumulate(const double *src, uint32_t count)
+{
+    const ysfx::f64_kernels &k = ysfx::get_f64_kernels();
+    const uint32_t ring_size = m_ring_mask + 1;
+    const uint32_t pos = (uint32_t)m_time & m_ring_mask;
+    uint32_t first = std::min(count, ring_size - pos);
+    k.add(&m_ahead[pos], src, first);
+    k.add(&m_ahead[0], src + first, count - first);
+}
+
+uint32_t ysfx_convolver_t::boundary(bool wait)
+{
+    // the tail first, so the workers run while this thread does the rest
+    uint32_t late = 0;
+    ysfx_convolver_pool_t *pool = nullptr;
+    for (uint32_t i = 1; i < m_num_stages; ++i) {
+        stage_t &stage = m_stages[i];
+        if ((m_time & (stage.size - 1)) != 0)
+            continue;
+
+        // the block submitted one partition ago is due now
+        int state = stage.state.load(std::memory_order_acquire);
+        if (state == stage_queued && wait) {
+            wait_stage(stage);
+            state = stage_done;
+        }
+        if (state == stage_queued) {
+            // the worker still has the buffers: repeat the previous output,
+            //   and collect this one later, in place of the next
+            accumulate(stage.last_output.data(), stage.size);
+            ++late;
+            continue;
+        }
+        if (state == stage_done && stage.job_generation == m_generation) {
+            accumulate(stage.output.data(), stage.size);
+            std::copy(stage.output.begin(), stage.output.end(), stage.last_output.begin());
+        }
+
+        begin_stage(stage);
+        stage.job_generation = m_generation;
+        stage.state.store(stage_queued, std::memory_order_release);
+        if (!pool)
+            pool = &ysfx_convolver_pool_t::instance();
+        pool->wake(i - 1);
+    }
+
+    stage_t &first = m_stages[0];
+    begin_stage(first);
+    compute_stage(first);
+    accumulate(first.output.data(), first.size);
+    return late;
+}
+
+uint32_t ysfx_convolver_t::process(double *data, uint32_t count, bool wait)
+{
+    const ysfx::f64_kernels &k = ysfx::get_f64_kernels();
+    const uint32_t ring_size = m_ring_mask + 1;
+    const uint32_t head = (uint32_t)m_head.size();
+    uint32_t late = 0;
+
+    while (count > 0) {
+        // process up to the end of a partition of the first stage
+        uint32_t n = ysfx_convolver_head_size - ((uint32_t)m_time & (ysfx_convolver_head_size - 1));
+        n = std::min(n, count);
+
+        for (uint32_t i = 0; i < n; ++i) {
+            uint32_t pos = (uint32_t)m_time & m_ring_mask;
+            m_history[pos] = m_history[pos + ring_size] = data[i];
+            double y = m_ahead[pos];
+            m_ahead[pos] = 0;
+            if (head > 0)
+                y += k.dot(m_head.data(), &m_history[pos + ring_size + 1 - head], head);
+            data[i] = y;
+            ++m_time;
+        }
+
+        if (m_num_stages > 0 && (m_time & (ysfx_convolver_head_size - 1)) == 0)
+            late += boundary(wait);
+
+        data += n;
+        count -= n;
+    }
+
+    return late;
+}
+
+void ysfx_convolver_t::reset()
+{
+    // the workers clear the past blocks of the tail with their next ones,
+    //   and the blocks they have yet to finish are dropped
+    ++m_generation;
+    for (uint32_t i = 0; i < m_num_stages; ++i) {
+        stage_t &stage = m_stages[i];
+        std::fill(stage.last_output.begin(), stage.last_output.end(), 0.0);
+        if (i == 0) {
+            std::fill(stage.fdl.begin(), stage.fdl.end(), 0.0);
+            stage.fdl_pos = 0;
+        }
+    }
+
+    std::fill(m_history.begin(), m_history.end(), 0.0);
+    std::fill(m_ahead.begin(), m_ahead.end(), 0.0);
+    m_time = 0;
+}
@@ -0,0 +1,123 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+#include "ysfx.h"
+#include "ysfx_utils.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <memory>
+
+// a convolution with a long impulse response, which adds no latency
+//   the response is cut into partitions which grow along its length:
+//   the head is applied in the time domain, the next partitions in the
+//   frequency domain on the calling thread, and the long partitions of the
+//   tail on the shared workers, each of which is due one partition later
+class ysfx_convolver_t {
+public:
+    explicit ysfx_convolver_t(const double *response, uint32_t length);
+    ~ysfx_convolver_t();
+
+    uint32_t length() const { return m_length; }
+    // filter the samples in place, continuing from the previous call;
+    //   if it must not `wait` for the workers, a partition which is late
+    //   repeats its previous output, and it returns the count of these
+    uint32_t process(double *data, uint32_t count, bool wait = true);
+    // clear the past input, as if the filter had never run
+    void reset();
+
+    std::unique_ptr<ysfx::mutex> m_mutex{new ysfx::mutex};
+
+    friend void ysfx_convolver_free(ysfx_convolver_t *conv);
+    friend class ysfx_convolver_pool_t;
+
+private:
+    enum {
+        stage_idle,
+        stage_queued,
+        stage_done,
+    };
+
+    // a range of the response, as uniform partitions convolved by overlap-save
+    struct stage_t {
+        uint32_t size = 0;
+        uint32_t bits = 0;
+        uint32_t count = 0;
+        // the spectra of the partitions, each with `2*size` values
+        std::vector<double> filter;
+        // the spectra of the past blocks of input, most recent at `fdl_pos`
+        std::vector<double> fdl;
+        uint32_t fdl_pos = 0;
+        // the last `2*size` input samples, then the spectral accumulator
+        std::vector<double> input;
+        std::vector<double> spectrum;
+        // the output which is due `size` samples after the block ends
+        std::vector<double> output;
+        // the resets which the past blocks and the queued block come after;
+        //   the worker clears the past blocks when these differ
+        uint32_t fdl_generation = 0;
+        uint32_t job_generation = 0;
+        // the worker owns the buffers from queued to done, the calling thread otherwise
+        std::atomic<int> state{stage_idle};
+        // the output of the previous block, repeated if the next one is late
+        std::vector<double> last_output;
+    };
+
+    void setup_stage(stage_t &stage, uint32_t size, const double *response, uint32_t count);
+    void compute_stage(stage_t &stage);
+    void run_stage(stage_t &stage);
+    void wait_stage(stage_t &stage);
+    void begin_stage(stage_t &stage);
+    void accumulate(const double *src, uint32_t count);
+    uint32_t boundary(bool wait);
+
+private:
+    uint32_t m_length = 0;
+
+    // the head of the response, reversed, which is applied directly
+    std::vector<double> m_head;
+    // the first stage is on the calling thread, the next ones on the workers
+    std::unique_ptr<stage_t[]> m_stages;
+    uint32_t m_num_stages = 0;
+
+    // the input history, stored twice so that every window is contiguous
+    std::vector<double> m_history;
+    // the output of the stages, accumulated ahead of time
+    std::vector<double> m_ahead;
+    uint32_t m_ring_mask = 0;
+    uint64_t m_time = 0;
+    uint32_t m_generation = 0;
+
+    // for the calling thread to wait for the workers, outside of the processing
+    std::mutex m_done_mutex;
+    std::condition_variable m_done_cond;
+
+    // once freed, the workers let it go, and the last one deletes it
+    std::atomic<bool> m_disposed{false};
+    std::atomic<uint32_t> m_refs{0};
+
+private:
+    ysfx_convolver_t(const ysfx_convolver_t &) = delete;
+    ysfx_convolver_t &operator=(const ysfx_convolver_t &) = delete;
+};
+
+// delete the convolver without waiting for the workers, which free the
+//   memory in the background, for the processing to call it
+void ysfx_convolver_free(ysfx_convolver_t *conv);
+YSFX_DEFINE_AUTO_PTR(ysfx_convolver_u, ysfx_convolver_t, ysfx_convolver_free);
@@ -25,21 +25,38 @@ ysfx_eel_ram_reader::ysfx_eel_ram_reader(NSEEL_VMCTX vm, int64_t addr)
 
 EEL_F ysfx_eel_ram_reader::read_next()
 {
-    if (m_block_avail == 0) {
-        m_block = (m_addr < 0 || m_addr > 0xFFFFFFFFu) ? nullptr :
-            NSEEL_VM_getramptr_noalloc(m_vm, (uint32_t)m_addr, (int32_t *)&m_block_avail);
-        if (m_block)
-            m_addr += m_block_avail;
-        else {
-            m_addr += 1;
-            m_block_avail = 1;
-        }
-    }
+    if (m_block_avail == 0)
+        next_block();
     EEL_F value = m_block ? *m_block++ : 0;
     m_block_avail -= 1;
     return value;
 }
 
+const EEL_F *ysfx_eel_ram_reader::read_span(uint32_t count, uint32_t *span_count)
+{
+    if (m_block_avail == 0)
+        next_block();
+    uint32_t n = (count < m_block_avail) ? count : m_block_avail;
+    const EEL_F *span = m_block;
+    if (m_block)
+        m_block += n;
+    m_block_avail -= n;
+    *span_count = n;
+    return span;
+}
+
+void ysfx_eel_ram_reader::next_block()
+{
+    m_block = (m_addr < 0 || m_addr > 0xFFFFFFFFu) ? nullptr :
+        NSEEL_VM_getramptr_noalloc(m_vm, (uint32_t)m_addr, (int32_t *)&m_block_avail);
+    if (!m_block) {
+        // the block is not allocated, it reads as zeros up to the end of it
+        m_block_avail = (m_addr < 0) ? 1 :
+            (NSEEL_RAM_ITEMSPERBLOCK - (uint32_t)(m_addr % NSEEL_RAM_ITEMSPERBLOCK));
+    }
+    m_addr += m_block_avail;
+}
+
 //------------------------------------------------------------------------------
 ysfx_eel_ram_writer::ysfx_eel_ram_writer(NSEEL_VMCTX vm, int64_t addr)
     : m_vm(vm),
@@ -49,18 +66,35 @@ ysfx_eel_ram_writer::ysfx_eel_ram_writer(NSEEL_VMCTX vm, int64_t addr)
 
 bool ysfx_eel_ram_writer::write_next(EEL_F value)
 {
-    if (m_block_avail == 0) {
-        m_block = (m_addr < 0 || m_addr > 0xFFFFFFFFu) ? nullptr :
-            NSEEL_VM_getramptr(m_vm, (uint32_t)m_addr, (int32_t *)&m_block_avail);
-        if (m_block)
-            m_addr += m_block_avail;
-        else {
-            m_addr += 1;
-            m_block_avail = 1;
-        }
-    }
+    if (m_block_avail == 0)
+        next_block();
     if (m_block)
         *m_block++ = value;
     m_block_avail -= 1;
     return true;
 }
+
+EEL_F *ysfx_eel_ram_writer::write_span(uint32_t count, uint32_t *span_count)
+{
+    if (m_block_avail == 0)
+        next_block();
+    uint32_t n = (count < m_block_avail) ? count : m_block_avail;
+    EEL_F *span = m_block;
+    if (m_block)
+        m_block += n;
+    m_block_avail -= n;
+    *span_count = n;
+    return span;
+}
+
+void ysfx_eel_ram_writer::next_block()
+{
+    m_block = (m_addr < 0 || m_addr > 0xFFFFFFFFu) ? nullptr :
+        NSEEL_VM_getramptr(m_vm, (uint32_t)m_addr, (int32_t *)&m_block_avail);
+    if (!m_block) {
+        // the failure concerns the entire block, skip to the end of it
+        m_block_avail = (m_addr < 0) ? 1 :
+            (NSEEL_RAM_ITEMSPERBLOCK - (uint32_t)(m_addr % NSEEL_RAM_ITEMSPERBLOCK));
+    }
+    m_addr += m_block_avail;
+}
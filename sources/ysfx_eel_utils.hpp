@@ -34,6 +34,12 @@ public:
     ysfx_eel_ram_reader() = default;
     ysfx_eel_ram_reader(NSEEL_VMCTX vm, int64_t addr);
     EEL_F read_next();
+    // get the next contiguous span of up to `count` values, and advance past it
+    // a null span is not addressable, and its values are meant to read as zeros
+    const EEL_F *read_span(uint32_t count, uint32_t *span_count);
+
+private:
+    void next_block();
 
 private:
     NSEEL_VMCTX m_vm{};
@@ -48,6 +54,12 @@ public:
     ysfx_eel_ram_writer() = default;
     ysfx_eel_ram_writer(NSEEL_VMCTX vm, int64_t addr);
     bool write_next(EEL_F value);
+    // get the next contiguous span of up to `count` values, and advance past it
+    // a null span is not addressable, and its values are meant to be discarded
+    EEL_F *write_span(uint32_t count, uint32_t *span_count);
+
+private:
+    void next_block();
 
 private:
     NSEEL_VMCTX m_vm{};
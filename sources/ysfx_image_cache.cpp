@@ -0,0 +1,151 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ysfx_image_cache.hpp"
+#include <mutex>
+
+static void ysfx_image_cache_trim(ysfx_image_cache_t &cache, uint64_t budget);
+static void ysfx_image_cache_erase(ysfx_image_cache_t &cache, std::list<ysfx_image_cache_t::entry_t>::iterator pos);
+
+ysfx_image_cache_t *ysfx_image_cache_new(uint64_t max_bytes)
+{
+    ysfx_image_cache_t *cache = new ysfx_image_cache_t;
+    cache->budget = max_bytes;
+    return cache;
+}
+
+void ysfx_image_cache_free(ysfx_image_cache_t *cache)
+{
+    if (!cache)
+        return;
+
+    if (cache->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        delete cache;
+}
+
+void ysfx_image_cache_add_ref(ysfx_image_cache_t *cache)
+{
+    cache->ref_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ysfx_image_cache_set_budget(ysfx_image_cache_t *cache, uint64_t max_bytes)
+{
+    std::lock_guard<ysfx::mutex> lock{cache->mutex};
+    cache->budget = max_bytes;
+    ysfx_image_cache_trim(*cache, max_bytes);
+}
+
+uint64_t ysfx_image_cache_get_size(ysfx_image_cache_t *cache)
+{
+    std::lock_guard<ysfx::mutex> lock{cache->mutex};
+    return cache->size;
+}
+
+uint32_t ysfx_image_cache_get_count(ysfx_image_cache_t *cache)
+{
+    std::lock_guard<ysfx::mutex> lock{cache->mutex};
+    uint32_t count = 0;
+    for (const ysfx_image_cache_t::entry_t &entry : cache->lru)
+        count += entry.size > 0;
+    return count;
+}
+
+void ysfx_image_cache_clear(ysfx_image_cache_t *cache)
+{
+    std::lock_guard<ysfx::mutex> lock{cache->mutex};
+    ysfx_image_cache_trim(*cache, 0);
+}
+
+//------------------------------------------------------------------------------
+// evict the least recently used images, except those which are pending
+static void ysfx_image_cache_trim(ysfx_image_cache_t &cache, uint64_t budget)
+{
+    auto pos = cache.lru.end();
+    while (cache.size > budget && pos != cache.lru.begin()) {
+        --pos;
+        if (pos->size > 0)
+            ysfx_image_cache_erase(cache, pos++);
+    }
+}
+
+static void ysfx_image_cache_erase(ysfx_image_cache_t &cache, std::list<ysfx_image_cache_t::entry_t>::iterator pos)
+{
+    cache.size -= pos->size;
+    cache.index.erase(pos->path);
+    cache.lru.erase(pos);
+}
+
+ysfx_image_data_ptr ysfx_image_cache_acquire(ysfx_image_cache_t *cache, const char *path, ysfx_image_decoder_t *decode)
+{
+    ysfx::file_stamp stamp;
+    if (!ysfx::get_file_stamp(path, stamp))
+        return nullptr;
+
+    const std::string key{path};
+    std::promise<ysfx_image_data_ptr> promise;
+    uint64_t serial;
+
+    {
+        std::unique_lock<ysfx::mutex> lock{cache->mutex};
+        auto it = cache->index.find(key);
+        if (it != cache->index.end()) {
+            auto pos = it->second;
+            if (pos->stamp == stamp) {
+                cache->lru.splice(cache->lru.begin(), cache->lru, pos);
+                std::shared_future<ysfx_image_data_ptr> data = pos->data;
+                lock.unlock();
+                return data.get();
+            }
+            // the file has changed since: discard the old contents
+            ysfx_image_cache_erase(*cache, pos);
+        }
+        // register the decoding in progress, for other requesters to wait on it
+        ysfx_image_cache_t::entry_t entry;
+        entry.path = key;
+        entry.stamp = stamp;
+        entry.data = promise.get_future().share();
+        entry.serial = serial = cache->next_serial++;
+        cache->lru.push_front(std::move(entry));
+        cache->index[key] = cache->lru.begin();
+    }
+
+    // decode without holding the lock
+    ysfx_image_data_ptr data = decode(path);
+    promise.set_value(data);
+
+    uint64_t size = data ? (uint64_t)data->pixels.size() * sizeof(uint32_t) : 0;
+
+    std::lock_guard<ysfx::mutex> lock{cache->mutex};
+    auto it = cache->index.find(key);
+    // the entry may be replaced already, if the file has changed meanwhile
+    if (it == cache->index.end() || it->second->serial != serial)
+        return data;
+    auto pos = it->second;
+
+    // do not retain the failures, nor an image which is too large to retain
+    //   along with the rest
+    if (size == 0 || size > cache->budget) {
+        ysfx_image_cache_erase(*cache, pos);
+        return data;
+    }
+
+    ysfx_image_cache_trim(*cache, cache->budget - size);
+    pos->size = size;
+    cache->size += size;
+
+    return data;
+}
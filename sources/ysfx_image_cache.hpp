@@ -0,0 +1,68 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+#include "ysfx.h"
+#include "ysfx_utils.hpp"
+#include <unordered_map>
+#include <list>
+#include <vector>
+#include <string>
+#include <memory>
+#include <future>
+#include <atomic>
+
+// the decoded pixels of an image file, which are immutable once cached
+struct ysfx_image_data_t {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    // the rows of pixels, in the native format of LICE, with no padding
+    std::vector<uint32_t> pixels;
+};
+
+using ysfx_image_data_ptr = std::shared_ptr<const ysfx_image_data_t>;
+
+// decode an image file; returns null if the file is not a supported image
+typedef ysfx_image_data_ptr (ysfx_image_decoder_t)(const char *path);
+
+struct ysfx_image_cache_s {
+    struct entry_t {
+        std::string path;
+        ysfx::file_stamp stamp;
+        // the image, which is pending while the first requester decodes the file
+        std::shared_future<ysfx_image_data_ptr> data;
+        // the size of the image, which is 0 while it is pending
+        uint64_t size = 0;
+        // a number which identifies the decoding
+        uint64_t serial = 0;
+    };
+
+    ysfx::mutex mutex;
+    // the entries, ordered from the most recently used to the least
+    std::list<entry_t> lru;
+    std::unordered_map<std::string, std::list<entry_t>::iterator> index;
+    uint64_t budget = 0;
+    uint64_t size = 0;
+    uint64_t next_serial = 0;
+    std::atomic<uint32_t> ref_count{1};
+};
+
+// get the decoded pixels of an image file, decoding the file if it is not in
+//   cache or if it has changed on disk since it was cached; if another thread
+//   is decoding the file already, wait for its result
+// returns null if the file cannot be decoded
+ysfx_image_data_ptr ysfx_image_cache_acquire(ysfx_image_cache_t *cache, const char *path, ysfx_image_decoder_t *decode);
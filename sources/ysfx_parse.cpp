@@ -378,3 +378,86 @@ bool ysfx_parse_filename(const char *line, ysfx_parsed_filename_t &filename)
     filename.filename.assign(cur);
     return true;
 }
+
+void ysfx_scan_code(const std::string &text, ysfx_code_scan_t &scan)
+{
+    scan = ysfx_code_scan_t{};
+
+    auto is_ident_start = [](char c) -> bool {
+        return ysfx::ascii_isalpha(c) || c == '_';
+    };
+    auto is_ident_char = [](char c) -> bool {
+        return ysfx::ascii_isalpha(c) || (c >= '0' && c <= '9') || c == '_' || c == '.';
+    };
+
+    const char *cur = text.c_str();
+    const char *end = cur + text.size();
+    bool after_function = false;
+
+    while (cur != end) {
+        char c = *cur;
+
+        // comments
+        if (c == '/' && cur + 1 != end && cur[1] == '/') {
+            while (cur != end && *cur != '\n')
+                ++cur;
+            continue;
+        }
+        if (c == '/' && cur + 1 != end && cur[1] == '*') {
+            const char *close = strstr(cur + 2, "*/");
+            cur = close ? (close + 2) : end;
+            continue;
+        }
+
+        // strings and character constants
+        if (c == '"' || c == '\'') {
+            for (++cur; cur != end && *cur != c; ++cur) {
+                if (*cur == '\\' && cur + 1 != end)
+                    ++cur;
+            }
+            cur += (cur != end);
+            continue;
+        }
+
+        // numbers, named constants, string variables
+        if ((c >= '0' && c <= '9') || c == '$' || c == '#' ||
+            (c == '.' && cur + 1 != end && cur[1] >= '0' && cur[1] <= '9'))
+        {
+            for (++cur; cur != end && is_ident_char(*cur); ++cur);
+            after_function = false;
+            continue;
+        }
+
+        if (c == '[')
+            scan.has_indexing = true;
+
+        if (!is_ident_start(c)) {
+            after_function = after_function && ysfx::ascii_isspace(c);
+            ++cur;
+            continue;
+        }
+
+        ysfx_code_ident_t ident;
+        for (; cur != end && is_ident_char(*cur); ++cur)
+            ident.name.push_back(ysfx::ascii_tolower(*cur));
+
+        const char *next = cur;
+        while (next != end && ysfx::ascii_isspace(*next))
+            ++next;
+        char c1 = (next != end) ? next[0] : '\0';
+        char c2 = (next != end && next + 1 != end) ? next[1] : '\0';
+
+        if (after_function)
+            ident.is_definition = true;
+        else if (c1 == '(')
+            ident.is_call = true;
+        else if (c1 == '=')
+            ident.is_assigned = c2 != '=';
+        else if (c1 != '\0' && c2 == '=' && strchr("+-*/%|&^~", c1))
+            ident.is_assigned = true;
+
+        after_function = ident.name == "function";
+        if (!after_function)
+            scan.idents.push_back(std::move(ident));
+    }
+}
@@ -95,7 +95,28 @@ struct ysfx_parsed_filename_t {
     std::string filename;
 };
 
+// a use of an identifier in the code of a section
+struct ysfx_code_ident_t {
+    // the name in lowercase
+    std::string name;
+    // whether it is a function which is called
+    bool is_call = false;
+    // whether it is a variable which is assigned
+    bool is_assigned = false;
+    // whether it is a function which is defined
+    bool is_definition = false;
+};
+
+// the identifiers which are used by the code of a section, not interpreting
+//   the code beyond; the string variables and the constants are excluded
+struct ysfx_code_scan_t {
+    std::vector<ysfx_code_ident_t> idents;
+    // whether the code accesses the memory by the index operator
+    bool has_indexing = false;
+};
+
 bool ysfx_parse_toplevel(ysfx::text_reader &reader, ysfx_toplevel_t &toplevel, ysfx_parse_error *error);
 bool ysfx_parse_slider(const char *line, ysfx_slider_t &slider);
 bool ysfx_parse_filename(const char *line, ysfx_parsed_filename_t &filename);
 void ysfx_parse_header(ysfx_section_t *section, ysfx_header_t &header);
+void ysfx_scan_code(const std::string &text, ysfx_code_scan_t &scan);
@@ -19,41 +19,62 @@
 #include "ysfx_preset.hpp"
 #include "ysfx_utils.hpp"
 #include <vector>
+#include <list>
+#include <unordered_set>
 #include <string>
 #include <cstring>
 
 #include "WDL/lineparse.h"
 
-static void ysfx_preset_clear(ysfx_preset_t *preset);
-static ysfx_bank_t *ysfx_load_bank_from_rpl_text(const std::string &text);
-static void ysfx_parse_preset_from_rpl_blob(ysfx_preset_t *preset, const char *name, const std::vector<uint8_t> &data);
-
-ysfx_bank_t *ysfx_load_bank(const char *path)
+// the bank, along with what is needed to decode the presets on demand
+struct ysfx_bank_index_t : ysfx_bank_t {
+    // the text of the RPL, and the range of base64 lines of each preset
+    std::string text;
+    std::vector<std::pair<size_t, size_t>> ranges;
+    // the presets which were most recently decoded
+    ysfx::mutex mutex;
+    std::list<std::pair<uint32_t, ysfx_state_u>> decoded;
+};
+
+static constexpr size_t ysfx_bank_max_decoded = 8;
+
+// the banks which were loaded lazily, and which are really of the type above;
+//   the others may have been made by the application, using the public type
+struct ysfx_lazy_bank_set_t {
+    ysfx::mutex mutex;
+    std::unordered_set<const ysfx_bank_t *> banks;
+};
+
+static ysfx_lazy_bank_set_t &ysfx_lazy_banks()
 {
-#if defined(_WIN32)
-    std::wstring wpath = ysfx::widen(path);
-    ysfx::FILE_u stream{_wfopen(wpath.c_str(), L"rb")};
-#else
-    ysfx::FILE_u stream{fopen(path, "rb")};
-#endif
+    // NOTE: never destroyed, banks may be freed during the static destruction
+    static ysfx_lazy_bank_set_t *set = new ysfx_lazy_bank_set_t;
+    return *set;
+}
 
-    if (!stream)
+static ysfx_bank_index_t *ysfx_bank_get_index(ysfx_bank_t *bank)
+{
+    ysfx_lazy_bank_set_t &set = ysfx_lazy_banks();
+    std::lock_guard<ysfx::mutex> lock{set.mutex};
+    if (set.banks.find(bank) == set.banks.end())
         return nullptr;
+    return static_cast<ysfx_bank_index_t *>(bank);
+}
 
-    std::string input;
-    constexpr uint32_t max_input = 1u << 24;
-    input.reserve(1u << 16);
-
-    for (int ch; input.size() < max_input && (ch = fgetc(stream.get())) != EOF; ) {
-        ch = (ch == '\r' || ch == '\n') ? ' ' : ch;
-        input.push_back((unsigned char)ch);
-    }
+static void ysfx_preset_clear(ysfx_preset_t *preset);
+static ysfx_bank_t *ysfx_load_bank_from_rpl_file(const char *path, bool lazy);
+static bool ysfx_rpl_next_token(const std::string &text, size_t &pos, size_t &begin, size_t &end);
+static ysfx_state_t *ysfx_parse_preset_from_rpl_range(const std::string &text, size_t begin, size_t end);
+static ysfx_state_t *ysfx_parse_preset_from_rpl_blob(const std::vector<uint8_t> &data);
 
-    if (ferror(stream.get()))
-        return nullptr;
+ysfx_bank_t *ysfx_load_bank(const char *path)
+{
+    return ysfx_load_bank_from_rpl_file(path, false);
+}
 
-    stream.reset();
-    return ysfx_load_bank_from_rpl_text(input);
+ysfx_bank_t *ysfx_load_bank_lazy(const char *path)
+{
+    return ysfx_load_bank_from_rpl_file(path, true);
 }
 
 void ysfx_bank_free(ysfx_bank_t *bank)
@@ -70,7 +91,49 @@ void ysfx_bank_free(ysfx_bank_t *bank)
         delete[] presets;
     }
 
-    delete bank;
+    ysfx_lazy_bank_set_t &set = ysfx_lazy_banks();
+    std::unique_lock<ysfx::mutex> lock{set.mutex};
+    if (set.banks.erase(bank) > 0) {
+        lock.unlock();
+        delete static_cast<ysfx_bank_index_t *>(bank);
+    }
+    else {
+        lock.unlock();
+        delete bank;
+    }
+}
+
+ysfx_state_t *ysfx_bank_get_preset_state(ysfx_bank_t *bank_, uint32_t index)
+{
+    if (index >= bank_->preset_count)
+        return nullptr;
+    if (ysfx_state_t *state = bank_->presets[index].state)
+        return ysfx_state_dup(state);
+
+    ysfx_bank_index_t *bank = ysfx_bank_get_index(bank_);
+    if (!bank)
+        return nullptr;
+
+    std::unique_lock<ysfx::mutex> lock{bank->mutex};
+    for (auto it = bank->decoded.begin(); it != bank->decoded.end(); ++it) {
+        if (it->first == index) {
+            bank->decoded.splice(bank->decoded.begin(), bank->decoded, it);
+            return ysfx_state_dup(it->second.get());
+        }
+    }
+    lock.unlock();
+
+    // decode outside the lock, the text of the bank is never modified
+    const std::pair<size_t, size_t> &range = bank->ranges[index];
+    ysfx_state_u state{ysfx_parse_preset_from_rpl_range(bank->text, range.first, range.second)};
+    ysfx_state_t *result = ysfx_state_dup(state.get());
+
+    lock.lock();
+    bank->decoded.emplace_front(index, std::move(state));
+    while (bank->decoded.size() > ysfx_bank_max_decoded)
+        bank->decoded.pop_back();
+
+    return result;
 }
 
 static void ysfx_preset_clear(ysfx_preset_t *preset)
@@ -82,12 +145,34 @@ static void ysfx_preset_clear(ysfx_preset_t *preset)
     preset->state = nullptr;
 }
 
-static ysfx_bank_t *ysfx_load_bank_from_rpl_text(const std::string &text)
+static ysfx_bank_t *ysfx_load_bank_from_rpl_file(const char *path, bool lazy)
 {
-    LineParser parser;
-    if (parser.parse(text.c_str()) < 0)
+    ysfx::FILE_u stream{ysfx::fopen_utf8(path, "rb")};
+    if (!stream)
         return nullptr;
 
+    // read the entire file at once, up to a limit
+    constexpr uint32_t max_input = 1u << 24;
+    int64_t file_size = -1;
+    if (ysfx::fseek_lfs(stream.get(), 0, SEEK_END) == 0) {
+        file_size = ysfx::ftell_lfs(stream.get());
+        ysfx::fseek_lfs(stream.get(), 0, SEEK_SET);
+    }
+    if (file_size < 0)
+        return nullptr;
+
+    std::string text;
+    text.resize((file_size < max_input) ? (size_t)file_size : max_input);
+    if (!text.empty())
+        text.resize(fread(&text[0], 1, text.size(), stream.get()));
+
+    if (ferror(stream.get()))
+        return nullptr;
+    stream.reset();
+
+    // like the parser of the line, stop at the first null character
+    text.resize(strnlen(text.data(), text.size()));
+
     ///
     std::vector<ysfx_preset_t> preset_list;
     preset_list.reserve(256);
@@ -97,39 +182,67 @@ static ysfx_bank_t *ysfx_load_bank_from_rpl_text(const std::string &text)
             ysfx_preset_clear(&pst);
     });
 
+    std::vector<std::pair<size_t, size_t>> ranges;
+    ranges.reserve(256);
+
     ///
-    int ntok = parser.getnumtokens();
-    int itok = 0;
+    size_t pos = 0;
+    size_t begin, end;
 
-    if (strcmp("<REAPER_PRESET_LIBRARY", parser.gettoken_str(itok++)) != 0)
+    if (!ysfx_rpl_next_token(text, pos, begin, end) ||
+        text.compare(begin, end - begin, "<REAPER_PRESET_LIBRARY") != 0)
         return nullptr;
 
-    const char *bank_name = parser.gettoken_str(itok++);
-
-    while (itok < ntok) {
-        if (strcmp("<PRESET", parser.gettoken_str(itok++)) == 0) {
-            const char *preset_name = parser.gettoken_str(itok++);
-
-            std::vector<uint8_t> blob;
-            blob.reserve(64 * 1024);
-
-            for (const char *part; itok < ntok &&
-                     strcmp(">", (part = parser.gettoken_str(itok++))) != 0; )
-            {
-                std::vector<uint8_t> blobChunk = ysfx::decode_base64(part);
-                blob.insert(blob.end(), blobChunk.begin(), blobChunk.end());
+    std::string bank_name;
+    if (ysfx_rpl_next_token(text, pos, begin, end))
+        bank_name.assign(&text[begin], end - begin);
+
+    while (ysfx_rpl_next_token(text, pos, begin, end)) {
+        if (text.compare(begin, end - begin, "<PRESET") == 0) {
+            std::string preset_name;
+            if (ysfx_rpl_next_token(text, pos, begin, end))
+                preset_name.assign(&text[begin], end - begin);
+
+            // the lines of the preset extend up to the closing token
+            size_t range_begin = pos;
+            size_t range_end = pos;
+            while (ysfx_rpl_next_token(text, pos, begin, end)) {
+                range_end = pos;
+                if (text.compare(begin, end - begin, ">") == 0) {
+                    range_end = begin;
+                    break;
+                }
             }
 
             preset_list.emplace_back();
             ysfx_preset_t &preset = preset_list.back();
-
-            ysfx_parse_preset_from_rpl_blob(&preset, preset_name, blob);
+            preset.name = ysfx::strdup_using_new(preset_name.c_str());
+            if (!lazy)
+                preset.state = ysfx_parse_preset_from_rpl_range(text, range_begin, range_end);
+            ranges.emplace_back(range_begin, range_end);
         }
     }
 
+    // the parser of the line fails on an unterminated quote
+    if (pos == std::string::npos)
+        return nullptr;
+
     ///
-    ysfx_bank_u bank{new ysfx_bank_t{}};
-    bank->name = ysfx::strdup_using_new(bank_name);
+    std::unique_ptr<ysfx_bank_index_t> index;
+    std::unique_ptr<ysfx_bank_t> plain;
+    ysfx_bank_t *bank;
+    if (lazy) {
+        index.reset(new ysfx_bank_index_t{});
+        index->text = std::move(text);
+        index->ranges = std::move(ranges);
+        bank = index.get();
+    }
+    else {
+        plain.reset(new ysfx_bank_t{});
+        bank = plain.get();
+    }
+
+    bank->name = ysfx::strdup_using_new(bank_name.c_str());
     bank->presets = new ysfx_preset_t[(uint32_t)preset_list.size()]{};
     bank->preset_count = (uint32_t)preset_list.size();
 
@@ -138,10 +251,69 @@ static ysfx_bank_t *ysfx_load_bank_from_rpl_text(const std::string &text)
         preset_list.pop_back();
     }
 
-    return bank.release();
+    if (!lazy)
+        return plain.release();
+
+    ysfx_lazy_bank_set_t &set = ysfx_lazy_banks();
+    std::lock_guard<ysfx::mutex> lock{set.mutex};
+    set.banks.insert(bank);
+    return index.release();
+}
+
+// extract the next token, according to the rules of `LineParser`, accepting
+//   line endings as white space; on an unterminated quote, `pos` becomes `npos`
+static bool ysfx_rpl_next_token(const std::string &text, size_t &pos, size_t &begin, size_t &end)
+{
+    auto is_space = [](char c) -> bool {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    };
+
+    size_t size = text.size();
+    if (pos >= size)
+        return false;
+
+    while (pos < size && is_space(text[pos]))
+        ++pos;
+    if (pos == size)
+        return false;
+
+    char quote = text[pos];
+    if (quote == '"' || quote == '\'' || quote == '`') {
+        begin = pos + 1;
+        end = text.find(quote, begin);
+        if (end == std::string::npos) {
+            pos = std::string::npos;
+            return false;
+        }
+        pos = end + 1;
+    }
+    else {
+        begin = pos;
+        while (pos < size && !is_space(text[pos]))
+            ++pos;
+        end = pos;
+    }
+
+    return true;
+}
+
+static ysfx_state_t *ysfx_parse_preset_from_rpl_range(const std::string &text, size_t begin, size_t end)
+{
+    std::vector<uint8_t> blob;
+    blob.reserve((end - begin) / 4 * 3);
+
+    // each line is base64-encoded on its own
+    size_t pos = begin;
+    size_t token_begin, token_end;
+    while (pos < end && ysfx_rpl_next_token(text, pos, token_begin, token_end)) {
+        std::vector<uint8_t> chunk = ysfx::decode_base64(&text[token_begin], token_end - token_begin);
+        blob.insert(blob.end(), chunk.begin(), chunk.end());
+    }
+
+    return ysfx_parse_preset_from_rpl_blob(blob);
 }
 
-static void ysfx_parse_preset_from_rpl_blob(ysfx_preset_t *preset, const char *name, const std::vector<uint8_t> &data)
+static ysfx_state_t *ysfx_parse_preset_from_rpl_blob(const std::vector<uint8_t> &data)
 {
     ysfx_state_t state{};
     std::vector<ysfx_state_slider_t> sliders;
@@ -188,6 +360,5 @@ static void ysfx_parse_preset_from_rpl_blob(ysfx_preset_t *preset, const char *n
         state.slider_count = (uint32_t)sliders.size();
     }
 
-    preset->name = ysfx::strdup_using_new(name);
-    preset->state = ysfx_state_dup(&state);
+    return ysfx_state_dup(&state);
 }
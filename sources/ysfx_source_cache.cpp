@@ -0,0 +1,196 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ysfx_source_cache.hpp"
+#include "ysfx_reader.hpp"
+#include <mutex>
+
+static void ysfx_source_cache_trim(ysfx_source_cache_t &cache, uint64_t budget);
+static void ysfx_source_cache_erase(ysfx_source_cache_t &cache, std::list<ysfx_source_cache_t::entry_t>::iterator pos);
+static uint64_t ysfx_source_unit_size(const ysfx_source_unit_t &unit);
+
+ysfx_source_cache_t *ysfx_source_cache_new()
+{
+    return new ysfx_source_cache_t;
+}
+
+void ysfx_source_cache_free(ysfx_source_cache_t *cache)
+{
+    if (!cache)
+        return;
+
+    if (cache->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        delete cache;
+}
+
+void ysfx_source_cache_add_ref(ysfx_source_cache_t *cache)
+{
+    cache->ref_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ysfx_source_cache_set_budget(ysfx_source_cache_t *cache, uint64_t max_bytes)
+{
+    std::lock_guard<ysfx::mutex> lock{cache->mutex};
+    cache->budget = max_bytes;
+    ysfx_source_cache_trim(*cache, max_bytes);
+}
+
+uint64_t ysfx_source_cache_get_size(ysfx_source_cache_t *cache)
+{
+    std::lock_guard<ysfx::mutex> lock{cache->mutex};
+    return cache->size;
+}
+
+uint32_t ysfx_source_cache_get_count(ysfx_source_cache_t *cache)
+{
+    std::lock_guard<ysfx::mutex> lock{cache->mutex};
+    return (uint32_t)cache->lru.size();
+}
+
+void ysfx_source_cache_clear(ysfx_source_cache_t *cache)
+{
+    std::lock_guard<ysfx::mutex> lock{cache->mutex};
+    cache->lru.clear();
+    cache->index.clear();
+    cache->size = 0;
+}
+
+//------------------------------------------------------------------------------
+static void ysfx_source_cache_trim(ysfx_source_cache_t &cache, uint64_t budget)
+{
+    // NOTE: the pending entries may go too, their requesters hold the result
+    while (cache.size > budget && !cache.lru.empty())
+        ysfx_source_cache_erase(cache, std::prev(cache.lru.end()));
+}
+
+static void ysfx_source_cache_erase(ysfx_source_cache_t &cache, std::list<ysfx_source_cache_t::entry_t>::iterator pos)
+{
+    cache.size -= pos->size;
+    cache.index.erase(pos->path);
+    cache.lru.erase(pos);
+}
+
+static uint64_t ysfx_source_unit_size(const ysfx_source_unit_t &unit)
+{
+    const ysfx_toplevel_t &toplevel = unit.toplevel;
+    uint64_t size = sizeof(ysfx_source_unit_t);
+    for (const ysfx_section_t *section : {toplevel.header.get(), toplevel.init.get(), toplevel.slider.get(),
+            toplevel.block.get(), toplevel.sample.get(), toplevel.serialize.get(), toplevel.gfx.get()}) {
+        if (section)
+            size += sizeof(ysfx_section_t) + section->text.size();
+    }
+    return size;
+}
+
+ysfx_source_result_t ysfx_source_parse(const char *path)
+{
+    ysfx_source_result_t result;
+
+    ysfx::FILE_u stream{ysfx::fopen_utf8(path, "rb")};
+    if (!stream)
+        return result;
+
+    ysfx_source_unit_u unit{new ysfx_source_unit_t};
+    ysfx::stdio_text_reader reader(stream.get());
+
+    if (!ysfx_parse_toplevel(reader, unit->toplevel, &result.error))
+        return result;
+    ysfx_parse_header(unit->toplevel.header.get(), unit->header);
+
+    result.unit = std::move(unit);
+    return result;
+}
+
+ysfx_source_result_t ysfx_source_cache_acquire(ysfx_source_cache_t *cache, const char *path, const ysfx::file_stamp &stamp)
+{
+    const std::string key{path};
+    std::promise<ysfx_source_result_t> promise;
+
+    {
+        std::unique_lock<ysfx::mutex> lock{cache->mutex};
+        auto it = cache->index.find(key);
+        if (it != cache->index.end()) {
+            auto pos = it->second;
+            if (pos->stamp == stamp) {
+                cache->lru.splice(cache->lru.begin(), cache->lru, pos);
+                std::shared_future<ysfx_source_result_t> result = pos->result;
+                lock.unlock();
+                return result.get();
+            }
+            // the file has changed since it was cached: discard the old contents
+            ysfx_source_cache_erase(*cache, pos);
+        }
+        // register the parse in progress, for other requesters to wait on it
+        ysfx_source_cache_t::entry_t entry;
+        entry.path = key;
+        entry.stamp = stamp;
+        entry.result = promise.get_future().share();
+        cache->lru.push_front(std::move(entry));
+        cache->index[key] = cache->lru.begin();
+    }
+
+    ysfx_source_result_t result = ysfx_source_parse(path);
+    promise.set_value(result);
+
+    std::lock_guard<ysfx::mutex> lock{cache->mutex};
+    auto it = cache->index.find(key);
+    // the entry was evicted or replaced meanwhile
+    if (it == cache->index.end() || !(it->second->stamp == stamp) || it->second->size != 0)
+        return result;
+
+    // do not retain the failures, the file may get fixed without changing
+    //   its stamp, as in the case of a missing file which gets created;
+    //   neither retain what is too large to fit along with the rest
+    uint64_t size = result.unit ? ysfx_source_unit_size(*result.unit) : 0;
+    if (!result.unit || size > cache->budget) {
+        ysfx_source_cache_erase(*cache, it->second);
+        return result;
+    }
+
+    ysfx_source_cache_t::entry_t &entry = *it->second;
+    entry.size = size;
+    cache->size += size;
+    // keep this entry out of the eviction, it is no larger than the budget
+    cache->lru.splice(cache->lru.begin(), cache->lru, it->second);
+    ysfx_source_cache_trim(*cache, cache->budget);
+
+    return result;
+}
+
+//------------------------------------------------------------------------------
+static ysfx_section_u ysfx_section_clone(const ysfx_section_u &section)
+{
+    return section ? ysfx_section_u{new ysfx_section_t(*section)} : nullptr;
+}
+
+ysfx_source_unit_u ysfx_source_unit_clone(const ysfx_source_unit_t &unit)
+{
+    ysfx_source_unit_u copy{new ysfx_source_unit_t};
+    const ysfx_toplevel_t &src = unit.toplevel;
+    ysfx_toplevel_t &dst = copy->toplevel;
+    dst.header = ysfx_section_clone(src.header);
+    dst.init = ysfx_section_clone(src.init);
+    dst.slider = ysfx_section_clone(src.slider);
+    dst.block = ysfx_section_clone(src.block);
+    dst.sample = ysfx_section_clone(src.sample);
+    dst.serialize = ysfx_section_clone(src.serialize);
+    dst.gfx = ysfx_section_clone(src.gfx);
+    dst.gfx_w = src.gfx_w;
+    dst.gfx_h = src.gfx_h;
+    copy->header = unit.header;
+    return copy;
+}
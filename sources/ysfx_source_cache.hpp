@@ -0,0 +1,69 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+#include "ysfx.h"
+#include "ysfx_parse.hpp"
+#include "ysfx_utils.hpp"
+#include <unordered_map>
+#include <list>
+#include <string>
+#include <memory>
+#include <future>
+#include <atomic>
+
+struct ysfx_source_unit_t {
+    ysfx_toplevel_t toplevel;
+    ysfx_header_t header;
+};
+using ysfx_source_unit_u = std::unique_ptr<ysfx_source_unit_t>;
+
+// a parsed source file, which is immutable once cached
+using ysfx_source_unit_ptr = std::shared_ptr<const ysfx_source_unit_t>;
+
+struct ysfx_source_result_t {
+    ysfx_source_unit_ptr unit;
+    ysfx_parse_error error;
+};
+
+struct ysfx_source_cache_s {
+    struct entry_t {
+        std::string path;
+        ysfx::file_stamp stamp;
+        // the result, which is pending while the first requester parses the file
+        std::shared_future<ysfx_source_result_t> result;
+        // the size of the result, which is zero while it is pending
+        uint64_t size = 0;
+    };
+
+    ysfx::mutex mutex;
+    // the entries, ordered from the most recently used to the least
+    std::list<entry_t> lru;
+    std::unordered_map<std::string, std::list<entry_t>::iterator> index;
+    uint64_t budget = 32 << 20;
+    uint64_t size = 0;
+    std::atomic<uint32_t> ref_count{1};
+};
+
+// parse a source file, and its header
+// returns null, and an empty error message, if the file cannot be opened
+ysfx_source_result_t ysfx_source_parse(const char *path);
+// get the parsed contents of a source file, parsing it if it is not in cache or if it has changed
+//   on disk since it was cached; if another thread is parsing the file already, wait for its result
+ysfx_source_result_t ysfx_source_cache_acquire(ysfx_source_cache_t *cache, const char *path, const ysfx::file_stamp &stamp);
+// make a modifiable copy of a parsed source file
+ysfx_source_unit_u ysfx_source_unit_clone(const ysfx_source_unit_t &unit);
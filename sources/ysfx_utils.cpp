@@ -26,6 +26,7 @@
 #if !defined(_WIN32)
 #   include <sys/stat.h>
 #   include <sys/types.h>
+#   include <sys/mman.h>
 #   include <unistd.h>
 #   include <dirent.h>
 #   include <fcntl.h>
@@ -181,6 +182,8 @@ double c_strtod(const char *text, char **endp, c_locale_t loc)
 {
 #if defined(_WIN32)
     return _strtod_l(text, endp, loc);
+#elif defined(__GLIBC__) || defined(__APPLE__)
+    return strtod_l(text, endp, loc);
 #else
     scoped_posix_uselocale use(loc);
     return strtod(text, endp);
@@ -197,6 +200,329 @@ double dot_strtod(const char *text, char **endp)
     return c_strtod(text, endp, c_numeric_locale());
 }
 
+namespace {
+
+// the powers of five from 5^-64 to 5^64, normalized and truncated to 128 bits
+enum { pow5_min = -64, pow5_max = 64 };
+const uint64_t pow5_128[] = {
+        0xa87fea27a539e9a5, 0x3f2398d747b36224,
+        0xd29fe4b18e88640e, 0x8eec7f0d19a03aad,
+        0x83a3eeeef9153e89, 0x1953cf68300424ac,
+        0xa48ceaaab75a8e2b, 0x5fa8c3423c052dd7,
+        0xcdb02555653131b6, 0x3792f412cb06794d,
+        0x808e17555f3ebf11, 0xe2bbd88bbee40bd0,
+        0xa0b19d2ab70e6ed6, 0x5b6aceaeae9d0ec4,
+        0xc8de047564d20a8b, 0xf245825a5a445275,
+        0xfb158592be068d2e, 0xeed6e2f0f0d56712,
+        0x9ced737bb6c4183d, 0x55464dd69685606b,
+        0xc428d05aa4751e4c, 0xaa97e14c3c26b886,
+        0xf53304714d9265df, 0xd53dd99f4b3066a8,
+        0x993fe2c6d07b7fab, 0xe546a8038efe4029,
+        0xbf8fdb78849a5f96, 0xde98520472bdd033,
+        0xef73d256a5c0f77c, 0x963e66858f6d4440,
+        0x95a8637627989aad, 0xdde7001379a44aa8,
+        0xbb127c53b17ec159, 0x5560c018580d5d52,
+        0xe9d71b689dde71af, 0xaab8f01e6e10b4a6,
+        0x9226712162ab070d, 0xcab3961304ca70e8,
+        0xb6b00d69bb55c8d1, 0x3d607b97c5fd0d22,
+        0xe45c10c42a2b3b05, 0x8cb89a7db77c506a,
+        0x8eb98a7a9a5b04e3, 0x77f3608e92adb242,
+        0xb267ed1940f1c61c, 0x55f038b237591ed3,
+        0xdf01e85f912e37a3, 0x6b6c46dec52f6688,
+        0x8b61313bbabce2c6, 0x2323ac4b3b3da015,
+        0xae397d8aa96c1b77, 0xabec975e0a0d081a,
+        0xd9c7dced53c72255, 0x96e7bd358c904a21,
+        0x881cea14545c7575, 0x7e50d64177da2e54,
+        0xaa242499697392d2, 0xdde50bd1d5d0b9e9,
+        0xd4ad2dbfc3d07787, 0x955e4ec64b44e864,
+        0x84ec3c97da624ab4, 0xbd5af13bef0b113e,
+        0xa6274bbdd0fadd61, 0xecb1ad8aeacdd58e,
+        0xcfb11ead453994ba, 0x67de18eda5814af2,
+        0x81ceb32c4b43fcf4, 0x80eacf948770ced7,
+        0xa2425ff75e14fc31, 0xa1258379a94d028d,
+        0xcad2f7f5359a3b3e, 0x096ee45813a04330,
+        0xfd87b5f28300ca0d, 0x8bca9d6e188853fc,
+        0x9e74d1b791e07e48, 0x775ea264cf55347e,
+        0xc612062576589dda, 0x95364afe032a819e,
+        0xf79687aed3eec551, 0x3a83ddbd83f52205,
+        0x9abe14cd44753b52, 0xc4926a9672793543,
+        0xc16d9a0095928a27, 0x75b7053c0f178294,
+        0xf1c90080baf72cb1, 0x5324c68b12dd6339,
+        0x971da05074da7bee, 0xd3f6fc16ebca5e04,
+        0xbce5086492111aea, 0x88f4bb1ca6bcf585,
+        0xec1e4a7db69561a5, 0x2b31e9e3d06c32e6,
+        0x9392ee8e921d5d07, 0x3aff322e62439fd0,
+        0xb877aa3236a4b449, 0x09befeb9fad487c3,
+        0xe69594bec44de15b, 0x4c2ebe687989a9b4,
+        0x901d7cf73ab0acd9, 0x0f9d37014bf60a11,
+        0xb424dc35095cd80f, 0x538484c19ef38c95,
+        0xe12e13424bb40e13, 0x2865a5f206b06fba,
+        0x8cbccc096f5088cb, 0xf93f87b7442e45d4,
+        0xafebff0bcb24aafe, 0xf78f69a51539d749,
+        0xdbe6fecebdedd5be, 0xb573440e5a884d1c,
+        0x89705f4136b4a597, 0x31680a88f8953031,
+        0xabcc77118461cefc, 0xfdc20d2b36ba7c3e,
+        0xd6bf94d5e57a42bc, 0x3d32907604691b4d,
+        0x8637bd05af6c69b5, 0xa63f9a49c2c1b110,
+        0xa7c5ac471b478423, 0x0fcf80dc33721d54,
+        0xd1b71758e219652b, 0xd3c36113404ea4a9,
+        0x83126e978d4fdf3b, 0x645a1cac083126ea,
+        0xa3d70a3d70a3d70a, 0x3d70a3d70a3d70a4,
+        0xcccccccccccccccc, 0xcccccccccccccccd,
+        0x8000000000000000, 0x0000000000000000,
+        0xa000000000000000, 0x0000000000000000,
+        0xc800000000000000, 0x0000000000000000,
+        0xfa00000000000000, 0x0000000000000000,
+        0x9c40000000000000, 0x0000000000000000,
+        0xc350000000000000, 0x0000000000000000,
+        0xf424000000000000, 0x0000000000000000,
+        0x9896800000000000, 0x0000000000000000,
+        0xbebc200000000000, 0x0000000000000000,
+        0xee6b280000000000, 0x0000000000000000,
+        0x9502f90000000000, 0x0000000000000000,
+        0xba43b74000000000, 0x0000000000000000,
+        0xe8d4a51000000000, 0x0000000000000000,
+        0x9184e72a00000000, 0x0000000000000000,
+        0xb5e620f480000000, 0x0000000000000000,
+        0xe35fa931a0000000, 0x0000000000000000,
+        0x8e1bc9bf04000000, 0x0000000000000000,
+        0xb1a2bc2ec5000000, 0x0000000000000000,
+        0xde0b6b3a76400000, 0x0000000000000000,
+        0x8ac7230489e80000, 0x0000000000000000,
+        0xad78ebc5ac620000, 0x0000000000000000,
+        0xd8d726b7177a8000, 0x0000000000000000,
+        0x878678326eac9000, 0x0000000000000000,
+        0xa968163f0a57b400, 0x0000000000000000,
+        0xd3c21bcecceda100, 0x0000000000000000,
+        0x84595161401484a0, 0x0000000000000000,
+        0xa56fa5b99019a5c8, 0x0000000000000000,
+        0xcecb8f27f4200f3a, 0x0000000000000000,
+        0x813f3978f8940984, 0x4000000000000000,
+        0xa18f07d736b90be5, 0x5000000000000000,
+        0xc9f2c9cd04674ede, 0xa400000000000000,
+        0xfc6f7c4045812296, 0x4d00000000000000,
+        0x9dc5ada82b70b59d, 0xf020000000000000,
+        0xc5371912364ce305, 0x6c28000000000000,
+        0xf684df56c3e01bc6, 0xc732000000000000,
+        0x9a130b963a6c115c, 0x3c7f400000000000,
+        0xc097ce7bc90715b3, 0x4b9f100000000000,
+        0xf0bdc21abb48db20, 0x1e86d40000000000,
+        0x96769950b50d88f4, 0x1314448000000000,
+        0xbc143fa4e250eb31, 0x17d955a000000000,
+        0xeb194f8e1ae525fd, 0x5dcfab0800000000,
+        0x92efd1b8d0cf37be, 0x5aa1cae500000000,
+        0xb7abc627050305ad, 0xf14a3d9e40000000,
+        0xe596b7b0c643c719, 0x6d9ccd05d0000000,
+        0x8f7e32ce7bea5c6f, 0xe4820023a2000000,
+        0xb35dbf821ae4f38b, 0xdda2802c8a800000,
+        0xe0352f62a19e306e, 0xd50b2037ad200000,
+        0x8c213d9da502de45, 0x4526f422cc340000,
+        0xaf298d050e4395d6, 0x9670b12b7f410000,
+        0xdaf3f04651d47b4c, 0x3c0cdd765f114000,
+        0x88d8762bf324cd0f, 0xa5880a69fb6ac800,
+        0xab0e93b6efee0053, 0x8eea0d047a457a00,
+        0xd5d238a4abe98068, 0x72a4904598d6d880,
+        0x85a36366eb71f041, 0x47a6da2b7f864750,
+        0xa70c3c40a64e6c51, 0x999090b65f67d924,
+        0xd0cf4b50cfe20765, 0xfff4b4e3f741cf6d,
+        0x82818f1281ed449f, 0xbff8f10e7a8921a4,
+        0xa321f2d7226895c7, 0xaff72d52192b6a0d,
+        0xcbea6f8ceb02bb39, 0x9bf4f8a69f764490,
+        0xfee50b7025c36a08, 0x02f236d04753d5b4,
+        0x9f4f2726179a2245, 0x01d762422c946590,
+        0xc722f0ef9d80aad6, 0x424d3ad2b7b97ef5,
+        0xf8ebad2b84e0d58b, 0xd2e0898765a7deb2,
+        0x9b934c3b330c8577, 0x63cc55f49f88eb2f,
+        0xc2781f49ffcfa6d5, 0x3cbf6b71c76b25fb,
+};
+
+void mul_64x64(uint64_t a, uint64_t b, uint64_t &hi, uint64_t &lo)
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 r = (unsigned __int128)a * b;
+    hi = (uint64_t)(r >> 64);
+    lo = (uint64_t)r;
+#else
+    uint64_t al = a & 0xffffffff, ah = a >> 32;
+    uint64_t bl = b & 0xffffffff, bh = b >> 32;
+    uint64_t ll = al * bl, lh = al * bh, hl = ah * bl, hh = ah * bh;
+    uint64_t mid = (ll >> 32) + (lh & 0xffffffff) + (hl & 0xffffffff);
+    lo = (mid << 32) | (ll & 0xffffffff);
+    hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+}
+
+int count_leading_zeros(uint64_t x)
+{
+    int n = 0;
+    for (; !(x & ((uint64_t)1 << 63)); x <<= 1)
+        ++n;
+    return n;
+}
+
+// convert w*10^q, w being nonzero, to the nearest double with the algorithm of
+//   Eisel-Lemire; returns false if it cannot decide, or the result is not normal
+bool eisel_lemire(uint64_t w, int64_t q, double &value)
+{
+    if (q < pow5_min || q > pow5_max)
+        return false;
+
+    int lz = count_leading_zeros(w);
+    w <<= lz;
+
+    size_t index = 2 * (size_t)(q - pow5_min);
+    uint64_t hi, lo;
+    mul_64x64(w, pow5_128[index], hi, lo);
+    if ((hi & 0x1ff) == 0x1ff) {
+        uint64_t hi2, lo2;
+        mul_64x64(w, pow5_128[index + 1], hi2, lo2);
+        lo += hi2;
+        hi += hi2 > lo;
+        if (lo == ~(uint64_t)0 && (q < -27 || q > 55))
+            return false;
+    }
+
+    int upperbit = (int)(hi >> 63);
+    uint64_t mantissa = hi >> (upperbit + 9);
+    int64_t power2 = ((((152170 + 65536) * q) >> 16) + 63) + upperbit - lz + 1023;
+    if (power2 <= 0)
+        return false;
+
+    // exactly halfway: round to even
+    if (lo <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << (upperbit + 9)) == hi)
+        mantissa &= ~(uint64_t)1;
+
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >= ((uint64_t)2 << 52)) {
+        mantissa = (uint64_t)1 << 52;
+        ++power2;
+    }
+    mantissa &= ~((uint64_t)1 << 52);
+    if (power2 >= 0x7ff)
+        return false;
+
+    uint64_t bits = mantissa | ((uint64_t)power2 << 52);
+    memcpy(&value, &bits, sizeof(value));
+    return true;
+}
+
+} // namespace
+
+const char *dot_parse_number(const char *first, const char *last, double &value)
+{
+    // powers of ten which are exact in double precision
+    static const double exact_pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+
+    const char *p = first;
+    while (p != last && ascii_isspace(*p))
+        ++p;
+
+    const char *start = p;
+    bool neg = false;
+    if (p != last && (*p == '+' || *p == '-'))
+        neg = *p++ == '-';
+
+    // special values and hexadecimal go the slow way
+    bool slow = p != last && (*p == 'i' || *p == 'I' || *p == 'n' || *p == 'N' ||
+        (*p == '0' && last - p > 1 && (p[1] == 'x' || p[1] == 'X')));
+
+    uint64_t mant = 0;
+    uint32_t ndigits = 0;
+    int64_t exp10 = 0;
+    bool anydigit = false;
+
+    for (bool frac = false; !slow && p != last; ++p) {
+        if (*p == '.' && !frac) {
+            frac = true;
+            continue;
+        }
+        if (*p < '0' || *p > '9')
+            break;
+        anydigit = true;
+        uint32_t d = (uint32_t)(*p - '0');
+        if (mant == 0 && d == 0)
+            exp10 -= frac;
+        else if (ndigits < 19) {
+            mant = mant * 10 + d;
+            ++ndigits;
+            exp10 -= frac;
+        }
+        else {
+            // digits beyond the precision of the mantissa
+            exp10 += !frac;
+            slow = slow || d != 0;
+        }
+    }
+
+    if (!slow && !anydigit)
+        return first;
+
+    if (!slow && p != last && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        bool eneg = false;
+        if (q != last && (*q == '+' || *q == '-'))
+            eneg = *q++ == '-';
+        if (q != last && *q >= '0' && *q <= '9') {
+            int64_t e = 0;
+            for (; q != last && *q >= '0' && *q <= '9'; ++q)
+                e = (e < 100000) ? (e * 10 + (*q - '0')) : e;
+            exp10 += eneg ? -e : e;
+            p = q;
+        }
+    }
+
+    if (!slow) {
+        if (mant == 0) {
+            value = neg ? -0.0 : 0.0;
+            return p;
+        }
+        // the product of two exact values is correctly rounded
+        if (mant <= ((uint64_t)1 << 53) && exp10 >= -22 && exp10 <= 22) {
+            double x = (double)mant;
+            x = (exp10 < 0) ? (x / exact_pow10[-exp10]) : (x * exact_pow10[exp10]);
+            value = neg ? -x : x;
+            return p;
+        }
+        double x;
+        if (eisel_lemire(mant, exp10, x)) {
+            value = neg ? -x : x;
+            return p;
+        }
+    }
+
+    // otherwise, delegate to the C library on a terminated copy
+    //   which covers all the characters the number can possibly have
+    const char *end = start;
+    while (end != last && (ascii_isalpha(*end) || (*end >= '0' && *end <= '9') ||
+                           *end == '.' || *end == '+' || *end == '-'))
+        ++end;
+
+    char stackbuf[128];
+    std::string heapbuf;
+    size_t len = (size_t)(end - start);
+    char *buf = stackbuf;
+    if (len >= sizeof(stackbuf)) {
+        heapbuf.assign(start, len);
+        buf = &heapbuf[0];
+    }
+    else {
+        memcpy(buf, start, len);
+        buf[len] = '\0';
+    }
+
+    char *endp = buf;
+    double x = dot_strtod(buf, &endp);
+    if (endp == buf)
+        return first;
+
+    value = x;
+    return start + (endp - buf);
+}
+
 bool ascii_isspace(char c)
 {
     switch (c) {
@@ -315,6 +641,19 @@ void pack_f32le(float value, uint8_t data[4])
     pack_u32le(u, data);
 }
 
+void pack_u64le(uint64_t value, uint8_t data[8])
+{
+    pack_u32le((uint32_t)value, data);
+    pack_u32le((uint32_t)(value >> 32), data + 4);
+}
+
+void pack_f64le(double value, uint8_t data[8])
+{
+    uint64_t u;
+    memcpy(&u, &value, 8);
+    pack_u64le(u, data);
+}
+
 uint32_t unpack_u32le(const uint8_t data[4])
 {
     return data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24);
@@ -328,6 +667,19 @@ float unpack_f32le(const uint8_t data[4])
     return value;
 }
 
+uint64_t unpack_u64le(const uint8_t data[8])
+{
+    return unpack_u32le(data) | ((uint64_t)unpack_u32le(data + 4) << 32);
+}
+
+double unpack_f64le(const uint8_t data[8])
+{
+    double value;
+    uint64_t u = unpack_u64le(data);
+    memcpy(&value, &u, 8);
+    return value;
+}
+
 //------------------------------------------------------------------------------
 
 std::vector<uint8_t> decode_base64(const char *text, size_t len)
@@ -345,7 +697,7 @@ std::string encode_base64(const uint8_t *data, size_t len)
 bool get_file_uid(const char *path, file_uid &uid)
 {
 #ifdef _WIN32
-    HANDLE handle = CreateFileW(widen(path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    HANDLE handle = CreateFileW(widen(path).c_str(), GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
     if (handle == INVALID_HANDLE_VALUE)
         return false;
     bool success = get_handle_file_uid((void *)handle, uid);
@@ -404,6 +756,124 @@ bool get_handle_file_uid(void *handle, file_uid &uid)
 }
 #endif
 
+bool get_file_stamp(const char *path, file_stamp &stamp)
+{
+#ifdef _WIN32
+    HANDLE handle = CreateFileW(widen(path).c_str(), GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, 0, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+        return false;
+    BY_HANDLE_FILE_INFORMATION info;
+    bool success = GetFileInformationByHandle(handle, &info) != 0;
+    CloseHandle(handle);
+    if (!success)
+        return false;
+    stamp.uid.first = info.dwVolumeSerialNumber;
+    stamp.uid.second = (uint64_t)info.nFileIndexLow | ((uint64_t)info.nFileIndexHigh << 32);
+    stamp.mtime = (int64_t)((uint64_t)info.ftLastWriteTime.dwLowDateTime | ((uint64_t)info.ftLastWriteTime.dwHighDateTime << 32));
+    stamp.size = (uint64_t)info.nFileSizeLow | ((uint64_t)info.nFileSizeHigh << 32);
+    return true;
+#else
+    struct stat st;
+    if (stat(path, &st) != 0)
+        return false;
+    stamp.uid.first = (uint64_t)st.st_dev;
+    stamp.uid.second = (uint64_t)st.st_ino;
+#if defined(__APPLE__)
+    stamp.mtime = (int64_t)st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    stamp.mtime = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    stamp.size = (uint64_t)st.st_size;
+    return true;
+#endif
+}
+
+//------------------------------------------------------------------------------
+
+bool mapped_file::open(const char *path, uint64_t min_size)
+{
+    close();
+
+#if !defined(_WIN32)
+    int fd = ::open(path, O_RDONLY);
+    if (fd == -1)
+        return false;
+    auto fd_cleanup = defer([fd]() { ::close(fd); });
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0 || (uint64_t)st.st_size > SIZE_MAX)
+        return false;
+    if ((uint64_t)st.st_size < min_size)
+        return false;
+
+    void *data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+        return false;
+
+    // keep the descriptor, to check the size later
+    fd_cleanup.disarm();
+    m_fd = fd;
+    m_data = (const uint8_t *)data;
+    m_size = (uint64_t)st.st_size;
+#else
+    HANDLE file = CreateFileW(widen(path).c_str(), GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    auto file_cleanup = defer([file]() { CloseHandle(file); });
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0 || (uint64_t)size.QuadPart > SIZE_MAX)
+        return false;
+    if ((uint64_t)size.QuadPart < min_size)
+        return false;
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+        return false;
+    auto mapping_cleanup = defer([mapping]() { CloseHandle(mapping); });
+
+    void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data)
+        return false;
+
+    m_data = (const uint8_t *)data;
+    m_size = (uint64_t)size.QuadPart;
+#endif
+
+    m_map_size = m_size;
+    return true;
+}
+
+void mapped_file::close()
+{
+    if (!m_data)
+        return;
+
+#if !defined(_WIN32)
+    munmap((void *)m_data, (size_t)m_map_size);
+    ::close(m_fd);
+    m_fd = -1;
+#else
+    UnmapViewOfFile(m_data);
+#endif
+
+    m_data = nullptr;
+    m_size = 0;
+    m_map_size = 0;
+}
+
+uint64_t mapped_file::refresh()
+{
+#if !defined(_WIN32)
+    struct stat st;
+    if (m_data && fstat(m_fd, &st) == 0 && (uint64_t)st.st_size < m_size)
+        m_size = (st.st_size > 0) ? (uint64_t)st.st_size : 0;
+#else
+    // NOTE: Windows does not permit to truncate a file which is mapped
+#endif
+    return m_size;
+}
+
 //------------------------------------------------------------------------------
 
 bool is_path_separator(char ch)
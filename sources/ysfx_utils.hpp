@@ -86,6 +86,9 @@ double c_atof(const char *text, c_locale_t loc);
 double c_strtod(const char *text, char **endp, c_locale_t loc);
 double dot_atof(const char *text);
 double dot_strtod(const char *text, char **endp);
+// parse a number like `dot_strtod`, from a range which does not need a terminator;
+//   returns the end of the number, or `first` if there was none
+const char *dot_parse_number(const char *first, const char *last, double &value);
 bool ascii_isspace(char c);
 bool ascii_isalpha(char c);
 char ascii_tolower(char c);
@@ -101,8 +104,66 @@ std::string trim(const char *input, bool(*pred)(char));
 
 void pack_u32le(uint32_t value, uint8_t data[4]);
 void pack_f32le(float value, uint8_t data[4]);
+void pack_u64le(uint64_t value, uint8_t data[8]);
+void pack_f64le(double value, uint8_t data[8]);
 uint32_t unpack_u32le(const uint8_t data[4]);
 float unpack_f32le(const uint8_t data[4]);
+uint64_t unpack_u64le(const uint8_t data[8]);
+double unpack_f64le(const uint8_t data[8]);
+
+//------------------------------------------------------------------------------
+
+// convert floats to doubles; `src` may alias the start of `dst` to convert in place
+void widen_f32_to_f64(const float *src, double *dst, size_t count);
+// convert little-endian floats of arbitrary alignment to doubles
+void widen_f32le_to_f64(const uint8_t *src, double *dst, size_t count);
+// convert doubles to little-endian floats of arbitrary alignment
+void narrow_f64_to_f32le(const double *src, uint8_t *dst, size_t count);
+
+// arithmetic on arrays of doubles, with the best instruction set of the processor
+struct f64_kernels {
+    // dst[i] += src[i]
+    void (*add)(double *dst, const double *src, size_t count);
+    // dst[i] *= src[i]
+    void (*mul)(double *dst, const double *src, size_t count);
+    // dst[i] += src1[i] * src2[i]
+    void (*mac)(double *dst, const double *src1, const double *src2, size_t count);
+    // dst[i] *= gain
+    void (*scale)(double *dst, double gain, size_t count);
+    // the sum of src[i]
+    double (*sum)(const double *src, size_t count);
+    // the sum of src1[i] * src2[i]
+    double (*dot)(const double *src1, const double *src2, size_t count);
+    // the extremum of src[i] and `init`; NaN elements are ignored
+    double (*min)(const double *src, size_t count, double init);
+    double (*max)(const double *src, size_t count, double init);
+    double (*absmax)(const double *src, size_t count, double init);
+    // dst[i] *= src[i], on complex values made of pairs of doubles
+    void (*cmul)(double *dst, const double *src, size_t count);
+    // dst[i] += src1[i] * src2[i], on complex values
+    void (*cmac)(double *dst, const double *src1, const double *src2, size_t count);
+    // the FFT of 2^bits complex values in place, in the conventions of `fft_complex`;
+    //   `tw[b]` has the twiddle factors of the size 2^b, for each size up to 2^bits
+    void (*fft)(double *data, uint32_t bits, const double *const *tw, bool inverse);
+};
+const f64_kernels &get_f64_kernels();
+// get the name of the instruction set which the kernels use
+const char *get_f64_kernels_isa();
+
+// the FFT, in the conventions of WDL_fft and WDL_real_fft: the transforms are
+//   not normalized, and the spectrum is in the order of `fft_permutation`;
+//   the real transform packs the Nyquist bin in the imaginary part of the first
+enum { fft_max_bits = 16 };
+// compute the tables of the sizes up to 2^15, which are otherwise computed at first use
+void fft_init();
+// transform 2^bits complex values, made of pairs of doubles (1 <= bits <= fft_max_bits)
+void fft_complex(double *data, uint32_t bits, bool inverse);
+// transform 2^bits real values, into 2^(bits-1) complex values (2 <= bits <= fft_max_bits)
+void fft_real(double *data, uint32_t bits, bool inverse);
+// reorder 2^bits complex values from the spectrum to the natural order, or the inverse
+void fft_permute(double *data, uint32_t bits, bool inverse);
+// get the position in the spectrum of each frequency bin, for 2^bits complex values
+const uint32_t *fft_permutation(uint32_t bits);
 
 //------------------------------------------------------------------------------
 
@@ -119,6 +180,57 @@ bool get_descriptor_file_uid(int fd, file_uid &uid);
 bool get_handle_file_uid(void *handle, file_uid &uid);
 #endif
 
+// the identity of a file, and the last modification it was seen with
+struct file_stamp {
+    file_uid uid;
+    int64_t mtime = 0;
+    uint64_t size = 0;
+};
+bool get_file_stamp(const char *path, file_stamp &stamp);
+inline bool operator==(const file_stamp &a, const file_stamp &b)
+{
+    return a.uid == b.uid && a.mtime == b.mtime && a.size == b.size;
+}
+inline bool operator!=(const file_stamp &a, const file_stamp &b)
+{
+    return !(a == b);
+}
+
+//------------------------------------------------------------------------------
+
+// a read-only mapping of an entire file into memory
+//   if another process truncates the file, the access to the pages past its
+//   new end faults; `refresh` shrinks the size to what remains, so the
+//   readers call it before the accesses, at least at every seek and bulk read
+class mapped_file {
+public:
+    mapped_file() = default;
+    ~mapped_file() { close(); }
+
+    // map the file, unless it is smaller than `min_size`
+    bool open(const char *path, uint64_t min_size = 0);
+    void close();
+    const uint8_t *data() const { return m_data; }
+    uint64_t size() const { return m_size; }
+    // reduce the size if the file was truncated, and return it
+    uint64_t refresh();
+
+private:
+    const uint8_t *m_data = nullptr;
+    uint64_t m_size = 0;
+    uint64_t m_map_size = 0;
+#if !defined(_WIN32)
+    int m_fd = -1;
+#endif
+
+private:
+    mapped_file(const mapped_file &) = delete;
+    mapped_file &operator=(const mapped_file &) = delete;
+};
+
+// the size under which the data files are read rather than mapped
+enum { mapped_file_min_size = 1 << 20 };
+
 //------------------------------------------------------------------------------
 
 struct split_path_t {
@@ -0,0 +1,232 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ysfx_utils.hpp"
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <cmath>
+
+namespace ysfx {
+
+namespace {
+
+// the tables of a transform of 2^bits complex values, which are immutable once made
+struct fft_tables {
+    // the twiddle factors w^m of the split-radix pass, for m < n/4
+    std::vector<double> twiddles;
+    // the position in the spectrum of each frequency bin
+    std::vector<uint32_t> permutation;
+    // the first position of each cycle of the permutation, to permute in place
+    std::vector<uint32_t> cycles;
+    // the twiddle factors of this size and the smaller ones, indexed by size
+    const double *all_twiddles[fft_max_bits + 1] = {};
+};
+
+} // namespace
+
+static constexpr double fft_pi = 3.14159265358979323846;
+
+// the tables are never freed, for the workers which outlive the static destructors
+static ysfx::mutex fft_tables_mutex;
+static std::atomic<const fft_tables *> fft_tables_cache[fft_max_bits + 1];
+
+// the frequency at a position of the output of the split-radix FFT, as in WDL
+static uint32_t fft_frequency(uint32_t i, uint32_t n)
+{
+    if (n <= 2)
+        return i;
+    uint32_t m = n >> 1;
+    if (i < m)
+        return fft_frequency(i, m) << 1;
+    i -= m;
+    m >>= 1;
+    if (i < m)
+        return (fft_frequency(i, m) << 2) + 1;
+    i -= m;
+    return ((fft_frequency(i, m) << 2) - 1) & (n - 1);
+}
+
+static std::unique_ptr<fft_tables> fft_make_tables(uint32_t bits)
+{
+    const uint32_t n = (uint32_t)1 << bits;
+    std::unique_ptr<fft_tables> tab{new fft_tables};
+
+    tab->twiddles.resize(2 * (n / 4));
+    for (uint32_t m = 0; m < n / 4; ++m) {
+        double angle = 2 * fft_pi * m / n;
+        tab->twiddles[2 * m] = std::cos(angle);
+        tab->twiddles[2 * m + 1] = std::sin(angle);
+    }
+
+    tab->permutation.resize(n);
+    tab->permutation[0] = 0;
+    for (uint32_t i = 1; i < n; ++i)
+        tab->permutation[n - fft_frequency(i, n)] = i;
+
+    std::vector<bool> visited(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        if (visited[i] || tab->permutation[i] == i)
+            continue;
+        tab->cycles.push_back(i);
+        for (uint32_t j = i; !visited[j]; j = tab->permutation[j])
+            visited[j] = true;
+    }
+
+    return tab;
+}
+
+static const fft_tables &fft_get_tables(uint32_t bits)
+{
+    const fft_tables *tab = fft_tables_cache[bits].load(std::memory_order_acquire);
+    if (tab)
+        return *tab;
+
+    // make this size, and the smaller ones which the transform also uses
+    std::lock_guard<ysfx::mutex> lock{fft_tables_mutex};
+    for (uint32_t b = 1; b <= bits; ++b) {
+        if (fft_tables_cache[b].load(std::memory_order_relaxed))
+            continue;
+        std::unique_ptr<fft_tables> made = fft_make_tables(b);
+        for (uint32_t i = 1; i < b; ++i)
+            made->all_twiddles[i] = fft_tables_cache[i].load(std::memory_order_relaxed)->twiddles.data();
+        made->all_twiddles[b] = made->twiddles.data();
+        fft_tables_cache[b].store(made.release(), std::memory_order_release);
+    }
+    return *fft_tables_cache[bits].load(std::memory_order_relaxed);
+}
+
+void fft_init()
+{
+    fft_get_tables(fft_max_bits);
+}
+
+const uint32_t *fft_permutation(uint32_t bits)
+{
+    return fft_get_tables(bits).permutation.data();
+}
+
+void fft_complex(double *data, uint32_t bits, bool inverse)
+{
+    get_f64_kernels().fft(data, bits, fft_get_tables(bits).all_twiddles, inverse);
+}
+
+// NOTE: the real transform of size N is a complex one of size N/2 over the
+//   even and odd samples, which are separated with the twiddles of size N;
+//   this goes over the pairs of bins k and N/2-k, which it updates in place
+
+void fft_real(double *data, uint32_t bits, bool inverse)
+{
+    const size_t half = (size_t)1 << (bits - 1);
+    const size_t quart = half / 2;
+    const fft_tables &half_tab = fft_get_tables(bits - 1);
+    const uint32_t *perm = half_tab.permutation.data();
+    const double *tw = fft_get_tables(bits).twiddles.data();
+    const f64_kernels &k = get_f64_kernels();
+
+    if (!inverse)
+        k.fft(data, bits - 1, half_tab.all_twiddles, false);
+
+    // the bins 0 and N/2, which are real, and packed in the first pair
+    double r0 = data[0];
+    double r1 = data[1];
+    if (!inverse) {
+        data[0] = 2 * (r0 + r1);
+        data[1] = 2 * (r0 - r1);
+    }
+    else {
+        data[0] = r0 + r1;
+        data[1] = r0 - r1;
+    }
+
+    for (size_t i = 1; i < quart; ++i) {
+        double *pk = &data[2 * perm[i]];
+        double *pm = &data[2 * perm[half - i]];
+        // the twiddle factor of the bin, e^(-2 pi i k/N)
+        double wr = tw[2 * i];
+        double wi = -tw[2 * i + 1];
+        if (!inverse) {
+            // from the even part `e` and the odd part `d`
+            double er = pk[0] + pm[0];
+            double ei = pk[1] - pm[1];
+            double dr = pk[0] - pm[0];
+            double di = pk[1] + pm[1];
+            double tr = wr * dr - wi * di;
+            double ti = wr * di + wi * dr;
+            pk[0] = er + ti;
+            pk[1] = ei - tr;
+            pm[0] = er - ti;
+            pm[1] = -ei - tr;
+        }
+        else {
+            double sr = pk[0] + pm[0];
+            double si = pk[1] - pm[1];
+            double dr = pm[0] - pk[0];
+            double di = -pm[1] - pk[1];
+            double ur = wr * dr + wi * di;
+            double ui = wr * di - wi * dr;
+            pk[0] = sr + ui;
+            pk[1] = si - ur;
+            pm[0] = sr - ui;
+            pm[1] = -si - ur;
+        }
+    }
+
+    // the bin N/4, whose twiddle factor is -i
+    if (quart > 0) {
+        double *pq = &data[2 * perm[quart]];
+        pq[0] *= 2;
+        pq[1] *= -2;
+    }
+
+    if (inverse)
+        k.fft(data, bits - 1, half_tab.all_twiddles, true);
+}
+
+void fft_permute(double *data, uint32_t bits, bool inverse)
+{
+    const fft_tables &tab = fft_get_tables(bits);
+    const uint32_t *perm = tab.permutation.data();
+
+    // follow each cycle, moving the values by one step
+    for (uint32_t first : tab.cycles) {
+        double re = data[2 * first];
+        double im = data[2 * first + 1];
+        uint32_t i = first;
+        if (!inverse) {
+            // data[i] = data[perm[i]]
+            for (uint32_t j; (j = perm[i]) != first; i = j) {
+                data[2 * i] = data[2 * j];
+                data[2 * i + 1] = data[2 * j + 1];
+            }
+            data[2 * i] = re;
+            data[2 * i + 1] = im;
+        }
+        else {
+            // data[perm[i]] = data[i]
+            while ((i = perm[i]) != first) {
+                std::swap(re, data[2 * i]);
+                std::swap(im, data[2 * i + 1]);
+            }
+            data[2 * first] = re;
+            data[2 * first + 1] = im;
+        }
+    }
+}
+
+} // namespace ysfx
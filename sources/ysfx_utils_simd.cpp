@@ -0,0 +1,179 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ysfx_utils.hpp"
+#include "ysfx_utils_simd.hpp"
+#include <cstring>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#   include <intrin.h>
+#endif
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#   define YSFX_BIG_ENDIAN 1
+#endif
+
+namespace ysfx {
+
+void widen_f32_to_f64(const float *src, double *dst, size_t count)
+{
+    // NOTE: going backwards permits to widen in place, when `src` is at the
+    //   front of `dst`: each double is stored past the floats yet to be read
+    size_t i = count;
+
+#if defined(YSFX_SIMD_SSE2)
+    while (i >= 4) {
+        i -= 4;
+        __m128 f = _mm_loadu_ps(&src[i]);
+        __m128d lo = _mm_cvtps_pd(f);
+        __m128d hi = _mm_cvtps_pd(_mm_movehl_ps(f, f));
+        _mm_storeu_pd(&dst[i + 2], hi);
+        _mm_storeu_pd(&dst[i], lo);
+    }
+#elif defined(YSFX_SIMD_NEON64)
+    while (i >= 4) {
+        i -= 4;
+        float32x4_t f = vld1q_f32(&src[i]);
+        float64x2_t lo = vcvt_f64_f32(vget_low_f32(f));
+        float64x2_t hi = vcvt_high_f64_f32(f);
+        vst1q_f64(&dst[i + 2], hi);
+        vst1q_f64(&dst[i], lo);
+    }
+#endif
+
+    while (i-- > 0)
+        dst[i] = src[i];
+}
+
+void widen_f32le_to_f64(const uint8_t *src, double *dst, size_t count)
+{
+    size_t i = 0;
+
+#if !defined(YSFX_BIG_ENDIAN)
+#   if defined(YSFX_SIMD_SSE2)
+    for (; i + 4 <= count; i += 4) {
+        __m128 f = _mm_loadu_ps((const float *)&src[4 * i]);
+        _mm_storeu_pd(&dst[i], _mm_cvtps_pd(f));
+        _mm_storeu_pd(&dst[i + 2], _mm_cvtps_pd(_mm_movehl_ps(f, f)));
+    }
+#   elif defined(YSFX_SIMD_NEON64)
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t f = vreinterpretq_f32_u8(vld1q_u8(&src[4 * i]));
+        vst1q_f64(&dst[i], vcvt_f64_f32(vget_low_f32(f)));
+        vst1q_f64(&dst[i + 2], vcvt_high_f64_f32(f));
+    }
+#   endif
+    for (; i < count; ++i) {
+        float f;
+        memcpy(&f, &src[4 * i], 4);
+        dst[i] = f;
+    }
+#else
+    for (; i < count; ++i)
+        dst[i] = unpack_f32le(&src[4 * i]);
+#endif
+}
+
+void narrow_f64_to_f32le(const double *src, uint8_t *dst, size_t count)
+{
+    size_t i = 0;
+
+#if !defined(YSFX_BIG_ENDIAN)
+#   if defined(YSFX_SIMD_SSE2)
+    for (; i + 4 <= count; i += 4) {
+        __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(&src[i]));
+        __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(&src[i + 2]));
+        _mm_storeu_ps((float *)&dst[4 * i], _mm_movelh_ps(lo, hi));
+    }
+#   elif defined(YSFX_SIMD_NEON64)
+    for (; i + 4 <= count; i += 4) {
+        float32x2_t lo = vcvt_f32_f64(vld1q_f64(&src[i]));
+        float32x4_t f = vcvt_high_f32_f64(lo, vld1q_f64(&src[i + 2]));
+        vst1q_u8(&dst[4 * i], vreinterpretq_u8_f32(f));
+    }
+#   endif
+    for (; i < count; ++i) {
+        float f = (float)src[i];
+        memcpy(&dst[4 * i], &f, 4);
+    }
+#else
+    for (; i < count; ++i)
+        pack_f32le((float)src[i], &dst[4 * i]);
+#endif
+}
+
+//------------------------------------------------------------------------------
+#if defined(YSFX_SIMD_SSE2) && defined(YSFX_SIMD_HAVE_AVX2_UNIT)
+static bool cpu_has_avx2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    // the processor supports AVX, and the system saves its registers
+    const int osxsave_avx = (1 << 27) | (1 << 28);
+    if ((info[2] & osxsave_avx) != osxsave_avx || (_xgetbv(0) & 6) != 6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+struct f64_kernels_choice {
+    const f64_kernels *kernels;
+    const char *isa;
+};
+
+static f64_kernels_choice choose_f64_kernels()
+{
+#if defined(YSFX_SIMD_SSE2)
+#   if defined(YSFX_SIMD_HAVE_AVX2_UNIT)
+    if (cpu_has_avx2())
+        return {f64_kernels_avx2(), "avx2"};
+#   endif
+    static const f64_kernels sse2 = make_f64_kernels<vec_sse2, cvec_sse2>();
+    return {&sse2, "sse2"};
+#elif defined(YSFX_SIMD_NEON64)
+    static const f64_kernels neon64 = make_f64_kernels<vec_neon64, cvec_neon64>();
+    return {&neon64, "neon64"};
+#else
+    static const f64_kernels scalar = make_f64_kernels<vec_scalar, cvec_scalar>();
+    return {&scalar, "scalar"};
+#endif
+}
+
+static const f64_kernels_choice &get_f64_kernels_choice()
+{
+    static const f64_kernels_choice choice = choose_f64_kernels();
+    return choice;
+}
+
+const f64_kernels &get_f64_kernels()
+{
+    return *get_f64_kernels_choice().kernels;
+}
+
+const char *get_f64_kernels_isa()
+{
+    return get_f64_kernels_choice().isa;
+}
+
+} // namespace ysfx
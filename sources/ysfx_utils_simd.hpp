@@ -0,0 +1,495 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+// the vector kernels, which are compiled separately for each instruction set
+
+#pragma once
+#include "ysfx_utils.hpp"
+#include <cstddef>
+#include <cmath>
+
+#if !defined(YSFX_NO_SIMD)
+#   if defined(__AVX2__)
+#       define YSFX_SIMD_AVX2 1
+#       include <immintrin.h>
+#   endif
+#   if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#       define YSFX_SIMD_SSE2 1
+#       include <emmintrin.h>
+#   elif defined(__aarch64__) || defined(_M_ARM64)
+#       define YSFX_SIMD_NEON64 1
+#       include <arm_neon.h>
+#   endif
+#endif
+
+namespace ysfx {
+
+const f64_kernels *f64_kernels_avx2();
+
+namespace {
+
+//------------------------------------------------------------------------------
+struct vec_scalar {
+    typedef double type;
+    enum { width = 1 };
+    static type load(const double *p) { return *p; }
+    static void store(double *p, type x) { *p = x; }
+    static type set1(double x) { return x; }
+    static type add(type a, type b) { return a + b; }
+    static type mul(type a, type b) { return a * b; }
+    static type min(type a, type b) { return (b < a) ? b : a; }
+    static type max(type a, type b) { return (b > a) ? b : a; }
+    static type abs(type a) { return std::fabs(a); }
+    static double hsum(type a) { return a; }
+    static double hmin(type a) { return a; }
+    static double hmax(type a) { return a; }
+};
+
+#if defined(YSFX_SIMD_SSE2)
+struct vec_sse2 {
+    typedef __m128d type;
+    enum { width = 2 };
+    static type load(const double *p) { return _mm_loadu_pd(p); }
+    static void store(double *p, type x) { _mm_storeu_pd(p, x); }
+    static type set1(double x) { return _mm_set1_pd(x); }
+    static type add(type a, type b) { return _mm_add_pd(a, b); }
+    static type mul(type a, type b) { return _mm_mul_pd(a, b); }
+    // the operands are swapped to ignore a NaN in `b`, like the scalar version
+    static type min(type a, type b) { return _mm_min_pd(b, a); }
+    static type max(type a, type b) { return _mm_max_pd(b, a); }
+    static type abs(type a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+    static double hsum(type a) { return _mm_cvtsd_f64(_mm_add_sd(a, _mm_unpackhi_pd(a, a))); }
+    static double hmin(type a) { return _mm_cvtsd_f64(_mm_min_sd(a, _mm_unpackhi_pd(a, a))); }
+    static double hmax(type a) { return _mm_cvtsd_f64(_mm_max_sd(a, _mm_unpackhi_pd(a, a))); }
+};
+#endif
+
+#if defined(YSFX_SIMD_AVX2)
+struct vec_avx2 {
+    typedef __m256d type;
+    enum { width = 4 };
+    static type load(const double *p) { return _mm256_loadu_pd(p); }
+    static void store(double *p, type x) { _mm256_storeu_pd(p, x); }
+    static type set1(double x) { return _mm256_set1_pd(x); }
+    static type add(type a, type b) { return _mm256_add_pd(a, b); }
+    static type mul(type a, type b) { return _mm256_mul_pd(a, b); }
+    static type min(type a, type b) { return _mm256_min_pd(b, a); }
+    static type max(type a, type b) { return _mm256_max_pd(b, a); }
+    static type abs(type a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+    static double hsum(type a) { return vec_sse2::hsum(_mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1))); }
+    static double hmin(type a) { return vec_sse2::hmin(_mm_min_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1))); }
+    static double hmax(type a) { return vec_sse2::hmax(_mm_max_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1))); }
+};
+#endif
+
+#if defined(YSFX_SIMD_NEON64)
+struct vec_neon64 {
+    typedef float64x2_t type;
+    enum { width = 2 };
+    static type load(const double *p) { return vld1q_f64(p); }
+    static void store(double *p, type x) { vst1q_f64(p, x); }
+    static type set1(double x) { return vdupq_n_f64(x); }
+    static type add(type a, type b) { return vaddq_f64(a, b); }
+    static type mul(type a, type b) { return vmulq_f64(a, b); }
+    static type min(type a, type b) { return vminnmq_f64(a, b); }
+    static type max(type a, type b) { return vmaxnmq_f64(a, b); }
+    static type abs(type a) { return vabsq_f64(a); }
+    static double hsum(type a) { return vaddvq_f64(a); }
+    static double hmin(type a) { return vminvq_f64(a); }
+    static double hmax(type a) { return vmaxvq_f64(a); }
+};
+#endif
+
+//------------------------------------------------------------------------------
+// complex vectors, which hold pairs of real and imaginary parts
+
+struct cvec_scalar {
+    struct type { double re, im; };
+    enum { width = 1 };
+    static type load(const double *p) { return {p[0], p[1]}; }
+    static void store(double *p, type x) { p[0] = x.re; p[1] = x.im; }
+    static type add(type a, type b) { return {a.re + b.re, a.im + b.im}; }
+    static type sub(type a, type b) { return {a.re - b.re, a.im - b.im}; }
+    static type conj(type a) { return {a.re, -a.im}; }
+    // multiply by i, or by -i if inverse
+    template <bool Inverse> static type rot(type a) { return Inverse ? type{a.im, -a.re} : type{-a.im, a.re}; }
+    static type cmul(type a, type b) { return {a.re * b.re - a.im * b.im, a.im * b.re + a.re * b.im}; }
+};
+
+#if defined(YSFX_SIMD_SSE2)
+struct cvec_sse2 {
+    typedef __m128d type;
+    enum { width = 1 };
+    static type load(const double *p) { return _mm_loadu_pd(p); }
+    static void store(double *p, type x) { _mm_storeu_pd(p, x); }
+    static type add(type a, type b) { return _mm_add_pd(a, b); }
+    static type sub(type a, type b) { return _mm_sub_pd(a, b); }
+    static type conj(type a) { return _mm_xor_pd(a, _mm_set_pd(-0.0, 0.0)); }
+    static type swap(type a) { return _mm_shuffle_pd(a, a, 1); }
+    template <bool Inverse> static type rot(type a) { return _mm_xor_pd(swap(a), Inverse ? _mm_set_pd(-0.0, 0.0) : _mm_set_pd(0.0, -0.0)); }
+    static type cmul(type a, type b)
+    {
+        __m128d re = _mm_unpacklo_pd(b, b);
+        __m128d im = _mm_xor_pd(_mm_unpackhi_pd(b, b), _mm_set_pd(0.0, -0.0));
+        return _mm_add_pd(_mm_mul_pd(a, re), _mm_mul_pd(swap(a), im));
+    }
+};
+#endif
+
+#if defined(YSFX_SIMD_AVX2)
+struct cvec_avx2 {
+    typedef __m256d type;
+    enum { width = 2 };
+    static type load(const double *p) { return _mm256_loadu_pd(p); }
+    static void store(double *p, type x) { _mm256_storeu_pd(p, x); }
+    static type add(type a, type b) { return _mm256_add_pd(a, b); }
+    static type sub(type a, type b) { return _mm256_sub_pd(a, b); }
+    static type conj(type a) { return _mm256_xor_pd(a, _mm256_set_pd(-0.0, 0.0, -0.0, 0.0)); }
+    static type swap(type a) { return _mm256_permute_pd(a, 5); }
+    template <bool Inverse> static type rot(type a) { return _mm256_xor_pd(swap(a), Inverse ? _mm256_set_pd(-0.0, 0.0, -0.0, 0.0) : _mm256_set_pd(0.0, -0.0, 0.0, -0.0)); }
+    static type cmul(type a, type b)
+    {
+        __m256d re = _mm256_movedup_pd(b);
+        __m256d im = _mm256_xor_pd(_mm256_permute_pd(b, 15), _mm256_set_pd(0.0, -0.0, 0.0, -0.0));
+        return _mm256_add_pd(_mm256_mul_pd(a, re), _mm256_mul_pd(swap(a), im));
+    }
+};
+#endif
+
+#if defined(YSFX_SIMD_NEON64)
+struct cvec_neon64 {
+    typedef float64x2_t type;
+    enum { width = 1 };
+    static type load(const double *p) { return vld1q_f64(p); }
+    static void store(double *p, type x) { vst1q_f64(p, x); }
+    static type add(type a, type b) { return vaddq_f64(a, b); }
+    static type sub(type a, type b) { return vsubq_f64(a, b); }
+    static type pair(double lo, double hi) { return vcombine_f64(vdup_n_f64(lo), vdup_n_f64(hi)); }
+    static type conj(type a) { return vmulq_f64(a, pair(1.0, -1.0)); }
+    static type swap(type a) { return vextq_f64(a, a, 1); }
+    template <bool Inverse> static type rot(type a) { return vmulq_f64(swap(a), Inverse ? pair(1.0, -1.0) : pair(-1.0, 1.0)); }
+    static type cmul(type a, type b)
+    {
+        float64x2_t re = vdupq_laneq_f64(b, 0);
+        float64x2_t im = vmulq_f64(vdupq_laneq_f64(b, 1), pair(-1.0, 1.0));
+        return vaddq_f64(vmulq_f64(a, re), vmulq_f64(swap(a), im));
+    }
+};
+#endif
+
+//------------------------------------------------------------------------------
+// NOTE: the element-wise kernels round like the scalar code; the reductions
+//   accumulate in several lanes, which changes the order of the additions
+
+template <class V>
+void add_f64(double *dst, const double *src, size_t count)
+{
+    size_t i = 0;
+    for (; i + V::width <= count; i += V::width)
+        V::store(&dst[i], V::add(V::load(&dst[i]), V::load(&src[i])));
+    for (; i < count; ++i)
+        dst[i] += src[i];
+}
+
+template <class V>
+void mul_f64(double *dst, const double *src, size_t count)
+{
+    size_t i = 0;
+    for (; i + V::width <= count; i += V::width)
+        V::store(&dst[i], V::mul(V::load(&dst[i]), V::load(&src[i])));
+    for (; i < count; ++i)
+        dst[i] *= src[i];
+}
+
+template <class V>
+void mac_f64(double *dst, const double *src1, const double *src2, size_t count)
+{
+    size_t i = 0;
+    for (; i + V::width <= count; i += V::width)
+        V::store(&dst[i], V::add(V::load(&dst[i]), V::mul(V::load(&src1[i]), V::load(&src2[i]))));
+    for (; i < count; ++i)
+        dst[i] += src1[i] * src2[i];
+}
+
+template <class V>
+void scale_f64(double *dst, double gain, size_t count)
+{
+    size_t i = 0;
+    typename V::type k = V::set1(gain);
+    for (; i + V::width <= count; i += V::width)
+        V::store(&dst[i], V::mul(V::load(&dst[i]), k));
+    for (; i < count; ++i)
+        dst[i] *= gain;
+}
+
+template <class V>
+double sum_f64(const double *src, size_t count)
+{
+    size_t i = 0;
+    typename V::type acc1 = V::set1(0), acc2 = V::set1(0);
+    for (; i + 2 * V::width <= count; i += 2 * V::width) {
+        acc1 = V::add(acc1, V::load(&src[i]));
+        acc2 = V::add(acc2, V::load(&src[i + V::width]));
+    }
+    double sum = V::hsum(V::add(acc1, acc2));
+    for (; i < count; ++i)
+        sum += src[i];
+    return sum;
+}
+
+template <class V>
+double dot_f64(const double *src1, const double *src2, size_t count)
+{
+    size_t i = 0;
+    typename V::type acc1 = V::set1(0), acc2 = V::set1(0);
+    for (; i + 2 * V::width <= count; i += 2 * V::width) {
+        acc1 = V::add(acc1, V::mul(V::load(&src1[i]), V::load(&src2[i])));
+        acc2 = V::add(acc2, V::mul(V::load(&src1[i + V::width]), V::load(&src2[i + V::width])));
+    }
+    double sum = V::hsum(V::add(acc1, acc2));
+    for (; i < count; ++i)
+        sum += src1[i] * src2[i];
+    return sum;
+}
+
+template <class V>
+double min_f64(const double *src, size_t count, double init)
+{
+    size_t i = 0;
+    typename V::type acc = V::set1(init);
+    for (; i + V::width <= count; i += V::width)
+        acc = V::min(acc, V::load(&src[i]));
+    double value = V::hmin(acc);
+    for (; i < count; ++i)
+        value = vec_scalar::min(value, src[i]);
+    return value;
+}
+
+template <class V>
+double max_f64(const double *src, size_t count, double init)
+{
+    size_t i = 0;
+    typename V::type acc = V::set1(init);
+    for (; i + V::width <= count; i += V::width)
+        acc = V::max(acc, V::load(&src[i]));
+    double value = V::hmax(acc);
+    for (; i < count; ++i)
+        value = vec_scalar::max(value, src[i]);
+    return value;
+}
+
+template <class V>
+double absmax_f64(const double *src, size_t count, double init)
+{
+    size_t i = 0;
+    typename V::type acc = V::set1(init);
+    for (; i + V::width <= count; i += V::width)
+        acc = V::max(acc, V::abs(V::load(&src[i])));
+    double value = V::hmax(acc);
+    for (; i < count; ++i)
+        value = vec_scalar::max(value, std::fabs(src[i]));
+    return value;
+}
+
+//------------------------------------------------------------------------------
+// NOTE: the FFT is the conjugate-pair split-radix of WDL, which works in place
+//   and leaves the spectrum in its order; a pass splits the transform into a
+//   half and two quarters, vectorized when the quarters fill the vectors
+
+template <class C, bool Inverse>
+void fft_pass_with(double *a, const double *tw, size_t n4)
+{
+    double *a0 = a;
+    double *a1 = a0 + 2 * n4;
+    double *a2 = a1 + 2 * n4;
+    double *a3 = a2 + 2 * n4;
+    for (size_t m = 0; m < 2 * n4; m += 2 * C::width) {
+        typename C::type w = C::load(&tw[m]);
+        typename C::type x0 = C::load(&a0[m]);
+        typename C::type x1 = C::load(&a1[m]);
+        typename C::type x2 = C::load(&a2[m]);
+        typename C::type x3 = C::load(&a3[m]);
+        if (!Inverse) {
+            // the even half, and the bins 4k+1 and 4k-1 times w^m and w^-m
+            typename C::type z = C::sub(x0, x2);
+            typename C::type iy = C::template rot<false>(C::sub(x1, x3));
+            C::store(&a0[m], C::add(x0, x2));
+            C::store(&a1[m], C::add(x1, x3));
+            C::store(&a2[m], C::cmul(C::add(z, iy), w));
+            C::store(&a3[m], C::cmul(C::sub(z, iy), C::conj(w)));
+        }
+        else {
+            // the transposition of the above, with the conjugate twiddles
+            typename C::type p = C::cmul(x2, C::conj(w));
+            typename C::type q = C::cmul(x3, w);
+            typename C::type s = C::add(p, q);
+            typename C::type d = C::template rot<true>(C::sub(p, q));
+            C::store(&a0[m], C::add(x0, s));
+            C::store(&a2[m], C::sub(x0, s));
+            C::store(&a1[m], C::add(x1, d));
+            C::store(&a3[m], C::sub(x1, d));
+        }
+    }
+}
+
+template <class C, class C1, bool Inverse>
+void fft_pass(double *a, const double *tw, size_t n4)
+{
+    if (n4 < C::width)
+        fft_pass_with<C1, Inverse>(a, tw, n4);
+    else
+        fft_pass_with<C, Inverse>(a, tw, n4);
+}
+
+// the transforms of the small sizes, which are unrolled
+template <class C, class C1, bool Inverse, uint32_t Bits>
+struct fft_fixed {
+    static void run(double *a, const double *const *tw)
+    {
+        const size_t n4 = (size_t)1 << (Bits - 2);
+        if (!Inverse)
+            fft_pass<C, C1, Inverse>(a, tw[Bits], n4);
+        fft_fixed<C, C1, Inverse, Bits - 1>::run(a, tw);
+        fft_fixed<C, C1, Inverse, Bits - 2>::run(a + 4 * n4, tw);
+        fft_fixed<C, C1, Inverse, Bits - 2>::run(a + 6 * n4, tw);
+        if (Inverse)
+            fft_pass<C, C1, Inverse>(a, tw[Bits], n4);
+    }
+};
+
+template <class C, class C1, bool Inverse>
+struct fft_fixed<C, C1, Inverse, 0> {
+    static void run(double *, const double *const *) {}
+};
+
+template <class C, class C1, bool Inverse>
+struct fft_fixed<C, C1, Inverse, 1> {
+    static void run(double *a, const double *const *)
+    {
+        typename C1::type x0 = C1::load(&a[0]);
+        typename C1::type x1 = C1::load(&a[2]);
+        C1::store(&a[0], C1::add(x0, x1));
+        C1::store(&a[2], C1::sub(x0, x1));
+    }
+};
+
+template <class C, class C1, bool Inverse>
+struct fft_fixed<C, C1, Inverse, 2> {
+    static void run(double *a, const double *const *)
+    {
+        typename C1::type x0 = C1::load(&a[0]);
+        typename C1::type x1 = C1::load(&a[2]);
+        typename C1::type x2 = C1::load(&a[4]);
+        typename C1::type x3 = C1::load(&a[6]);
+        if (!Inverse) {
+            typename C1::type s02 = C1::add(x0, x2);
+            typename C1::type s13 = C1::add(x1, x3);
+            typename C1::type z = C1::sub(x0, x2);
+            typename C1::type iy = C1::template rot<false>(C1::sub(x1, x3));
+            C1::store(&a[0], C1::add(s02, s13));
+            C1::store(&a[2], C1::sub(s02, s13));
+            C1::store(&a[4], C1::add(z, iy));
+            C1::store(&a[6], C1::sub(z, iy));
+        }
+        else {
+            typename C1::type e0 = C1::add(x0, x1);
+            typename C1::type e1 = C1::sub(x0, x1);
+            typename C1::type s = C1::add(x2, x3);
+            typename C1::type d = C1::template rot<true>(C1::sub(x2, x3));
+            C1::store(&a[0], C1::add(e0, s));
+            C1::store(&a[4], C1::sub(e0, s));
+            C1::store(&a[2], C1::add(e1, d));
+            C1::store(&a[6], C1::sub(e1, d));
+        }
+    }
+};
+
+template <class C, class C1, bool Inverse>
+void fft_split_radix(double *a, uint32_t bits, const double *const *tw)
+{
+    switch (bits) {
+    case 0: fft_fixed<C, C1, Inverse, 0>::run(a, tw); return;
+    case 1: fft_fixed<C, C1, Inverse, 1>::run(a, tw); return;
+    case 2: fft_fixed<C, C1, Inverse, 2>::run(a, tw); return;
+    case 3: fft_fixed<C, C1, Inverse, 3>::run(a, tw); return;
+    case 4: fft_fixed<C, C1, Inverse, 4>::run(a, tw); return;
+    case 5: fft_fixed<C, C1, Inverse, 5>::run(a, tw); return;
+    }
+
+    const size_t n4 = (size_t)1 << (bits - 2);
+    if (!Inverse)
+        fft_pass<C, C1, Inverse>(a, tw[bits], n4);
+    fft_split_radix<C, C1, Inverse>(a, bits - 1, tw);
+    fft_split_radix<C, C1, Inverse>(a + 4 * n4, bits - 2, tw);
+    fft_split_radix<C, C1, Inverse>(a + 6 * n4, bits - 2, tw);
+    if (Inverse)
+        fft_pass<C, C1, Inverse>(a, tw[bits], n4);
+}
+
+// `C` is the complex vector, and `C1` the one which holds a single value
+template <class C, class C1>
+void fft_f64(double *data, uint32_t bits, const double *const *tw, bool inverse)
+{
+    if (!inverse)
+        fft_split_radix<C, C1, false>(data, bits, tw);
+    else
+        fft_split_radix<C, C1, true>(data, bits, tw);
+}
+
+template <class C, class C1>
+void cmul_f64(double *dst, const double *src, size_t count)
+{
+    size_t i = 0;
+    for (; i + C::width <= count; i += C::width)
+        C::store(&dst[2 * i], C::cmul(C::load(&dst[2 * i]), C::load(&src[2 * i])));
+    for (; i < count; ++i)
+        C1::store(&dst[2 * i], C1::cmul(C1::load(&dst[2 * i]), C1::load(&src[2 * i])));
+}
+
+template <class C, class C1>
+void cmac_f64(double *dst, const double *src1, const double *src2, size_t count)
+{
+    size_t i = 0;
+    for (; i + C::width <= count; i += C::width)
+        C::store(&dst[2 * i], C::add(C::load(&dst[2 * i]), C::cmul(C::load(&src1[2 * i]), C::load(&src2[2 * i]))));
+    for (; i < count; ++i)
+        C1::store(&dst[2 * i], C1::add(C1::load(&dst[2 * i]), C1::cmul(C1::load(&src1[2 * i]), C1::load(&src2[2 * i]))));
+}
+
+//------------------------------------------------------------------------------
+template <class V, class C, class C1 = C>
+f64_kernels make_f64_kernels()
+{
+    f64_kernels k;
+    k.add = &add_f64<V>;
+    k.mul = &mul_f64<V>;
+    k.mac = &mac_f64<V>;
+    k.scale = &scale_f64<V>;
+    k.sum = &sum_f64<V>;
+    k.dot = &dot_f64<V>;
+    k.min = &min_f64<V>;
+    k.max = &max_f64<V>;
+    k.absmax = &absmax_f64<V>;
+    k.cmul = &cmul_f64<C, C1>;
+    k.cmac = &cmac_f64<C, C1>;
+    k.fft = &fft_f64<C, C1>;
+    return k;
+}
+
+} // namespace
+
+} // namespace ysfx
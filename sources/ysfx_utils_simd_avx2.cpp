@@ -0,0 +1,33 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+// NOTE: this unit is compiled with AVX2 enabled, and it is only entered
+//   after checking that the processor supports it
+
+#include "ysfx_utils_simd.hpp"
+
+#if defined(YSFX_SIMD_AVX2)
+namespace ysfx {
+
+const f64_kernels *f64_kernels_avx2()
+{
+    static const f64_kernels kernels = make_f64_kernels<vec_avx2, cvec_avx2, cvec_sse2>();
+    return &kernels;
+}
+
+} // namespace ysfx
+#endif
@@ -0,0 +1,125 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ysfx.h"
+#include "ysfx_utils.hpp"
+#include "../ysfx_test_utils.hpp"
+#include "ysfx_bench_utils.hpp"
+#include <memory>
+#include <string>
+#include <cstdio>
+
+#if defined(YSFX_TESTS_HAVE_SNDFILE)
+#   include <sndfile.h>
+#endif
+
+// a 60 second stereo file at 48 kHz
+static constexpr uint32_t bench_channels = 2;
+static constexpr uint32_t bench_rate = 48000;
+static constexpr uint64_t bench_frames = 60 * bench_rate;
+static constexpr uint32_t bench_runs = 10;
+
+static uint64_t file_size(const char *path)
+{
+    ysfx::FILE_u stream{ysfx::fopen_utf8(path, "rb")};
+    if (!stream || ysfx::fseek_lfs(stream.get(), 0, SEEK_END) == -1)
+        return 0;
+    int64_t size = ysfx::ftell_lfs(stream.get());
+    return (size > 0) ? (uint64_t)size : 0;
+}
+
+// load the entire file into memory with `file_mem` during @init
+static void bench_file_mem(const char *name, const std::string &audio_name)
+{
+    std::string text =
+        "desc:bench" "\n"
+        "options:maxmem=33554432" "\n"
+        "filename:0," + audio_name + "\n"
+        "@init" "\n"
+        "h=file_open(0);" "\n"
+        "n=file_avail(h);" "\n"
+        "file_mem(h,0,n);" "\n"
+        "file_close(h);" "\n";
+
+    scoped_new_txt file_main("${root}/Effects/bench.jsfx", text.c_str());
+
+    ysfx_config_u config{ysfx_config_new()};
+    ysfx_register_builtin_audio_formats(config.get());
+    ysfx_u fx{ysfx_new(config.get())};
+
+    if (!ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0) || !ysfx_compile(fx.get(), 0)) {
+        fprintf(stderr, "%s: cannot compile the effect\n", name);
+        return;
+    }
+
+    bench_result res = bench_measure(bench_runs, [&fx]() { ysfx_init(fx.get()); });
+
+    std::string audio_path = tests_root_path + "/Effects/" + audio_name;
+    bench_report(name, res, file_size(audio_path.c_str()));
+}
+
+int main()
+{
+    scoped_new_dir root_dir(tests_root_path);
+    scoped_new_dir dir_fx("${root}/Effects");
+
+    const uint64_t total_smpls = bench_channels * bench_frames;
+    std::vector<float> data = make_noise(total_smpls);
+
+    bench_report_header();
+
+    {
+        scoped_new_txt wav_file("${root}/Effects/bench.wav", nullptr, 0);
+
+        if (!write_wav_file(wav_file.m_path, data.data(), bench_channels, bench_rate, bench_frames))
+            return 1;
+
+        bench_file_mem("file_mem (wav f32)", "bench.wav");
+    }
+
+    {
+        std::unique_ptr<uint8_t[]> bytes{new uint8_t[4 * (size_t)total_smpls]};
+        for (size_t i = 0; i < (size_t)total_smpls; ++i)
+            ysfx::pack_f32le(data[i], &bytes[4 * i]);
+        scoped_new_txt raw_file("${root}/Effects/bench.raw", (const char *)bytes.get(), 4 * (size_t)total_smpls);
+
+        bench_file_mem("file_mem (raw f32)", "bench.raw");
+    }
+
+#if defined(YSFX_TESTS_HAVE_SNDFILE)
+    {
+        scoped_new_txt flac_file("${root}/Effects/bench.flac", nullptr, 0);
+
+        SF_INFO info{};
+        info.frames = bench_frames;
+        info.samplerate = bench_rate;
+        info.channels = bench_channels;
+        info.format = SF_FORMAT_FLAC|SF_FORMAT_PCM_16;
+        SNDFILE *snd = sf_open(flac_file.m_path.c_str(), SFM_WRITE, &info);
+        if (!snd)
+            return 1;
+        sf_writef_float(snd, data.data(), bench_frames);
+        sf_close(snd);
+
+        bench_file_mem("file_mem (flac s16)", "bench.flac");
+    }
+#else
+    fprintf(stderr, "sndfile is missing, not benchmarking flac\n");
+#endif
+
+    return 0;
+}
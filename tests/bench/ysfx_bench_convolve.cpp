@@ -0,0 +1,123 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ysfx.h"
+#include "ysfx_utils.hpp"
+#include "../ysfx_test_utils.hpp"
+#include "ysfx_bench_utils.hpp"
+#include <string>
+#include <cstdio>
+
+// one second of audio at 48 kHz, in blocks of 256 samples
+static constexpr uint32_t bench_rate = 48000;
+static constexpr uint32_t bench_block = 256;
+static constexpr uint32_t bench_runs = 5;
+
+// the uniformly partitioned convolution of the reverbs written in EEL, with
+//   a partition per block, and complex transforms of twice the block size;
+//   the areas of the spectra are aligned, for `convolve_c` to accept them
+static const char bench_eel_init[] =
+    "K = ceil(L / P); S = 4 * P;" "\n"
+    "H = ir + ceil(L / 65536) * 65536; FDL = H + K * S; acc = FDL + K * S; tmp = acc + S; prev = tmp + S;" "\n"
+    "m = 0; loop(K," "\n"
+    "  part = H + m * S; memset(part, 0, S);" "\n"
+    "  i = 0; loop(min(P, L - m * P), part[2 * i] = ir[m * P + i]; i += 1);" "\n"
+    "  fft(part, 2 * P);" "\n"
+    "  m += 1;" "\n"
+    ");" "\n"
+    "fdlpos = 0;" "\n";
+
+static const char bench_eel_block[] =
+    "slot = FDL + fdlpos * S;" "\n"
+    "i = 0; loop(P," "\n"
+    "  slot[2 * i] = prev[i]; slot[2 * i + 1] = 0;" "\n"
+    "  slot[2 * (P + i)] = x[i]; slot[2 * (P + i) + 1] = 0;" "\n"
+    "  prev[i] = x[i];" "\n"
+    "  i += 1;" "\n"
+    ");" "\n"
+    "fft(slot, 2 * P);" "\n"
+    "memset(acc, 0, S);" "\n"
+    "m = 0; loop(K," "\n"
+    "  pos = fdlpos - m; pos < 0 ? pos += K;" "\n"
+    "  memcpy(tmp, FDL + pos * S, S);" "\n"
+    "  convolve_c(tmp, H + m * S, 2 * P);" "\n"
+    "  i = 0; loop(S, acc[i] += tmp[i]; i += 1);" "\n"
+    "  m += 1;" "\n"
+    ");" "\n"
+    "ifft(acc, 2 * P);" "\n"
+    "i = 0; loop(P, x[i] = acc[2 * (P + i)] / (2 * P); i += 1);" "\n"
+    "fdlpos += 1; fdlpos >= K ? fdlpos = 0;" "\n";
+
+static const char bench_native_init[] =
+    "c = conv_new(ir, L);" "\n";
+
+static const char bench_native_block[] =
+    "conv_process(c, x, P);" "\n";
+
+// filter one second of noise in @block, with a decaying response of `length`
+static void bench_convolution(const char *name, uint32_t length, const char *init, const char *block)
+{
+    std::string text =
+        "desc:bench" "\n"
+        "options:maxmem=16777216" "\n"
+        "@init" "\n"
+        "P = " + std::to_string(bench_block) + "; L = " + std::to_string(length) + ";" "\n"
+        "R = " + std::to_string(bench_rate) + "; nblocks = floor(R / P);" "\n"
+        "src = 0; x = src + R; ir = 65536;" "\n"
+        "i = 0; loop(R, src[i] = rand(2) - 1; i += 1);" "\n"
+        "i = 0; loop(L, ir[i] = (rand(2) - 1) * exp(-3 * i / L); i += 1);" "\n"
+        + std::string{init} +
+        "@block" "\n"
+        "blk = 0; loop(nblocks," "\n"
+        "  memcpy(x, src + blk * P, P);" "\n"
+        + std::string{block} +
+        "  blk += 1;" "\n"
+        ");" "\n";
+
+    scoped_new_txt file_main("${root}/Effects/bench.jsfx", text.c_str());
+
+    ysfx_config_u config{ysfx_config_new()};
+    ysfx_u fx{ysfx_new(config.get())};
+    if (!ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0) || !ysfx_compile(fx.get(), 0)) {
+        fprintf(stderr, "%s: cannot compile the effect\n", name);
+        return;
+    }
+    ysfx_init(fx.get());
+
+    bench_result res = bench_measure(bench_runs, [&fx]() {
+        ysfx_process_double(fx.get(), nullptr, nullptr, 0, 0, 1);
+    });
+    bench_report(name, res, (uint64_t)bench_rate * sizeof(ysfx_real));
+}
+
+int main()
+{
+    scoped_new_dir root_dir(tests_root_path);
+    scoped_new_dir dir_fx("${root}/Effects");
+
+    printf("Instruction set: %s\n\n", ysfx::get_f64_kernels_isa());
+    bench_report_header();
+
+    for (uint32_t seconds : {1, 4}) {
+        uint32_t length = seconds * bench_rate;
+        std::string suffix = " (" + std::to_string(seconds) + " s)";
+        bench_convolution(("conv_process" + suffix).c_str(), length, bench_native_init, bench_native_block);
+        bench_convolution(("eel partitioned" + suffix).c_str(), length, bench_eel_init, bench_eel_block);
+    }
+
+    return 0;
+}
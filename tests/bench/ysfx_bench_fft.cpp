@@ -0,0 +1,90 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ysfx.h"
+#include "ysfx_utils.hpp"
+#include "ysfx_bench_utils.hpp"
+#include "WDL/fft.h"
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+// each measurement runs about 2^20 points through the transforms
+static constexpr uint32_t bench_points_bits = 20;
+static constexpr uint32_t bench_runs = 10;
+// the largest size of WDL
+static constexpr uint32_t bench_wdl_max_bits = 15;
+
+static std::vector<double> make_noise(size_t count)
+{
+    std::vector<double> data(count);
+    std::mt19937_64 prng;
+    for (size_t i = 0; i < count; ++i)
+        data[i] = std::uniform_real_distribution<double>{-1.0, 1.0}(prng);
+    return data;
+}
+
+// run a transform in both directions, over the data of 2^bits points
+template <class F>
+static void bench_transform(const std::string &name, uint32_t bits, std::vector<double> &data, F &&fn)
+{
+    const uint32_t repeat = 1u << (bench_points_bits - bits);
+    bench_result res = bench_measure(bench_runs, [&]() {
+        for (uint32_t i = 0; i < repeat; ++i) {
+            fn(data.data(), false);
+            fn(data.data(), true);
+        }
+    });
+    bench_report(name.c_str(), res, (uint64_t)repeat * data.size() * sizeof(double));
+}
+
+int main()
+{
+    WDL_fft_init();
+    ysfx::fft_init();
+
+    printf("Instruction set: %s\n\n", ysfx::get_f64_kernels_isa());
+    bench_report_header();
+
+    for (uint32_t bits = 4; bits <= ysfx::fft_max_bits; ++bits) {
+        const int n = 1 << bits;
+        const std::string size = std::to_string(n);
+        std::vector<double> data = make_noise(2 * (size_t)n);
+
+        if (bits <= bench_wdl_max_bits) {
+            bench_transform("fft " + size + " (wdl)", bits, data, [n](double *x, bool inverse) {
+                WDL_fft((WDL_FFT_COMPLEX *)x, n, inverse);
+            });
+        }
+        bench_transform("fft " + size + " (ysfx)", bits, data, [bits](double *x, bool inverse) {
+            ysfx::fft_complex(x, bits, inverse);
+        });
+
+        data.resize((size_t)n);
+        if (bits <= bench_wdl_max_bits) {
+            bench_transform("fft_real " + size + " (wdl)", bits, data, [n](double *x, bool inverse) {
+                WDL_real_fft(x, n, inverse);
+            });
+        }
+        bench_transform("fft_real " + size + " (ysfx)", bits, data, [bits](double *x, bool inverse) {
+            ysfx::fft_real(x, bits, inverse);
+        });
+    }
+
+    return 0;
+}
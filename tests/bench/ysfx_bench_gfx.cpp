@@ -0,0 +1,121 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ysfx.h"
+#include "../ysfx_test_utils.hpp"
+#include "ysfx_bench_utils.hpp"
+#include <vector>
+#include <string>
+#include <cstdio>
+
+struct bench_primitive {
+    const char *name;
+    // the code which draws at every frame, after clearing
+    const char *code;
+};
+
+static const bench_primitive bench_primitives[] = {
+    {"gfx_rect", "gfx_rect(0, 0, gfx_w, gfx_h);"},
+    {"gfx_line", "i = 0; loop(100, gfx_line(0, i * gfx_h / 100, gfx_w, gfx_h - i * gfx_h / 100, 1); i += 1);"},
+    {"gfx_circle", "i = 0; loop(20, gfx_circle(gfx_w * (i + 0.5) / 20, gfx_h / 2, gfx_h / 4, 1, 1); i += 1);"},
+    {"gfx_roundrect", "i = 0; loop(20, gfx_roundrect(i * gfx_w / 40, i * gfx_h / 40, gfx_w / 2, gfx_h / 2, 8, 1); i += 1);"},
+    {"gfx_triangle", "i = 0; loop(20, gfx_triangle(0, 0, gfx_w, i * gfx_h / 20, i * gfx_w / 20, gfx_h); i += 1);"},
+    {"gfx_gradrect", "gfx_gradrect(0, 0, gfx_w, gfx_h, 0, 0, 0, 1, 1 / gfx_w, 0.5 / gfx_w, 0, 0, 0, 1 / gfx_h, 0, 0);"},
+    {"gfx_blit", "gfx_blit(0, 1, 0, 0, 0, 256, 256, 0, 0, gfx_w, gfx_h);"},
+    {"gfx_blit (rotated)", "gfx_blit(0, 1, 0.5, 0, 0, 256, 256, 0, 0, gfx_w, gfx_h);"},
+    {"gfx_blurto", "gfx_rect(0, 0, gfx_w / 2, gfx_h); gfx_x = 0; gfx_y = 0; gfx_blurto(gfx_w, gfx_h);"},
+    {"gfx_setpixel", "i = 0; loop(10000, gfx_x = i % gfx_w; gfx_y = (i * 7) % gfx_h; gfx_setpixel(1, 0, 0); i += 1);"},
+    {"gfx_drawstr", "i = 0; loop(50, gfx_x = 10; gfx_y = (i * 13) % gfx_h; gfx_drawstr(\"The quick brown fox\"); i += 1);"},
+};
+
+struct bench_canvas {
+    uint32_t width;
+    uint32_t height;
+};
+
+static const bench_canvas bench_canvases[] = {
+    {320, 200},
+    {1280, 720},
+    {1920, 1080},
+};
+
+static constexpr uint32_t bench_frames = 10;
+static constexpr uint32_t bench_runs = 5;
+
+static void bench_primitive_at(const bench_primitive &prim, const bench_canvas &canvas)
+{
+    // a 256x256 image to blit, drawn at the first frame
+    std::string text =
+        "desc:bench" "\n"
+        "out_pin:output" "\n"
+        "@init" "\n"
+        "ready = 0;" "\n"
+        "@gfx" "\n"
+        "!ready ? (" "\n"
+        "  gfx_setimgdim(0, 256, 256); gfx_dest = 0;" "\n"
+        "  gfx_gradrect(0, 0, 256, 256, 1, 0, 0, 1, 0, 1 / 256, 0, 0, 0, 0, 1 / 256, 0);" "\n"
+        "  gfx_dest = -1; ready = 1;" "\n"
+        ");" "\n"
+        "gfx_clear = 0;" "\n"
+        "gfx_set(0.2, 0.6, 1, 0.8);" "\n"
+        + std::string{prim.code} + "\n";
+
+    scoped_new_txt file_main("${root}/Effects/bench.jsfx", text.c_str());
+
+    ysfx_config_u config{ysfx_config_new()};
+    ysfx_u fx{ysfx_new(config.get())};
+    if (!ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0) || !ysfx_compile(fx.get(), 0)) {
+        fprintf(stderr, "%s: cannot compile the effect\n", prim.name);
+        return;
+    }
+    ysfx_init(fx.get());
+
+    std::vector<uint8_t> pixels(4 * (size_t)canvas.width * canvas.height);
+    ysfx_gfx_config_t gc{};
+    gc.pixel_width = canvas.width;
+    gc.pixel_height = canvas.height;
+    gc.pixels = pixels.data();
+    gc.scale_factor = 1.0;
+    ysfx_gfx_setup(fx.get(), &gc);
+
+    bench_result res = bench_measure(bench_runs, [&fx]() {
+        for (uint32_t i = 0; i < bench_frames; ++i)
+            ysfx_gfx_run(fx.get());
+    });
+    res.min_time /= bench_frames;
+    res.mean_time /= bench_frames;
+
+    char name[128];
+    snprintf(name, sizeof(name), "%s %ux%u", prim.name, canvas.width, canvas.height);
+    bench_report(name, res);
+}
+
+int main()
+{
+    scoped_new_dir root_dir(tests_root_path);
+    scoped_new_dir dir_fx("${root}/Effects");
+
+    printf("Times are per frame\n\n");
+    bench_report_header();
+
+    for (const bench_canvas &canvas : bench_canvases) {
+        for (const bench_primitive &prim : bench_primitives)
+            bench_primitive_at(prim, canvas);
+    }
+
+    return 0;
+}
@@ -0,0 +1,127 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ysfx.h"
+#include "../ysfx_test_utils.hpp"
+#include "ysfx_bench_utils.hpp"
+#include <vector>
+#include <string>
+#include <cstdio>
+
+// a meter which prints a grid of numbers, like the analyzers do
+static const char bench_meter_text[] =
+    "desc:bench" "\n"
+    "out_pin:output" "\n"
+    "@init" "\n"
+    "frame = 0;" "\n"
+    "@gfx 640 480" "\n"
+    "gfx_clear = 0;" "\n"
+    "gfx_set(0.8, 0.9, 1, 1);" "\n"
+    "gfx_setfont(1, \"Sans\", 12);" "\n"
+    "i = 0;" "\n"
+    "loop(400," "\n"
+    "  gfx_x = 10 + (i % 10) * 62; gfx_y = 10 + floor(i / 10) * 11;" "\n"
+    "  gfx_printf(\"%.1f dB\", -60 + ((i * 7 + frame) % 600) / 10);" "\n"
+    "  i += 1;" "\n"
+    ");" "\n"
+    "frame += 1;" "\n";
+
+// a display which switches between sizes of font at every frame
+static const char bench_switch_text[] =
+    "desc:bench" "\n"
+    "out_pin:output" "\n"
+    "@init" "\n"
+    "frame = 0;" "\n"
+    "@gfx 640 480" "\n"
+    "gfx_clear = 0;" "\n"
+    "gfx_setfont(1, \"Sans\", 12 + frame % 4);" "\n"
+    "i = 0;" "\n"
+    "loop(40," "\n"
+    "  gfx_x = 10; gfx_y = 10 + i * 11;" "\n"
+    "  gfx_drawnumber(i * 1.25 + frame, 2);" "\n"
+    "  i += 1;" "\n"
+    ");" "\n"
+    "frame += 1;" "\n";
+
+static constexpr uint32_t bench_width = 640;
+static constexpr uint32_t bench_height = 480;
+static constexpr uint32_t bench_frames = 50;
+static constexpr uint32_t bench_runs = 5;
+
+static ysfx_u load_gfx(ysfx_config_t *config, const char *path, std::vector<uint8_t> &pixels)
+{
+    ysfx_u fx{ysfx_new(config)};
+    if (!ysfx_load_file(fx.get(), path, 0) || !ysfx_compile(fx.get(), 0))
+        return nullptr;
+    ysfx_init(fx.get());
+
+    ysfx_gfx_config_t gc{};
+    gc.pixel_width = bench_width;
+    gc.pixel_height = bench_height;
+    gc.pixels = pixels.data();
+    gc.scale_factor = 1.0;
+    ysfx_gfx_setup(fx.get(), &gc);
+    return fx;
+}
+
+// run frames of an instance which remains open
+static void bench_frames_of(const char *name, ysfx_config_t *config, const char *path)
+{
+    std::vector<uint8_t> pixels(4 * bench_width * bench_height);
+    ysfx_u fx = load_gfx(config, path, pixels);
+    if (!fx) {
+        fprintf(stderr, "%s: cannot compile the effect\n", name);
+        return;
+    }
+
+    bench_result res = bench_measure(bench_runs, [&fx]() {
+        for (uint32_t i = 0; i < bench_frames; ++i)
+            ysfx_gfx_run(fx.get());
+    });
+    bench_report(name, res);
+}
+
+// open a new instance and run its first frame, as when an editor opens
+static void bench_first_frame(const char *name, ysfx_config_t *config, const char *path)
+{
+    std::vector<uint8_t> pixels(4 * bench_width * bench_height);
+
+    bench_result res = bench_measure(bench_runs, [&]() {
+        ysfx_u fx = load_gfx(config, path, pixels);
+        if (fx)
+            ysfx_gfx_run(fx.get());
+    });
+    bench_report(name, res);
+}
+
+int main()
+{
+    scoped_new_dir root_dir(tests_root_path);
+    scoped_new_dir dir_fx("${root}/Effects");
+    scoped_new_txt file_meter("${root}/Effects/meter.jsfx", bench_meter_text);
+    scoped_new_txt file_switch("${root}/Effects/switch.jsfx", bench_switch_text);
+
+    ysfx_config_u config{ysfx_config_new()};
+
+    bench_report_header();
+
+    bench_frames_of("gfx_printf meter (50 frames)", config.get(), file_meter.m_path.c_str());
+    bench_first_frame("gfx_printf meter (new instance)", config.get(), file_meter.m_path.c_str());
+    bench_frames_of("gfx_setfont switching (50 frames)", config.get(), file_switch.m_path.c_str());
+
+    return 0;
+}
@@ -0,0 +1,90 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ysfx.h"
+#include "ysfx_utils.hpp"
+#include "../ysfx_test_utils.hpp"
+#include "ysfx_bench_utils.hpp"
+#include <string>
+#include <cstdio>
+
+// 4 blocks of memory per range, and 3 ranges
+static constexpr uint32_t bench_length = 4 << 16;
+static constexpr uint32_t bench_runs = 20;
+
+struct bench_op {
+    const char *name;
+    // the builtin, and the equivalent loop, over `a`, `b` and `x`
+    const char *builtin;
+    const char *loop;
+};
+
+static const bench_op bench_ops[] = {
+    {"add", "mem_add(x, a, N);", "i = 0; loop(N, x[i] += a[i]; i += 1);"},
+    {"mul", "mem_mul(x, a, N);", "i = 0; loop(N, x[i] *= a[i]; i += 1);"},
+    {"mac", "mem_mac(x, a, b, N);", "i = 0; loop(N, x[i] += a[i] * b[i]; i += 1);"},
+    {"scale", "mem_scale(x, 0.999, N);", "i = 0; loop(N, x[i] *= 0.999; i += 1);"},
+    {"sum", "s = mem_sum(a, N);", "s = 0; i = 0; loop(N, s += a[i]; i += 1);"},
+    {"dot", "s = mem_dot(a, b, N);", "s = 0; i = 0; loop(N, s += a[i] * b[i]; i += 1);"},
+    {"max", "s = mem_max(a, N);", "s = a[0]; i = 0; loop(N, s = max(s, a[i]); i += 1);"},
+    {"absmax", "s = mem_absmax(a, N);", "s = 0; i = 0; loop(N, s = max(s, abs(a[i])); i += 1);"},
+};
+
+// run the code in @block, over ranges which were filled by @init
+static void bench_code(const std::string &name, const char *code)
+{
+    std::string text =
+        "desc:bench" "\n"
+        "options:maxmem=" + std::to_string(4 * bench_length) + "\n"
+        "@init" "\n"
+        "N = " + std::to_string(bench_length) + ";" "\n"
+        "a = 0; b = a + N; x = b + N;" "\n"
+        "i = 0; loop(N, a[i] = sin(i * 0.01); b[i] = cos(i * 0.02); x[i] = 1; i += 1);" "\n"
+        "@block" "\n"
+        + std::string{code} + "\n";
+
+    scoped_new_txt file_main("${root}/Effects/bench.jsfx", text.c_str());
+
+    ysfx_config_u config{ysfx_config_new()};
+    ysfx_u fx{ysfx_new(config.get())};
+    if (!ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0) || !ysfx_compile(fx.get(), 0)) {
+        fprintf(stderr, "%s: cannot compile the effect\n", name.c_str());
+        return;
+    }
+    ysfx_init(fx.get());
+
+    bench_result res = bench_measure(bench_runs, [&fx]() {
+        ysfx_process_double(fx.get(), nullptr, nullptr, 0, 0, 1);
+    });
+    bench_report(name.c_str(), res, (uint64_t)bench_length * sizeof(ysfx_real));
+}
+
+int main()
+{
+    scoped_new_dir root_dir(tests_root_path);
+    scoped_new_dir dir_fx("${root}/Effects");
+
+    printf("Instruction set: %s\n\n", ysfx::get_f64_kernels_isa());
+    bench_report_header();
+
+    for (const bench_op &op : bench_ops) {
+        bench_code(std::string{"mem_"} + op.name, op.builtin);
+        bench_code(std::string{"loop "} + op.name, op.loop);
+    }
+
+    return 0;
+}
@@ -0,0 +1,100 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ysfx.h"
+#include "ysfx_utils.hpp"
+#include "../ysfx_test_utils.hpp"
+#include "ysfx_bench_utils.hpp"
+#include <string>
+#include <vector>
+#include <cstdio>
+
+// an effect which serializes 64 sliders and 16 MB of memory
+static constexpr uint32_t bench_mem_size = 4 << 20;
+static constexpr uint32_t bench_runs = 10;
+
+// the former plugin encoding: sliders as text properties, data as base64
+static std::string legacy_encode(const ysfx_state_t &state)
+{
+    std::string text;
+    char buf[64];
+    for (uint32_t i = 0; i < state.slider_count; ++i) {
+        snprintf(buf, sizeof(buf), "%u=%.17g;", state.sliders[i].index, state.sliders[i].value);
+        text.append(buf);
+    }
+    text.append(ysfx::encode_base64(state.data, state.data_size));
+    return text;
+}
+
+int main()
+{
+    scoped_new_dir root_dir(tests_root_path);
+    scoped_new_dir dir_fx("${root}/Effects");
+
+    std::string text =
+        "desc:bench" "\n"
+        "options:maxmem=" + std::to_string(bench_mem_size) + "\n";
+    for (uint32_t i = 1; i <= ysfx_max_sliders; ++i)
+        text += "slider" + std::to_string(i) + ":0<0,1,0.001>slider " + std::to_string(i) + "\n";
+    text +=
+        "@init" "\n"
+        "i=0; loop(" + std::to_string(bench_mem_size) + ", i[0]=sin(i*0.001); i+=1);" "\n"
+        "@serialize" "\n"
+        "file_mem(0, 0, " + std::to_string(bench_mem_size) + ");" "\n";
+
+    scoped_new_txt file_main("${root}/Effects/bench.jsfx", text.c_str());
+
+    ysfx_config_u config{ysfx_config_new()};
+    ysfx_u fx{ysfx_new(config.get())};
+
+    if (!ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0) || !ysfx_compile(fx.get(), 0)) {
+        fprintf(stderr, "cannot compile the effect\n");
+        return 1;
+    }
+    ysfx_init(fx.get());
+
+    bench_report_header();
+
+    ysfx_state_u state;
+    bench_result res = bench_measure(bench_runs, [&]() { state.reset(ysfx_save_state(fx.get())); });
+    bench_report("save state", res, state->data_size);
+
+    res = bench_measure(bench_runs, [&]() { ysfx_load_state(fx.get(), state.get()); });
+    bench_report("load state", res, state->data_size);
+
+    std::string legacy;
+    res = bench_measure(bench_runs, [&]() { legacy = legacy_encode(*state); });
+    bench_report("encode (legacy text)", res, state->data_size);
+
+    std::vector<uint8_t> binary(ysfx_state_encode(state.get(), nullptr, 0));
+    res = bench_measure(bench_runs, [&]() { ysfx_state_encode(state.get(), binary.data(), binary.size()); });
+    bench_report("encode (binary)", res, state->data_size);
+
+    size_t base64_pos = legacy.rfind(';') + 1;
+    res = bench_measure(bench_runs, [&]() { ysfx::decode_base64(&legacy[base64_pos], legacy.size() - base64_pos); });
+    bench_report("decode (legacy text)", res, state->data_size);
+
+    res = bench_measure(bench_runs, [&]() { ysfx_state_u decoded{ysfx_state_decode(binary.data(), binary.size())}; });
+    bench_report("decode (binary)", res, state->data_size);
+
+    printf("\n");
+    printf("%-40s %12zu bytes\n", "serialized data", state->data_size);
+    printf("%-40s %12zu bytes\n", "encoded size (legacy text)", legacy.size());
+    printf("%-40s %12zu bytes\n", "encoded size (binary)", binary.size());
+
+    return 0;
+}
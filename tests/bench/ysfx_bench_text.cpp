@@ -0,0 +1,121 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ysfx.h"
+#include "ysfx_utils.hpp"
+#include "../ysfx_test_utils.hpp"
+#include "ysfx_bench_utils.hpp"
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+
+// a table of about 10 MB
+static constexpr uint64_t bench_table_size = 10 << 20;
+static constexpr uint32_t bench_runs = 5;
+
+static std::string make_table(const char *fmt)
+{
+    std::string data;
+    data.reserve(bench_table_size + 64);
+    std::mt19937_64 prng;
+    char buf[64];
+    for (uint32_t i = 0; data.size() < bench_table_size; ++i) {
+        double x = std::uniform_real_distribution<double>{-1.0, 1.0}(prng);
+        snprintf(buf, sizeof(buf), fmt, x);
+        data.append(buf);
+        data.push_back((i % 8 == 7) ? '\n' : ',');
+    }
+    return data;
+}
+
+// the character-wise reading, switching locale per number, as the text files used to do it
+static uint32_t reference_parse(const char *path, std::vector<double> &dest)
+{
+    ysfx::FILE_u stream{ysfx::fopen_utf8(path, "rb")};
+    if (!stream)
+        return 0;
+
+    std::string buf;
+    uint32_t count = 0;
+    int ch;
+    do {
+        buf.clear();
+        while ((ch = fgetc(stream.get())) != EOF && ch != '\n' && ch != ',')
+            buf.push_back((unsigned char)ch);
+        const char *startp = buf.c_str();
+        char *endp = (char *)startp;
+#if !defined(_WIN32)
+        ysfx::c_locale_t old = uselocale(ysfx::c_numeric_locale());
+        double value = strtod(startp, &endp);
+        uselocale(old);
+#else
+        double value = _strtod_l(startp, &endp, ysfx::c_numeric_locale());
+#endif
+        if (endp != startp && count < dest.size())
+            dest[count++] = value;
+    } while (ch != EOF);
+
+    return count;
+}
+
+static void bench_table(const char *name, const char *fmt)
+{
+    std::string data = make_table(fmt);
+    scoped_new_txt file_data("${root}/Effects/bench.txt", data.c_str());
+
+    {
+        std::vector<double> dest(bench_table_size);
+        bench_result res = bench_measure(bench_runs, [&]() { reference_parse(file_data.m_path.c_str(), dest); });
+        bench_report((std::string(name) + " reference").c_str(), res, data.size());
+    }
+
+    const char *text =
+        "desc:bench" "\n"
+        "options:maxmem=33554432" "\n"
+        "filename:0,bench.txt" "\n"
+        "@init" "\n"
+        "h=file_open(0);" "\n"
+        "file_mem(h,0,33554432);" "\n"
+        "file_close(h);" "\n";
+
+    scoped_new_txt file_main("${root}/Effects/bench.jsfx", text);
+
+    ysfx_config_u config{ysfx_config_new()};
+    ysfx_u fx{ysfx_new(config.get())};
+
+    if (!ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0) || !ysfx_compile(fx.get(), 0)) {
+        fprintf(stderr, "%s: cannot compile the effect\n", name);
+        return;
+    }
+
+    bench_result res = bench_measure(bench_runs, [&fx]() { ysfx_init(fx.get()); });
+    bench_report((std::string(name) + " file_mem").c_str(), res, data.size());
+}
+
+int main()
+{
+    scoped_new_dir root_dir(tests_root_path);
+    scoped_new_dir dir_fx("${root}/Effects");
+
+    bench_report_header();
+    bench_table("text %.17g", "%.17g");
+    bench_table("text %.6f", "%.6f");
+
+    return 0;
+}
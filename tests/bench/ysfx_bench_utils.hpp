@@ -0,0 +1,67 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+
+//------------------------------------------------------------------------------
+struct bench_result {
+    // the fastest of the measured runs, in seconds
+    double min_time = 0;
+    // the average of the measured runs, in seconds
+    double mean_time = 0;
+};
+
+// run the function once to warm up, then measure it for a number of runs
+template <class F>
+bench_result bench_measure(uint32_t runs, F &&fn)
+{
+    namespace kro = std::chrono;
+
+    fn();
+
+    bench_result res;
+    double total = 0;
+    for (uint32_t i = 0; i < runs; ++i) {
+        kro::steady_clock::time_point t1 = kro::steady_clock::now();
+        fn();
+        kro::steady_clock::time_point t2 = kro::steady_clock::now();
+        double t = kro::duration<double>(t2 - t1).count();
+        res.min_time = (i == 0 || t < res.min_time) ? t : res.min_time;
+        total += t;
+    }
+    res.mean_time = (runs > 0) ? (total / runs) : 0;
+    return res;
+}
+
+// print a line with the timing, and the throughput if the byte count is nonzero
+inline void bench_report(const char *name, const bench_result &res, uint64_t bytes = 0)
+{
+    if (bytes == 0)
+        printf("%-40s %12.3f ms %12.3f ms\n", name, 1e3 * res.min_time, 1e3 * res.mean_time);
+    else {
+        double mbps = (res.min_time > 0) ? (bytes / res.min_time / 1e6) : 0;
+        printf("%-40s %12.3f ms %12.3f ms %10.1f MB/s\n", name, 1e3 * res.min_time, 1e3 * res.mean_time, mbps);
+    }
+}
+
+inline void bench_report_header()
+{
+    printf("%-40s %15s %15s %15s\n", "Benchmark", "Best", "Mean", "Throughput");
+}
@@ -0,0 +1,260 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ysfx.h"
+#include "ysfx_audio_wav.hpp"
+#include "ysfx_audio_cache.hpp"
+#include "ysfx_test_utils.hpp"
+#include <catch.hpp>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <atomic>
+
+static void check_file_mem(ysfx_t *fx, const std::vector<float> &data)
+{
+    REQUIRE(*ysfx_find_var(fx, "n") == (ysfx_real)data.size());
+    std::vector<ysfx_real> mem(data.size());
+    ysfx_read_vmem(fx, 0, mem.data(), (uint32_t)mem.size());
+    for (size_t i = 0; i < data.size(); ++i)
+        REQUIRE(mem[i] == data[i]);
+}
+
+// a format which decodes WAV at half the gain, so that its contents differ
+static ysfx_audio_reader_t *half_wav_open(const char *path)
+{
+    return ysfx_audio_format_wav.open(path);
+}
+
+static uint64_t half_wav_read(ysfx_audio_reader_t *reader, ysfx_real *samples, uint64_t count)
+{
+    uint64_t n = ysfx_audio_format_wav.read(reader, samples, count);
+    for (uint64_t i = 0; i < n; ++i)
+        samples[i] *= 0.5;
+    return n;
+}
+
+// a format which counts the decodings, and which is slow to open
+static std::atomic<uint32_t> slow_wav_opens{0};
+
+static ysfx_audio_reader_t *slow_wav_open(const char *path)
+{
+    ++slow_wav_opens;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    return ysfx_audio_format_wav.open(path);
+}
+
+TEST_CASE("audio cache", "[audiocache]")
+{
+    const char *text =
+        "desc:example" "\n"
+        "filename:0,example.wav" "\n"
+        "@init" "\n"
+        "h=file_open(0);" "\n"
+        "n=file_mem(h,0,file_avail(h));" "\n"
+        "file_close(h);" "\n";
+
+    scoped_new_dir dir_fx("${root}/Effects");
+    scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+    scoped_new_txt wav_file("${root}/Effects/example.wav", nullptr, 0);
+
+    SECTION("share the decoded file")
+    {
+        std::vector<float> data = make_noise(2 * 70000, 1);
+        REQUIRE(write_wav_file(wav_file.m_path, data.data(), 2, 44100, 70000));
+
+        ysfx_audio_cache_u cache{ysfx_audio_cache_new(64 << 20)};
+        ysfx_config_u config{ysfx_config_new()};
+        ysfx_register_builtin_audio_formats(config.get());
+        ysfx_set_audio_cache(config.get(), cache.get());
+
+        ysfx_u fx1 = load_compiled_fx(config.get(), file_main.m_path, true);
+        REQUIRE(fx1);
+        ysfx_u fx2 = load_compiled_fx(config.get(), file_main.m_path, true);
+        REQUIRE(fx2);
+        check_file_mem(fx1.get(), data);
+        check_file_mem(fx2.get(), data);
+
+        REQUIRE(ysfx_audio_cache_get_count(cache.get()) == 1);
+        REQUIRE(ysfx_audio_cache_get_size(cache.get()) == data.size() * sizeof(ysfx_real));
+
+        ysfx_audio_cache_clear(cache.get());
+        REQUIRE(ysfx_audio_cache_get_count(cache.get()) == 0);
+        REQUIRE(ysfx_audio_cache_get_size(cache.get()) == 0);
+    }
+
+    SECTION("distinguish the formats")
+    {
+        std::vector<float> data = make_noise(2 * 1000, 1);
+        REQUIRE(write_wav_file(wav_file.m_path, data.data(), 2, 44100, 1000));
+        std::vector<float> half = data;
+        for (float &x : half)
+            x *= 0.5f;
+
+        ysfx_audio_format_t half_wav = ysfx_audio_format_wav;
+        half_wav.open = &half_wav_open;
+        half_wav.read = &half_wav_read;
+
+        ysfx_audio_cache_u cache{ysfx_audio_cache_new(64 << 20)};
+        ysfx_config_u config1{ysfx_config_new()};
+        ysfx_register_builtin_audio_formats(config1.get());
+        ysfx_set_audio_cache(config1.get(), cache.get());
+        ysfx_config_u config2{ysfx_config_new()};
+        ysfx_register_audio_format_sized(config2.get(), &half_wav, sizeof(half_wav));
+        ysfx_set_audio_cache(config2.get(), cache.get());
+
+        ysfx_u fx1 = load_compiled_fx(config1.get(), file_main.m_path, true);
+        REQUIRE(fx1);
+        ysfx_u fx2 = load_compiled_fx(config2.get(), file_main.m_path, true);
+        REQUIRE(fx2);
+        check_file_mem(fx1.get(), data);
+        check_file_mem(fx2.get(), half);
+
+        REQUIRE(ysfx_audio_cache_get_count(cache.get()) == 2);
+    }
+
+    SECTION("invalidate a modified file")
+    {
+        std::vector<float> data1 = make_noise(2 * 1000, 1);
+        REQUIRE(write_wav_file(wav_file.m_path, data1.data(), 2, 44100, 1000));
+
+        ysfx_audio_cache_u cache{ysfx_audio_cache_new(64 << 20)};
+        ysfx_config_u config{ysfx_config_new()};
+        ysfx_register_builtin_audio_formats(config.get());
+        ysfx_set_audio_cache(config.get(), cache.get());
+
+        ysfx_u fx1 = load_compiled_fx(config.get(), file_main.m_path, true);
+        REQUIRE(fx1);
+        check_file_mem(fx1.get(), data1);
+
+        std::vector<float> data2 = make_noise(2 * 2000, 2);
+        REQUIRE(write_wav_file(wav_file.m_path, data2.data(), 2, 44100, 2000));
+        ysfx_u fx2 = load_compiled_fx(config.get(), file_main.m_path, true);
+        REQUIRE(fx2);
+        check_file_mem(fx2.get(), data2);
+
+        REQUIRE(ysfx_audio_cache_get_count(cache.get()) == 1);
+        REQUIRE(ysfx_audio_cache_get_size(cache.get()) == data2.size() * sizeof(ysfx_real));
+    }
+
+    SECTION("evict over budget")
+    {
+        const char *text2 =
+            "desc:example" "\n"
+            "filename:0,other.wav" "\n"
+            "@init" "\n"
+            "h=file_open(0);" "\n"
+            "n=file_mem(h,0,file_avail(h));" "\n"
+            "file_close(h);" "\n";
+
+        scoped_new_txt file_other("${root}/Effects/other.jsfx", text2);
+        scoped_new_txt wav_other("${root}/Effects/other.wav", nullptr, 0);
+
+        std::vector<float> data1 = make_noise(2 * 1000, 1);
+        REQUIRE(write_wav_file(wav_file.m_path, data1.data(), 2, 44100, 1000));
+        std::vector<float> data2 = make_noise(2 * 1000, 2);
+        REQUIRE(write_wav_file(wav_other.m_path, data2.data(), 2, 44100, 1000));
+
+        // enough for a single one of the files
+        ysfx_audio_cache_u cache{ysfx_audio_cache_new(3000 * sizeof(ysfx_real))};
+        ysfx_config_u config{ysfx_config_new()};
+        ysfx_register_builtin_audio_formats(config.get());
+        ysfx_set_audio_cache(config.get(), cache.get());
+
+        ysfx_u fx1 = load_compiled_fx(config.get(), file_main.m_path, true);
+        REQUIRE(fx1);
+        ysfx_u fx2 = load_compiled_fx(config.get(), file_other.m_path, true);
+        REQUIRE(fx2);
+        check_file_mem(fx1.get(), data1);
+        check_file_mem(fx2.get(), data2);
+
+        REQUIRE(ysfx_audio_cache_get_count(cache.get()) == 1);
+        REQUIRE(ysfx_audio_cache_get_size(cache.get()) == data2.size() * sizeof(ysfx_real));
+
+        // a file larger than the budget is read without the cache
+        ysfx_audio_cache_set_budget(cache.get(), 1000 * sizeof(ysfx_real));
+        REQUIRE(ysfx_audio_cache_get_count(cache.get()) == 0);
+        ysfx_u fx3 = load_compiled_fx(config.get(), file_main.m_path, true);
+        REQUIRE(fx3);
+        check_file_mem(fx3.get(), data1);
+        REQUIRE(ysfx_audio_cache_get_count(cache.get()) == 0);
+    }
+
+    SECTION("decode once for concurrent requesters")
+    {
+        std::vector<float> data = make_noise(2 * 1000, 1);
+        REQUIRE(write_wav_file(wav_file.m_path, data.data(), 2, 44100, 1000));
+
+        ysfx_audio_format_t slow_wav = ysfx_audio_format_wav;
+        slow_wav.open = &slow_wav_open;
+        slow_wav_opens = 0;
+
+        ysfx_audio_cache_u cache{ysfx_audio_cache_new(64 << 20)};
+        const uint32_t num_threads = 4;
+        ysfx_audio_data_ptr results[num_threads];
+        std::thread threads[num_threads];
+        for (uint32_t i = 0; i < num_threads; ++i) {
+            threads[i] = std::thread([&, i]() {
+                results[i] = ysfx_audio_cache_acquire(cache.get(), slow_wav, wav_file.m_path.c_str());
+            });
+        }
+        for (std::thread &thread : threads)
+            thread.join();
+
+        REQUIRE(slow_wav_opens == 1);
+        for (uint32_t i = 0; i < num_threads; ++i) {
+            REQUIRE(results[i]);
+            REQUIRE(results[i] == results[0]);
+        }
+        REQUIRE(results[0]->samples.size() == data.size());
+        REQUIRE(ysfx_audio_cache_get_count(cache.get()) == 1);
+    }
+
+    SECTION("never decode in the processing")
+    {
+        const char *text2 =
+            "desc:example" "\n"
+            "filename:0,example.wav" "\n"
+            "@block" "\n"
+            "h=file_open(0);" "\n"
+            "a=file_avail(h);" "\n"
+            "file_close(h);" "\n";
+
+        scoped_new_txt file_block("${root}/Effects/block.jsfx", text2);
+
+        std::vector<float> data = make_noise(2 * 1000, 1);
+        REQUIRE(write_wav_file(wav_file.m_path, data.data(), 2, 44100, 1000));
+
+        ysfx_audio_cache_u cache{ysfx_audio_cache_new(64 << 20)};
+        ysfx_config_u config{ysfx_config_new()};
+        ysfx_register_builtin_audio_formats(config.get());
+        ysfx_set_audio_cache(config.get(), cache.get());
+
+        ysfx_u fx1 = load_compiled_fx(config.get(), file_block.m_path, true);
+        REQUIRE(fx1);
+        ysfx_process_float(fx1.get(), nullptr, nullptr, 0, 0, 16);
+        REQUIRE(*ysfx_find_var(fx1.get(), "a") == (ysfx_real)data.size());
+        REQUIRE(ysfx_audio_cache_get_count(cache.get()) == 0);
+
+        // the contents which are decoded already are taken from the cache
+        ysfx_u fx2 = load_compiled_fx(config.get(), file_main.m_path, true);
+        REQUIRE(fx2);
+        REQUIRE(ysfx_audio_cache_get_count(cache.get()) == 1);
+        ysfx_process_float(fx1.get(), nullptr, nullptr, 0, 0, 16);
+        REQUIRE(*ysfx_find_var(fx1.get(), "a") == (ysfx_real)data.size());
+    }
+}
@@ -0,0 +1,202 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ysfx.h"
+#include "ysfx_test_utils.hpp"
+#include "ysfx_audio_stream.hpp"
+#include "ysfx_audio_wav.hpp"
+#include <catch.hpp>
+#include <thread>
+#include <chrono>
+
+TEST_CASE("audio stream", "[audiostream]")
+{
+    const uint32_t channels = 2;
+    const uint32_t sample_rate = 44100;
+    uint64_t totalframes = 70000;
+    uint64_t totalsmpls = channels * totalframes;
+    std::vector<float> data = make_noise(totalsmpls);
+
+    scoped_new_dir dir_fx("${root}/Effects");
+    scoped_new_txt wav_file("${root}/Effects/example.wav", nullptr, 0);
+    REQUIRE(write_wav_file(wav_file.m_path, data.data(), channels, sample_rate, totalframes));
+
+    const uint32_t read_ahead = 4096;
+
+    SECTION("read the stream entirely")
+    {
+        ysfx_audio_streamer_t streamer;
+        ysfx_audio_stream_ptr stream = streamer.open(ysfx_audio_format_wav, wav_file.m_path.c_str(), read_ahead);
+        REQUIRE(stream);
+        REQUIRE(stream->info().channels == channels);
+        REQUIRE(stream->info().sample_rate == sample_rate);
+
+        std::unique_ptr<ysfx_real[]> buf{new ysfx_real[(size_t)totalsmpls]};
+
+        // do once, and redo after rewinding in the middle
+        for (uint64_t stop : {totalsmpls / 3, totalsmpls}) {
+            uint64_t smplpos = 0;
+            while (smplpos < stop) {
+                REQUIRE(stream->avail() == totalsmpls - smplpos);
+                uint32_t n = (uint32_t)std::min<uint64_t>(1000, stop - smplpos);
+                bool underrun = false;
+                uint32_t m = stream->read(&buf[(size_t)smplpos], n, underrun);
+                REQUIRE(underrun == (m < n));
+                smplpos += m;
+                if (underrun)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            for (size_t i = 0; i < (size_t)stop; ++i)
+                REQUIRE(buf[i] == data[i]);
+            stream->rewind();
+        }
+
+        bool underrun = false;
+        REQUIRE(stream->avail() == totalsmpls);
+        REQUIRE(stream->read(buf.get(), read_ahead, underrun) == read_ahead);
+        REQUIRE(!underrun);
+
+        streamer.close(stream);
+    }
+
+    SECTION("seek in the stream")
+    {
+        ysfx_audio_streamer_t streamer;
+        ysfx_audio_stream_ptr stream = streamer.open(ysfx_audio_format_wav, wav_file.m_path.c_str(), read_ahead);
+        REQUIRE(stream);
+
+        std::unique_ptr<ysfx_real[]> buf{new ysfx_real[1000]};
+
+        // positions both within the head and past it
+        for (uint64_t position : {(uint64_t)100001, (uint64_t)17, (uint64_t)50000, (uint64_t)4000}) {
+            stream->seek(position);
+            REQUIRE(stream->avail() == totalsmpls - position);
+
+            uint32_t numread = 0;
+            while (numread < 1000) {
+                bool underrun = false;
+                numread += stream->read(&buf[numread], 1000 - numread, underrun);
+                if (underrun)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            for (size_t i = 0; i < 1000; ++i)
+                REQUIRE(buf[i] == data[(size_t)position + i]);
+        }
+
+        streamer.close(stream);
+    }
+
+    SECTION("stream from the effect")
+    {
+        const char *text =
+            "desc:example" "\n"
+            "filename:0,example.wav" "\n"
+            "@init" "\n"
+            "h=file_open(0);" "\n"
+            "a=file_avail(h);" "\n"
+            "n=file_mem(h,0,4096);" "\n"
+            "file_close(h);" "\n";
+
+        scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+
+        ysfx_config_u config{ysfx_config_new()};
+        ysfx_register_builtin_audio_formats(config.get());
+        ysfx_set_audio_read_ahead(config.get(), read_ahead);
+        ysfx_u fx{ysfx_new(config.get())};
+
+        REQUIRE(ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0));
+        REQUIRE(ysfx_compile(fx.get(), 0));
+        ysfx_init(fx.get());
+
+        // the head of the file is ready at once
+        REQUIRE(*ysfx_find_var(fx.get(), "a") == (ysfx_real)totalsmpls);
+        REQUIRE(*ysfx_find_var(fx.get(), "n") == 4096);
+        REQUIRE(ysfx_get_audio_underruns(fx.get()) == 0);
+
+        std::unique_ptr<ysfx_real[]> mem{new ysfx_real[4096]};
+        ysfx_read_vmem(fx.get(), 0, mem.get(), 4096);
+        for (size_t i = 0; i < 4096; ++i)
+            REQUIRE(mem[i] == data[i]);
+    }
+
+    SECTION("read synchronously outside of the audio sections")
+    {
+        const char *text =
+            "desc:example" "\n"
+            "filename:0,example.wav" "\n"
+            "@init" "\n"
+            "h=file_open(0);" "\n"
+            "n=file_mem(h,0,file_avail(h));" "\n"
+            "file_rewind(h);" "\n"
+            "v=0; sum=0; while(file_var(h,x)) (v+=1; sum+=x);" "\n"
+            "file_close(h);" "\n";
+
+        scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+
+        ysfx_config_u config{ysfx_config_new()};
+        ysfx_register_builtin_audio_formats(config.get());
+        ysfx_set_audio_read_ahead(config.get(), read_ahead);
+        ysfx_u fx{ysfx_new(config.get())};
+
+        REQUIRE(ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0));
+        REQUIRE(ysfx_compile(fx.get(), 0));
+        ysfx_init(fx.get());
+
+        // @init waits for the decoder, rather than reading past the ready samples
+        REQUIRE(*ysfx_find_var(fx.get(), "n") == (ysfx_real)totalsmpls);
+        REQUIRE(*ysfx_find_var(fx.get(), "v") == (ysfx_real)totalsmpls);
+        REQUIRE(ysfx_get_audio_underruns(fx.get()) == 0);
+
+        std::unique_ptr<ysfx_real[]> mem{new ysfx_real[(size_t)totalsmpls]};
+        ysfx_read_vmem(fx.get(), 0, mem.get(), (uint32_t)totalsmpls);
+        ysfx_real sum = 0;
+        for (size_t i = 0; i < (size_t)totalsmpls; ++i) {
+            REQUIRE(mem[i] == data[i]);
+            sum += data[i];
+        }
+        REQUIRE(*ysfx_find_var(fx.get(), "sum") == Approx(sum));
+    }
+
+    SECTION("open in the processing")
+    {
+        const char *text =
+            "desc:example" "\n"
+            "filename:0,example.wav" "\n"
+            "@block" "\n"
+            "!opened ? (h=file_open(0); opened=1);" "\n"
+            "a=file_avail(h);" "\n";
+
+        scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+
+        ysfx_config_u config{ysfx_config_new()};
+        ysfx_register_builtin_audio_formats(config.get());
+        ysfx_set_audio_read_ahead(config.get(), read_ahead);
+        ysfx_u fx{ysfx_new(config.get())};
+
+        REQUIRE(ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0));
+        REQUIRE(ysfx_compile(fx.get(), 0));
+        ysfx_init(fx.get());
+
+        // the file is opened by the worker, and is empty until then
+        for (int i = 0; i < 1000 && *ysfx_find_var(fx.get(), "a") != (ysfx_real)totalsmpls; ++i) {
+            ysfx_process_float(fx.get(), nullptr, nullptr, 0, 0, 16);
+            REQUIRE(*ysfx_find_var(fx.get(), "h") >= 0);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        REQUIRE(*ysfx_find_var(fx.get(), "a") == (ysfx_real)totalsmpls);
+    }
+}
@@ -20,21 +20,6 @@
 #include "ysfx_audio_wav.hpp"
 #include "ysfx_utils.hpp"
 #include <catch.hpp>
-#include <random>
-
-#if defined(__GNUC__)
-#   pragma GCC diagnostic push
-#   pragma GCC diagnostic ignored "-Wunused-function"
-#endif
-
-#define DR_WAV_IMPLEMENTATION
-#define DRWAV_API static
-#define DRWAV_PRIVATE static
-#include "dr_wav.h"
-
-#if defined(__GNUC__)
-#   pragma GCC diagnostic pop
-#endif
 
 TEST_CASE("wav audio format", "[wav]")
 {
@@ -43,31 +28,15 @@ TEST_CASE("wav audio format", "[wav]")
         scoped_new_txt wav_file("${root}/example.wav", nullptr, 0);
         REQUIRE(ysfx_audio_format_wav.can_handle(wav_file.m_path.c_str()));
 
-        drwav_data_format fmt{};
-        fmt.container = drwav_container_riff;
-        fmt.format = DR_WAVE_FORMAT_IEEE_FLOAT;
-        fmt.channels = 8;
-        fmt.sampleRate = 44100;
-        fmt.bitsPerSample = 32;
+        const uint32_t channels = 8;
+        const uint32_t sample_rate = 44100;
         uint64_t totalframes = 1024;
-        uint64_t totalsmpls = fmt.channels * totalframes;
-        std::unique_ptr<float[]> data{new float[(size_t)totalsmpls]};
-
-        {
-            std::mt19937_64 prng;
-            for (size_t i = 0; i < (size_t)totalsmpls; ++i)
-                data[i] = std::uniform_real_distribution<float>{-1.0f, 1.0f}(prng);
-        }
-        {
-            drwav wav;
-            REQUIRE(drwav_init_file_write(&wav, wav_file.m_path.c_str(), &fmt, nullptr));
-            uint64_t written = drwav_write_pcm_frames(&wav, totalframes, data.get());
-            drwav_uninit(&wav);
-            REQUIRE(written == totalframes);
-        }
+        uint64_t totalsmpls = channels * totalframes;
+        std::vector<float> data = make_noise(totalsmpls);
+        REQUIRE(write_wav_file(wav_file.m_path, data.data(), channels, sample_rate, totalframes));
 
         // try reading in various buffer sizes
-        for (uint32_t bufsize = 1; bufsize <= fmt.channels; ++bufsize) {
+        for (uint32_t bufsize = 1; bufsize <= channels; ++bufsize) {
             ysfx_audio_reader_t *reader = ysfx_audio_format_wav.open(wav_file.m_path.c_str());
             REQUIRE(reader);
             auto reader_cleanup = ysfx::defer([reader]() { ysfx_audio_format_wav.close(reader); });
@@ -75,8 +44,8 @@ TEST_CASE("wav audio format", "[wav]")
             std::unique_ptr<ysfx_real[]> buf{new ysfx_real[bufsize]};
 
             ysfx_audio_file_info_t info = ysfx_audio_format_wav.info(reader);
-            REQUIRE(info.sample_rate == fmt.sampleRate);
-            REQUIRE(info.channels == fmt.channels);
+            REQUIRE(info.sample_rate == sample_rate);
+            REQUIRE(info.channels == channels);
 
             // do once, and redo after rewind
             for (int time = 0; time < 2; ++time) {
@@ -97,4 +66,99 @@ TEST_CASE("wav audio format", "[wav]")
             }
         }
     }
+
+    SECTION("load wav file into memory")
+    {
+        const uint32_t channels = 2;
+        const uint32_t sample_rate = 44100;
+        // large enough to span multiple RAM blocks
+        uint64_t totalframes = 70000;
+        uint64_t totalsmpls = channels * totalframes;
+        std::vector<float> data = make_noise(totalsmpls);
+
+        const char *text =
+            "desc:example" "\n"
+            "filename:0,example.wav" "\n"
+            "@init" "\n"
+            "h=file_open(0);" "\n"
+            "n=file_mem(h,1000,file_avail(h));" "\n"
+            "file_close(h);" "\n";
+
+        scoped_new_dir dir_fx("${root}/Effects");
+        scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+        scoped_new_txt wav_file("${root}/Effects/example.wav", nullptr, 0);
+
+        REQUIRE(write_wav_file(wav_file.m_path, data.data(), channels, sample_rate, totalframes));
+
+        ysfx_config_u config{ysfx_config_new()};
+        ysfx_register_builtin_audio_formats(config.get());
+        ysfx_u fx{ysfx_new(config.get())};
+
+        REQUIRE(ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0));
+        REQUIRE(ysfx_compile(fx.get(), 0));
+        ysfx_init(fx.get());
+
+        REQUIRE(*ysfx_find_var(fx.get(), "n") == (ysfx_real)totalsmpls);
+
+        std::unique_ptr<ysfx_real[]> mem{new ysfx_real[(size_t)totalsmpls]};
+        ysfx_read_vmem(fx.get(), 1000, mem.get(), (uint32_t)totalsmpls);
+        for (size_t i = 0; i < (size_t)totalsmpls; ++i)
+            REQUIRE(mem[i] == data[i]);
+    }
+
+    SECTION("seek in wav file")
+    {
+        const uint32_t channels = 2;
+        const uint32_t sample_rate = 44100;
+        uint64_t totalframes = 1024;
+        uint64_t totalsmpls = channels * totalframes;
+        std::vector<float> data = make_noise(totalsmpls);
+
+        const char *text =
+            "desc:example" "\n"
+            "filename:0,example.wav" "\n"
+            "@init" "\n"
+            "h=file_open(0);" "\n"
+            "s1=file_seek(h,1001);" "\n"
+            "a1=file_avail(h);" "\n"
+            "file_var(h,v1);" "\n"
+            "s2=file_seek(h,10);" "\n"
+            "file_var(h,v2);" "\n"
+            "file_close(h);" "\n";
+
+        scoped_new_dir dir_fx("${root}/Effects");
+        scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+        scoped_new_txt wav_file("${root}/Effects/example.wav", nullptr, 0);
+
+        REQUIRE(write_wav_file(wav_file.m_path, data.data(), channels, sample_rate, totalframes));
+
+        {
+            ysfx_audio_reader_t *reader = ysfx_audio_format_wav.open(wav_file.m_path.c_str());
+            REQUIRE(reader);
+            auto reader_cleanup = ysfx::defer([reader]() { ysfx_audio_format_wav.close(reader); });
+
+            ysfx_real smpl = 0;
+            REQUIRE(ysfx_audio_format_wav.seek(reader, 500));
+            REQUIRE(ysfx_audio_format_wav.avail(reader) == totalsmpls - 1000);
+            REQUIRE(ysfx_audio_format_wav.read(reader, &smpl, 1) == 1);
+            REQUIRE(smpl == data[1000]);
+            REQUIRE(ysfx_audio_format_wav.seek(reader, 3));
+            REQUIRE(ysfx_audio_format_wav.read(reader, &smpl, 1) == 1);
+            REQUIRE(smpl == data[6]);
+        }
+
+        ysfx_config_u config{ysfx_config_new()};
+        ysfx_register_builtin_audio_formats(config.get());
+        ysfx_u fx{ysfx_new(config.get())};
+
+        REQUIRE(ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0));
+        REQUIRE(ysfx_compile(fx.get(), 0));
+        ysfx_init(fx.get());
+
+        REQUIRE(*ysfx_find_var(fx.get(), "s1") == 1);
+        REQUIRE(*ysfx_find_var(fx.get(), "a1") == (ysfx_real)(totalsmpls - 1001));
+        REQUIRE(*ysfx_find_var(fx.get(), "v1") == data[1001]);
+        REQUIRE(*ysfx_find_var(fx.get(), "s2") == 1);
+        REQUIRE(*ysfx_find_var(fx.get(), "v2") == data[10]);
+    }
 }
@@ -0,0 +1,234 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ysfx.h"
+#include "ysfx_convolver.hpp"
+#include "ysfx_test_utils.hpp"
+#include <catch.hpp>
+#include <random>
+#include <vector>
+#include <cmath>
+
+static std::vector<double> direct_convolution(const std::vector<double> &x, const std::vector<double> &h)
+{
+    std::vector<double> y(x.size());
+    for (size_t j = 0; j < h.size(); ++j) {
+        if (h[j] == 0)
+            continue;
+        for (size_t i = j; i < x.size(); ++i)
+            y[i] += h[j] * x[i - j];
+    }
+    return y;
+}
+
+// filter in blocks of random sizes, which do not align with the partitions
+static std::vector<double> run_convolver(ysfx_convolver_t &conv, std::vector<double> x, uint64_t seed)
+{
+    std::mt19937_64 prng{seed};
+    for (size_t i = 0; i < x.size(); ) {
+        uint32_t n = std::uniform_int_distribution<uint32_t>{1, 700}(prng);
+        n = (uint32_t)std::min<size_t>(n, x.size() - i);
+        conv.process(&x[i], n);
+        i += n;
+    }
+    return x;
+}
+
+TEST_CASE("convolver", "[convolve]")
+{
+    std::mt19937_64 prng;
+    auto noise = [&prng](size_t count) -> std::vector<double> {
+        std::vector<double> data(count);
+        for (double &value : data)
+            value = std::uniform_real_distribution<double>{-1.0, 1.0}(prng);
+        return data;
+    };
+
+    SECTION("dense responses")
+    {
+        // the head only, then the first stage, then some of the worker stages
+        for (uint32_t length : {0, 1, 50, 64, 65, 128, 500, 513, 2048, 3000, 9000}) {
+            INFO("length: " << length);
+            std::vector<double> h = noise(length);
+            std::vector<double> x = noise(3 * length + 1000);
+            ysfx_convolver_t conv{h.data(), length};
+            REQUIRE(conv.length() == length);
+            REQUIRE(max_difference(run_convolver(conv, x, length), direct_convolution(x, h)) < 1e-10);
+        }
+    }
+
+    SECTION("long sparse response")
+    {
+        // all the stages, including the last which repeats the largest partition
+        const uint32_t length = 100000;
+        std::vector<double> h(length);
+        std::vector<double> head = noise(700);
+        std::copy(head.begin(), head.end(), h.begin());
+        for (uint32_t i = 700; i < length; i += 97)
+            h[i] = std::uniform_real_distribution<double>{-1.0, 1.0}(prng);
+        h[length - 1] = 0.5;
+
+        std::vector<double> x = noise(130000);
+        ysfx_convolver_t conv{h.data(), length};
+        REQUIRE(max_difference(run_convolver(conv, x, 1), direct_convolution(x, h)) < 1e-10);
+    }
+
+    SECTION("reset")
+    {
+        std::vector<double> h = noise(5000);
+        std::vector<double> x = noise(12000);
+        ysfx_convolver_t conv{h.data(), 5000};
+        std::vector<double> first = run_convolver(conv, x, 1);
+        conv.reset();
+        std::vector<double> second = run_convolver(conv, x, 2);
+        REQUIRE(max_difference(first, second) < 1e-12);
+    }
+
+    SECTION("without waiting")
+    {
+        // the result is exact, unless some partitions were late
+        std::vector<double> h = noise(20000);
+        std::vector<double> x = noise(50000);
+        std::vector<double> y = x;
+        ysfx_convolver_t conv{h.data(), 20000};
+        uint32_t late = 0;
+        for (size_t i = 0; i < y.size(); i += 64)
+            late += conv.process(&y[i], (uint32_t)std::min<size_t>(64, y.size() - i), false);
+        REQUIRE((late > 0 || max_difference(y, direct_convolution(x, h)) < 1e-10));
+    }
+
+    SECTION("freed while computing")
+    {
+        std::vector<double> h = noise(100000);
+        std::vector<double> x = noise(40000);
+        for (int i = 0; i < 8; ++i) {
+            ysfx_convolver_u conv{new ysfx_convolver_t(h.data(), 100000)};
+            conv->process(x.data(), (uint32_t)x.size(), false);
+        }
+    }
+}
+
+TEST_CASE("convolver functions", "[convolve]")
+{
+    const char *text =
+        "desc:example" "\n"
+        "filename:0,example.wav" "\n"
+        "@init" "\n"
+        "ir = 1000; buf = 2000;" "\n"
+        "ir[0] = 1; ir[1] = 0.5; ir[2] = -0.25;" "\n"
+        "c = conv_new(ir, 3);" "\n"
+        "buf[0] = 1; buf[1] = 2;" "\n"
+        "conv_process(c, buf, 2);" "\n"
+        "conv_process(c, buf + 2, 2);" "\n"
+        "conv_reset(c);" "\n"
+        "buf[4] = 4;" "\n"
+        "conv_process(c, buf + 4, 2);" "\n"
+        "free_ok = conv_free(c);" "\n"
+        "free_again = conv_free(c);" "\n"
+        "h = file_open(0);" "\n"
+        "bad_channel = conv_new_file(h, 2);" "\n"
+        "w = conv_new_file(h, 1);" "\n"
+        "file_close(h);" "\n"
+        "out = 10000; out[0] = 1;" "\n"
+        "conv_process(w, out, 600);" "\n";
+
+    scoped_new_dir dir_fx("${root}/Effects");
+    scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+    scoped_new_txt file_wav("${root}/Effects/example.wav", nullptr, 0);
+
+    // a stereo response, of which the second channel is used
+    const uint32_t frames = 500;
+    std::vector<float> data = make_noise(2 * frames);
+    REQUIRE(write_wav_file(file_wav.m_path, data.data(), 2, 44100, frames));
+
+    ysfx_config_u config{ysfx_config_new()};
+    ysfx_register_builtin_audio_formats(config.get());
+    ysfx_u fx{ysfx_new(config.get())};
+    REQUIRE(ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0));
+    REQUIRE(ysfx_compile(fx.get(), 0));
+    ysfx_init(fx.get());
+
+    auto var = [&fx](const char *name) -> ysfx_real { return *ysfx_find_var(fx.get(), name); };
+
+    REQUIRE(var("c") >= 0);
+    REQUIRE(var("free_ok") == 0);
+    REQUIRE(var("free_again") == -1);
+    REQUIRE(var("bad_channel") == -1);
+    REQUIRE(var("w") >= 0);
+
+    // the state continues across the calls, until it is reset
+    ysfx_real buf[6] = {};
+    ysfx_read_vmem(fx.get(), 2000, buf, 6);
+    REQUIRE(buf[0] == Approx(1));
+    REQUIRE(buf[1] == Approx(2.5));
+    REQUIRE(buf[2] == Approx(0.75));
+    REQUIRE(buf[3] == Approx(-0.5));
+    REQUIRE(buf[4] == Approx(4));
+    REQUIRE(buf[5] == Approx(2));
+
+    std::vector<ysfx_real> out(600);
+    ysfx_read_vmem(fx.get(), 10000, out.data(), 600);
+    for (uint32_t i = 0; i < frames; ++i)
+        REQUIRE(out[i] == Approx(data[2 * i + 1]).margin(1e-12));
+    for (uint32_t i = frames; i < 600; ++i)
+        REQUIRE(std::fabs(out[i]) < 1e-12);
+}
+
+TEST_CASE("convolver functions in the processing", "[convolve]")
+{
+    // the long response has a worker, which is freed without waiting
+    const char *text =
+        "desc:example" "\n"
+        "out_pin:output" "\n"
+        "@init" "\n"
+        "ir = 1000;" "\n"
+        "i = 0; loop(5000, ir[i] = 1 / (1 + i); i += 1);" "\n"
+        "c = conv_new(ir, 5000);" "\n"
+        "made = freed = -2;" "\n"
+        "@block" "\n"
+        "made == -2 ? (" "\n"
+        "  made = conv_new(ir, 3);" "\n"
+        "  buf = 10000; buf[0] = 1;" "\n"
+        "  conv_process(c, buf, 64);" "\n"
+        "  freed = conv_free(c);" "\n"
+        ");" "\n";
+
+    scoped_new_dir dir_fx("${root}/Effects");
+    scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+
+    ysfx_config_u config{ysfx_config_new()};
+    ysfx_u fx{ysfx_new(config.get())};
+    REQUIRE(ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0));
+    REQUIRE(ysfx_compile(fx.get(), 0));
+    ysfx_init(fx.get());
+
+    auto var = [&fx](const char *name) -> ysfx_real { return *ysfx_find_var(fx.get(), name); };
+
+    REQUIRE(var("c") >= 0);
+
+    float out[16] = {};
+    float *outs[] = {out};
+    ysfx_process_float(fx.get(), nullptr, outs, 0, 1, 16);
+
+    REQUIRE(var("made") == -1);
+    REQUIRE(var("freed") == 0);
+
+    ysfx_real buf[2] = {};
+    ysfx_read_vmem(fx.get(), 10000, buf, 2);
+    REQUIRE(buf[0] == Approx(1));
+    REQUIRE(buf[1] == Approx(0.5));
+}
@@ -0,0 +1,243 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ysfx.h"
+#include "ysfx.hpp"
+#include "ysfx_utils_simd.hpp"
+#include "ysfx_test_utils.hpp"
+#include "WDL/fft.h"
+#include <catch.hpp>
+#include <random>
+#include <vector>
+#include <cmath>
+
+static std::vector<double> make_signal(size_t count, uint64_t seed)
+{
+    std::vector<double> data(count);
+    std::mt19937_64 prng{seed};
+    for (size_t i = 0; i < count; ++i)
+        data[i] = std::uniform_real_distribution<double>{-1.0, 1.0}(prng);
+    return data;
+}
+
+TEST_CASE("fft", "[fft]")
+{
+    WDL_fft_init();
+    ysfx::fft_init();
+
+    SECTION("permutation")
+    {
+        for (uint32_t bits = 1; bits <= 15; ++bits) {
+            const uint32_t n = 1u << bits;
+            const uint32_t *perm = ysfx::fft_permutation(bits);
+            const int *ref = WDL_fft_permute_tab((int)n);
+            for (uint32_t i = 0; i < n; ++i)
+                REQUIRE(perm[i] == (uint32_t)ref[i]);
+
+            // permute in place, and back
+            std::vector<double> x(2 * n);
+            for (uint32_t i = 0; i < n; ++i)
+                x[2 * perm[i]] = x[2 * perm[i] + 1] = i;
+            ysfx::fft_permute(x.data(), bits, false);
+            for (uint32_t i = 0; i < n; ++i)
+                REQUIRE((x[2 * i] == i && x[2 * i + 1] == i));
+            ysfx::fft_permute(x.data(), bits, true);
+            for (uint32_t i = 0; i < n; ++i)
+                REQUIRE((x[2 * perm[i]] == i && x[2 * perm[i] + 1] == i));
+        }
+    }
+
+    SECTION("complex")
+    {
+        for (uint32_t bits = 1; bits <= 15; ++bits) {
+            INFO("bits: " << bits);
+            const size_t n = (size_t)1 << bits;
+            const double tolerance = 1e-14 * n;
+
+            std::vector<double> x = make_signal(2 * n, bits);
+            std::vector<double> y = x;
+            ysfx::fft_complex(x.data(), bits, false);
+            WDL_fft((WDL_FFT_COMPLEX *)y.data(), (int)n, false);
+            REQUIRE(max_difference(x, y) < tolerance);
+
+            x = y = make_signal(2 * n, bits + 100);
+            ysfx::fft_complex(x.data(), bits, true);
+            WDL_fft((WDL_FFT_COMPLEX *)y.data(), (int)n, true);
+            REQUIRE(max_difference(x, y) < tolerance);
+        }
+    }
+
+    SECTION("real")
+    {
+        for (uint32_t bits = 2; bits <= 15; ++bits) {
+            INFO("bits: " << bits);
+            const size_t n = (size_t)1 << bits;
+            const double tolerance = 1e-14 * n;
+
+            std::vector<double> x = make_signal(n, bits);
+            std::vector<double> y = x;
+            ysfx::fft_real(x.data(), bits, false);
+            WDL_real_fft(y.data(), (int)n, false);
+            REQUIRE(max_difference(x, y) < tolerance);
+
+            x = y = make_signal(n, bits + 100);
+            ysfx::fft_real(x.data(), bits, true);
+            WDL_real_fft(y.data(), (int)n, true);
+            REQUIRE(max_difference(x, y) < tolerance);
+        }
+    }
+
+    SECTION("largest size")
+    {
+        // no reference, so check the round trip and a tone
+        const uint32_t bits = ysfx::fft_max_bits;
+        const size_t n = (size_t)1 << bits;
+        const uint32_t *perm = ysfx::fft_permutation(bits);
+
+        std::vector<double> x = make_signal(2 * n, 1);
+        std::vector<double> y = x;
+        ysfx::fft_complex(y.data(), bits, false);
+        ysfx::fft_complex(y.data(), bits, true);
+        for (double &value : y)
+            value /= n;
+        REQUIRE(max_difference(x, y) < 1e-12);
+
+        const double pi = 3.14159265358979323846;
+        const size_t bin = 1234;
+        for (size_t i = 0; i < n; ++i) {
+            x[2 * i] = std::cos(2 * pi * bin * i / n);
+            x[2 * i + 1] = std::sin(2 * pi * bin * i / n);
+        }
+        ysfx::fft_complex(x.data(), bits, false);
+        REQUIRE(x[2 * perm[bin]] == Approx(n));
+        REQUIRE(std::fabs(x[2 * perm[bin + 1]]) < 1e-6);
+
+        x = make_signal(n, 2);
+        y = x;
+        ysfx::fft_real(y.data(), bits, false);
+        ysfx::fft_real(y.data(), bits, true);
+        for (double &value : y)
+            value /= 2 * n;
+        REQUIRE(max_difference(x, y) < 1e-12);
+    }
+}
+
+static void check_fft_kernels(const ysfx::f64_kernels &k)
+{
+    // the twiddle factors, as the transform expects them
+    std::vector<double> tables[ysfx::fft_max_bits + 1];
+    const double *tw[ysfx::fft_max_bits + 1] = {};
+    for (uint32_t bits = 2; bits <= 12; ++bits) {
+        const size_t n = (size_t)1 << bits;
+        for (size_t m = 0; m < n / 4; ++m) {
+            tables[bits].push_back(std::cos(2 * 3.14159265358979323846 * m / n));
+            tables[bits].push_back(std::sin(2 * 3.14159265358979323846 * m / n));
+        }
+        tw[bits] = tables[bits].data();
+    }
+
+    for (uint32_t bits = 1; bits <= 12; ++bits) {
+        INFO("bits: " << bits);
+        const size_t n = (size_t)1 << bits;
+        for (bool inverse : {false, true}) {
+            std::vector<double> x = make_signal(2 * n, bits);
+            std::vector<double> y = x;
+            k.fft(x.data(), bits, tw, inverse);
+            WDL_fft((WDL_FFT_COMPLEX *)y.data(), (int)n, inverse);
+            REQUIRE(max_difference(x, y) < 1e-14 * n);
+        }
+    }
+}
+
+TEST_CASE("fft kernels", "[fft]")
+{
+    WDL_fft_init();
+
+    INFO("instruction set: " << ysfx::get_f64_kernels_isa());
+    check_fft_kernels(ysfx::get_f64_kernels());
+    check_fft_kernels(ysfx::make_f64_kernels<ysfx::vec_scalar, ysfx::cvec_scalar>());
+#if defined(YSFX_SIMD_SSE2)
+    check_fft_kernels(ysfx::make_f64_kernels<ysfx::vec_sse2, ysfx::cvec_sse2>());
+#elif defined(YSFX_SIMD_NEON64)
+    check_fft_kernels(ysfx::make_f64_kernels<ysfx::vec_neon64, ysfx::cvec_neon64>());
+#endif
+}
+
+TEST_CASE("fft functions", "[fft]")
+{
+    // the transforms of 65536 points cross the boundary of the first block
+    const char *text =
+        "desc:example" "\n"
+        "options:maxmem=1048576" "\n"
+        "@init" "\n"
+        "N = 65536;" "\n"
+        "a = 1000; b = a + 2 * N;" "\n"
+        "i = 0; loop(2 * N, a[i] = b[i] = sin(i * 0.37); i += 1);" "\n"
+        "fft(a, N); fft_permute(a, N);" "\n"
+        "fft_ipermute(a, N); ifft(a, N);" "\n"
+        "err_big = 0; i = 0; loop(2 * N, err_big = max(err_big, abs(a[i] / N - b[i])); i += 1);" "\n"
+        "" "\n"
+        "c = 200000; M = 256;" "\n"
+        "i = 0; loop(M, c[i] = sin(i * 0.1); i += 1);" "\n"
+        "fft_real(c, M);" "\n"
+        "dc = c[0];" "\n"
+        "ifft_real(c, M);" "\n"
+        "err_real = 0; i = 0; loop(M, err_real = max(err_real, abs(c[i] / (2 * M) - sin(i * 0.1))); i += 1);" "\n"
+        "" "\n"
+        "d = 300000; e = d + 16;" "\n"
+        "d[0] = 1; d[1] = 2; d[2] = 3; d[3] = 4; d[4] = 5; d[5] = 6;" "\n"
+        "e[0] = 2; e[1] = 1; e[2] = 0; e[3] = 1; e[4] = 7; e[5] = 7;" "\n"
+        "convolve_c(d, e, 3);" "\n";
+
+    scoped_new_dir dir_fx("${root}/Effects");
+    scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+
+    ysfx_config_u config{ysfx_config_new()};
+    ysfx_u fx{ysfx_new(config.get())};
+    REQUIRE(ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0));
+    REQUIRE(ysfx_compile(fx.get(), 0));
+
+    // the copies of the transforms are allocated before the code runs
+    const ysfx_real *scratch_data[3];
+    for (uint32_t i = 0; i < 3; ++i) {
+        REQUIRE(fx->fft.scratch[i].size() >= 2 * 65536);
+        scratch_data[i] = fx->fft.scratch[i].data();
+    }
+    ysfx_init(fx.get());
+    for (uint32_t i = 0; i < 3; ++i)
+        REQUIRE(fx->fft.scratch[i].data() == scratch_data[i]);
+
+    auto var = [&fx](const char *name) -> ysfx_real { return *ysfx_find_var(fx.get(), name); };
+
+    REQUIRE(var("err_big") < 1e-12);
+    REQUIRE(var("err_real") < 1e-12);
+
+    double dc = 0;
+    for (int i = 0; i < 256; ++i)
+        dc += std::sin(i * 0.1);
+    REQUIRE(var("dc") == Approx(2 * dc));
+
+    // an even number of pairs is multiplied, like the original
+    ysfx_real d[6] = {};
+    ysfx_read_vmem(fx.get(), 300000, d, 6);
+    REQUIRE(d[0] == 1 * 2 - 2 * 1);
+    REQUIRE(d[1] == 2 * 2 + 1 * 1);
+    REQUIRE(d[2] == 3 * 0 - 4 * 1);
+    REQUIRE(d[3] == 4 * 0 + 3 * 1);
+    REQUIRE(d[4] == 5);
+    REQUIRE(d[5] == 6);
+}
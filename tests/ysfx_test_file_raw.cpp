@@ -0,0 +1,142 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ysfx.h"
+#include "ysfx_utils.hpp"
+#include "ysfx_test_utils.hpp"
+#include <catch.hpp>
+#if !defined(_WIN32)
+#   include <unistd.h>
+#endif
+#include <random>
+#include <vector>
+
+TEST_CASE("raw data file", "[raw]")
+{
+    // large enough to span multiple RAM blocks
+    const uint32_t count = 70000;
+    std::vector<float> data(count);
+    std::vector<uint8_t> bytes(4 * count);
+
+    {
+        std::mt19937_64 prng;
+        for (uint32_t i = 0; i < count; ++i) {
+            data[i] = std::uniform_real_distribution<float>{-1.0f, 1.0f}(prng);
+            ysfx::pack_f32le(data[i], &bytes[4 * i]);
+        }
+    }
+
+    scoped_new_dir dir_fx("${root}/Effects");
+    scoped_new_txt raw_file("${root}/Effects/example.raw", (const char *)bytes.data(), bytes.size());
+
+    SECTION("load raw file into memory")
+    {
+        const char *text =
+            "desc:example" "\n"
+            "filename:0,example.raw" "\n"
+            "@init" "\n"
+            "h=file_open(0);" "\n"
+            "a=file_avail(h);" "\n"
+            "file_var(h,v);" "\n"
+            "n=file_mem(h,1000,100000);" "\n"
+            "b=file_avail(h);" "\n"
+            "s=file_seek(h,5);" "\n"
+            "file_var(h,w);" "\n"
+            "file_close(h);" "\n";
+
+        scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+
+        ysfx_config_u config{ysfx_config_new()};
+        ysfx_u fx{ysfx_new(config.get())};
+
+        REQUIRE(ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0));
+        REQUIRE(ysfx_compile(fx.get(), 0));
+        ysfx_init(fx.get());
+
+        REQUIRE(*ysfx_find_var(fx.get(), "a") == count);
+        REQUIRE(*ysfx_find_var(fx.get(), "v") == data[0]);
+        REQUIRE(*ysfx_find_var(fx.get(), "n") == count - 1);
+        REQUIRE(*ysfx_find_var(fx.get(), "b") == 0);
+        REQUIRE(*ysfx_find_var(fx.get(), "s") == 1);
+        REQUIRE(*ysfx_find_var(fx.get(), "w") == data[5]);
+
+        std::vector<ysfx_real> mem(count - 1);
+        ysfx_read_vmem(fx.get(), 1000, mem.data(), count - 1);
+        for (uint32_t i = 0; i < count - 1; ++i)
+            REQUIRE(mem[i] == data[i + 1]);
+    }
+}
+
+#if !defined(_WIN32)
+TEST_CASE("raw data file truncated while mapped", "[raw]")
+{
+    // large enough to be mapped
+    const uint32_t count = 300000;
+    const uint32_t remain = 100000;
+    std::vector<float> data(count);
+    std::vector<uint8_t> bytes(4 * count);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        data[i] = (float)i;
+        ysfx::pack_f32le(data[i], &bytes[4 * i]);
+    }
+
+    scoped_new_dir dir_fx("${root}/Effects");
+    scoped_new_txt raw_file("${root}/Effects/example.raw", (const char *)bytes.data(), bytes.size());
+
+    const char *text =
+        "desc:example" "\n"
+        "filename:0,example.raw" "\n"
+        "@init" "\n"
+        "h=file_open(0);" "\n"
+        "a=file_avail(h);" "\n"
+        "n1=file_mem(h,0,1000);" "\n"
+        "@block" "\n"
+        "file_rewind(h);" "\n"
+        "b=file_avail(h);" "\n"
+        "n2=file_mem(h,0,count);" "\n"
+        "file_var(h,v);" "\n"
+        "s=file_seek(h,count-1);" "\n"
+        "c=file_avail(h);" "\n";
+
+    scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+
+    ysfx_config_u config{ysfx_config_new()};
+    ysfx_u fx{ysfx_new(config.get())};
+
+    REQUIRE(ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0));
+    REQUIRE(ysfx_compile(fx.get(), 0));
+    ysfx_init(fx.get());
+    *ysfx_find_var(fx.get(), "count") = count;
+
+    REQUIRE(*ysfx_find_var(fx.get(), "a") == count);
+    REQUIRE(*ysfx_find_var(fx.get(), "n1") == 1000);
+
+    REQUIRE(truncate(raw_file.m_path.c_str(), 4 * remain) == 0);
+    ysfx_process_float(fx.get(), nullptr, nullptr, 0, 0, 1);
+
+    REQUIRE(*ysfx_find_var(fx.get(), "b") == remain);
+    REQUIRE(*ysfx_find_var(fx.get(), "n2") == remain);
+    REQUIRE(*ysfx_find_var(fx.get(), "v") == 0);
+    REQUIRE(*ysfx_find_var(fx.get(), "c") == 0);
+
+    std::vector<ysfx_real> mem(remain);
+    ysfx_read_vmem(fx.get(), 0, mem.data(), remain);
+    for (uint32_t i = 0; i < remain; ++i)
+        REQUIRE(mem[i] == data[i]);
+}
+#endif
@@ -0,0 +1,172 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ysfx.h"
+#include "ysfx_utils.hpp"
+#include "ysfx_test_utils.hpp"
+#include <catch.hpp>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cmath>
+
+TEST_CASE("text data file", "[text]")
+{
+    SECTION("parse numbers")
+    {
+        auto check = [](const char *text) {
+            const char *first = text;
+            const char *last = text + strlen(text);
+            char *endp = (char *)first;
+            double expected = ysfx::dot_strtod(first, &endp);
+            double value = 0;
+            const char *end = ysfx::dot_parse_number(first, last, value);
+            REQUIRE(end == endp);
+            if (end != first) {
+                if (std::isnan(expected))
+                    REQUIRE(std::isnan(value));
+                else {
+                    REQUIRE(value == expected);
+                    REQUIRE(std::signbit(value) == std::signbit(expected));
+                }
+            }
+        };
+
+        for (const char *text : {
+                "0", "-0", "+1", "  \t12", "1.5", "-.25", "5.", ".", "-", "",
+                "1e3", "1E-3", "2e", "2e+", "1.25e+2x", "abc", "0.1", "1e22", "1e23",
+                "123456789012345678901234567890", "0.000000000000000000000000001",
+                "9007199254740993", "1e400", "1e-400", "0x1p4", "inf", "-Infinity",
+                "nan", "3.14159265358979323846", "4.9406564584124654e-324"})
+            check(text);
+
+        // longer than any fixed buffer
+        std::string longtext = std::string(150, '1') + "e-100";
+        check(longtext.c_str());
+        check(("-0." + std::string(200, '0') + "12345e+180,").c_str());
+
+        std::mt19937_64 prng;
+        char buf[64];
+        for (int i = 0; i < 10000; ++i) {
+            double x = std::uniform_real_distribution<double>{-1e3, 1e3}(prng);
+            for (const char *fmt : {"%.17g", "%g", "%.6f", "%.3e"}) {
+                snprintf(buf, sizeof(buf), fmt, x);
+                check(buf);
+            }
+        }
+    }
+
+    SECTION("read numbers")
+    {
+        const char *data =
+            "1,2.5, -3" "\n"
+            "not a number" "\n"
+            "\n"
+            "4e2,,abc,5" "\r\n"
+            "6";
+
+        const char *text =
+            "desc:example" "\n"
+            "filename:0,example.txt" "\n"
+            "@init" "\n"
+            "h=file_open(0);" "\n"
+            "t=file_text(h);" "\n"
+            "file_var(h,v);" "\n"
+            "n=file_mem(h,10,100);" "\n"
+            "a=file_avail(h);" "\n"
+            "file_rewind(h);" "\n"
+            "b=file_avail(h);" "\n"
+            "file_string(h,#s);" "\n"
+            "m=file_mem(h,20,100);" "\n"
+            "file_close(h);" "\n";
+
+        scoped_new_dir dir_fx("${root}/Effects");
+        scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+        scoped_new_txt file_data("${root}/Effects/example.txt", data);
+
+        ysfx_config_u config{ysfx_config_new()};
+        ysfx_u fx{ysfx_new(config.get())};
+
+        REQUIRE(ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0));
+        REQUIRE(ysfx_compile(fx.get(), 0));
+        ysfx_init(fx.get());
+
+        REQUIRE(*ysfx_find_var(fx.get(), "t") == 1);
+        REQUIRE(*ysfx_find_var(fx.get(), "v") == 1);
+        REQUIRE(*ysfx_find_var(fx.get(), "n") == 5);
+        REQUIRE(*ysfx_find_var(fx.get(), "a") == 1);
+        REQUIRE(*ysfx_find_var(fx.get(), "b") == 0);
+        REQUIRE(*ysfx_find_var(fx.get(), "m") == 3);
+
+        ysfx_real mem[5] = {};
+        ysfx_read_vmem(fx.get(), 10, mem, 5);
+        REQUIRE(mem[0] == 2.5);
+        REQUIRE(mem[1] == -3);
+        REQUIRE(mem[2] == 400);
+        REQUIRE(mem[3] == 5);
+        REQUIRE(mem[4] == 6);
+
+        // after the first line is consumed as a string
+        ysfx_read_vmem(fx.get(), 20, mem, 3);
+        REQUIRE(mem[0] == 400);
+        REQUIRE(mem[1] == 5);
+        REQUIRE(mem[2] == 6);
+    }
+
+    SECTION("load a large table into memory")
+    {
+        // large enough to span multiple RAM blocks and buffer refills
+        const uint32_t count = 200000;
+        std::vector<double> values(count);
+        std::string data;
+
+        std::mt19937_64 prng;
+        char buf[64];
+        for (uint32_t i = 0; i < count; ++i) {
+            values[i] = std::uniform_real_distribution<double>{-1.0, 1.0}(prng);
+            snprintf(buf, sizeof(buf), "%.17g%c", values[i], (i % 8 == 7) ? '\n' : ',');
+            data.append(buf);
+        }
+
+        const char *text =
+            "desc:example" "\n"
+            "filename:0,example.txt" "\n"
+            "@init" "\n"
+            "h=file_open(0);" "\n"
+            "n=file_mem(h,1000,1000000);" "\n"
+            "file_close(h);" "\n";
+
+        scoped_new_dir dir_fx("${root}/Effects");
+        scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+        scoped_new_txt file_data("${root}/Effects/example.txt", data.c_str());
+
+        ysfx_config_u config{ysfx_config_new()};
+        ysfx_u fx{ysfx_new(config.get())};
+
+        REQUIRE(ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0));
+        REQUIRE(ysfx_compile(fx.get(), 0));
+        ysfx_init(fx.get());
+
+        REQUIRE(*ysfx_find_var(fx.get(), "n") == count);
+
+        std::vector<ysfx_real> mem(count);
+        ysfx_read_vmem(fx.get(), 1000, mem.data(), count);
+        for (uint32_t i = 0; i < count; ++i)
+            REQUIRE(mem[i] == values[i]);
+    }
+}
@@ -0,0 +1,422 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ysfx.h"
+#include "ysfx_api_gfx.hpp"
+#include "ysfx_test_utils.hpp"
+#include <catch.hpp>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <string>
+#include <cstring>
+
+// a @gfx which exercises the shapes, the images, the fonts and the text
+static const char gfx_stress_text[] =
+    "desc:example" "\n"
+    "out_pin:output" "\n"
+    "@init" "\n"
+    "frame = 0;" "\n"
+    "@gfx 320 200" "\n"
+    "gfx_clear = 0;" "\n"
+    "gfx_set(0.2, 0.4, 0.8, 1);" "\n"
+    "gfx_rect(10, 10, 100, 50);" "\n"
+    "gfx_set(1, 0.5, 0, 0.7);" "\n"
+    "gfx_circle(160, 100, 40, 1, 1);" "\n"
+    "gfx_line(0, 0, gfx_w, gfx_h, 1);" "\n"
+    "gfx_roundrect(200, 20, 80, 40, 8, 1);" "\n"
+    "gfx_setfont(1, \"Sans\", 14 + frame % 3);" "\n"
+    "gfx_x = 20; gfx_y = 120;" "\n"
+    "gfx_drawstr(\"The quick brown fox\");" "\n"
+    "gfx_measurestr(\"jumps over\", w, h);" "\n"
+    "gfx_setfont(2, \"Serif\", 20, 'b');" "\n"
+    "gfx_x = 20; gfx_y = 150;" "\n"
+    "gfx_printf(\"%d x %d\", w, h);" "\n"
+    "gfx_setfont(0);" "\n"
+    "gfx_x = 200; gfx_y = 180;" "\n"
+    "gfx_drawnumber(frame, 0);" "\n"
+    "gfx_setimgdim(3, 64, 64);" "\n"
+    "gfx_dest = 3;" "\n"
+    "gfx_set(0, 1, 0, 1);" "\n"
+    "gfx_rect(0, 0, 64, 64);" "\n"
+    "gfx_dest = -1;" "\n"
+    "gfx_blit(3, 1, 0.5, 0, 0, 64, 64, 240, 120, 64, 64);" "\n"
+    "gfx_x = 0; gfx_y = 0;" "\n"
+    "gfx_blurto(100, 100);" "\n"
+    "frame += 1;" "\n";
+
+static const uint32_t gfx_stress_width = 320;
+static const uint32_t gfx_stress_height = 200;
+
+// render some frames of the effect, and return the pixels of the last one
+static std::vector<uint8_t> render_gfx_frames(ysfx_config_t *config, const char *path, uint32_t num_frames)
+{
+    std::vector<uint8_t> pixels(4 * gfx_stress_width * gfx_stress_height);
+
+    ysfx_u fx{ysfx_new(config)};
+    if (!ysfx_load_file(fx.get(), path, 0) || !ysfx_compile(fx.get(), 0))
+        return {};
+    ysfx_init(fx.get());
+
+    ysfx_gfx_config_t gc{};
+    gc.pixel_width = gfx_stress_width;
+    gc.pixel_height = gfx_stress_height;
+    gc.pixels = pixels.data();
+    gc.scale_factor = 1.0;
+    ysfx_gfx_setup(fx.get(), &gc);
+
+    for (uint32_t i = 0; i < num_frames; ++i) {
+        std::memset(pixels.data(), 0, pixels.size());
+        ysfx_gfx_run(fx.get());
+    }
+
+    return pixels;
+}
+
+TEST_CASE("concurrent graphics", "[gfx]")
+{
+    const uint32_t num_threads = 8;
+    const uint32_t num_frames = 10;
+
+    scoped_new_dir dir_fx("${root}/Effects");
+    scoped_new_txt file_main("${root}/Effects/example.jsfx", gfx_stress_text);
+
+    ysfx_config_u config{ysfx_config_new()};
+
+    // render alone first, for reference
+    std::vector<uint8_t> expected = render_gfx_frames(config.get(), file_main.m_path.c_str(), num_frames);
+    REQUIRE(!expected.empty());
+
+    std::vector<std::vector<uint8_t>> results(num_threads);
+    std::vector<std::thread> threads;
+    std::atomic<bool> go{false};
+
+    for (uint32_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t]() {
+            while (!go.load())
+                std::this_thread::yield();
+            results[t] = render_gfx_frames(config.get(), file_main.m_path.c_str(), num_frames);
+        });
+    }
+    go.store(true);
+    for (std::thread &thread : threads)
+        thread.join();
+
+    for (uint32_t t = 0; t < num_threads; ++t)
+        REQUIRE(results[t] == expected);
+}
+
+static bool gfx_damage_contains(const ysfx_gfx_rect_t *rects, uint32_t count, uint32_t x, uint32_t y)
+{
+    for (uint32_t i = 0; i < count; ++i) {
+        const ysfx_gfx_rect_t &r = rects[i];
+        if (x >= r.x && x < r.x + r.w && y >= r.y && y < r.y + r.h)
+            return true;
+    }
+    return false;
+}
+
+TEST_CASE("graphics damage", "[gfx]")
+{
+    scoped_new_dir dir_fx("${root}/Effects");
+
+    SECTION("small shape")
+    {
+        const char *text =
+            "desc:example" "\n"
+            "out_pin:output" "\n"
+            "@gfx 320 200" "\n"
+            "gfx_clear = -1;" "\n"
+            "gfx_rect(10, 20, 30, 40);" "\n";
+
+        scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+
+        ysfx_config_u config{ysfx_config_new()};
+        ysfx_u fx{ysfx_new(config.get())};
+        REQUIRE(ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0));
+        REQUIRE(ysfx_compile(fx.get(), 0));
+        ysfx_init(fx.get());
+
+        std::vector<uint8_t> pixels(4 * 320 * 200);
+        ysfx_gfx_config_t gc{};
+        gc.pixel_width = 320;
+        gc.pixel_height = 200;
+        gc.pixels = pixels.data();
+        gc.scale_factor = 1.0;
+        ysfx_gfx_setup(fx.get(), &gc);
+
+        REQUIRE(ysfx_gfx_run(fx.get()));
+
+        ysfx_gfx_rect_t rects[ysfx_gfx_max_damage];
+        REQUIRE(ysfx_gfx_get_damage(fx.get(), rects, ysfx_gfx_max_damage) == 1);
+        REQUIRE(rects[0].x <= 10);
+        REQUIRE(rects[0].y <= 20);
+        REQUIRE(rects[0].x + rects[0].w >= 40);
+        REQUIRE(rects[0].y + rects[0].h >= 60);
+        REQUIRE(rects[0].w * rects[0].h < 320 * 200 / 10);
+    }
+
+    SECTION("cleared frame")
+    {
+        const char *text =
+            "desc:example" "\n"
+            "out_pin:output" "\n"
+            "@gfx 320 200" "\n"
+            "gfx_rect(10, 20, 30, 40);" "\n";
+
+        scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+
+        ysfx_config_u config{ysfx_config_new()};
+        ysfx_u fx{ysfx_new(config.get())};
+        REQUIRE(ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0));
+        REQUIRE(ysfx_compile(fx.get(), 0));
+        ysfx_init(fx.get());
+
+        std::vector<uint8_t> pixels(4 * 320 * 200);
+        ysfx_gfx_config_t gc{};
+        gc.pixel_width = 320;
+        gc.pixel_height = 200;
+        gc.pixels = pixels.data();
+        gc.scale_factor = 1.0;
+        ysfx_gfx_setup(fx.get(), &gc);
+
+        REQUIRE(ysfx_gfx_run(fx.get()));
+
+        ysfx_gfx_rect_t rects[ysfx_gfx_max_damage];
+        REQUIRE(ysfx_gfx_get_damage(fx.get(), rects, ysfx_gfx_max_damage) == 1);
+        REQUIRE(rects[0].x == 0);
+        REQUIRE(rects[0].y == 0);
+        REQUIRE(rects[0].w == 320);
+        REQUIRE(rects[0].h == 200);
+    }
+
+    SECTION("covering the changes")
+    {
+        std::string text = gfx_stress_text;
+        size_t pos = text.find("gfx_clear = 0;");
+        REQUIRE(pos != text.npos);
+        text.replace(pos, 14, "gfx_clear = -1;");
+        // draw a shorter diagonal and an unrotated blit, which do not damage
+        // all the frame
+        pos = text.find("gfx_line(0, 0, gfx_w, gfx_h, 1);");
+        REQUIRE(pos != text.npos);
+        text.replace(pos, 32, "gfx_line(0, 0, 50, 30, 1);");
+        pos = text.find("gfx_blit(3, 1, 0.5,");
+        REQUIRE(pos != text.npos);
+        text.replace(pos, 19, "gfx_blit(3, 1, 0,");
+
+        scoped_new_txt file_main("${root}/Effects/example.jsfx", text.c_str());
+
+        ysfx_config_u config{ysfx_config_new()};
+        ysfx_u fx{ysfx_new(config.get())};
+        REQUIRE(ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0));
+        REQUIRE(ysfx_compile(fx.get(), 0));
+        ysfx_init(fx.get());
+
+        std::vector<uint8_t> pixels(4 * gfx_stress_width * gfx_stress_height);
+        ysfx_gfx_config_t gc{};
+        gc.pixel_width = gfx_stress_width;
+        gc.pixel_height = gfx_stress_height;
+        gc.pixels = pixels.data();
+        gc.scale_factor = 1.0;
+        ysfx_gfx_setup(fx.get(), &gc);
+
+        for (uint32_t frame = 0; frame < 5; ++frame) {
+            std::vector<uint8_t> previous = pixels;
+            ysfx_gfx_run(fx.get());
+
+            ysfx_gfx_rect_t rects[ysfx_gfx_max_damage];
+            uint32_t count = ysfx_gfx_get_damage(fx.get(), rects, ysfx_gfx_max_damage);
+            REQUIRE(count <= ysfx_gfx_max_damage);
+
+            uint32_t area = 0;
+            for (uint32_t i = 0; i < count; ++i)
+                area += rects[i].w * rects[i].h;
+            REQUIRE(area < gfx_stress_width * gfx_stress_height);
+
+            for (uint32_t y = 0; y < gfx_stress_height; ++y) {
+                for (uint32_t x = 0; x < gfx_stress_width; ++x) {
+                    size_t i = 4 * (y * gfx_stress_width + x);
+                    if (std::memcmp(&pixels[i], &previous[i], 4) != 0)
+                        REQUIRE(gfx_damage_contains(rects, count, x, y));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("shared fonts", "[gfx]")
+{
+    const char *text =
+        "desc:example" "\n"
+        "out_pin:output" "\n"
+        "@gfx 320 200" "\n"
+        "gfx_clear = 0;" "\n"
+        "gfx_setfont(1, \"Sans\", 18);" "\n"
+        "texth = gfx_texth;" "\n"
+        "gfx_x = 10; gfx_y = 10;" "\n"
+        "gfx_drawstr(\"-12.5 dB\");" "\n"
+        "gfx_setfont(2, \"Sans\", 18);" "\n"
+        "gfx_x = 10; gfx_y = 40;" "\n"
+        "gfx_drawstr(\"-12.5 dB\");" "\n";
+
+    scoped_new_dir dir_fx("${root}/Effects");
+    scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+
+    ysfx_config_u config{ysfx_config_new()};
+
+    auto render = [](ysfx_t *fx, std::vector<uint8_t> &pixels) {
+        pixels.assign(4 * 320 * 200, 0);
+        ysfx_gfx_config_t gc{};
+        gc.pixel_width = 320;
+        gc.pixel_height = 200;
+        gc.pixels = pixels.data();
+        gc.scale_factor = 1.0;
+        ysfx_gfx_setup(fx, &gc);
+        REQUIRE(ysfx_gfx_run(fx));
+    };
+
+    // the font is of a size which no other test uses
+    uint32_t font_count = ysfx_gfx_get_font_cache_count();
+
+    ysfx_u fx1{ysfx_new(config.get())};
+    REQUIRE(ysfx_load_file(fx1.get(), file_main.m_path.c_str(), 0));
+    REQUIRE(ysfx_compile(fx1.get(), 0));
+    ysfx_init(fx1.get());
+    std::vector<uint8_t> pixels1;
+    render(fx1.get(), pixels1);
+    REQUIRE(ysfx_gfx_get_font_cache_count() == font_count + 1);
+
+    ysfx_u fx2{ysfx_new(config.get())};
+    REQUIRE(ysfx_load_file(fx2.get(), file_main.m_path.c_str(), 0));
+    REQUIRE(ysfx_compile(fx2.get(), 0));
+    ysfx_init(fx2.get());
+    std::vector<uint8_t> pixels2;
+    render(fx2.get(), pixels2);
+    REQUIRE(ysfx_gfx_get_font_cache_count() == font_count + 1);
+
+    REQUIRE(*ysfx_find_var(fx1.get(), "texth") > 0);
+    REQUIRE(*ysfx_find_var(fx2.get(), "texth") == *ysfx_find_var(fx1.get(), "texth"));
+    REQUIRE(pixels2 == pixels1);
+
+    // the font remains valid for the other user, once one is gone
+    fx1.reset();
+    render(fx2.get(), pixels2);
+    REQUIRE(pixels2 == pixels1);
+    REQUIRE(ysfx_gfx_get_font_cache_count() == font_count + 1);
+}
+
+TEST_CASE("graphics data serial", "[gfx]")
+{
+    scoped_new_dir dir_fx("${root}/Effects");
+
+    auto load = [](ysfx_config_t *config, const std::string &path) -> ysfx_u {
+        ysfx_u fx{ysfx_new(config)};
+        REQUIRE(ysfx_load_file(fx.get(), path.c_str(), 0));
+        REQUIRE(ysfx_compile(fx.get(), 0));
+        ysfx_init(fx.get());
+        return fx;
+    };
+
+    ysfx_config_u config{ysfx_config_new()};
+
+    SECTION("watched variables")
+    {
+        const char *text =
+            "desc:example" "\n"
+            "out_pin:output" "\n"
+            "@init" "\n"
+            "level = 0; hold = 0; counter = 0;" "\n"
+            "@block" "\n"
+            "counter += 1;" "\n"
+            "slider1 > 0 ? level = slider1;" "\n"
+            "@gfx 320 200" "\n"
+            "// the level and the hold are displayed, the counter is not" "\n"
+            "gfx_x = 0; gfx_y = 0;" "\n"
+            "i = 0; loop(4, gfx_rect(i * 10, 0, 5, level * 100); i += 1);" "\n"
+            "hold = max(hold, level);" "\n"
+            "gfx_drawnumber(hold, 1);" "\n";
+
+        scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+        ysfx_u fx = load(config.get(), file_main.m_path);
+
+        uint64_t serial = ysfx_gfx_get_data_serial(fx.get());
+        ysfx_process_float(fx.get(), nullptr, nullptr, 0, 0, 16);
+        REQUIRE(ysfx_gfx_get_data_serial(fx.get()) == serial);
+
+        *ysfx_find_var(fx.get(), "slider1") = 0.5;
+        ysfx_process_float(fx.get(), nullptr, nullptr, 0, 0, 16);
+        REQUIRE(ysfx_gfx_get_data_serial(fx.get()) == serial + 1);
+
+        ysfx_process_float(fx.get(), nullptr, nullptr, 0, 0, 16);
+        REQUIRE(ysfx_gfx_get_data_serial(fx.get()) == serial + 1);
+
+        // reinitializing changes everything
+        ysfx_init(fx.get());
+        REQUIRE(ysfx_gfx_get_data_serial(fx.get()) == serial + 2);
+    }
+
+    SECTION("automated sliders")
+    {
+        const char *text =
+            "desc:example" "\n"
+            "slider1:0<0,1,0.01>Level" "\n"
+            "out_pin:output" "\n"
+            "@gfx 320 200" "\n"
+            "gfx_rect(0, 0, 5, slider1 * 100);" "\n";
+
+        scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+        ysfx_u fx = load(config.get(), file_main.m_path);
+
+        ysfx_process_float(fx.get(), nullptr, nullptr, 0, 0, 16);
+        uint64_t serial = ysfx_gfx_get_data_serial(fx.get());
+
+        // the host writes the slider before the processing
+        ysfx_slider_set_value(fx.get(), 0, 0.5);
+        ysfx_process_float(fx.get(), nullptr, nullptr, 0, 0, 16);
+        REQUIRE(ysfx_gfx_get_data_serial(fx.get()) == serial + 1);
+
+        ysfx_process_float(fx.get(), nullptr, nullptr, 0, 0, 16);
+        REQUIRE(ysfx_gfx_get_data_serial(fx.get()) == serial + 1);
+    }
+
+    SECTION("unwatchable reads")
+    {
+        for (const char *gfx : {
+                "gfx_rect(0, 0, 5, buf[0] * 100);",
+                "function draw() ( gfx_rect(0, 0, 5, 5) ); draw();",
+                "gfx_rect(0, 0, 5, spl(0) * 100);"})
+        {
+            std::string text =
+                "desc:example" "\n"
+                "out_pin:output" "\n"
+                "@init" "\n"
+                "buf = 0;" "\n"
+                "@gfx 320 200" "\n";
+            text += gfx;
+            text += "\n";
+
+            scoped_new_txt file_main("${root}/Effects/example.jsfx", text.c_str());
+            ysfx_u fx = load(config.get(), file_main.m_path);
+
+            uint64_t serial = ysfx_gfx_get_data_serial(fx.get());
+            ysfx_process_float(fx.get(), nullptr, nullptr, 0, 0, 16);
+            REQUIRE(ysfx_gfx_get_data_serial(fx.get()) == serial + 1);
+        }
+    }
+}
@@ -0,0 +1,207 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ysfx.h"
+#include "ysfx_test_utils.hpp"
+#include <catch.hpp>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+
+// write an uncompressed 24-bit BMP, with the pixels given as 0xRRGGBB from the top row
+static void write_bmp(const std::string &path, uint32_t w, uint32_t h, const std::vector<uint32_t> &pixels)
+{
+    uint32_t rowsize = (3 * w + 3) & ~3u;
+    uint32_t datasize = rowsize * h;
+
+    std::vector<uint8_t> bmp(54 + datasize);
+    auto put32 = [&bmp](size_t off, uint32_t value) {
+        for (size_t i = 0; i < 4; ++i)
+            bmp[off + i] = (uint8_t)(value >> (8 * i));
+    };
+    bmp[0] = 'B';
+    bmp[1] = 'M';
+    put32(2, (uint32_t)bmp.size());
+    put32(10, 54);
+    put32(14, 40);
+    put32(18, w);
+    put32(22, h);
+    bmp[26] = 1;
+    bmp[28] = 24;
+    put32(34, datasize);
+
+    for (uint32_t row = 0; row < h; ++row) {
+        uint8_t *dst = &bmp[54 + (h - 1 - row) * rowsize];
+        for (uint32_t col = 0; col < w; ++col) {
+            uint32_t px = pixels[row * w + col];
+            dst[3 * col + 0] = (uint8_t)px;
+            dst[3 * col + 1] = (uint8_t)(px >> 8);
+            dst[3 * col + 2] = (uint8_t)(px >> 16);
+        }
+    }
+
+    FILE *stream = fopen(path.c_str(), "wb");
+    REQUIRE(stream);
+    REQUIRE(fwrite(bmp.data(), 1, bmp.size(), stream) == bmp.size());
+    fclose(stream);
+}
+
+// run a frame of @gfx, and return the pixels as 0xRRGGBB
+static std::vector<uint32_t> render_gfx_fx(ysfx_t *fx, uint32_t w, uint32_t h)
+{
+    std::vector<uint8_t> bytes(4 * w * h);
+    ysfx_gfx_config_t gc{};
+    gc.pixel_width = w;
+    gc.pixel_height = h;
+    gc.pixels = bytes.data();
+    gc.scale_factor = 1.0;
+    ysfx_gfx_setup(fx, &gc);
+    ysfx_gfx_run(fx);
+
+    std::vector<uint32_t> pixels(w * h);
+    for (size_t i = 0; i < pixels.size(); ++i)
+        pixels[i] = bytes[4 * i] | (bytes[4 * i + 1] << 8) | (bytes[4 * i + 2] << 16);
+    return pixels;
+}
+
+static bool has_image_at_origin(const std::vector<uint32_t> &frame, uint32_t framew, const std::vector<uint32_t> &image, uint32_t w, uint32_t h)
+{
+    for (uint32_t row = 0; row < h; ++row) {
+        for (uint32_t col = 0; col < w; ++col) {
+            if (frame[row * framew + col] != image[row * w + col])
+                return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE("image cache", "[imagecache]")
+{
+    const char *text =
+        "desc:example" "\n"
+        "filename:0,example.bmp" "\n"
+        "out_pin:output" "\n"
+        "@gfx 16 16" "\n"
+        "gfx_clear = 0;" "\n"
+        "gfx_getimgdim(0, w, h);" "\n"
+        "gfx_x = 0; gfx_y = 0;" "\n"
+        "gfx_blit(0, 1, 0);" "\n";
+
+    const char *text_drawing =
+        "desc:example" "\n"
+        "filename:0,example.bmp" "\n"
+        "out_pin:output" "\n"
+        "@gfx 16 16" "\n"
+        "gfx_clear = 0;" "\n"
+        "gfx_dest = 0;" "\n"
+        "gfx_set(1, 1, 1, 1);" "\n"
+        "gfx_rect(0, 0, 2, 2);" "\n"
+        "gfx_dest = -1;" "\n"
+        "gfx_x = 0; gfx_y = 0;" "\n"
+        "gfx_blit(0, 1, 0);" "\n";
+
+    const std::vector<uint32_t> image1{
+        0xff0000, 0x00ff00, 0x0000ff, 0x808080,
+        0x102030, 0x405060, 0x708090, 0xa0b0c0,
+    };
+    const std::vector<uint32_t> image2{
+        0x00ffff, 0xff00ff, 0xffff00,
+        0x123456, 0x654321, 0xabcdef,
+        0x000000, 0x111111, 0x222222,
+    };
+
+    scoped_new_dir dir_fx("${root}/Effects");
+    scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+    scoped_new_txt file_drawing("${root}/Effects/drawing.jsfx", text_drawing);
+    scoped_new_txt bmp_file("${root}/Effects/example.bmp", nullptr, 0);
+    write_bmp(bmp_file.m_path, 4, 2, image1);
+
+    ysfx_image_cache_u cache{ysfx_image_cache_new(64 << 20)};
+    ysfx_config_u config{ysfx_config_new()};
+    ysfx_set_image_cache(config.get(), cache.get());
+
+    SECTION("share the decoded file")
+    {
+        ysfx_u fx1 = load_compiled_fx(config.get(), file_main.m_path, true);
+        REQUIRE(fx1);
+        ysfx_u fx2 = load_compiled_fx(config.get(), file_main.m_path, true);
+        REQUIRE(fx2);
+        REQUIRE(has_image_at_origin(render_gfx_fx(fx1.get(), 16, 16), 16, image1, 4, 2));
+        REQUIRE(has_image_at_origin(render_gfx_fx(fx2.get(), 16, 16), 16, image1, 4, 2));
+        REQUIRE(*ysfx_find_var(fx1.get(), "w") == 4);
+        REQUIRE(*ysfx_find_var(fx1.get(), "h") == 2);
+
+        REQUIRE(ysfx_image_cache_get_count(cache.get()) == 1);
+        REQUIRE(ysfx_image_cache_get_size(cache.get()) == 4 * 2 * sizeof(uint32_t));
+
+        ysfx_image_cache_clear(cache.get());
+        REQUIRE(ysfx_image_cache_get_count(cache.get()) == 0);
+        REQUIRE(ysfx_image_cache_get_size(cache.get()) == 0);
+    }
+
+    SECTION("copy on write")
+    {
+        ysfx_u fx1 = load_compiled_fx(config.get(), file_drawing.m_path, true);
+        REQUIRE(fx1);
+        ysfx_u fx2 = load_compiled_fx(config.get(), file_main.m_path, true);
+        REQUIRE(fx2);
+
+        std::vector<uint32_t> frame1 = render_gfx_fx(fx1.get(), 16, 16);
+        REQUIRE(frame1[0] == 0xffffff);
+        REQUIRE(frame1[16 + 1] == 0xffffff);
+        REQUIRE(frame1[2] == image1[2]);
+
+        REQUIRE(has_image_at_origin(render_gfx_fx(fx2.get(), 16, 16), 16, image1, 4, 2));
+        REQUIRE(ysfx_image_cache_get_count(cache.get()) == 1);
+    }
+
+    SECTION("invalidate a modified file")
+    {
+        ysfx_u fx1 = load_compiled_fx(config.get(), file_main.m_path, true);
+        REQUIRE(fx1);
+        REQUIRE(has_image_at_origin(render_gfx_fx(fx1.get(), 16, 16), 16, image1, 4, 2));
+
+        write_bmp(bmp_file.m_path, 3, 3, image2);
+        ysfx_u fx2 = load_compiled_fx(config.get(), file_main.m_path, true);
+        REQUIRE(fx2);
+        REQUIRE(has_image_at_origin(render_gfx_fx(fx2.get(), 16, 16), 16, image2, 3, 3));
+
+        REQUIRE(ysfx_image_cache_get_count(cache.get()) == 1);
+        REQUIRE(ysfx_image_cache_get_size(cache.get()) == 3 * 3 * sizeof(uint32_t));
+    }
+
+    SECTION("preload")
+    {
+        ysfx_u fx = load_compiled_fx(config.get(), file_main.m_path, true);
+        REQUIRE(fx);
+        ysfx_gfx_preload_images(fx.get());
+        REQUIRE(ysfx_image_cache_get_count(cache.get()) == 1);
+        REQUIRE(has_image_at_origin(render_gfx_fx(fx.get(), 16, 16), 16, image1, 4, 2));
+        REQUIRE(ysfx_image_cache_get_count(cache.get()) == 1);
+    }
+
+    SECTION("reject over budget")
+    {
+        ysfx_image_cache_set_budget(cache.get(), 16);
+        ysfx_u fx = load_compiled_fx(config.get(), file_main.m_path, true);
+        REQUIRE(fx);
+        REQUIRE(has_image_at_origin(render_gfx_fx(fx.get(), 16, 16), 16, image1, 4, 2));
+        REQUIRE(ysfx_image_cache_get_count(cache.get()) == 0);
+        REQUIRE(ysfx_image_cache_get_size(cache.get()) == 0);
+    }
+}
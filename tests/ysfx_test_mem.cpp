@@ -0,0 +1,163 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ysfx.h"
+#include "ysfx_utils_simd.hpp"
+#include "ysfx_test_utils.hpp"
+#include "WDL/eel2/ns-eel.h"
+#include <catch.hpp>
+#include <random>
+#include <vector>
+
+TEST_CASE("memory arithmetic", "[mem]")
+{
+    // the ranges cross the boundary of the first block of memory, at 65536
+    const char *text =
+        "desc:example" "\n"
+        "options:maxmem=1048576" "\n"
+        "@init" "\n"
+        "N = 1000;" "\n"
+        "a = 65536 - 300; b = a + N; x = b + N; y = x + N;" "\n"
+        "i = 0; loop(N, a[i] = sin(i); b[i] = cos(i * 0.3) * 2; i += 1);" "\n"
+        "" "\n"
+        "function check() local(i, err) (" "\n"
+        "  err = 0; i = 0; loop(N, err += x[i] != y[i]; i += 1); err;" "\n"
+        ");" "\n"
+        "function reset() (" "\n"
+        "  i = 0; loop(N, x[i] = y[i] = i * 0.001; i += 1);" "\n"
+        ");" "\n"
+        "" "\n"
+        "reset(); mem_add(x, a, N); i = 0; loop(N, y[i] += a[i]; i += 1); err_add = check();" "\n"
+        "reset(); mem_mul(x, a, N); i = 0; loop(N, y[i] *= a[i]; i += 1); err_mul = check();" "\n"
+        "reset(); mem_mac(x, a, b, N); i = 0; loop(N, y[i] += a[i] * b[i]; i += 1); err_mac = check();" "\n"
+        "reset(); mem_scale(x, 0.7, N); i = 0; loop(N, y[i] *= 0.7; i += 1); err_scale = check();" "\n"
+        "" "\n"
+        "sum = mem_sum(a, N); ref_sum = 0; i = 0; loop(N, ref_sum += a[i]; i += 1);" "\n"
+        "dot = mem_dot(a, b, N); ref_dot = 0; i = 0; loop(N, ref_dot += a[i] * b[i]; i += 1);" "\n"
+        "mn = mem_min(b, N); ref_mn = b[0]; i = 0; loop(N, ref_mn = min(ref_mn, b[i]); i += 1);" "\n"
+        "mx = mem_max(b, N); ref_mx = b[0]; i = 0; loop(N, ref_mx = max(ref_mx, b[i]); i += 1);" "\n"
+        "amx = mem_absmax(b, N); ref_amx = 0; i = 0; loop(N, ref_amx = max(ref_amx, abs(b[i])); i += 1);" "\n"
+        "" "\n"
+        // a source which is not allocated reads as zeros
+        "far = 8 * 65536;" "\n"
+        "reset(); mem_mul(x, far, N); err_far = 0; i = 0; loop(N, err_far += x[i] != 0; i += 1);" "\n"
+        "far_sum = mem_sum(far, N);" "\n"
+        // the ranges are trimmed to the front of the memory
+        "reset(); mem_add(-10, a - 10, 20); err_front = (0[0] != a[0]) + (9[0] != a[9]) + (10[0] != 0);" "\n"
+        "empty_max = mem_max(a, 0);" "\n";
+
+    scoped_new_dir dir_fx("${root}/Effects");
+    scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+
+    ysfx_config_u config{ysfx_config_new()};
+    ysfx_u fx{ysfx_new(config.get())};
+    REQUIRE(ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0));
+    REQUIRE(ysfx_compile(fx.get(), 0));
+    ysfx_init(fx.get());
+
+    auto var = [&fx](const char *name) -> ysfx_real { return *ysfx_find_var(fx.get(), name); };
+
+    REQUIRE(var("err_add") == 0);
+    REQUIRE(var("err_mul") == 0);
+    REQUIRE(var("err_mac") == 0);
+    REQUIRE(var("err_scale") == 0);
+
+    REQUIRE(var("sum") == Approx(var("ref_sum")).margin(1e-9));
+    REQUIRE(var("dot") == Approx(var("ref_dot")).margin(1e-9));
+    REQUIRE(var("mn") == var("ref_mn"));
+    REQUIRE(var("mx") == var("ref_mx"));
+    REQUIRE(var("amx") == var("ref_amx"));
+
+    REQUIRE(var("err_far") == 0);
+    REQUIRE(var("far_sum") == 0);
+    REQUIRE(var("err_front") == 0);
+    REQUIRE(var("empty_max") == 0);
+}
+
+static void check_kernels(const ysfx::f64_kernels &k, const ysfx::f64_kernels &ref)
+{
+    std::mt19937_64 prng;
+    for (size_t count : {0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 100, 1001}) {
+        std::vector<double> a(count), b(count), c(count);
+        for (size_t i = 0; i < count; ++i) {
+            a[i] = std::uniform_real_distribution<double>{-1.0, 1.0}(prng);
+            b[i] = std::uniform_real_distribution<double>{-2.0, 2.0}(prng);
+            c[i] = std::uniform_real_distribution<double>{-3.0, 3.0}(prng);
+        }
+
+        std::vector<double> x, y;
+        x = y = c; k.add(x.data(), a.data(), count); ref.add(y.data(), a.data(), count);
+        REQUIRE(x == y);
+        x = y = c; k.mul(x.data(), a.data(), count); ref.mul(y.data(), a.data(), count);
+        REQUIRE(x == y);
+        x = y = c; k.mac(x.data(), a.data(), b.data(), count); ref.mac(y.data(), a.data(), b.data(), count);
+        REQUIRE(x == y);
+        x = y = c; k.scale(x.data(), 0.3, count); ref.scale(y.data(), 0.3, count);
+        REQUIRE(x == y);
+        x = y = c; k.cmul(x.data(), a.data(), count / 2); ref.cmul(y.data(), a.data(), count / 2);
+        REQUIRE(x == y);
+        x = y = c; k.cmac(x.data(), a.data(), b.data(), count / 2); ref.cmac(y.data(), a.data(), b.data(), count / 2);
+        REQUIRE(x == y);
+
+        REQUIRE(k.sum(a.data(), count) == Approx(ref.sum(a.data(), count)).margin(1e-9));
+        REQUIRE(k.dot(a.data(), b.data(), count) == Approx(ref.dot(a.data(), b.data(), count)).margin(1e-9));
+        REQUIRE(k.min(b.data(), count, 0.5) == ref.min(b.data(), count, 0.5));
+        REQUIRE(k.max(b.data(), count, -0.5) == ref.max(b.data(), count, -0.5));
+        REQUIRE(k.absmax(b.data(), count, 0) == ref.absmax(b.data(), count, 0));
+    }
+}
+
+TEST_CASE("memory arithmetic kernels", "[mem]")
+{
+    const ysfx::f64_kernels scalar = ysfx::make_f64_kernels<ysfx::vec_scalar, ysfx::cvec_scalar>();
+
+    INFO("instruction set: " << ysfx::get_f64_kernels_isa());
+    check_kernels(ysfx::get_f64_kernels(), scalar);
+#if defined(YSFX_SIMD_SSE2)
+    check_kernels(ysfx::make_f64_kernels<ysfx::vec_sse2, ysfx::cvec_sse2>(), scalar);
+#elif defined(YSFX_SIMD_NEON64)
+    check_kernels(ysfx::make_f64_kernels<ysfx::vec_neon64, ysfx::cvec_neon64>(), scalar);
+#endif
+}
+
+TEST_CASE("memory allocation apart from the compiler", "[mem]")
+{
+    const char *text =
+        "desc:example" "\n"
+        "options:maxmem=1048576" "\n"
+        "@block" "\n"
+        "// a block of memory which is touched first in the processing" "\n"
+        "x = 300000; x[0] += 1;" "\n";
+
+    scoped_new_dir dir_fx("${root}/Effects");
+    scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+
+    ysfx_config_u config{ysfx_config_new()};
+    ysfx_u fx{ysfx_new(config.get())};
+    REQUIRE(ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0));
+    REQUIRE(ysfx_compile(fx.get(), 0));
+    ysfx_init(fx.get());
+
+    // the processing goes on while a compile holds the lock of the compiler
+    NSEEL_HOSTSTUB_EnterMutex();
+    ysfx_process_float(fx.get(), nullptr, nullptr, 0, 0, 16);
+    NSEEL_HOSTSTUB_LeaveMutex();
+
+    ysfx_real value = 0;
+    ysfx_read_vmem(fx.get(), 300000, &value, 1);
+    REQUIRE(value == 1);
+}
@@ -505,3 +505,49 @@ TEST_CASE("header parsing", "[parse]")
         REQUIRE(header.filenames[1] == "titi");
     }
 }
+
+TEST_CASE("code scanning", "[parse]")
+{
+    auto find = [](const ysfx_code_scan_t &scan, const char *name) -> const ysfx_code_ident_t * {
+        for (const ysfx_code_ident_t &ident : scan.idents) {
+            if (ident.name == name)
+                return &ident;
+        }
+        return nullptr;
+    };
+
+    SECTION("identifiers")
+    {
+        const char *text =
+            "// Comment: ignored" "\n"
+            "function Draw(x) ( gfx_rect(x, 0, 1, 1) );" "\n"
+            "Level += 1; hold = max(hold, level) == 0 ? $pi : 1.5e3;" "\n"
+            "/* block comment: ignored */ strcpy(#name, \"quoted: ignored\");" "\n";
+
+        ysfx_code_scan_t scan;
+        ysfx_scan_code(text, scan);
+        REQUIRE(!scan.has_indexing);
+        REQUIRE(!find(scan, "comment"));
+        REQUIRE(!find(scan, "ignored"));
+        REQUIRE(!find(scan, "pi"));
+        REQUIRE(!find(scan, "name"));
+        REQUIRE(!find(scan, "e3"));
+        REQUIRE(find(scan, "draw"));
+        REQUIRE(find(scan, "draw")->is_definition);
+        REQUIRE(find(scan, "gfx_rect"));
+        REQUIRE(find(scan, "gfx_rect")->is_call);
+        REQUIRE(find(scan, "level"));
+        REQUIRE(find(scan, "level")->is_assigned);
+        REQUIRE(find(scan, "hold"));
+        REQUIRE(find(scan, "hold")->is_assigned);
+        REQUIRE(find(scan, "max"));
+        REQUIRE(find(scan, "max")->is_call);
+    }
+
+    SECTION("indexing")
+    {
+        ysfx_code_scan_t scan;
+        ysfx_scan_code("x = buf[1];", scan);
+        REQUIRE(scan.has_indexing);
+    }
+}
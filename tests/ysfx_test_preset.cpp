@@ -19,6 +19,8 @@
 #include "ysfx_utils.hpp"
 #include "ysfx_test_utils.hpp"
 #include <catch.hpp>
+#include <string>
+#include <vector>
 #include <cstring>
 
 TEST_CASE("preset handling", "[preset]")
@@ -129,6 +131,80 @@ TEST_CASE("preset handling", "[preset]")
         REQUIRE(ysfx::unpack_f32le(&state->data[0 * sizeof(float)]) == Approx(0.8));
         REQUIRE(ysfx::unpack_f32le(&state->data[1 * sizeof(float)]) == Approx(0.9));
         REQUIRE(ysfx::unpack_f32le(&state->data[2 * sizeof(float)]) == Approx(1.0));
+
+        // the lazy bank must decode identical states, on demand
+        ysfx_bank_u lazy{ysfx_load_bank_lazy(file_rpl.m_path.c_str())};
+        REQUIRE(lazy);
+        REQUIRE(!strcmp(lazy->name, bank->name));
+        REQUIRE(lazy->preset_count == bank->preset_count);
+
+        for (uint32_t round = 0; round < 2; ++round) {
+            for (uint32_t i = 0; i < bank->preset_count; ++i) {
+                REQUIRE(!strcmp(lazy->presets[i].name, bank->presets[i].name));
+                REQUIRE(lazy->presets[i].state == nullptr);
+                ysfx_state_u expected{ysfx_bank_get_preset_state(bank.get(), i)};
+                ysfx_state_u actual{ysfx_bank_get_preset_state(lazy.get(), i)};
+                REQUIRE(expected);
+                REQUIRE(actual);
+                std::vector<uint8_t> expected_data(ysfx_state_encode(expected.get(), nullptr, 0));
+                std::vector<uint8_t> actual_data(ysfx_state_encode(actual.get(), nullptr, 0));
+                ysfx_state_encode(expected.get(), expected_data.data(), expected_data.size());
+                ysfx_state_encode(actual.get(), actual_data.data(), actual_data.size());
+                REQUIRE(expected_data == actual_data);
+            }
+        }
+
+        REQUIRE(ysfx_bank_get_preset_state(lazy.get(), lazy->preset_count) == nullptr);
+    }
+
+    SECTION("Bank made by the application")
+    {
+        ysfx_bank_u bank{new ysfx_bank_t{}};
+        bank->name = ysfx::strdup_using_new("made");
+        bank->presets = new ysfx_preset_t[2]{};
+        bank->preset_count = 2;
+        bank->presets[0].name = ysfx::strdup_using_new("first");
+        bank->presets[0].state = ysfx_state_new(0);
+
+        ysfx_state_u state{ysfx_bank_get_preset_state(bank.get(), 0)};
+        REQUIRE(state);
+        REQUIRE(state->data_size == 0);
+        REQUIRE(ysfx_bank_get_preset_state(bank.get(), 1) == nullptr);
+    }
+
+    SECTION("Lazy bank with many presets")
+    {
+        std::string rpl_text = "<REAPER_PRESET_LIBRARY `JS: Many`\n";
+        for (uint32_t i = 0; i < 100; ++i) {
+            std::string line = std::to_string(i) + " -";
+            for (uint32_t j = 2; j < 64; ++j)
+                line += " -";
+            std::vector<uint8_t> blob(line.begin(), line.end());
+            blob.push_back(0);
+            rpl_text += "  <PRESET `preset " + std::to_string(i) + "`\n";
+            rpl_text += "    " + ysfx::encode_base64(blob.data(), blob.size()) + "\n";
+            rpl_text += "  >\n";
+        }
+        rpl_text += ">\n";
+
+        scoped_new_dir dir_fx("${root}/Effects");
+        scoped_new_txt file_rpl("${root}/Effects/many.rpl", rpl_text.c_str());
+
+        ysfx_bank_u bank{ysfx_load_bank_lazy(file_rpl.m_path.c_str())};
+        REQUIRE(bank);
+        REQUIRE(bank->preset_count == 100);
+
+        for (uint32_t round = 0; round < 3; ++round) {
+            for (uint32_t i = 0; i < 100; i += 1 + round) {
+                REQUIRE(bank->presets[i].name == "preset " + std::to_string(i));
+                ysfx_state_u state{ysfx_bank_get_preset_state(bank.get(), i)};
+                REQUIRE(state);
+                REQUIRE(state->slider_count == 1);
+                REQUIRE(state->sliders[0].index == 0);
+                REQUIRE(state->sliders[0].value == i);
+                REQUIRE(state->data_size == 0);
+            }
+        }
     }
 
     SECTION("Locate preset bank")
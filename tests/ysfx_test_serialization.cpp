@@ -19,6 +19,8 @@
 #include "ysfx_utils.hpp"
 #include "ysfx_test_utils.hpp"
 #include <catch.hpp>
+#include <vector>
+#include <cstring>
 
 TEST_CASE("save and load", "[serialization]")
 {
@@ -108,4 +110,238 @@ TEST_CASE("save and load", "[serialization]")
         REQUIRE(ysfx::unpack_f32le(&state->data[3 * sizeof(float)]) == 300);
         REQUIRE(ysfx::unpack_f32le(&state->data[4 * sizeof(float)]) == 400);
     };
+    SECTION("memory across blocks")
+    {
+        // an array spanning 3 blocks of RAM, of which the middle one is not allocated
+        const char *text =
+            "desc:example" "\n"
+            "out_pin:output" "\n"
+            "@init" "\n"
+            "i=0; loop(1000, 65000[i]=i+1; i+=1);" "\n"
+            "i=0; loop(1000, 140000[i]=-(i+1); i+=1);" "\n"
+            "@serialize" "\n"
+            "file_mem(0, 65000, 76000);" "\n"
+            "@sample" "\n"
+            "spl0=0.0;" "\n";
+
+        scoped_new_dir dir_fx("${root}/Effects");
+        scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+
+        ysfx_config_u config{ysfx_config_new()};
+        ysfx_u fx{ysfx_new(config.get())};
+
+        REQUIRE(ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0));
+        REQUIRE(ysfx_compile(fx.get(), 0));
+
+        ysfx_state_u state{ysfx_save_state(fx.get())};
+        REQUIRE(state);
+        REQUIRE(state->data_size == 76000 * sizeof(float));
+        for (uint32_t i = 0; i < 76000; ++i) {
+            float expected = 0;
+            if (i < 1000)
+                expected = (float)(i + 1);
+            else if (i >= 75000)
+                expected = -(float)(i - 75000 + 1);
+            if (ysfx::unpack_f32le(&state->data[i * sizeof(float)]) != expected)
+                FAIL("wrong value at index " << i);
+        }
+
+        for (uint32_t i = 0; i < 76000; ++i)
+            ysfx::pack_f32le((float)i * 0.5f, &state->data[i * sizeof(float)]);
+        REQUIRE(ysfx_load_state(fx.get(), state.get()));
+
+        ysfx_state_u state2{ysfx_save_state(fx.get())};
+        REQUIRE(state2);
+        REQUIRE(state2->data_size == state->data_size);
+        REQUIRE(memcmp(state2->data, state->data, state->data_size) == 0);
+    };
+
+    SECTION("memory short read")
+    {
+        const char *text =
+            "desc:example" "\n"
+            "out_pin:output" "\n"
+            "@init" "\n"
+            "myarray[0]=1; myarray[1]=2; myarray[2]=3;" "\n"
+            "@serialize" "\n"
+            "count=file_mem(0, myarray, 3);" "\n"
+            "file_var(0, after);" "\n"
+            "@sample" "\n"
+            "spl0=0.0;" "\n";
+
+        scoped_new_dir dir_fx("${root}/Effects");
+        scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+
+        ysfx_config_u config{ysfx_config_new()};
+        ysfx_u fx{ysfx_new(config.get())};
+
+        REQUIRE(ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0));
+        REQUIRE(ysfx_compile(fx.get(), 0));
+
+        ysfx_state_u state{ysfx_save_state(fx.get())};
+        REQUIRE(state);
+        REQUIRE(state->data_size == 4 * sizeof(float));
+
+        state->data_size = 2 * sizeof(float) + 2;
+        ysfx::pack_f32le(10, &state->data[0 * sizeof(float)]);
+        ysfx::pack_f32le(20, &state->data[1 * sizeof(float)]);
+        REQUIRE(ysfx_load_state(fx.get(), state.get()));
+        REQUIRE(*ysfx_find_var(fx.get(), "count") == 2);
+        REQUIRE(*ysfx_find_var(fx.get(), "after") == 0);
+        ysfx_real mem[3]{};
+        ysfx_read_vmem(fx.get(), 0, mem, 3);
+        REQUIRE(mem[0] == 10);
+        REQUIRE(mem[1] == 20);
+        REQUIRE(mem[2] == 3);
+    };
+
+    SECTION("save into a preallocated state")
+    {
+        const char *text =
+            "desc:example" "\n"
+            "out_pin:output" "\n"
+            "slider3:0<0,10,1>the slider" "\n"
+            "slider7:0<0,10,1>the other slider" "\n"
+            "@init" "\n"
+            "slider3=4; slider7=8;" "\n"
+            "myarray[0]=1; myarray[1]=2; myarray[2]=3;" "\n"
+            "@serialize" "\n"
+            "file_var(0, slider3);" "\n"
+            "file_mem(0, myarray, 3);" "\n"
+            "@sample" "\n"
+            "spl0=0.0;" "\n";
+
+        scoped_new_dir dir_fx("${root}/Effects");
+        scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+
+        ysfx_config_u config{ysfx_config_new()};
+        ysfx_u fx{ysfx_new(config.get())};
+
+        REQUIRE(ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0));
+        REQUIRE(ysfx_compile(fx.get(), 0));
+        ysfx_init(fx.get());
+
+        ysfx_state_u expected{ysfx_save_state(fx.get())};
+        REQUIRE(expected);
+        REQUIRE(expected->slider_count == 2);
+        REQUIRE(expected->sliders[1].index == 6);
+        REQUIRE(expected->sliders[1].value == 8);
+
+        // too small: the required size is reported, and the buffer not overrun
+        ysfx_state_u state{ysfx_state_new(8)};
+        REQUIRE(!ysfx_save_state_into(fx.get(), state.get(), 8));
+        REQUIRE(state->data_size == 4 * sizeof(float));
+
+        state.reset(ysfx_state_new(4 * sizeof(float)));
+        REQUIRE(ysfx_save_state_into(fx.get(), state.get(), 4 * sizeof(float)));
+        REQUIRE(state->data_size == expected->data_size);
+        REQUIRE(memcmp(state->data, expected->data, expected->data_size) == 0);
+        REQUIRE(state->slider_count == expected->slider_count);
+        for (uint32_t i = 0; i < state->slider_count; ++i) {
+            REQUIRE(state->sliders[i].index == expected->sliders[i].index);
+            REQUIRE(state->sliders[i].value == expected->sliders[i].value);
+        }
+
+        // the ordinary save is unaffected by the previous one
+        ysfx_state_u state2{ysfx_save_state(fx.get())};
+        REQUIRE(state2->data_size == expected->data_size);
+        REQUIRE(memcmp(state2->data, expected->data, expected->data_size) == 0);
+    };
+
+    SECTION("load from the processing")
+    {
+        // @serialize does not wait, as in @block and @sample
+        const char *text =
+            "desc:example" "\n"
+            "out_pin:output" "\n"
+            "@init" "\n"
+            "ir = 1000; ir[0] = 1;" "\n"
+            "@serialize" "\n"
+            "file_var(0, value);" "\n"
+            "conv = conv_new(ir, 1);" "\n"
+            "@sample" "\n"
+            "spl0=0.0;" "\n";
+
+        scoped_new_dir dir_fx("${root}/Effects");
+        scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+
+        ysfx_config_u config{ysfx_config_new()};
+        ysfx_u fx{ysfx_new(config.get())};
+
+        REQUIRE(ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0));
+        REQUIRE(ysfx_compile(fx.get(), 0));
+        ysfx_init(fx.get());
+
+        float value = 7;
+        ysfx_state_t state{};
+        state.data = (uint8_t *)&value;
+        state.data_size = sizeof(value);
+
+        REQUIRE(ysfx_load_state(fx.get(), &state));
+        REQUIRE(*ysfx_find_var(fx.get(), "value") == 7);
+        REQUIRE(*ysfx_find_var(fx.get(), "conv") >= 0);
+
+        value = 9;
+        REQUIRE(ysfx_load_state_realtime(fx.get(), &state));
+        REQUIRE(*ysfx_find_var(fx.get(), "value") == 9);
+        REQUIRE(*ysfx_find_var(fx.get(), "conv") == -1);
+
+        // the capture into a preallocated state is also for the processing
+        ysfx_state_u saved{ysfx_state_new(sizeof(float))};
+        *ysfx_find_var(fx.get(), "conv") = 0;
+        REQUIRE(ysfx_save_state_into(fx.get(), saved.get(), sizeof(float)));
+        REQUIRE(*ysfx_find_var(fx.get(), "conv") == -1);
+        REQUIRE(saved->data_size == sizeof(float));
+    }
+}
+
+TEST_CASE("binary state encoding", "[serialization]")
+{
+    ysfx_state_slider_t sliders[2]{};
+    sliders[0].index = 3;
+    sliders[0].value = 0.25;
+    sliders[1].index = 63;
+    sliders[1].value = -1e10;
+    uint8_t data[5] = {1, 2, 3, 4, 5};
+
+    ysfx_state_t state{};
+    state.sliders = sliders;
+    state.slider_count = 2;
+    state.data = data;
+    state.data_size = sizeof(data);
+
+    size_t size = ysfx_state_encode(&state, nullptr, 0);
+    REQUIRE(size == 12 + 2 * 12 + 8 + sizeof(data));
+
+    std::vector<uint8_t> encoded(size);
+    REQUIRE(ysfx_state_encode(&state, encoded.data(), encoded.size()) == size);
+
+    SECTION("round trip")
+    {
+        ysfx_state_u decoded{ysfx_state_decode(encoded.data(), encoded.size())};
+        REQUIRE(decoded);
+        REQUIRE(decoded->slider_count == 2);
+        REQUIRE(decoded->sliders[0].index == 3);
+        REQUIRE(decoded->sliders[0].value == 0.25);
+        REQUIRE(decoded->sliders[1].index == 63);
+        REQUIRE(decoded->sliders[1].value == -1e10);
+        REQUIRE(decoded->data_size == sizeof(data));
+        REQUIRE(memcmp(decoded->data, data, sizeof(data)) == 0);
+    }
+
+    SECTION("truncated")
+    {
+        for (size_t n = 0; n < size; ++n) {
+            ysfx_state_u decoded{ysfx_state_decode(encoded.data(), n)};
+            if (decoded)
+                FAIL("decoded a state truncated to " << n << " bytes");
+        }
+    }
+
+    SECTION("bad magic")
+    {
+        encoded[0] = 'y';
+        ysfx_state_u decoded{ysfx_state_decode(encoded.data(), encoded.size())};
+        REQUIRE(!decoded);
+    }
 }
@@ -162,4 +162,38 @@ TEST_CASE("slider manipulation", "[sliders]")
         REQUIRE(changed == 0);
         REQUIRE(automated == 0);
     }
+
+    SECTION("slider value changes")
+    {
+        const char *text =
+            "desc:example" "\n"
+            "out_pin:output" "\n"
+            "slider1:0<0,1,0.1>the slider 1" "\n"
+            "slider2:0<0,1,0.1>the slider 2" "\n"
+            "@block" "\n"
+            "slider2 != 0 ? slider1 = slider2;" "\n";
+
+        scoped_new_dir dir_fx("${root}/Effects");
+        scoped_new_txt file_main("${root}/Effects/example.jsfx", text);
+
+        ysfx_config_u config{ysfx_config_new()};
+        ysfx_u fx{ysfx_new(config.get())};
+
+        REQUIRE(ysfx_load_file(fx.get(), file_main.m_path.c_str(), 0));
+        REQUIRE(ysfx_compile(fx.get(), 0));
+
+        ysfx_init(fx.get());
+
+        ysfx_process_float(fx.get(), nullptr, nullptr, 0, 0, 1);
+        REQUIRE(ysfx_fetch_slider_changes(fx.get()) == 0);
+
+        // the value set by the caller is not reported, the one set by the code is
+        ysfx_slider_set_value(fx.get(), 1, 0.5);
+        ysfx_process_float(fx.get(), nullptr, nullptr, 0, 0, 1);
+        REQUIRE(ysfx_fetch_slider_changes(fx.get()) == (1 << 0));
+        REQUIRE(ysfx_slider_get_value(fx.get(), 0) == 0.5);
+
+        ysfx_process_float(fx.get(), nullptr, nullptr, 0, 0, 1);
+        REQUIRE(ysfx_fetch_slider_changes(fx.get()) == 0);
+    }
 }
@@ -0,0 +1,203 @@
+// Copyright 2021 Jean Pierre Cimalando
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ysfx.h"
+#include "ysfx_test_utils.hpp"
+#include <catch.hpp>
+#include <thread>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <cstdio>
+
+static void overwrite_file(const std::string &path, const char *text)
+{
+    FILE *stream = fopen(path.c_str(), "wb");
+    REQUIRE(stream);
+    fputs(text, stream);
+    fclose(stream);
+}
+
+TEST_CASE("source cache", "[sourcecache]")
+{
+    const char *text_main =
+        "desc:example" "\n"
+        "import example.jsfx-inc" "\n"
+        "slider1:1<1,10,1>the slider" "\n"
+        "@init" "\n"
+        "x=imported_value();" "\n";
+
+    const char *text_inc =
+        "@init" "\n"
+        "function imported_value() ( 42 );" "\n";
+
+    scoped_new_dir dir_fx("${root}/Effects");
+    scoped_new_txt file_main("${root}/Effects/example.jsfx", text_main);
+    scoped_new_txt file_inc("${root}/Effects/example.jsfx-inc", text_inc);
+
+    SECTION("share the parsed files")
+    {
+        ysfx_source_cache_u cache{ysfx_source_cache_new()};
+        ysfx_config_u config{ysfx_config_new()};
+        ysfx_set_source_cache(config.get(), cache.get());
+
+        ysfx_u fx1 = load_compiled_fx(config.get(), file_main.m_path);
+        ysfx_u fx2 = load_compiled_fx(config.get(), file_main.m_path);
+        REQUIRE(fx1);
+        REQUIRE(fx2);
+        REQUIRE(ysfx_source_cache_get_count(cache.get()) == 2);
+
+        for (ysfx_t *fx : {fx1.get(), fx2.get()}) {
+            ysfx_init(fx);
+            REQUIRE(*ysfx_find_var(fx, "x") == 42);
+            REQUIRE(ysfx_slider_exists(fx, 0));
+        }
+
+        ysfx_source_cache_clear(cache.get());
+        REQUIRE(ysfx_source_cache_get_count(cache.get()) == 0);
+
+        // the effects are unaffected by the clearing
+        ysfx_init(fx1.get());
+        REQUIRE(*ysfx_find_var(fx1.get(), "x") == 42);
+    }
+
+    SECTION("invalidate a modified file")
+    {
+        ysfx_source_cache_u cache{ysfx_source_cache_new()};
+        ysfx_config_u config{ysfx_config_new()};
+        ysfx_set_source_cache(config.get(), cache.get());
+
+        ysfx_u fx1 = load_compiled_fx(config.get(), file_main.m_path);
+        REQUIRE(fx1);
+
+        overwrite_file(file_inc.m_path,
+            "@init" "\n"
+            "function imported_value() ( 1234 );" "\n");
+
+        ysfx_u fx2 = load_compiled_fx(config.get(), file_main.m_path);
+        REQUIRE(fx2);
+        REQUIRE(ysfx_source_cache_get_count(cache.get()) == 2);
+
+        ysfx_init(fx1.get());
+        ysfx_init(fx2.get());
+        REQUIRE(*ysfx_find_var(fx1.get(), "x") == 42);
+        REQUIRE(*ysfx_find_var(fx2.get(), "x") == 1234);
+    }
+
+    SECTION("evict the least recently used")
+    {
+        ysfx_source_cache_u cache{ysfx_source_cache_new()};
+        ysfx_config_u config{ysfx_config_new()};
+        ysfx_set_source_cache(config.get(), cache.get());
+
+        ysfx_u fx1 = load_compiled_fx(config.get(), file_main.m_path);
+        REQUIRE(fx1);
+        REQUIRE(ysfx_source_cache_get_count(cache.get()) == 2);
+        uint64_t size = ysfx_source_cache_get_size(cache.get());
+        REQUIRE(size > 0);
+
+        ysfx_source_cache_set_budget(cache.get(), size - 1);
+        REQUIRE(ysfx_source_cache_get_count(cache.get()) == 1);
+        REQUIRE(ysfx_source_cache_get_size(cache.get()) < size);
+
+        // nothing fits, the files are parsed but not retained
+        ysfx_source_cache_set_budget(cache.get(), 0);
+        REQUIRE(ysfx_source_cache_get_count(cache.get()) == 0);
+        REQUIRE(ysfx_source_cache_get_size(cache.get()) == 0);
+
+        ysfx_u fx2 = load_compiled_fx(config.get(), file_main.m_path);
+        REQUIRE(fx2);
+        REQUIRE(ysfx_source_cache_get_count(cache.get()) == 0);
+        ysfx_init(fx2.get());
+        REQUIRE(*ysfx_find_var(fx2.get(), "x") == 42);
+
+        ysfx_source_cache_set_budget(cache.get(), size);
+        ysfx_u fx3 = load_compiled_fx(config.get(), file_main.m_path);
+        REQUIRE(fx3);
+        REQUIRE(ysfx_source_cache_get_count(cache.get()) == 2);
+        REQUIRE(ysfx_source_cache_get_size(cache.get()) == size);
+    }
+
+    SECTION("do not retain the failures")
+    {
+        ysfx_source_cache_u cache{ysfx_source_cache_new()};
+        ysfx_config_u config{ysfx_config_new()};
+        ysfx_set_source_cache(config.get(), cache.get());
+
+        overwrite_file(file_main.m_path, "desc:example" "\n" "@invalid" "\n");
+        REQUIRE(!load_compiled_fx(config.get(), file_main.m_path));
+        REQUIRE(ysfx_source_cache_get_count(cache.get()) == 0);
+    }
+}
+
+TEST_CASE("concurrent compilation", "[sourcecache]")
+{
+    const uint32_t num_effects = 8;
+    const uint32_t num_threads = 8;
+    const uint32_t num_rounds = 20;
+
+    scoped_new_dir dir_fx("${root}/Effects");
+
+    // some effects which compile differently, touch the shared memory,
+    //   and compute a result which is specific to each of them
+    std::vector<std::unique_ptr<scoped_new_txt>> files;
+    for (uint32_t i = 0; i < num_effects; ++i) {
+        std::string index = std::to_string(i);
+        std::string text =
+            "desc:example " + index + "\n"
+            "import common.jsfx-inc" "\n"
+            "@init" "\n"
+            "function value_" + index + "(a) ( a * " + index + " + common(a) );" "\n"
+            "gmem[1000 * " + index + "] = " + index + ";" "\n"
+            "x = value_" + index + "(3) + gmem[1000 * " + index + "];" "\n"
+            "_global.counter += 1;" "\n";
+        files.emplace_back(new scoped_new_txt("${root}/Effects/example" + index + ".jsfx", text.c_str()));
+    }
+    scoped_new_txt file_inc("${root}/Effects/common.jsfx-inc",
+        "@init" "\n"
+        "function common(a) ( sqrt(a * a) + floor(a / 2) );" "\n");
+
+    auto expected = [](uint32_t i) -> ysfx_real { return 3 * i + 3 + 1 + i; };
+
+    ysfx_source_cache_u cache{ysfx_source_cache_new()};
+    ysfx_config_u config{ysfx_config_new()};
+    ysfx_set_source_cache(config.get(), cache.get());
+
+    std::atomic<uint32_t> failures{0};
+    std::vector<std::thread> threads;
+
+    for (uint32_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t]() {
+            for (uint32_t r = 0; r < num_rounds; ++r) {
+                uint32_t i = (t + r) % num_effects;
+                ysfx_u fx = load_compiled_fx(config.get(), files[i]->m_path);
+                if (!fx) {
+                    ++failures;
+                    continue;
+                }
+                ysfx_init(fx.get());
+                if (*ysfx_find_var(fx.get(), "x") != expected(i))
+                    ++failures;
+            }
+        });
+    }
+    for (std::thread &thread : threads)
+        thread.join();
+
+    REQUIRE(failures.load() == 0);
+    REQUIRE(ysfx_source_cache_get_count(cache.get()) == num_effects + 1);
+}
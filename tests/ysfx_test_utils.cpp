@@ -24,8 +24,25 @@
 #   include <direct.h>
 #endif
 #include <system_error>
+#include <algorithm>
+#include <random>
 #include <cstdio>
 #include <cstring>
+#include <cmath>
+
+#if defined(__GNUC__)
+#   pragma GCC diagnostic push
+#   pragma GCC diagnostic ignored "-Wunused-function"
+#endif
+
+#define DR_WAV_IMPLEMENTATION
+#define DRWAV_API static
+#define DRWAV_PRIVATE static
+#include "dr_wav.h"
+
+#if defined(__GNUC__)
+#   pragma GCC diagnostic pop
+#endif
 
 #if !defined(_WIN32)
 std::string tests_root_path = "ysfx-test-tmp." + std::to_string(getpid());
@@ -99,3 +116,50 @@ bool is_on_case_sensitive_filesystem(const char *path)
     return true;
 #endif
 }
+
+//------------------------------------------------------------------------------
+ysfx_u load_compiled_fx(ysfx_config_t *config, const std::string &path, bool init)
+{
+    ysfx_u fx{ysfx_new(config)};
+    if (!ysfx_load_file(fx.get(), path.c_str(), 0) || !ysfx_compile(fx.get(), 0))
+        return nullptr;
+    if (init)
+        ysfx_init(fx.get());
+    return fx;
+}
+
+//------------------------------------------------------------------------------
+std::vector<float> make_noise(uint64_t count, uint64_t seed)
+{
+    std::vector<float> data((size_t)count);
+    std::mt19937_64 prng{seed};
+    for (float &x : data)
+        x = std::uniform_real_distribution<float>{-1.0f, 1.0f}(prng);
+    return data;
+}
+
+bool write_wav_file(const std::string &path, const float *data, uint32_t channels, uint32_t sample_rate, uint64_t frames)
+{
+    drwav_data_format fmt{};
+    fmt.container = drwav_container_riff;
+    fmt.format = DR_WAVE_FORMAT_IEEE_FLOAT;
+    fmt.channels = channels;
+    fmt.sampleRate = sample_rate;
+    fmt.bitsPerSample = 32;
+
+    drwav wav;
+    if (!drwav_init_file_write(&wav, path.c_str(), &fmt, nullptr))
+        return false;
+    uint64_t written = drwav_write_pcm_frames(&wav, frames, data);
+    drwav_uninit(&wav);
+    return written == frames;
+}
+
+//------------------------------------------------------------------------------
+double max_difference(const std::vector<double> &a, const std::vector<double> &b)
+{
+    double diff = 0;
+    for (size_t i = 0; i < a.size(); ++i)
+        diff = std::max(diff, std::fabs(a[i] - b[i]));
+    return diff;
+}
@@ -16,7 +16,10 @@
 //
 
 #pragma once
+#include "ysfx.h"
+#include <vector>
 #include <string>
+#include <cstdint>
 
 extern std::string tests_root_path;
 
@@ -36,3 +39,17 @@ struct scoped_new_txt {
 
 //------------------------------------------------------------------------------
 bool is_on_case_sensitive_filesystem(const char *path);
+
+//------------------------------------------------------------------------------
+// load and compile an effect, and run @init if requested; null if it fails
+ysfx_u load_compiled_fx(ysfx_config_t *config, const std::string &path, bool init = false);
+
+//------------------------------------------------------------------------------
+// make uniform noise in [-1, 1], which is the same for the same seed
+std::vector<float> make_noise(uint64_t count, uint64_t seed = 5489);
+// write the interleaved samples as a WAV file of 32-bit floats, return whether it succeeds
+bool write_wav_file(const std::string &path, const float *data, uint32_t channels, uint32_t sample_rate, uint64_t frames);
+
+//------------------------------------------------------------------------------
+// the largest absolute difference of the items of two signals
+double max_difference(const std::vector<double> &a, const std::vector<double> &b);
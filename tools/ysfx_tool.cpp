@@ -16,7 +16,12 @@
 //
 
 #include "ysfx.h"
+#if defined(YSFX_TOOL_HAVE_LICE)
+#   define WDL_NO_DEFINE_MINMAX
+#   include "WDL/lice/lice.h"
+#endif
 #include <getopt.h>
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <chrono>
@@ -28,14 +33,26 @@ struct {
     const char *input_file = nullptr;
     bool no_gfx = false;
     bool no_serialize = false;
+    uint32_t gfx_frames = 0;
+    uint32_t gfx_width = 0;
+    uint32_t gfx_height = 0;
+    const char *gfx_mouse_file = nullptr;
+    const char *gfx_snapshot_prefix = nullptr;
+    uint32_t gfx_snapshot_every = 0;
 } args;
 
 void print_help()
 {
     fprintf(stderr, "Usage: ysfx_tool [option]... <file.jsfx>\n"
         "Options:\n"
-        "\t" "--no-gfx          Do not compile the @gfx section" "\n"
-        "\t" "--no-serialize    Do not compile the @serialize section" "\n");
+        "\t" "--no-gfx                 Do not compile the @gfx section" "\n"
+        "\t" "--no-serialize           Do not compile the @serialize section" "\n"
+        "\t" "--gfx-frames=N           Render N frames of @gfx offscreen, and time them" "\n"
+        "\t" "--gfx-size=WxH           Size of the canvas (default: requested by the effect)" "\n"
+        "\t" "--gfx-mouse=FILE         Play the mouse input from lines of the file:" "\n"
+        "\t" "                           <frame> <x> <y> [<buttons> [<wheel>]]" "\n"
+        "\t" "--gfx-snapshot=PREFIX    Save the last frame to PREFIX-<frame>.png" "\n"
+        "\t" "--gfx-snapshot-every=K   Save also every K-th frame" "\n");
 }
 
 void process_args(int argc, char *argv[])
@@ -44,6 +61,11 @@ void process_args(int argc, char *argv[])
         {"help", 0, nullptr, 'h'},
         {"no-gfx", 0, nullptr, 'G'},
         {"no-serialize", 0, nullptr, 'S'},
+        {"gfx-frames", 1, nullptr, 'F'},
+        {"gfx-size", 1, nullptr, 'Z'},
+        {"gfx-mouse", 1, nullptr, 'M'},
+        {"gfx-snapshot", 1, nullptr, 'P'},
+        {"gfx-snapshot-every", 1, nullptr, 'E'},
         {},
     };
 
@@ -63,6 +85,26 @@ void process_args(int argc, char *argv[])
         case 'S':
             args.no_serialize = true;
             break;
+        case 'F':
+            args.gfx_frames = (uint32_t)strtoul(optarg, nullptr, 10);
+            break;
+        case 'Z':
+            if (sscanf(optarg, "%ux%u", &args.gfx_width, &args.gfx_height) != 2 ||
+                args.gfx_width == 0 || args.gfx_height == 0)
+            {
+                fprintf(stderr, "Invalid canvas size: %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'M':
+            args.gfx_mouse_file = optarg;
+            break;
+        case 'P':
+            args.gfx_snapshot_prefix = optarg;
+            break;
+        case 'E':
+            args.gfx_snapshot_every = (uint32_t)strtoul(optarg, nullptr, 10);
+            break;
         default:
             exit(1);
         }
@@ -164,6 +206,143 @@ void dump_header_info(ysfx_t *fx)
     }
 }
 
+struct mouse_event {
+    uint32_t frame = 0;
+    int32_t x = 0;
+    int32_t y = 0;
+    uint32_t buttons = 0;
+    double wheel = 0;
+};
+
+bool load_mouse_events(const char *path, std::vector<mouse_event> &events)
+{
+    FILE *stream = fopen(path, "r");
+    if (!stream)
+        return false;
+
+    char line[256];
+    while (fgets(line, sizeof(line), stream)) {
+        mouse_event ev;
+        int n = sscanf(line, "%u %d %d %u %lf", &ev.frame, &ev.x, &ev.y, &ev.buttons, &ev.wheel);
+        if (n >= 3)
+            events.push_back(ev);
+    }
+
+    fclose(stream);
+    std::stable_sort(events.begin(), events.end(),
+                     [](const mouse_event &a, const mouse_event &b) { return a.frame < b.frame; });
+    return true;
+}
+
+bool save_snapshot(uint8_t *pixels, uint32_t width, uint32_t height, uint32_t frame)
+{
+#if defined(YSFX_TOOL_HAVE_LICE)
+    char path[1024];
+    snprintf(path, sizeof(path), "%s-%04u.png", args.gfx_snapshot_prefix, frame);
+    LICE_WrapperBitmap bitmap{(LICE_pixel *)pixels, (int)width, (int)height, (int)width, false};
+    if (!LICE_WritePNG(path, &bitmap, false)) {
+        fprintf(stderr, "Cannot write the snapshot: %s\n", path);
+        return false;
+    }
+    printf("Snapshot: %s\n", path);
+    return true;
+#else
+    (void)pixels;
+    (void)width;
+    (void)height;
+    (void)frame;
+    fprintf(stderr, "Cannot write the snapshot, this build has no graphics support\n");
+    return false;
+#endif
+}
+
+void print_frame_times(std::vector<double> times)
+{
+    if (times.empty())
+        return;
+
+    std::sort(times.begin(), times.end());
+    double total = 0;
+    for (double t : times)
+        total += t;
+    auto percentile = [&times](double p) -> double {
+        size_t i = (size_t)(p * (double)(times.size() - 1) + 0.5);
+        return times[i];
+    };
+
+    printf("Frames: %u\n", (uint32_t)times.size());
+    printf("Minimum: %.3f ms\n", 1e3 * times.front());
+    printf("Mean: %.3f ms\n", 1e3 * total / (double)times.size());
+    printf("Median: %.3f ms\n", 1e3 * percentile(0.50));
+    printf("90th percentile: %.3f ms\n", 1e3 * percentile(0.90));
+    printf("99th percentile: %.3f ms\n", 1e3 * percentile(0.99));
+    printf("Maximum: %.3f ms\n", 1e3 * times.back());
+}
+
+bool render_gfx(ysfx_t *fx)
+{
+    printf("\n" "--- graphics ---" "\n\n");
+
+    if (!ysfx_has_section(fx, ysfx_section_gfx)) {
+        fprintf(stderr, "The effect has no @gfx section.\n");
+        return false;
+    }
+
+    uint32_t width = args.gfx_width;
+    uint32_t height = args.gfx_height;
+    if (width == 0 || height == 0) {
+        uint32_t dim[2] = {};
+        ysfx_get_gfx_dim(fx, dim);
+        width = dim[0] ? dim[0] : 640;
+        height = dim[1] ? dim[1] : 480;
+    }
+    printf("Canvas: %ux%u\n", width, height);
+
+    std::vector<mouse_event> events;
+    if (args.gfx_mouse_file && !load_mouse_events(args.gfx_mouse_file, events)) {
+        fprintf(stderr, "Cannot read the mouse input: %s\n", args.gfx_mouse_file);
+        return false;
+    }
+
+    ysfx_set_sample_rate(fx, 44100);
+    ysfx_set_block_size(fx, 256);
+    ysfx_init(fx);
+
+    std::vector<uint8_t> pixels(4 * (size_t)width * height);
+    ysfx_gfx_config_t gc{};
+    gc.pixel_width = width;
+    gc.pixel_height = height;
+    gc.pixels = pixels.data();
+    gc.scale_factor = 1.0;
+    ysfx_gfx_setup(fx, &gc);
+
+    std::vector<double> times;
+    times.reserve(args.gfx_frames);
+
+    size_t next_event = 0;
+    for (uint32_t frame = 0; frame < args.gfx_frames; ++frame) {
+        for (; next_event < events.size() && events[next_event].frame <= frame; ++next_event) {
+            const mouse_event &ev = events[next_event];
+            ysfx_gfx_update_mouse(fx, 0, ev.x, ev.y, ev.buttons, ev.wheel, 0);
+        }
+
+        kro::steady_clock::time_point t1 = kro::steady_clock::now();
+        ysfx_gfx_run(fx);
+        kro::steady_clock::time_point t2 = kro::steady_clock::now();
+        times.push_back(kro::duration<double>(t2 - t1).count());
+
+        if (args.gfx_snapshot_prefix) {
+            bool last = frame + 1 == args.gfx_frames;
+            bool every = args.gfx_snapshot_every > 0 && (frame + 1) % args.gfx_snapshot_every == 0;
+            if ((last || every) && !save_snapshot(pixels.data(), width, height, frame))
+                return false;
+        }
+    }
+
+    print_frame_times(times);
+    return true;
+}
+
 bool process_jsfx()
 {
     ysfx_config_u config{ysfx_config_new()};
@@ -203,6 +382,9 @@ bool process_jsfx()
     t2 = kro::steady_clock::now();
     printf("Elapsed: %.3f ms\n", 1e3 * kro::duration<double>(t2 - t1).count());
 
+    if (args.gfx_frames > 0 && !render_gfx(fx.get()))
+        return false;
+
     printf("\n" "--- success ---" "\n");
     return true;
 }